@@ -121,38 +121,52 @@ void CameraPathData::updateStateSnapshot(const ReshadeStateSnapshot& snapshot, i
 }
 
 
-void CameraPathData::migratedContainedHandles(const ReshadeStateSnapshot& currentState)
+void CameraPathData::migratedContainedHandles(HandleMigration& migration)
 {
 	for(auto& snapshot : _snapshots)
 	{
-		snapshot.migrateState(currentState);
+		snapshot.migrateState(migration);
 	}
 }
 
 
-void CameraPathData::setReshadeState(int fromStateIndex, int toStateIndex, float interpolationFactor, reshade::api::effect_runtime* runtime)
+bool CameraPathData::compileInterpolationPlan(int fromStateIndex, int toStateIndex, StateInterpolationMode mode, InterpolationPlan& plan) const
 {
 	if(fromStateIndex<0 || toStateIndex < 0 || fromStateIndex>=_snapshots.size() || toStateIndex >= _snapshots.size())
 	{
-		return;
+		return false;
 	}
-	ReshadeStateSnapshot& fromState = _snapshots[fromStateIndex];
-	const ReshadeStateSnapshot& toState = _snapshots[toStateIndex];
-	fromState.applyStateFromTo(toState, interpolationFactor, runtime);
+	const ReshadeStateSnapshot* previousState = fromStateIndex > 0 ? &_snapshots[fromStateIndex - 1] : nullptr;
+	const ReshadeStateSnapshot* nextState = toStateIndex < (int)_snapshots.size() - 1 ? &_snapshots[toStateIndex + 1] : nullptr;
+	plan.compile(previousState, _snapshots[fromStateIndex], _snapshots[toStateIndex], nextState, mode);
+	return true;
 }
 
 
-void CameraPathData::setReshadeState(int stateIndex, reshade::api::effect_runtime* runtime)
+void CameraPathData::setReshadeState(int stateIndex, reshade::api::effect_runtime* runtime) const
 {
 	if(stateIndex < 0 || stateIndex >= _snapshots.size())
 	{
 		return;
 	}
-	ReshadeStateSnapshot& state = _snapshots[stateIndex];
+	const ReshadeStateSnapshot& state = _snapshots[stateIndex];
 	state.applyState(runtime);
 }
 
 
+size_t CameraPathData::calculateMemoryUsage() const
+{
+	// effect states shared by several snapshots are counted once.
+	std::unordered_set<const EffectState*> countedEffectStates;
+	size_t toReturn = sizeof(CameraPathData) + ((_snapshots.capacity() - _snapshots.size()) * sizeof(ReshadeStateSnapshot));
+	for(const auto& snapshot : _snapshots)
+	{
+		toReturn += snapshot.calculateMemoryUsage(countedEffectStates);
+	}
+	return toReturn;
+}
+
+
 void CameraPathData::propagateNewlyEnabledEffects(int startIndex, const ReshadeStateSnapshot& snapShotWithNewlyEnabledEffectsToCopy)
 {
 	if(snapShotWithNewlyEnabledEffectsToCopy.isEmpty())
@@ -165,3 +179,4 @@ void CameraPathData::propagateNewlyEnabledEffects(int startIndex, const ReshadeS
 		snapshot.addNewlyEnabledEffects(snapShotWithNewlyEnabledEffectsToCopy);
 	}
 }
+
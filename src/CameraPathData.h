@@ -32,10 +32,15 @@
 /////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <memory>
+#include <vector>
+#include "HandleMigration.h"
+#include "InterpolationPlan.h"
 #include "ReshadeStateSnapshot.h"
 
 /// <summary>
-/// Class which contains the reshade states for a path.
+/// Class which contains the reshade states for a path. Published paths are immutable (see ReshadeStateController): to change a path, a copy is changed
+/// and published in its place.
 /// </summary>
 class CameraPathData
 {
@@ -47,14 +52,23 @@ public:
 	void appendStateSnapshot(const ReshadeStateSnapshot& toAppend);
 	void removeStateSnapshot(int stateIndex);
 	void updateStateSnapshot(const ReshadeStateSnapshot& snapshot, int stateIndex);
-	void migratedContainedHandles(const ReshadeStateSnapshot& currentState);
-	void setReshadeState(int fromStateIndex, int toStateIndex, float interpolationFactor, reshade::api::effect_runtime* runtime);
-	void setReshadeState(int stateIndex, reshade::api::effect_runtime* runtime);
+	void migratedContainedHandles(HandleMigration& migration);
+	/// <summary>
+	/// Compiles plan to interpolate between the snapshots at fromStateIndex and toStateIndex. The cubic modes also use the snapshots before fromStateIndex
+	/// and after toStateIndex, so the values are smooth across the nodes. Returns false if the indices are out of range, plan is then left untouched.
+	/// </summary>
+	bool compileInterpolationPlan(int fromStateIndex, int toStateIndex, StateInterpolationMode mode, InterpolationPlan& plan) const;
+	void setReshadeState(int stateIndex, reshade::api::effect_runtime* runtime) const;
 	void insertStateSnapshotBeforeSnapshot(int indexToInsertBefore, const ReshadeStateSnapshot& reshadeStateSnapshot);
 	void appendStateSnapshotAfterSnapshot(int indexToAppendAfter, const ReshadeStateSnapshot& reshadeStateSnapshot);
 
-	bool isNonExisting() { return _isNonExisting; }
-	int numberOfSnapshots() { return _snapshots.size(); }
+	bool isNonExisting() const { return _isNonExisting; }
+	int numberOfSnapshots() const { return _snapshots.size(); }
+	const std::vector<ReshadeStateSnapshot>& getSnapshots() const { return _snapshots; }
+	/// <summary>
+	/// Returns the number of bytes used by the snapshots of this path. Effect states shared with other paths are included.
+	/// </summary>
+	size_t calculateMemoryUsage() const;
 
 private:
 	CameraPathData(bool isNonExisting);
@@ -72,3 +86,10 @@ private:
 	std::vector<ReshadeStateSnapshot> _snapshots;
 };
 
+
+/// <summary>
+/// A version of the camera paths. Versions are immutable, so they can be read without locking while a new version is built.
+/// Paths which don't change are shared with the previous version.
+/// </summary>
+using CameraPaths = std::vector<std::shared_ptr<const CameraPathData>>;
+
@@ -0,0 +1,558 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "CameraPathFile.h"
+#include "EffectState.h"
+#include "EffectStatePool.h"
+#include "NameTable.h"
+#include "ReshadeStateSnapshot.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace IGCS::CameraPathFile
+{
+	namespace
+	{
+		constexpr char FILE_MAGIC[8] = { 'I', 'G', 'C', 'S', 'P', 'A', 'T', 'H' };
+		// Increase when the layout changes. Older versions have to stay readable.
+		constexpr uint32_t FILE_VERSION = 1;
+
+		/// <summary>
+		/// Start of the file. The offsets are from the start of the file. Followed by, at the offsets specified:
+		/// name offsets: uint32[numberOfNames + 1], the offset of each name in the name characters, the last one is the total length.
+		/// name characters: the names, without terminating zeros. The index of a name is its id in the file.
+		/// effect state offsets: uint64[numberOfEffectStates]. Per effect state an EffectStateRecord followed by uint32 float uniform name ids,
+		/// XMFLOAT4 float uniform values (16 byte aligned) and uint32 uniform name ids.
+		/// paths: per path a PathRecord followed by its snapshots: per snapshot a SnapshotRecord followed by uint32 effect state indices, uint32
+		/// technique name ids and the uint64 technique enabled bits (8 byte aligned).
+		/// </summary>
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t numberOfNames;
+			uint32_t numberOfEffectStates;
+			uint32_t numberOfPaths;
+			uint64_t nameOffsetsOffset;
+			uint64_t nameCharactersOffset;
+			uint64_t effectStateOffsetsOffset;
+			uint64_t pathsOffset;
+			uint64_t fileSize;
+		};
+		static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed, increase FILE_VERSION");
+
+		struct EffectStateRecord
+		{
+			uint32_t nameId;
+			uint32_t numberOfFloatUniforms;
+			uint32_t numberOfUniforms;
+			uint32_t padding;
+		};
+
+		struct PathRecord
+		{
+			uint32_t numberOfSnapshots;
+			uint32_t padding;
+		};
+
+		struct SnapshotRecord
+		{
+			uint32_t numberOfEffectStates;
+			uint32_t numberOfTechniques;
+		};
+
+
+		class FileWriter
+		{
+		public:
+			template<typename T>
+			void append(const T* elements, size_t count)
+			{
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(elements);
+				_buffer.insert(_buffer.end(), bytes, bytes + (count * sizeof(T)));
+			}
+
+			template<typename T>
+			void append(const T& element) { append(&element, 1); }
+
+			void align(size_t alignment) { _buffer.resize((_buffer.size() + alignment - 1) / alignment * alignment, 0); }
+			size_t position() const { return _buffer.size(); }
+			std::vector<uint8_t>& buffer() { return _buffer; }
+
+		private:
+			std::vector<uint8_t> _buffer;
+		};
+
+
+		/// <summary>
+		/// Reads from the mapped file, checking every read against the size of the file so a damaged file can't make us read outside it.
+		/// </summary>
+		class FileReader
+		{
+		public:
+			FileReader(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+
+			/// <summary>
+			/// Returns a pointer to count elements at the current position and moves past them, or nullptr if they're not all inside the file.
+			/// </summary>
+			template<typename T>
+			const T* read(size_t count)
+			{
+				if(_position > _size || count > (_size - _position) / sizeof(T))
+				{
+					return nullptr;
+				}
+				const T* toReturn = reinterpret_cast<const T*>(_data + _position);
+				_position += count * sizeof(T);
+				return toReturn;
+			}
+
+			void align(size_t alignment) { _position = (_position + alignment - 1) / alignment * alignment; }
+			bool seek(uint64_t position)
+			{
+				_position = (size_t)position;
+				return position <= _size;
+			}
+
+		private:
+			const uint8_t* _data;
+			size_t _size;
+			size_t _position = 0;
+		};
+
+
+		/// <summary>
+		/// Read only memory mapping of a complete file, unmapped when destroyed.
+		/// </summary>
+		class MappedFile
+		{
+		public:
+			MappedFile(const std::string& filename)
+			{
+				_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if(INVALID_HANDLE_VALUE == _file)
+				{
+					return;
+				}
+				LARGE_INTEGER fileSize;
+				if(!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart <= 0)
+				{
+					return;
+				}
+				_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if(nullptr == _mapping)
+				{
+					return;
+				}
+				_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+				_size = nullptr == _data ? 0 : (size_t)fileSize.QuadPart;
+			}
+
+			~MappedFile()
+			{
+				if(nullptr != _data)
+				{
+					UnmapViewOfFile(_data);
+				}
+				if(nullptr != _mapping)
+				{
+					CloseHandle(_mapping);
+				}
+				if(INVALID_HANDLE_VALUE != _file)
+				{
+					CloseHandle(_file);
+				}
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const uint8_t* data() const { return _data; }
+			size_t size() const { return _size; }
+
+		private:
+			HANDLE _file = INVALID_HANDLE_VALUE;
+			HANDLE _mapping = nullptr;
+			const uint8_t* _data = nullptr;
+			size_t _size = 0;
+		};
+
+
+		void appendEffectState(FileWriter& writer, const EffectState& effectState)
+		{
+			const auto& floatUniformNameIds = effectState.getFloatUniformNameIds();
+			const auto& uniformNameIds = effectState.getUniformNameIds();
+			writer.append(EffectStateRecord{ effectState.nameId(), (uint32_t)floatUniformNameIds.size(), (uint32_t)uniformNameIds.size(), 0 });
+			writer.append(floatUniformNameIds.data(), floatUniformNameIds.size());
+			writer.align(16);
+			writer.append(effectState.getFloatUniformValues().data(), floatUniformNameIds.size());
+			writer.append(uniformNameIds.data(), uniformNameIds.size());
+			writer.align(8);
+		}
+
+
+		/// <summary>
+		/// An effect state in the mapped file, with the name ids as in the file.
+		/// </summary>
+		struct EffectStateInFile
+		{
+			const EffectStateRecord* record = nullptr;
+			const uint32_t* floatUniformNameIds = nullptr;
+			const DirectX::XMFLOAT4* floatUniformValues = nullptr;
+			const uint32_t* uniformNameIds = nullptr;
+		};
+
+
+		/// <summary>
+		/// A snapshot in the mapped file, with the technique name ids as in the file.
+		/// </summary>
+		struct SnapshotInFile
+		{
+			const SnapshotRecord* record = nullptr;
+			const uint32_t* effectStateIndices = nullptr;
+			const uint32_t* techniqueNameIds = nullptr;
+			const uint64_t* techniqueEnabledBits = nullptr;
+		};
+
+
+		bool areNameIdsInFile(const uint32_t* nameIds, size_t count, uint32_t numberOfNames)
+		{
+			return std::all_of(nameIds, nameIds + count, [numberOfNames](uint32_t nameId) { return nameId < numberOfNames; });
+		}
+
+
+		/// <summary>
+		/// Reads the effect state at the current position of the reader. Returns false if it's not inside the file or refers to a name which isn't in the file.
+		/// </summary>
+		bool readEffectState(FileReader& reader, uint32_t numberOfNames, EffectStateInFile& effectState)
+		{
+			effectState.record = reader.read<EffectStateRecord>(1);
+			if(nullptr == effectState.record || effectState.record->nameId >= numberOfNames)
+			{
+				return false;
+			}
+			effectState.floatUniformNameIds = reader.read<uint32_t>(effectState.record->numberOfFloatUniforms);
+			reader.align(16);
+			effectState.floatUniformValues = reader.read<DirectX::XMFLOAT4>(effectState.record->numberOfFloatUniforms);
+			effectState.uniformNameIds = reader.read<uint32_t>(effectState.record->numberOfUniforms);
+			return nullptr != effectState.floatUniformNameIds && nullptr != effectState.floatUniformValues && nullptr != effectState.uniformNameIds &&
+				   areNameIdsInFile(effectState.floatUniformNameIds, effectState.record->numberOfFloatUniforms, numberOfNames) &&
+				   areNameIdsInFile(effectState.uniformNameIds, effectState.record->numberOfUniforms, numberOfNames);
+		}
+
+
+		/// <summary>
+		/// Reads the snapshot at the current position of the reader. Returns false if it's not inside the file or refers to an effect state or name which isn't in the file.
+		/// </summary>
+		bool readSnapshot(FileReader& reader, uint32_t numberOfNames, uint32_t numberOfEffectStates, SnapshotInFile& snapshot)
+		{
+			snapshot.record = reader.read<SnapshotRecord>(1);
+			if(nullptr == snapshot.record)
+			{
+				return false;
+			}
+			snapshot.effectStateIndices = reader.read<uint32_t>(snapshot.record->numberOfEffectStates);
+			snapshot.techniqueNameIds = reader.read<uint32_t>(snapshot.record->numberOfTechniques);
+			reader.align(8);
+			snapshot.techniqueEnabledBits = reader.read<uint64_t>((snapshot.record->numberOfTechniques + 63) / 64);
+			return nullptr != snapshot.effectStateIndices && nullptr != snapshot.techniqueNameIds && nullptr != snapshot.techniqueEnabledBits &&
+				   std::all_of(snapshot.effectStateIndices, snapshot.effectStateIndices + snapshot.record->numberOfEffectStates,
+							   [numberOfEffectStates](uint32_t index) { return index < numberOfEffectStates; }) &&
+				   areNameIdsInFile(snapshot.techniqueNameIds, snapshot.record->numberOfTechniques, numberOfNames);
+		}
+
+
+		/// <summary>
+		/// Creates the effect state specified, read and validated by readEffectState, with its name ids mapped on the ids in the NameTable.
+		/// </summary>
+		std::shared_ptr<const EffectState> createEffectState(const EffectStateInFile& effectStateInFile, const std::vector<uint32_t>& nameIdPerFileNameId)
+		{
+			const EffectStateRecord& record = *effectStateInFile.record;
+			std::vector<uint32_t> floatUniformNameIds(record.numberOfFloatUniforms);
+			std::transform(effectStateInFile.floatUniformNameIds, effectStateInFile.floatUniformNameIds + record.numberOfFloatUniforms, floatUniformNameIds.begin(),
+						   [&nameIdPerFileNameId](uint32_t nameId) { return nameIdPerFileNameId[nameId]; });
+			std::vector<DirectX::XMFLOAT4A> floatUniformValues(record.numberOfFloatUniforms);
+			std::memcpy(floatUniformValues.data(), effectStateInFile.floatUniformValues, record.numberOfFloatUniforms * sizeof(DirectX::XMFLOAT4));
+			std::vector<uint32_t> uniformNameIds(record.numberOfUniforms);
+			std::transform(effectStateInFile.uniformNameIds, effectStateInFile.uniformNameIds + record.numberOfUniforms, uniformNameIds.begin(),
+						   [&nameIdPerFileNameId](uint32_t nameId) { return nameIdPerFileNameId[nameId]; });
+			EffectState toReturn(nameIdPerFileNameId[record.nameId], std::move(floatUniformNameIds), std::move(floatUniformValues), std::move(uniformNameIds));
+			// the ids in the table can be in a different order than the ids in the file.
+			toReturn.sortUniforms();
+			return EffectStatePool::instance().intern(std::move(toReturn));
+		}
+
+
+		/// <summary>
+		/// Fills the snapshot specified with the snapshot read and validated by readSnapshot.
+		/// </summary>
+		void fillSnapshot(const SnapshotInFile& snapshotInFile, const std::vector<uint32_t>& nameIdPerFileNameId, const std::vector<std::shared_ptr<const EffectState>>& effectStates,
+						  ReshadeStateSnapshot& snapshot)
+		{
+			for(uint32_t i = 0; i < snapshotInFile.record->numberOfEffectStates; i++)
+			{
+				snapshot.addEffectState(effectStates[snapshotInFile.effectStateIndices[i]]);
+			}
+			for(uint32_t i = 0; i < snapshotInFile.record->numberOfTechniques; i++)
+			{
+				snapshot.addTechnique(nameIdPerFileNameId[snapshotInFile.techniqueNameIds[i]], 0, (snapshotInFile.techniqueEnabledBits[i / 64] >> (i % 64)) & 1);
+			}
+			snapshot.sortOnNameIds();
+		}
+	}
+
+
+	bool write(const std::string& filename, const CameraPaths& paths)
+	{
+		FileWriter writer;
+		FileHeader header = {};
+		std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+		header.version = FILE_VERSION;
+		header.numberOfPaths = (uint32_t)paths.size();
+		writer.append(header);
+
+		// the whole name table, so the ids in the file are the ids in the table.
+		NameTable& nameTable = NameTable::instance();
+		header.numberOfNames = nameTable.getNumberOfNames();
+		header.nameOffsetsOffset = writer.position();
+		uint32_t nameOffset = 0;
+		for(uint32_t id = 0; id < header.numberOfNames; id++)
+		{
+			writer.append(nameOffset);
+			nameOffset += (uint32_t)nameTable.getName(id).size();
+		}
+		writer.append(nameOffset);
+		header.nameCharactersOffset = writer.position();
+		for(uint32_t id = 0; id < header.numberOfNames; id++)
+		{
+			const std::string& name = nameTable.getName(id);
+			writer.append(name.data(), name.size());
+		}
+		writer.align(8);
+
+		// every effect state once, even if it's shared by many snapshots.
+		std::unordered_map<const EffectState*, uint32_t> indexPerEffectState;
+		std::vector<const EffectState*> effectStatesToWrite;
+		for(const auto& path : paths)
+		{
+			for(const auto& snapshot : path->getSnapshots())
+			{
+				for(const auto& effectState : snapshot.getEffectStates())
+				{
+					if(indexPerEffectState.emplace(effectState.get(), (uint32_t)effectStatesToWrite.size()).second)
+					{
+						effectStatesToWrite.push_back(effectState.get());
+					}
+				}
+			}
+		}
+		header.numberOfEffectStates = (uint32_t)effectStatesToWrite.size();
+		header.effectStateOffsetsOffset = writer.position();
+		std::vector<uint64_t> effectStateOffsets(effectStatesToWrite.size());
+		writer.append(effectStateOffsets.data(), effectStateOffsets.size());
+		for(size_t i = 0; i < effectStatesToWrite.size(); i++)
+		{
+			effectStateOffsets[i] = writer.position();
+			appendEffectState(writer, *effectStatesToWrite[i]);
+		}
+		if(!effectStateOffsets.empty())
+		{
+			std::memcpy(writer.buffer().data() + header.effectStateOffsetsOffset, effectStateOffsets.data(), effectStateOffsets.size() * sizeof(uint64_t));
+		}
+
+		header.pathsOffset = writer.position();
+		for(const auto& path : paths)
+		{
+			const auto& snapshots = path->getSnapshots();
+			writer.append(PathRecord{ (uint32_t)snapshots.size(), 0 });
+			for(const auto& snapshot : snapshots)
+			{
+				const auto& effectStates = snapshot.getEffectStates();
+				const auto& techniqueNameIds = snapshot.getTechniqueNameIds();
+				writer.append(SnapshotRecord{ (uint32_t)effectStates.size(), (uint32_t)techniqueNameIds.size() });
+				for(const auto& effectState : effectStates)
+				{
+					writer.append(indexPerEffectState[effectState.get()]);
+				}
+				writer.append(techniqueNameIds.data(), techniqueNameIds.size());
+				writer.align(8);
+				std::vector<uint64_t> enabledBits((techniqueNameIds.size() + 63) / 64, 0);
+				for(size_t i = 0; i < techniqueNameIds.size(); i++)
+				{
+					if(snapshot.isTechniqueEnabled(i))
+					{
+						enabledBits[i / 64] |= (uint64_t)1 << (i % 64);
+					}
+				}
+				writer.append(enabledBits.data(), enabledBits.size());
+			}
+		}
+		header.fileSize = writer.position();
+		std::memcpy(writer.buffer().data(), &header, sizeof(FileHeader));
+
+		const std::string temporaryFilename = filename + ".tmp";
+		FILE* outFile = nullptr;
+		if(fopen_s(&outFile, temporaryFilename.c_str(), "wb") != 0 || nullptr == outFile)
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "Couldn't create camera path file %s", temporaryFilename.c_str());
+			return false;
+		}
+		const auto& buffer = writer.buffer();
+		const bool success = fwrite(buffer.data(), 1, buffer.size(), outFile) == buffer.size();
+		if(fclose(outFile) != 0 || !success)
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "Couldn't write camera path file %s", temporaryFilename.c_str());
+			remove(temporaryFilename.c_str());
+			return false;
+		}
+		if(!MoveFileExA(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "Couldn't replace camera path file %s", filename.c_str());
+			remove(temporaryFilename.c_str());
+			return false;
+		}
+		return true;
+	}
+
+
+	bool read(const std::string& filename, CameraPaths& paths)
+	{
+		const MappedFile file(filename);
+		if(nullptr == file.data())
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "Couldn't open camera path file %s", filename.c_str());
+			return false;
+		}
+		FileReader reader(file.data(), file.size());
+		const FileHeader* header = reader.read<FileHeader>(1);
+		if(nullptr == header || std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header->fileSize != file.size())
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "%s isn't a camera path file or is damaged", filename.c_str());
+			return false;
+		}
+		if(header->version < 1 || header->version > FILE_VERSION)
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "Camera path file %s has version %u, which isn't supported (supported up to version %u)", filename.c_str(),
+										  header->version, FILE_VERSION);
+			return false;
+		}
+
+		// The whole file is validated before anything is added to the NameTable or the EffectStatePool, so a damaged file doesn't leave names or
+		// effect states behind in them.
+		// names
+		const uint32_t* nameOffsets = nullptr;
+		const char* nameCharacters = nullptr;
+		if(reader.seek(header->nameOffsetsOffset))
+		{
+			nameOffsets = reader.read<uint32_t>((size_t)header->numberOfNames + 1);
+		}
+		if(nullptr != nameOffsets && reader.seek(header->nameCharactersOffset))
+		{
+			nameCharacters = reader.read<char>(nameOffsets[header->numberOfNames]);
+		}
+		bool success = nullptr != nameCharacters;
+		for(uint32_t i = 0; success && i < header->numberOfNames; i++)
+		{
+			success = nameOffsets[i] <= nameOffsets[i + 1] && nameOffsets[i + 1] <= nameOffsets[header->numberOfNames];
+		}
+
+		// effect states
+		const uint64_t* effectStateOffsets = nullptr;
+		if(success && reader.seek(header->effectStateOffsetsOffset))
+		{
+			effectStateOffsets = reader.read<uint64_t>(header->numberOfEffectStates);
+		}
+		success = nullptr != effectStateOffsets;
+		std::vector<EffectStateInFile> effectStatesInFile(success ? header->numberOfEffectStates : 0);
+		for(uint32_t i = 0; success && i < header->numberOfEffectStates; i++)
+		{
+			success = reader.seek(effectStateOffsets[i]) && readEffectState(reader, header->numberOfNames, effectStatesInFile[i]);
+		}
+
+		// paths
+		success = success && reader.seek(header->pathsOffset) && header->numberOfPaths <= file.size() / sizeof(PathRecord);
+		std::vector<std::vector<SnapshotInFile>> snapshotsInFilePerPath;
+		for(uint32_t pathIndex = 0; success && pathIndex < header->numberOfPaths; pathIndex++)
+		{
+			const PathRecord* record = reader.read<PathRecord>(1);
+			success = nullptr != record && record->numberOfSnapshots <= file.size() / sizeof(SnapshotRecord);
+			std::vector<SnapshotInFile> snapshotsInFile(success ? record->numberOfSnapshots : 0);
+			for(uint32_t i = 0; success && i < record->numberOfSnapshots; i++)
+			{
+				success = readSnapshot(reader, header->numberOfNames, header->numberOfEffectStates, snapshotsInFile[i]);
+			}
+			snapshotsInFilePerPath.push_back(std::move(snapshotsInFile));
+		}
+		if(!success)
+		{
+			IGCS::Utils::logLineToReshade(reshade::log_level::error, "Camera path file %s is damaged", filename.c_str());
+			return false;
+		}
+
+		// Interning the names gives the id of each name in the table, which is the same id as in the file if the table is the one the file was written from.
+		NameTable& nameTable = NameTable::instance();
+		std::vector<uint32_t> nameIdPerFileNameId(header->numberOfNames);
+		for(uint32_t i = 0; i < header->numberOfNames; i++)
+		{
+			nameIdPerFileNameId[i] = nameTable.intern(std::string_view(nameCharacters + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]));
+			if(NameTable::INVALID_NAME_ID == nameIdPerFileNameId[i])
+			{
+				IGCS::Utils::logLineToReshade(reshade::log_level::error, "Camera path file %s can't be loaded as the name table is full", filename.c_str());
+				return false;
+			}
+		}
+		// effect states, each interned once and shared by the snapshots referring to it.
+		std::vector<std::shared_ptr<const EffectState>> effectStates;
+		effectStates.reserve(effectStatesInFile.size());
+		for(const auto& effectStateInFile : effectStatesInFile)
+		{
+			effectStates.push_back(createEffectState(effectStateInFile, nameIdPerFileNameId));
+		}
+		CameraPaths pathsRead;
+		for(const auto& snapshotsInFile : snapshotsInFilePerPath)
+		{
+			auto path = std::make_shared<CameraPathData>();
+			for(const auto& snapshotInFile : snapshotsInFile)
+			{
+				ReshadeStateSnapshot snapshot;
+				fillSnapshot(snapshotInFile, nameIdPerFileNameId, effectStates, snapshot);
+				path->appendStateSnapshot(snapshot);
+			}
+			pathsRead.push_back(std::move(path));
+		}
+		paths = std::move(pathsRead);
+		return true;
+	}
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+#include <vector>
+#include "CameraPathData.h"
+
+/// <summary>
+/// Binary file with the reshade state snapshots of camera paths, so they survive a restart of the game. The file contains the NameTable, every
+/// (pooled) effect state once and per path the snapshots referring to these, all as flat arrays in native layout so they're bulk copied from the
+/// memory mapped file when loading. Handles aren't stored, as they're only valid in the runtime which created them: loaded snapshots have no handles
+/// until they're migrated to the current runtime with ReshadeStateSnapshot::migrateState.
+/// </summary>
+namespace IGCS::CameraPathFile
+{
+	/// <summary>
+	/// Writes the paths specified to the file specified. The file is first written under a temporary name and then moved over the existing file, so a
+	/// failed write never leaves a half written file behind.
+	/// </summary>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool write(const std::string& filename, const CameraPaths& paths);
+	/// <summary>
+	/// Reads the paths in the file specified into paths. The whole file is validated first, after which the names in the file are added to the NameTable
+	/// and the ids in the file are mapped to their ids in the table, so a damaged file adds nothing to the table. The snapshots read have no handles yet.
+	/// </summary>
+	/// <returns>true if the file was read successfully, false otherwise (paths is then left untouched)</returns>
+	bool read(const std::string& filename, CameraPaths& paths);
+}
@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "CoalescingWorkQueue.h"
+#include "Utils.h"
+#include <memory>
+
+
+CoalescingWorkQueue::CoalescingWorkQueue(size_t capacity) : _queue(capacity)
+{
+	for(auto& latestWork : _latestWorkPerKey)
+	{
+		latestWork.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+
+CoalescingWorkQueue::~CoalescingWorkQueue()
+{
+	for(auto& latestWork : _latestWorkPerKey)
+	{
+		delete latestWork.exchange(nullptr, std::memory_order_acquire);
+	}
+}
+
+
+void CoalescingWorkQueue::push(WorkItem&& item)
+{
+	if(WorkItemCoalescingKey::None != item.getCoalescingKey())
+	{
+		pushLatestWork(std::move(item));
+		return;
+	}
+	pushInOrder(std::move(item));
+}
+
+
+void CoalescingWorkQueue::performPendingWork(reshade::api::effect_runtime* runtime)
+{
+	uint64_t numberOfItemsPerformed = 0;
+	_queue.drain([this, runtime, &numberOfItemsPerformed](WorkItem&& item) { numberOfItemsPerformed += performWork(item, runtime) ? 1 : 0; });
+	// only once the queue is empty, as the work in the queue was pushed before the overflow work.
+	if(_numberOfOverflowItems.load(std::memory_order_acquire) > 0 && 0 == _queue.size())
+	{
+		{
+			std::scoped_lock lock(_overflowMutex);
+			_overflowWorkToPerform.swap(_overflowWork);
+			_numberOfOverflowItems.store(0, std::memory_order_release);
+		}
+		for(auto& item : _overflowWorkToPerform)
+		{
+			numberOfItemsPerformed += performWork(item, runtime) ? 1 : 0;
+		}
+		// release the captures of the work performed now rather than at the next overflow
+		_overflowWorkToPerform.clear();
+	}
+	if(numberOfItemsPerformed > _maxItemsPerPresent.load(std::memory_order_relaxed))
+	{
+		_maxItemsPerPresent.store(numberOfItemsPerformed, std::memory_order_relaxed);
+	}
+	_itemsPerformed.fetch_add(numberOfItemsPerformed, std::memory_order_relaxed);
+}
+
+
+WorkQueueStatistics CoalescingWorkQueue::getStatistics() const
+{
+	WorkQueueStatistics toReturn;
+	toReturn.itemsPending = _queue.size() + _numberOfOverflowItems.load(std::memory_order_relaxed);
+	toReturn.maxItemsPerPresent = _maxItemsPerPresent.load(std::memory_order_relaxed);
+	toReturn.itemsPerformed = _itemsPerformed.load(std::memory_order_relaxed);
+	toReturn.itemsCoalesced = _itemsCoalesced.load(std::memory_order_relaxed);
+	toReturn.itemsOverflowed = _itemsOverflowed.load(std::memory_order_relaxed);
+	return toReturn;
+}
+
+
+void CoalescingWorkQueue::pushLatestWork(WorkItem&& item)
+{
+	const WorkItemCoalescingKey key = item.getCoalescingKey();
+	// acq_rel: the work is published to whoever takes it next, and the work superseded was published to us by whoever pushed it.
+	std::unique_ptr<WorkItem> supersededWork(_latestWorkPerKey[(size_t)key].exchange(new WorkItem(std::move(item)), std::memory_order_acq_rel));
+	if(nullptr != supersededWork)
+	{
+		// its marker is still pending and performs our work instead.
+		_itemsCoalesced.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	pushInOrder(WorkItem(nullptr, key));
+}
+
+
+void CoalescingWorkQueue::pushInOrder(WorkItem&& item)
+{
+	// work pushed after work in the overflow list has to be performed after it, so it goes there as well.
+	if(0 == _numberOfOverflowItems.load(std::memory_order_acquire) && _queue.tryPush(std::move(item)))
+	{
+		return;
+	}
+	// no presents for a while. Waiting for one would hang the caller, which is the camera tools, for as long as that takes, and dropping an edit would
+	// make their paths differ from ours.
+	std::scoped_lock lock(_overflowMutex);
+	if(_overflowWork.empty())
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::warning, "The present work queue is full as there were no presents for a while, reshade state edits are kept until the next present.");
+	}
+	_overflowWork.push_back(std::move(item));
+	_numberOfOverflowItems.store(_overflowWork.size(), std::memory_order_release);
+	_itemsOverflowed.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+bool CoalescingWorkQueue::performWork(WorkItem& item, reshade::api::effect_runtime* runtime)
+{
+	if(!item.isEmpty())
+	{
+		item.perform(runtime);
+		return true;
+	}
+	// a marker: perform the latest work with its key.
+	std::unique_ptr<WorkItem> latestWork(_latestWorkPerKey[(size_t)item.getCoalescingKey()].exchange(nullptr, std::memory_order_acq_rel));
+	if(nullptr == latestWork)
+	{
+		return false;
+	}
+	latestWork->perform(runtime);
+	return true;
+}
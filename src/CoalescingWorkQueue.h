@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <reshade.hpp>
+#include "ConstantsEnums.h"
+#include "MpscRingQueue.h"
+#include "WorkItem.h"
+
+/// <summary>
+/// The statistics of the present work queue: the items pending right now and the most performed at one present, and since the start, the items performed,
+/// the items skipped because newer work with the same coalescing key superseded them before they were performed and the items which went to the overflow
+/// list as the queue was full.
+/// </summary>
+struct WorkQueueStatistics
+{
+	uint64_t itemsPending = 0;
+	uint64_t maxItemsPerPresent = 0;
+	uint64_t itemsPerformed = 0;
+	uint64_t itemsCoalesced = 0;
+	uint64_t itemsOverflowed = 0;
+};
+
+
+/// <summary>
+/// Queue of the work to perform on the render thread at present. Tools can request a new reshade state several times between two presents, and only
+/// the last request matters, so work with a coalescing key is coalesced when it's pushed: per key there's one slot with the latest work, which a push
+/// swaps the new work into, deleting the work it supersedes. Only the push which fills an empty slot puts a marker with the key in the queue, and the
+/// marker performs whatever work is in the slot by the time the render thread gets to it. Requests with a key therefore never take more than one place in
+/// the queue, however many are made while there are no presents, and the last one always wins. It's performed in the place of the oldest request it
+/// superseded, so work without a key, like appending a snapshot, sees the latest state requested before it was performed.
+/// Producers push without locks (see MpscRingQueue) and never wait, and only superseded work is ever discarded: when there are no presents for a while,
+/// e.g. while the game is minimized or loading, and the queue fills up, work without a key and markers go to an unbounded overflow list under a lock
+/// instead. That's rare and the list stays small, as it only gets edits and at most one marker per key. As long as the list isn't empty everything goes
+/// to it, and it's performed after the queue has been emptied, so the work is performed in the order pushed. performPendingWork is only to be called by
+/// the render thread.
+/// </summary>
+class CoalescingWorkQueue
+{
+public:
+	explicit CoalescingWorkQueue(size_t capacity);
+	~CoalescingWorkQueue();
+
+	/// <summary>
+	/// Moves item into the queue, in the slot of its coalescing key if it has one, or in the overflow list if the queue is full.
+	/// </summary>
+	void push(WorkItem&& item);
+	/// <summary>
+	/// Performs the pending work on the runtime specified. At most one queue full is performed per call, plus the overflow list once the queue has been
+	/// emptied.
+	/// </summary>
+	void performPendingWork(reshade::api::effect_runtime* runtime);
+	WorkQueueStatistics getStatistics() const;
+
+private:
+	/// <summary>
+	/// Moves item, which has a coalescing key, into the slot of its key and puts a marker in the queue if the slot was empty.
+	/// </summary>
+	void pushLatestWork(WorkItem&& item);
+	/// <summary>
+	/// Moves item, which has no coalescing key or is a marker, into the queue, or into the overflow list if the queue is full or the list isn't empty.
+	/// </summary>
+	void pushInOrder(WorkItem&& item);
+	/// <summary>
+	/// Performs item, or if it's a marker, the work in the slot of its key. Returns false if there was nothing to perform.
+	/// </summary>
+	bool performWork(WorkItem& item, reshade::api::effect_runtime* runtime);
+
+	IGCS::MpscRingQueue<WorkItem> _queue;
+	// per coalescing key the latest work pushed which hasn't been performed yet, or nullptr. Owned by the queue, swapped by producers and the render thread.
+	std::array<std::atomic<WorkItem*>, (size_t)WorkItemCoalescingKey::Count> _latestWorkPerKey;
+	// the work without a key and markers pushed while the queue was full and everything pushed in order after them, in push order.
+	std::mutex _overflowMutex;
+	std::vector<WorkItem> _overflowWork;
+	// the size of _overflowWork, so producers can check it's empty without taking the lock.
+	std::atomic<size_t> _numberOfOverflowItems = 0;
+	// the overflow work being performed by the render thread, kept to reuse its storage
+	std::vector<WorkItem> _overflowWorkToPerform;
+	// written by the render thread only, atomic so the statistics can be read from any thread
+	std::atomic<uint64_t> _maxItemsPerPresent = 0;
+	std::atomic<uint64_t> _itemsPerformed = 0;
+	// written by the producers
+	std::atomic<uint64_t> _itemsCoalesced = 0;
+	std::atomic<uint64_t> _itemsOverflowed = 0;
+};
@@ -37,12 +37,14 @@ enum class DepthOfFieldRenderOrder : int
 	InnerRingToOuterRing,
 	OuterRingToInnerRing,
 	Randomized,
+	Progressive,		// every checkpoint-sized prefix of the samples is a well distributed, normalized subset of the pattern
 };
 
 enum class DepthOfFieldBlurType : int
 {
 	ApertureShape,
 	Circular,
+	ApertureMask,
 };
 
 enum class DepthOfFieldFrameWaitType : int
@@ -51,6 +53,41 @@ enum class DepthOfFieldFrameWaitType : int
 	Classic,
 };
 
+enum class DepthOfFieldRenderMode : int
+{
+	Live,			// the frames are blended by the shader while rendering
+	Offline,		// the frames are captured to disk and composited on the cpu afterwards
+};
+
+enum class DepthOfFieldOfflineOutputType : int
+{
+	Png,
+	Exr,
+};
+
+enum class StateInterpolationMode : int
+{
+	Linear,				// lerp between the two snapshots of a segment, values kink at every node
+	CatmullRom,			// cubic through the neighbouring snapshots, smooth at the nodes but can overshoot the node values
+	MonotoneCubic,		// cubic like CatmullRom but with the tangents limited so values never overshoot (Fritsch-Carlson)
+};
+
+// Key of work done at present which supersedes pending work with the same key, see CoalescingWorkQueue. Used as index, so keep Count last.
+enum class WorkItemCoalescingKey : int
+{
+	None,				// never superseded, performed in the order pushed
+	ReshadeState,		// sets the effect state of the runtime presenting, only the last one pending matters
+	Count				// not a key, has to be last
+};
+
+enum class ReshadeStateStressTestPhase : int
+{
+	Idle,
+	Setup,			// waiting for the render thread to record the paths
+	Running,		// the render thread plays back while the background threads edit, save and load
+	Done,
+};
+
 enum class ScreenshotControllerState : int
 {
 	Off,
@@ -84,12 +121,28 @@ enum class DepthOfFieldColorChannel : int
 	Blue
 };
 
-enum class DepthOfFieldRenderFrameState : int
+// Uniforms of IgcsDof.fx written by the depth of field controller. Used as index in the uniform handle table, so keep in sync with the names there.
+enum class DepthOfFieldShaderUniform : int
 {
-	Off,			// no work
-	Start,			// start state of the whole process. 
-	FrameWait,		// Waiting for the camera to have moved after setup. This waiting is done with a counter
-	FrameBlending,	// Currently in the blending operation. 
+	SessionState,
+	FocusDelta,
+	BlendFrame,
+	BlendFactor,
+	AlignmentDelta,
+	HighlightBoost,
+	SampleWeightR,
+	SampleWeightG,
+	SampleWeightB,
+	HighlightGammaFactor,
+	ShowMagnifier,
+	MagnificationFactor,
+	MagnificationArea,
+	MagnificationLocationCenter,
+	CateyeVignette,
+	CateyeRadiusStart,
+	CateyeRadiusEnd,
+	CateyeIntensity,
+	Count			// not a uniform, has to be last
 };
 
 enum class ScreenshotType : int
@@ -104,7 +157,9 @@ enum class ScreenshotFiletype : int
 {
 	Bmp,
 	Jpeg,
-	Png
+	Png,
+	Tga,
+	Ppm
 };
 
 enum class ScreenshotSessionStartReturnCode : int
@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldApertureMask.h"
+#include "ImageFileIO.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// The R2 sequence (Roberts, 2018): the generalized golden ratio for 2 dimensions gives the best spread of all additive recurrences.
+	constexpr double R2_ALPHA_X = 0.7548776662466927;
+	constexpr double R2_ALPHA_Y = 0.5698402909980532;
+
+
+	/// <summary>
+	/// Returns the index of the first element in the CDF which is larger than value, so the cell value falls in, and where it lies in that cell (0.0-1.0).
+	/// Cells with a density of 0 are never returned, as their CDF value is equal to the one of the cell before.
+	/// </summary>
+	int sampleCdf(const float* cdf, int numberOfCells, float value, float& positionInCell)
+	{
+		const int cell = std::min((int)(std::upper_bound(cdf, cdf + numberOfCells, value) - cdf), numberOfCells - 1);
+		const float cellStart = cell > 0 ? cdf[cell - 1] : 0.0f;
+		const float cellMass = cdf[cell] - cellStart;
+		positionInCell = cellMass > 0.0f ? std::clamp((value - cellStart) / cellMass, 0.0f, 0.999f) : 0.5f;
+		return cell;
+	}
+}
+
+
+std::shared_ptr<const DepthOfFieldApertureMask> DepthOfFieldApertureMask::load(const std::string& filename, std::string& error)
+{
+	std::vector<uint8_t> imageData;
+	int imageWidth = 0;
+	int imageHeight = 0;
+	std::vector<float> luminance;
+	if(IGCS::ImageFileIO::readPgm(filename, imageData, imageWidth, imageHeight))
+	{
+		luminance.resize(imageData.size());
+		std::ranges::transform(imageData, luminance.begin(), [](uint8_t value) { return (float)value / 255.0f; });
+	}
+	else if(IGCS::ImageFileIO::readPpm(filename, imageData, imageWidth, imageHeight))
+	{
+		luminance.resize((size_t)imageWidth * imageHeight);
+		for(size_t i = 0; i < luminance.size(); i++)
+		{
+			luminance[i] = ((0.2126f * imageData[i * 3]) + (0.7152f * imageData[(i * 3) + 1]) + (0.0722f * imageData[(i * 3) + 2])) / 255.0f;
+		}
+	}
+	else
+	{
+		error = "Couldn't read the aperture mask. Only binary PGM and PPM files with 8 bits per channel are supported.";
+		return nullptr;
+	}
+
+	// downsample with a box filter, so the longest side is at most MAX_MASK_SIZE.
+	const int downsampleFactor = (std::max(imageWidth, imageHeight) + MAX_MASK_SIZE - 1) / MAX_MASK_SIZE;
+	std::shared_ptr<DepthOfFieldApertureMask> mask(new DepthOfFieldApertureMask());
+	mask->_width = (imageWidth + downsampleFactor - 1) / downsampleFactor;
+	mask->_height = (imageHeight + downsampleFactor - 1) / downsampleFactor;
+	mask->_transmission.assign((size_t)mask->_width * mask->_height, 0.0f);
+	for(int y = 0; y < mask->_height; y++)
+	{
+		for(int x = 0; x < mask->_width; x++)
+		{
+			float sum = 0.0f;
+			int numberOfPixels = 0;
+			for(int imageY = y * downsampleFactor; imageY < std::min((y + 1) * downsampleFactor, imageHeight); imageY++)
+			{
+				for(int imageX = x * downsampleFactor; imageX < std::min((x + 1) * downsampleFactor, imageWidth); imageX++)
+				{
+					sum += luminance[(size_t)imageY * imageWidth + imageX];
+					numberOfPixels++;
+				}
+			}
+			mask->_transmission[(size_t)y * mask->_width + x] = sum / (float)numberOfPixels;
+		}
+	}
+	if(!mask->calculateDistribution())
+	{
+		error = "The aperture mask has no transmitting pixels.";
+		return nullptr;
+	}
+	return mask;
+}
+
+
+bool DepthOfFieldApertureMask::calculateDistribution()
+{
+	_rowCdf.assign(_height, 0.0f);
+	_columnCdfs.assign(_transmission.size(), 0.0f);
+	const float centerX = (float)_width / 2.0f;
+	const float centerY = (float)_height / 2.0f;
+	float maxRadiusSquared = 0.0f;
+	double totalDensity = 0.0;
+	for(int y = 0; y < _height; y++)
+	{
+		double rowDensity = 0.0;
+		float* columnCdf = _columnCdfs.data() + (size_t)y * _width;
+		for(int x = 0; x < _width; x++)
+		{
+			const float transmission = _transmission[(size_t)y * _width + x];
+			rowDensity += sqrtf(transmission);
+			columnCdf[x] = (float)rowDensity;
+			if(transmission <= 0.0f)
+			{
+				continue;
+			}
+			// the farthest corner of the pixel.
+			const float dx = std::max(fabsf((float)x - centerX), fabsf((float)(x + 1) - centerX));
+			const float dy = std::max(fabsf((float)y - centerY), fabsf((float)(y + 1) - centerY));
+			maxRadiusSquared = std::max(maxRadiusSquared, (dx * dx) + (dy * dy));
+		}
+		if(rowDensity > 0.0)
+		{
+			for(int x = 0; x < _width; x++)
+			{
+				columnCdf[x] = (float)(columnCdf[x] / rowDensity);
+			}
+		}
+		totalDensity += rowDensity;
+		_rowCdf[y] = (float)totalDensity;
+	}
+	if(totalDensity <= 0.0)
+	{
+		return false;
+	}
+	for(float& value : _rowCdf)
+	{
+		value = (float)(value / totalDensity);
+	}
+	_pixelToNormalizedScale = 1.0f / sqrtf(maxRadiusSquared);
+	return true;
+}
+
+
+void DepthOfFieldApertureMask::createSamples(int numberOfSamples, std::vector<float>& x, std::vector<float>& y, std::vector<float>& weights) const
+{
+	x.resize(numberOfSamples);
+	y.resize(numberOfSamples);
+	weights.resize(numberOfSamples);
+	const float centerX = (float)_width / 2.0f;
+	const float centerY = (float)_height / 2.0f;
+	for(int i = 0; i < numberOfSamples; i++)
+	{
+		// in double, as the products get too large for float precision in a few thousand steps.
+		const double u = 0.5 + (R2_ALPHA_X * (double)i);
+		const double v = 0.5 + (R2_ALPHA_Y * (double)i);
+		float positionInRow = 0.0f;
+		float positionInColumn = 0.0f;
+		const int row = sampleCdf(_rowCdf.data(), _height, (float)(v - floor(v)), positionInRow);
+		const int column = sampleCdf(_columnCdfs.data() + (size_t)row * _width, _width, (float)(u - floor(u)), positionInColumn);
+		x[i] = (((float)column + positionInColumn) - centerX) * _pixelToNormalizedScale;
+		y[i] = (centerY - ((float)row + positionInRow)) * _pixelToNormalizedScale;
+		// transmission / sqrt(transmission)
+		weights[i] = sqrtf(_transmission[(size_t)row * _width + column]);
+	}
+}
+
+
+std::shared_ptr<const DepthOfFieldApertureMask> DepthOfFieldApertureMaskCache::getMask(const std::string& filename, std::string& error)
+{
+	std::error_code errorCode;
+	const std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(filename, errorCode);
+	if(errorCode)
+	{
+		error = "The aperture mask file doesn't exist or can't be accessed.";
+		return nullptr;
+	}
+	const auto cachedEntry = std::ranges::find_if(_cache, [&](const CacheEntry& entry) { return entry.filename == filename; });
+	if(cachedEntry != _cache.end())
+	{
+		// move the entry to the front, so the least recently used entry is always at the back.
+		std::rotate(_cache.begin(), cachedEntry, cachedEntry + 1);
+		if(_cache.front().lastWriteTime == lastWriteTime)
+		{
+			error = _cache.front().error;
+			return _cache.front().mask;
+		}
+		_cache.erase(_cache.begin());
+	}
+
+	CacheEntry newEntry;
+	newEntry.filename = filename;
+	newEntry.lastWriteTime = lastWriteTime;
+	newEntry.mask = DepthOfFieldApertureMask::load(filename, newEntry.error);
+	if(_cache.size() >= MAX_NUMBER_OF_CACHED_MASKS)
+	{
+		_cache.pop_back();
+	}
+	_cache.insert(_cache.begin(), newEntry);
+	error = newEntry.error;
+	return newEntry.mask;
+}
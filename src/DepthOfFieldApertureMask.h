@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A grayscale aperture mask, prepared for importance sampling: the transmission per pixel (0.0-1.0) plus a 2D CDF, so a marginal CDF over the rows
+/// and a conditional CDF over the columns per row. Samples are taken with a piecewise constant density proportional to the square root of the
+/// transmission and get the rest of the transmission as their weight. Sampling proportional to the transmission itself would leave dim areas of
+/// the mask with hardly any samples, while sampling uniformly would waste samples on them, this is the middle ground. Positions are normalized to the
+/// bokeh, so the farthest transmitting pixel corner from the image center is at radius 1.0, and y is up.
+/// </summary>
+class DepthOfFieldApertureMask
+{
+public:
+	/// <summary>
+	/// Loads the mask from a binary PGM (P5) or PPM (P6) file. Color images are converted to luminance. Masks larger than MAX_MASK_SIZE on their
+	/// longest side are downsampled with a box filter, as a finer mask doesn't add anything to a pattern of at most a few thousand samples.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="error">receives the reason if the mask couldn't be loaded</param>
+	/// <returns>the mask or nullptr if it couldn't be loaded or has no transmitting pixels</returns>
+	static std::shared_ptr<const DepthOfFieldApertureMask> load(const std::string& filename, std::string& error);
+
+	/// <summary>
+	/// Takes numberOfSamples stratified samples: the points of the R2 low discrepancy sequence are mapped through the inverse of the CDF, so every
+	/// region of the mask receives samples proportional to its density, without clumping. The weight per sample is the transmission divided by the
+	/// density of its pixel. The weights aren't normalized.
+	/// </summary>
+	void createSamples(int numberOfSamples, std::vector<float>& x, std::vector<float>& y, std::vector<float>& weights) const;
+
+	static constexpr int MAX_MASK_SIZE = 256;
+
+private:
+	DepthOfFieldApertureMask() = default;
+
+	/// <summary>
+	/// Calculates the CDFs and the scale from pixels to normalized positions. 
+	/// </summary>
+	/// <returns>false if there are no transmitting pixels</returns>
+	bool calculateDistribution();
+
+	int _width = 0;
+	int _height = 0;
+	std::vector<float> _transmission;		// per pixel, top-down
+	std::vector<float> _rowCdf;				// per row, the normalized cumulative density up to and including that row
+	std::vector<float> _columnCdfs;			// per pixel, the normalized cumulative density in its row up to and including that pixel
+	float _pixelToNormalizedScale = 1.0f;
+};
+
+
+/// <summary>
+/// Cache of loaded aperture masks, keyed by filename. A mask is reloaded when its file has been written to since it was loaded.
+/// </summary>
+class DepthOfFieldApertureMaskCache
+{
+public:
+	/// <summary>
+	/// Gets the mask for the filename specified, from the cache if the file hasn't changed since it was loaded.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="error">receives the reason if the mask couldn't be loaded</param>
+	/// <returns>the mask or nullptr if it couldn't be loaded</returns>
+	std::shared_ptr<const DepthOfFieldApertureMask> getMask(const std::string& filename, std::string& error);
+
+private:
+	struct CacheEntry
+	{
+		std::string filename;
+		std::filesystem::file_time_type lastWriteTime;
+		std::shared_ptr<const DepthOfFieldApertureMask> mask;
+		std::string error;
+	};
+
+	static constexpr size_t MAX_NUMBER_OF_CACHED_MASKS = 4;
+	std::vector<CacheEntry> _cache;		// most recently used first
+};
@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldCapture.h"
+#include "ImageFileIO.h"
+#include "Utils.h"
+#include <direct.h>
+
+bool DepthOfFieldCaptureManifest::load(const std::string& captureFolder)
+{
+	FILE* inFile = nullptr;
+	const std::string filename = captureFolder + "\\" + FILENAME;
+	if(fopen_s(&inFile, filename.c_str(), "r") != 0 || nullptr == inFile)
+	{
+		return false;
+	}
+	Steps.clear();
+	Settings.BracketFocusDeltas.clear();
+	int version = 0;
+	int cateyeVignette = 0;
+	bool success = fscanf_s(inFile, " IgcsDofCapture %d", &version) == 1 && version == VERSION &&
+				   fscanf_s(inFile, " Width %d Height %d NumberOfSteps %d", &Settings.Width, &Settings.Height, &Settings.NumberOfSteps) == 3 &&
+				   fscanf_s(inFile, " FocusDelta %f HighlightBoost %f HighlightGammaFactor %f", &Settings.FocusDelta, &Settings.HighlightBoost, &Settings.HighlightGammaFactor) == 3 &&
+				   fscanf_s(inFile, " CateyeRadiusStart %f CateyeRadiusEnd %f CateyeIntensity %f CateyeVignette %d", &Settings.CateyeRadiusStart, &Settings.CateyeRadiusEnd,
+							&Settings.CateyeIntensity, &cateyeVignette) == 4;
+	Settings.CateyeVignette = cateyeVignette != 0;
+	int numberOfBracketFocusDeltas = 0;
+	success = success && fscanf_s(inFile, " BracketFocusDeltas %d", &numberOfBracketFocusDeltas) == 1 && numberOfBracketFocusDeltas >= 0;
+	for(int i = 0; success && i < numberOfBracketFocusDeltas; i++)
+	{
+		float bracketFocusDelta = 0.0f;
+		success = fscanf_s(inFile, " %f", &bracketFocusDelta) == 1;
+		Settings.BracketFocusDeltas.push_back(bracketFocusDelta);
+	}
+	while(success)
+	{
+		DepthOfFieldCapturedStep step;
+		char stepFilename[256] = {};
+		if(fscanf_s(inFile, " Step %d %255s %f %f %f %f %f %f %f", &step.StepIndex, stepFilename, (unsigned)sizeof(stepFilename), &step.XAlignmentDelta, &step.YAlignmentDelta,
+					&step.SampleWeightRGB[0], &step.SampleWeightRGB[1], &step.SampleWeightRGB[2], &step.XSamplePosition, &step.YSamplePosition) != 9)
+		{
+			// end of the file, or a line which was only partially written when the capture was interrupted.
+			break;
+		}
+		step.Filename = stepFilename;
+		Steps.push_back(step);
+	}
+	fclose(inFile);
+	return success && Settings.Width > 0 && Settings.Height > 0;
+}
+
+
+DepthOfFieldFrameWriter::~DepthOfFieldFrameWriter()
+{
+	cancel();
+}
+
+
+bool DepthOfFieldFrameWriter::start(const std::string& captureFolder, const DepthOfFieldCaptureSettings& settings)
+{
+	if(_isRunning)
+	{
+		return false;
+	}
+	stopThread();		// joins a thread which ended by itself after a previous render.
+
+	_mkdir(captureFolder.c_str());
+	const std::string manifestFilename = captureFolder + "\\" + DepthOfFieldCaptureManifest::FILENAME;
+	if(fopen_s(&_manifestFile, manifestFilename.c_str(), "w") != 0 || nullptr == _manifestFile)
+	{
+		_manifestFile = nullptr;
+		return false;
+	}
+	// %.9g round trips floats exactly, so the compositor uses the same values the shader would have.
+	fprintf(_manifestFile, "IgcsDofCapture %d\nWidth %d\nHeight %d\nNumberOfSteps %d\n", DepthOfFieldCaptureManifest::VERSION, settings.Width, settings.Height, settings.NumberOfSteps);
+	fprintf(_manifestFile, "FocusDelta %.9g\nHighlightBoost %.9g\nHighlightGammaFactor %.9g\n", settings.FocusDelta, settings.HighlightBoost, settings.HighlightGammaFactor);
+	fprintf(_manifestFile, "CateyeRadiusStart %.9g\nCateyeRadiusEnd %.9g\nCateyeIntensity %.9g\nCateyeVignette %d\n", settings.CateyeRadiusStart, settings.CateyeRadiusEnd,
+			settings.CateyeIntensity, settings.CateyeVignette ? 1 : 0);
+	fprintf(_manifestFile, "BracketFocusDeltas %d", (int)settings.BracketFocusDeltas.size());
+	for(const float bracketFocusDelta : settings.BracketFocusDeltas)
+	{
+		fprintf(_manifestFile, " %.9g", bracketFocusDelta);
+	}
+	fprintf(_manifestFile, "\n");
+	fflush(_manifestFile);
+
+	_captureFolder = captureFolder;
+	_width = settings.Width;
+	_height = settings.Height;
+	_pendingFrames.clear();
+	_finishRequested = false;
+	_numberOfFramesWritten = 0;
+	_hasWriteErrors = false;
+	_isRunning = true;
+	_writerThread = std::thread(&DepthOfFieldFrameWriter::writeFrames, this);
+	return true;
+}
+
+
+void DepthOfFieldFrameWriter::addFrame(std::vector<uint8_t> rgbaData, DepthOfFieldCapturedStep step)
+{
+	{
+		std::scoped_lock lock(_queueMutex);
+		if(!_isRunning || _finishRequested)
+		{
+			return;
+		}
+		_pendingFrames.push_back({ std::move(rgbaData), std::move(step) });
+	}
+	_queueCondition.notify_one();
+}
+
+
+void DepthOfFieldFrameWriter::finish()
+{
+	{
+		std::scoped_lock lock(_queueMutex);
+		_finishRequested = true;
+	}
+	_queueCondition.notify_one();
+}
+
+
+void DepthOfFieldFrameWriter::cancel()
+{
+	{
+		std::scoped_lock lock(_queueMutex);
+		_pendingFrames.clear();
+		_finishRequested = true;
+	}
+	_queueCondition.notify_one();
+	stopThread();
+}
+
+
+bool DepthOfFieldFrameWriter::isBacklogFull()
+{
+	std::scoped_lock lock(_queueMutex);
+	return _pendingFrames.size() >= MAX_NUMBER_OF_PENDING_FRAMES;
+}
+
+
+void DepthOfFieldFrameWriter::stopThread()
+{
+	if(_writerThread.joinable())
+	{
+		_writerThread.join();
+	}
+}
+
+
+void DepthOfFieldFrameWriter::writeFrames()
+{
+	while(true)
+	{
+		PendingFrame frame;
+		{
+			std::unique_lock lock(_queueMutex);
+			_queueCondition.wait(lock, [this] { return _finishRequested || !_pendingFrames.empty(); });
+			if(_pendingFrames.empty())
+			{
+				// finish requested and nothing left to write
+				break;
+			}
+			frame = std::move(_pendingFrames.front());
+			_pendingFrames.pop_front();
+		}
+
+		if(frame.data.size() < (size_t)_width * _height * 4)
+		{
+			_hasWriteErrors = true;
+			continue;
+		}
+		// Alpha is of no use, so we pack the RGBA data as RGB data in place, like the screenshot controller does.
+		for(size_t i = 0; i < (size_t)_width * _height; ++i)
+		{
+			frame.data[(3 * i) + 0] = frame.data[(4 * i) + 0];
+			frame.data[(3 * i) + 1] = frame.data[(4 * i) + 1];
+			frame.data[(3 * i) + 2] = frame.data[(4 * i) + 2];
+		}
+		if(!IGCS::ImageFileIO::writePpm(_captureFolder + "\\" + frame.step.Filename, frame.data.data(), _width, _height))
+		{
+			_hasWriteErrors = true;
+			continue;
+		}
+		// only now the frame is on disk, it's added to the manifest.
+		fprintf(_manifestFile, "Step %d %s %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n", frame.step.StepIndex, frame.step.Filename.c_str(), frame.step.XAlignmentDelta, frame.step.YAlignmentDelta,
+				frame.step.SampleWeightRGB[0], frame.step.SampleWeightRGB[1], frame.step.SampleWeightRGB[2], frame.step.XSamplePosition, frame.step.YSamplePosition);
+		fflush(_manifestFile);
+		_numberOfFramesWritten++;
+	}
+	fclose(_manifestFile);
+	_manifestFile = nullptr;
+	_isRunning = false;
+}
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// The shader values which are constant for all frames of a depth of field render. 
+/// </summary>
+struct DepthOfFieldCaptureSettings
+{
+	int Width = 0;
+	int Height = 0;
+	int NumberOfSteps = 0;
+	float FocusDelta = 0.0f;
+	float HighlightBoost = 0.0f;
+	float HighlightGammaFactor = 2.2f;
+	float CateyeRadiusStart = 0.0f;
+	float CateyeRadiusEnd = 0.0f;
+	float CateyeIntensity = 0.0f;
+	bool CateyeVignette = false;
+	std::vector<float> BracketFocusDeltas;		// additional focus deltas the compositor produces a result for from the same frames
+};
+
+/// <summary>
+/// A captured frame of a depth of field render, with the values the shader would have used to blend it.
+/// </summary>
+struct DepthOfFieldCapturedStep
+{
+	int StepIndex = 0;
+	std::string Filename;			// relative to the capture folder
+	float XAlignmentDelta = 0.0f;
+	float YAlignmentDelta = 0.0f;
+	float SampleWeightRGB[3] = { 1.0f, 1.0f, 1.0f };		// as passed to the shader, so already multiplied with the number of steps
+	float XSamplePosition = 0.0f;		// position in the normalized sample pattern, to calculate the alignment deltas for other focus deltas
+	float YSamplePosition = 0.0f;
+};
+
+/// <summary>
+/// The manifest of a capture folder. It's a text file with the settings as the header and a line per captured frame, which is appended after the frame
+/// has been written, so the manifest always describes the frames which are completely on disk, even if the capture was interrupted.
+/// </summary>
+struct DepthOfFieldCaptureManifest
+{
+	DepthOfFieldCaptureSettings Settings;
+	std::vector<DepthOfFieldCapturedStep> Steps;
+
+	static constexpr const char* FILENAME = "IgcsDofCapture.txt";
+	static constexpr int VERSION = 1;
+
+	/// <summary>
+	/// Loads the manifest in the capture folder specified.
+	/// </summary>
+	/// <returns>true if the manifest was read successfully, false otherwise</returns>
+	bool load(const std::string& captureFolder);
+};
+
+/// <summary>
+/// Writes captured frames of an offline depth of field render as PPM files on a background thread, so the game isn't stalled by disk I/O, and maintains
+/// the capture manifest. The number of frames waiting to be written is limited by the caller using isBacklogFull, as every frame is a full copy of the framebuffer.
+/// </summary>
+class DepthOfFieldFrameWriter
+{
+public:
+	DepthOfFieldFrameWriter() = default;
+	~DepthOfFieldFrameWriter();
+
+	/// <summary>
+	/// Creates the capture folder, writes the manifest header and starts the writer thread.
+	/// </summary>
+	/// <returns>true if the writer was started, false if the folder or manifest couldn't be created or the writer is already running</returns>
+	bool start(const std::string& captureFolder, const DepthOfFieldCaptureSettings& settings);
+	/// <summary>
+	/// Queues the RGBA framebuffer data specified (as returned by capture_screenshot) to be written as the frame for the step specified.
+	/// </summary>
+	void addFrame(std::vector<uint8_t> rgbaData, DepthOfFieldCapturedStep step);
+	/// <summary>
+	/// Signals no more frames will be added. The writer thread ends after the frames queued have been written.
+	/// </summary>
+	void finish();
+	/// <summary>
+	/// Stops the writer, discarding the frames which haven't been written yet. Blocks till the writer thread has ended.
+	/// </summary>
+	void cancel();
+
+	bool isBacklogFull();
+	/// <summary>
+	/// Returns true if finish has been called and all frames have been written (or the writer was never started).
+	/// </summary>
+	bool isDone() { return !_isRunning; }
+	int getNumberOfFramesWritten() { return _numberOfFramesWritten; }
+	bool hasWriteErrors() { return _hasWriteErrors; }
+	std::string getCaptureFolder() { return _captureFolder; }
+
+private:
+	struct PendingFrame
+	{
+		std::vector<uint8_t> data;
+		DepthOfFieldCapturedStep step;
+	};
+
+	void writeFrames();
+	void stopThread();
+
+	static constexpr int MAX_NUMBER_OF_PENDING_FRAMES = 8;
+
+	std::string _captureFolder;
+	int _width = 0;
+	int _height = 0;
+	FILE* _manifestFile = nullptr;
+	std::thread _writerThread;
+	std::mutex _queueMutex;
+	std::condition_variable _queueCondition;
+	std::deque<PendingFrame> _pendingFrames;
+	bool _finishRequested = false;
+	std::atomic<bool> _isRunning = false;
+	std::atomic<int> _numberOfFramesWritten = 0;
+	std::atomic<bool> _hasWriteErrors = false;
+};
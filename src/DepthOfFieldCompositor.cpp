@@ -0,0 +1,593 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldCompositor.h"
+#include "DepthOfFieldCapture.h"
+#include "ImageFileIO.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <vector>
+#include <xmmintrin.h>
+
+RowBandWorkerPool::~RowBandWorkerPool()
+{
+	{
+		std::scoped_lock lock(_bandMutex);
+		_stopRequested = true;
+	}
+	_bandsAvailableCondition.notify_all();
+	for(auto& worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+
+void RowBandWorkerPool::run(int height, const std::function<void(int, int)>& func)
+{
+	if(height <= 0)
+	{
+		return;
+	}
+	const int numberOfThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+	if(_workers.empty())
+	{
+		// the calling thread is one of the threads processing bands.
+		for(int i = 1; i < numberOfThreads; i++)
+		{
+			_workers.emplace_back(&RowBandWorkerPool::processBands, this);
+		}
+	}
+	const int numberOfBands = std::min(numberOfThreads, height);
+	std::unique_lock lock(_bandMutex);
+	_func = &func;
+	_height = height;
+	_rowsPerBand = (height + numberOfBands - 1) / numberOfBands;
+	_nextRowStart = 0;
+	_numberOfBandsPending = (height + _rowsPerBand - 1) / _rowsPerBand;
+	_bandsAvailableCondition.notify_all();
+	while(_nextRowStart < _height)
+	{
+		processBand(lock);
+	}
+	_bandsDoneCondition.wait(lock, [this] { return _numberOfBandsPending == 0; });
+	_func = nullptr;
+}
+
+
+void RowBandWorkerPool::processBands()
+{
+	std::unique_lock lock(_bandMutex);
+	while(true)
+	{
+		_bandsAvailableCondition.wait(lock, [this] { return _stopRequested || (nullptr != _func && _nextRowStart < _height); });
+		if(_stopRequested)
+		{
+			return;
+		}
+		processBand(lock);
+	}
+}
+
+
+void RowBandWorkerPool::processBand(std::unique_lock<std::mutex>& lock)
+{
+	// takes the next band and runs the function for it without holding the lock.
+	const int rowStart = _nextRowStart;
+	const int rowEnd = std::min(rowStart + _rowsPerBand, _height);
+	_nextRowStart = rowEnd;
+	const std::function<void(int, int)>& func = *_func;
+	lock.unlock();
+	func(rowStart, rowEnd);
+	lock.lock();
+	_numberOfBandsPending--;
+	if(0 == _numberOfBandsPending)
+	{
+		_bandsDoneCondition.notify_all();
+	}
+}
+
+
+namespace
+{
+	// All constants and formulas below mirror IgcsDof.fx, so keep them in sync.
+	constexpr float CONE_OVERLAP_K = 0.4f * 0.33f;
+
+	struct LoadedFrame
+	{
+		std::vector<uint8_t> rgbData;
+		int width = 0;
+		int height = 0;
+		bool isLoaded = false;
+	};
+
+
+	LoadedFrame loadFrame(const std::string& filename)
+	{
+		LoadedFrame toReturn;
+		toReturn.isLoaded = IGCS::ImageFileIO::readPpm(filename, toReturn.rgbData, toReturn.width, toReturn.height);
+		return toReturn;
+	}
+
+
+	float linearstep(float lo, float hi, float x)
+	{
+		if(hi == lo)
+		{
+			return x >= lo ? 1.0f : 0.0f;
+		}
+		return std::clamp((x - lo) / (hi - lo), 0.0f, 1.0f);
+	}
+
+
+	/// <summary>
+	/// The feathered cutoff of the bokeh disc: smoothstep(1.0, 0.98, length)
+	/// </summary>
+	float calculateCateyeMask(float offsetX, float offsetY)
+	{
+		const float t = std::clamp((sqrtf((offsetX * offsetX) + (offsetY * offsetY)) - 1.0f) / (0.98f - 1.0f), 0.0f, 1.0f);
+		return t * t * (3.0f - (2.0f * t));
+	}
+
+
+	/// <summary>
+	/// AccentuateWhites: converts the 8 bit frame to HDR, 4 floats per pixel with 0 in the 4th, so the accumulation can use aligned SSE loads.
+	/// </summary>
+	void calculateHdrFrame(RowBandWorkerPool& workerPool, const LoadedFrame& frame, const DepthOfFieldCaptureSettings& settings, std::vector<float>& hdrFrame)
+	{
+		const float diagonal = 1.0f - (2.0f * CONE_OVERLAP_K);
+		workerPool.run(frame.height, [&](int rowStart, int rowEnd)
+		{
+			for(int y = rowStart; y < rowEnd; y++)
+			{
+				const uint8_t* source = frame.rgbData.data() + ((size_t)y * frame.width * 3);
+				float* destination = hdrFrame.data() + ((size_t)y * frame.width * 4);
+				for(int x = 0; x < frame.width; x++)
+				{
+					const float r = (float)source[(x * 3) + 0] / 255.0f;
+					const float g = (float)source[(x * 3) + 1] / 255.0f;
+					const float b = (float)source[(x * 3) + 2] / 255.0f;
+					const float coneOverlapped[3] = { (diagonal * r) + (CONE_OVERLAP_K * g) + (CONE_OVERLAP_K * b),
+													  (CONE_OVERLAP_K * r) + (diagonal * g) + (CONE_OVERLAP_K * b),
+													  (CONE_OVERLAP_K * r) + (CONE_OVERLAP_K * g) + (diagonal * b) };
+					for(int channel = 0; channel < 3; channel++)
+					{
+						const float fragment = powf(fabsf(coneOverlapped[channel]), settings.HighlightGammaFactor);
+						destination[(x * 4) + channel] = fragment / std::max(1.001f - (settings.HighlightBoost * fragment), 0.001f);
+					}
+					destination[(x * 4) + 3] = 0.0f;
+				}
+			}
+		});
+	}
+
+
+	/// <summary>
+	/// The part of the cateye offset which only depends on the pixel location. Only needed if the cateye intensity isn't 0.
+	/// </summary>
+	void calculateCateyePixelOffsets(RowBandWorkerPool& workerPool, const DepthOfFieldCaptureSettings& settings, std::vector<float>& cateyeOffsets)
+	{
+		const float aspectRatio = (float)settings.Width / (float)settings.Height;
+		const float cornerLength = sqrtf((1.0f / (aspectRatio * aspectRatio)) + 1.0f);
+		const float pixelSizeX = 1.0f / (float)settings.Width;
+		const float pixelSizeY = 1.0f / (float)settings.Height;
+		cateyeOffsets.resize((size_t)settings.Width * settings.Height * 2);
+		workerPool.run(settings.Height, [&](int rowStart, int rowEnd)
+		{
+			for(int y = rowStart; y < rowEnd; y++)
+			{
+				for(int x = 0; x < settings.Width; x++)
+				{
+					float offsetX = ((((float)x + 0.5f) * pixelSizeX) * 2.0f) - 1.0f;
+					float offsetY = (((((float)y + 0.5f) * pixelSizeY) * 2.0f) - 1.0f) / aspectRatio;
+					offsetX /= cornerLength;
+					offsetY /= cornerLength;
+					const float distanceFromCenter = sqrtf((offsetX * offsetX) + (offsetY * offsetY));
+					const float scale = linearstep(settings.CateyeRadiusStart, settings.CateyeRadiusEnd, distanceFromCenter) * sqrtf(2.0f) * settings.CateyeIntensity /
+										std::max(1e-6f, distanceFromCenter);
+					cateyeOffsets[(((size_t)y * settings.Width) + x) * 2] = offsetX * scale;
+					cateyeOffsets[((((size_t)y * settings.Width) + x) * 2) + 1] = offsetY * scale;
+				}
+			}
+		});
+	}
+
+
+	/// <summary>
+	/// A focus plane to composite: the one of the render itself or one of the bracket focus deltas. All planes are accumulated from the same frames,
+	/// every plane reads them at its own alignment delta.
+	/// </summary>
+	struct FocusPlane
+	{
+		float FocusDelta = 0.0f;
+		bool IsBracket = false;
+		std::vector<float> AccumulationBuffer;
+	};
+
+
+	/// <summary>
+	/// The alignment delta of a frame for a focus plane, and the sample position the shader derives from it for the cateye mask.
+	/// </summary>
+	struct FrameAlignment
+	{
+		float XAlignmentDelta = 0.0f;
+		float YAlignmentDelta = 0.0f;
+		float NormalizedOffsetX = 0.0f;
+		float NormalizedOffsetY = 0.0f;
+	};
+
+
+	FrameAlignment calculateFrameAlignment(const DepthOfFieldCapturedStep& step, const FocusPlane& plane)
+	{
+		FrameAlignment toReturn;
+		if(plane.IsBracket)
+		{
+			// same as DepthOfFieldController::calculateShapePoints does for the focus delta of the render.
+			toReturn.XAlignmentDelta = step.XSamplePosition * -(plane.FocusDelta / 2.0f);
+			toReturn.YAlignmentDelta = step.YSamplePosition * (plane.FocusDelta / 2.0f);
+		}
+		else
+		{
+			// the values the shader would have received
+			toReturn.XAlignmentDelta = step.XAlignmentDelta;
+			toReturn.YAlignmentDelta = step.YAlignmentDelta;
+		}
+		// the shader divides by FocusDelta, which results in NaN for the center sample if it's 0. We treat that as 'no cateye offset' instead.
+		if(fabsf(plane.FocusDelta) > 0.0f)
+		{
+			toReturn.NormalizedOffsetX = (toReturn.XAlignmentDelta / plane.FocusDelta) * 2.0f;
+			toReturn.NormalizedOffsetY = (toReturn.YAlignmentDelta / plane.FocusDelta) * 2.0f;
+		}
+		return toReturn;
+	}
+
+
+	/// <summary>
+	/// Blends the HDR frame into the accumulation buffers of the focus planes (rgb: weighted sum, a: sum of the masks), like the shader does when BlendFrame
+	/// is true. Every thread handles all planes for its band of rows, so the rows of the frame it reads stay in its cache.
+	/// </summary>
+	void accumulateFrame(RowBandWorkerPool& workerPool, const std::vector<float>& hdrFrame, const DepthOfFieldCapturedStep& step, const float (&sampleWeightRGB)[3], const DepthOfFieldCaptureSettings& settings,
+						 const std::vector<float>& cateyeOffsets, std::vector<FocusPlane>& focusPlanes)
+	{
+		const int width = settings.Width;
+		const int height = settings.Height;
+		const float pixelSizeX = 1.0f / (float)width;
+		const float pixelSizeY = 1.0f / (float)height;
+		const float aspectRatio = pixelSizeY / pixelSizeX;
+		const bool useCateyePixelOffsets = !cateyeOffsets.empty();
+		const __m128 sampleWeights = _mm_setr_ps(sampleWeightRGB[0], sampleWeightRGB[1], sampleWeightRGB[2], 0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		std::vector<FrameAlignment> alignments;
+		for(const auto& plane : focusPlanes)
+		{
+			alignments.push_back(calculateFrameAlignment(step, plane));
+		}
+
+		workerPool.run(height, [&](int rowStart, int rowEnd)
+		{
+			auto fetch = [&](int x, int y)
+			{
+				// tex2Dfetch returns 0 outside the texture
+				return (x < 0 || y < 0 || x >= width || y >= height) ? zero : _mm_loadu_ps(hdrFrame.data() + ((((size_t)y * width) + x) * 4));
+			};
+
+			for(size_t planeIndex = 0; planeIndex < focusPlanes.size(); planeIndex++)
+			{
+				const FrameAlignment& alignment = alignments[planeIndex];
+				const float frameCateyeMask = calculateCateyeMask(alignment.NormalizedOffsetX, alignment.NormalizedOffsetY);
+				std::vector<float>& accumulationBuffer = focusPlanes[planeIndex].AccumulationBuffer;
+				for(int y = rowStart; y < rowEnd; y++)
+				{
+					const float v = ((float)y + 0.5f) * pixelSizeY;
+					const float readV = v + (alignment.YAlignmentDelta * aspectRatio);
+					if(readV <= 0.0f || readV >= 1.0f)
+					{
+						// outside: the shader blends 0 for rgb and alpha.
+						continue;
+					}
+					const float gridV = (readV * (float)height) - 0.5f;
+					const int gridStartY = (int)gridV;
+					const float fractionY = gridV - floorf(gridV);
+					float* accumulationRow = accumulationBuffer.data() + ((size_t)y * width * 4);
+					for(int x = 0; x < width; x++)
+					{
+						const float u = ((float)x + 0.5f) * pixelSizeX;
+						const float readU = u + alignment.XAlignmentDelta;
+						if(readU <= 0.0f || readU >= 1.0f)
+						{
+							continue;
+						}
+						// ReadHDRInput: bilinear interpolation of the HDR converted texels. The int conversion truncates like the shader's int2() does.
+						const float gridU = (readU * (float)width) - 0.5f;
+						const int gridStartX = (int)gridU;
+						const float fractionX = gridU - floorf(gridU);
+						__m128 sample = _mm_mul_ps(fetch(gridStartX, gridStartY), _mm_set1_ps((1.0f - fractionX) * (1.0f - fractionY)));
+						sample = _mm_add_ps(sample, _mm_mul_ps(fetch(gridStartX + 1, gridStartY), _mm_set1_ps(fractionX * (1.0f - fractionY))));
+						sample = _mm_add_ps(sample, _mm_mul_ps(fetch(gridStartX, gridStartY + 1), _mm_set1_ps((1.0f - fractionX) * fractionY)));
+						sample = _mm_add_ps(sample, _mm_mul_ps(fetch(gridStartX + 1, gridStartY + 1), _mm_set1_ps(fractionX * fractionY)));
+
+						float cateyeMask = frameCateyeMask;
+						if(useCateyePixelOffsets)
+						{
+							const size_t offsetIndex = (((size_t)y * width) + x) * 2;
+							cateyeMask = calculateCateyeMask(alignment.NormalizedOffsetX + cateyeOffsets[offsetIndex], alignment.NormalizedOffsetY + cateyeOffsets[offsetIndex + 1]);
+						}
+						const float alpha = settings.CateyeVignette ? 1.0f : cateyeMask;
+						__m128 result = _mm_mul_ps(sample, _mm_mul_ps(sampleWeights, _mm_set1_ps(cateyeMask)));
+						result = _mm_add_ps(result, _mm_setr_ps(0.0f, 0.0f, 0.0f, alpha));
+						float* accumulationPixel = accumulationRow + (x * 4);
+						_mm_storeu_ps(accumulationPixel, _mm_add_ps(_mm_loadu_ps(accumulationPixel), result));
+					}
+				}
+			}
+		});
+	}
+
+
+	/// <summary>
+	/// Divides the accumulated color by the accumulated alpha and applies CorrectForWhiteAccentuation. Pixels which never received a sample become black,
+	/// like the saturate of the shader does with the NaN it produces.
+	/// </summary>
+	void resolveAccumulation(RowBandWorkerPool& workerPool, const std::vector<float>& accumulationBuffer, const DepthOfFieldCaptureSettings& settings, std::vector<float>& rgbResult)
+	{
+		const float inverseCoefficient = 1.0f / ((3.0f * CONE_OVERLAP_K) - 1.0f);
+		const float inverseDiagonal = (CONE_OVERLAP_K - 1.0f) * inverseCoefficient;
+		const float inverseOffDiagonal = CONE_OVERLAP_K * inverseCoefficient;
+		const float inverseGamma = 1.0f / settings.HighlightGammaFactor;
+		rgbResult.resize((size_t)settings.Width * settings.Height * 3);
+		workerPool.run(settings.Height, [&](int rowStart, int rowEnd)
+		{
+			for(size_t pixel = (size_t)rowStart * settings.Width; pixel < (size_t)rowEnd * settings.Width; pixel++)
+			{
+				const float* accumulated = accumulationBuffer.data() + (pixel * 4);
+				float* destination = rgbResult.data() + (pixel * 3);
+				if(accumulated[3] <= 0.0f)
+				{
+					destination[0] = destination[1] = destination[2] = 0.0f;
+					continue;
+				}
+				float toneMapped[3];
+				for(int channel = 0; channel < 3; channel++)
+				{
+					const float fragment = accumulated[channel] / accumulated[3];
+					toneMapped[channel] = powf(std::max(0.0f, fragment / (1.001f + (settings.HighlightBoost * fragment))), inverseGamma);
+				}
+				destination[0] = (inverseDiagonal * toneMapped[0]) + (inverseOffDiagonal * toneMapped[1]) + (inverseOffDiagonal * toneMapped[2]);
+				destination[1] = (inverseOffDiagonal * toneMapped[0]) + (inverseDiagonal * toneMapped[1]) + (inverseOffDiagonal * toneMapped[2]);
+				destination[2] = (inverseOffDiagonal * toneMapped[0]) + (inverseOffDiagonal * toneMapped[1]) + (inverseDiagonal * toneMapped[2]);
+			}
+		});
+	}
+
+
+	/// <summary>
+	/// Quantizes the result to 8 bits with the golden ratio dither of the shader.
+	/// </summary>
+	void quantizeWithDither(RowBandWorkerPool& workerPool, const std::vector<float>& rgbResult, int width, int height, std::vector<uint8_t>& rgbData)
+	{
+		constexpr uint32_t MAGIC_X = 3242174889u;
+		constexpr uint32_t MAGIC_Y = 2447445413u;
+		rgbData.resize((size_t)width * height * 3);
+		workerPool.run(height, [&](int rowStart, int rowEnd)
+		{
+			for(int y = rowStart; y < rowEnd; y++)
+			{
+				for(int x = 0; x < width; x++)
+				{
+					const uint32_t base = ((uint32_t)x * MAGIC_X) + ((uint32_t)y * MAGIC_Y);
+					const uint32_t ditherValues[3] = { base, base + ((MAGIC_X + MAGIC_Y) * 3u), base + ((MAGIC_X + MAGIC_Y) * 7u) };
+					const size_t pixelIndex = (((size_t)y * width) + x) * 3;
+					for(int channel = 0; channel < 3; channel++)
+					{
+						const float dither = (((float)ditherValues[channel] * exp2f(-32.0f)) - 0.5f) * 0.999f * exp2f(-8.0f);
+						const float value = std::clamp(rgbResult[pixelIndex + channel] + dither, 0.0f, 1.0f);
+						rgbData[pixelIndex + channel] = (uint8_t)((value * 255.0f) + 0.5f);
+					}
+				}
+			}
+		});
+	}
+
+
+	/// <summary>
+	/// Resolves the accumulation buffer specified and writes it as the output type specified, to the filename specified plus the extension of the type.
+	/// </summary>
+	bool writeResult(RowBandWorkerPool& workerPool, const std::vector<float>& accumulationBuffer, const DepthOfFieldCaptureSettings& settings, DepthOfFieldOfflineOutputType outputType,
+					 const std::string& filenameWithoutExtension, std::string& resultFilename)
+	{
+		std::vector<float> rgbResult;
+		resolveAccumulation(workerPool, accumulationBuffer, settings, rgbResult);
+		switch(outputType)
+		{
+			case DepthOfFieldOfflineOutputType::Exr:
+				resultFilename = filenameWithoutExtension + ".exr";
+				return IGCS::ImageFileIO::writeExr(resultFilename, rgbResult.data(), settings.Width, settings.Height);
+			case DepthOfFieldOfflineOutputType::Png:
+			default:
+				{
+					std::vector<uint8_t> rgbData;
+					quantizeWithDither(workerPool, rgbResult, settings.Width, settings.Height, rgbData);
+					resultFilename = filenameWithoutExtension + ".png";
+					return IGCS::ImageFileIO::writePng(resultFilename, rgbData.data(), settings.Width, settings.Height);
+				}
+		}
+	}
+}
+
+
+DepthOfFieldCompositor::~DepthOfFieldCompositor()
+{
+	_cancelRequested = true;
+	if(_compositionThread.joinable())
+	{
+		_compositionThread.join();
+	}
+}
+
+
+void DepthOfFieldCompositor::start(const std::string& captureFolder, DepthOfFieldOfflineOutputType outputType)
+{
+	bool expected = false;
+	if(!_isRunning.compare_exchange_strong(expected, true))
+	{
+		return;
+	}
+	if(_compositionThread.joinable())
+	{
+		// joins the thread of a previous composition, which has ended by itself.
+		_compositionThread.join();
+	}
+	_progress = 0.0f;
+	{
+		std::scoped_lock lock(_resultMutex);
+		_resultFilename = "";
+		_lastError = "";
+	}
+	_compositionThread = std::thread([this, captureFolder, outputType]()
+	{
+		std::string resultFilename;
+		std::string error;
+		compose(captureFolder, outputType, &_progress, resultFilename, error);
+		{
+			std::scoped_lock lock(_resultMutex);
+			_resultFilename = resultFilename;
+			_lastError = error;
+		}
+		_isRunning = false;
+	});
+}
+
+
+bool DepthOfFieldCompositor::compose(const std::string& captureFolder, DepthOfFieldOfflineOutputType outputType, std::atomic<float>* progress, std::string& resultFilename, std::string& error)
+{
+	DepthOfFieldCaptureManifest manifest;
+	if(!manifest.load(captureFolder))
+	{
+		error = "The capture manifest couldn't be read";
+		return false;
+	}
+	if(manifest.Steps.empty())
+	{
+		error = "The capture doesn't contain any frames";
+		return false;
+	}
+	const DepthOfFieldCaptureSettings& settings = manifest.Settings;
+
+	// The shader normalizes by the number of frames blended, and the weights passed to it sum to the total number of steps. If the capture is incomplete
+	// we scale the weights per channel so they sum to the number of frames we do have, so the result is still correctly exposed and tinted.
+	float sampleWeightSum[3] = { 0.0f, 0.0f, 0.0f };
+	for(const auto& step : manifest.Steps)
+	{
+		for(int channel = 0; channel < 3; channel++)
+		{
+			sampleWeightSum[channel] += step.SampleWeightRGB[channel];
+		}
+	}
+	float sampleWeightScale[3];
+	for(int channel = 0; channel < 3; channel++)
+	{
+		sampleWeightScale[channel] = sampleWeightSum[channel] > 0.0f ? (float)manifest.Steps.size() / sampleWeightSum[channel] : 1.0f;
+	}
+
+	// The render's own focus plane is the first, the bracket focus planes follow. Every plane needs a float4 buffer of the size of the frame.
+	const size_t numberOfPixels = (size_t)settings.Width * settings.Height;
+	std::vector<FocusPlane> focusPlanes(1 + settings.BracketFocusDeltas.size());
+	focusPlanes[0].FocusDelta = settings.FocusDelta;
+	for(size_t i = 0; i < settings.BracketFocusDeltas.size(); i++)
+	{
+		focusPlanes[i + 1].FocusDelta = settings.BracketFocusDeltas[i];
+		focusPlanes[i + 1].IsBracket = true;
+	}
+	for(auto& plane : focusPlanes)
+	{
+		plane.AccumulationBuffer.assign(numberOfPixels * 4, 0.0f);
+	}
+	std::vector<float> hdrFrame(numberOfPixels * 4);
+	std::vector<float> cateyeOffsets;
+	if(settings.CateyeIntensity != 0.0f)
+	{
+		calculateCateyePixelOffsets(_workerPool, settings, cateyeOffsets);
+	}
+
+	// the next frame is read from disk while the current one is processed.
+	std::future<LoadedFrame> nextFrame = std::async(std::launch::async, loadFrame, captureFolder + "\\" + manifest.Steps[0].Filename);
+	for(size_t i = 0; i < manifest.Steps.size(); i++)
+	{
+		const LoadedFrame frame = nextFrame.get();
+		if(_cancelRequested)
+		{
+			error = "The composition was cancelled";
+			return false;
+		}
+		if(i + 1 < manifest.Steps.size())
+		{
+			nextFrame = std::async(std::launch::async, loadFrame, captureFolder + "\\" + manifest.Steps[i + 1].Filename);
+		}
+		const DepthOfFieldCapturedStep& step = manifest.Steps[i];
+		if(!frame.isLoaded || frame.width != settings.Width || frame.height != settings.Height)
+		{
+			error = IGCS::Utils::formatString("Frame '%s' couldn't be read or has the wrong size", step.Filename.c_str());
+			return false;
+		}
+		const float sampleWeightRGB[3] = { step.SampleWeightRGB[0] * sampleWeightScale[0], step.SampleWeightRGB[1] * sampleWeightScale[1], step.SampleWeightRGB[2] * sampleWeightScale[2] };
+		calculateHdrFrame(_workerPool, frame, settings, hdrFrame);
+		accumulateFrame(_workerPool, hdrFrame, step, sampleWeightRGB, settings, cateyeOffsets, focusPlanes);
+		if(nullptr != progress)
+		{
+			*progress = 0.9f * (float)(i + 1) / (float)manifest.Steps.size();
+		}
+	}
+
+	bool success = writeResult(_workerPool, focusPlanes[0].AccumulationBuffer, settings, outputType, captureFolder + "\\IgcsDof", resultFilename);
+	for(size_t i = 1; success && i < focusPlanes.size(); i++)
+	{
+		if(nullptr != progress)
+		{
+			*progress = 0.9f + (0.1f * (float)i / (float)focusPlanes.size());
+		}
+		std::string bracketFilename;
+		success = writeResult(_workerPool, focusPlanes[i].AccumulationBuffer, settings, outputType, IGCS::Utils::formatString("%s\\IgcsDof-Bracket%d", captureFolder.c_str(), (int)i), bracketFilename);
+	}
+	if(!success)
+	{
+		error = "The result couldn't be written";
+	}
+	if(nullptr != progress)
+	{
+		*progress = 1.0f;
+	}
+	return success;
+}
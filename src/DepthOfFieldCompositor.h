@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConstantsEnums.h"
+
+/// <summary>
+/// Runs a function over bands of rows on a set of worker threads which are kept alive between calls, so the per frame passes of a composition don't
+/// create and join a thread per band. The calling thread processes bands as well. The workers are started on the first call and joined in the destructor.
+/// </summary>
+class RowBandWorkerPool
+{
+public:
+	RowBandWorkerPool() = default;
+	~RowBandWorkerPool();
+
+	/// <summary>
+	/// Calls the function specified for bands of rows, one band per hardware thread, and waits for all of them to complete. Has to be called from one thread at a time.
+	/// </summary>
+	void run(int height, const std::function<void(int, int)>& func);
+
+private:
+	void processBands();
+	void processBand(std::unique_lock<std::mutex>& lock);
+
+	std::vector<std::thread> _workers;
+	std::mutex _bandMutex;
+	std::condition_variable _bandsAvailableCondition;
+	std::condition_variable _bandsDoneCondition;
+	// the band state of the current run, guarded by _bandMutex
+	const std::function<void(int, int)>* _func = nullptr;
+	int _height = 0;
+	int _rowsPerBand = 0;
+	int _nextRowStart = 0;
+	int _numberOfBandsPending = 0;
+	bool _stopRequested = false;
+};
+
+/// <summary>
+/// Composites the frames of an offline depth of field capture (see DepthOfFieldFrameWriter) into the final image on the cpu. It reproduces the maths of
+/// IgcsDof.fx in float32 (HDR conversion of the input, bilinear read at the alignment delta, sample weights, cateye masking, normalization by the
+/// accumulated alpha and the conversion back), multithreaded and with SSE for the accumulation. The result is written as an 8 bit PNG with the shader's
+/// dither, or as a float EXR. It only depends on the files in the capture folder, so it can run on another machine as well.
+/// If the capture has bracket focus deltas, every frame is read once and accumulated for every focus plane, which results in an IgcsDof-Bracket<n>
+/// image per bracket focus delta next to the regular result. Every focus plane needs a float4 accumulation buffer the size of the frame.
+/// </summary>
+class DepthOfFieldCompositor
+{
+public:
+	DepthOfFieldCompositor() = default;
+	~DepthOfFieldCompositor();
+
+	/// <summary>
+	/// Starts the composition of the capture in the folder specified on a background thread. Does nothing if a composition is already running.
+	/// A composition still running when the compositor is destroyed is cancelled after the frame it's processing.
+	/// </summary>
+	void start(const std::string& captureFolder, DepthOfFieldOfflineOutputType outputType);
+	bool isRunning() { return _isRunning; }
+	float getProgress() { return _progress; }
+	std::string getResultFilename()
+	{
+		std::scoped_lock lock(_resultMutex);
+		return _resultFilename;
+	}
+	std::string getLastError()
+	{
+		std::scoped_lock lock(_resultMutex);
+		return _lastError;
+	}
+
+	/// <summary>
+	/// Composites the capture in the folder specified and writes the result, and the result of every bracket focus delta, to that folder. If not all steps
+	/// have been captured, the weights of the frames present are renormalized, so the result is still correctly exposed.
+	/// </summary>
+	/// <param name="captureFolder"></param>
+	/// <param name="outputType"></param>
+	/// <param name="progress">receives the progress, 0.0-1.0. Can be null</param>
+	/// <param name="resultFilename">receives the filename of the result of the render's own focus delta</param>
+	/// <param name="error">receives the error if the composition failed</param>
+	/// <returns>true if the result was written successfully, false otherwise</returns>
+	bool compose(const std::string& captureFolder, DepthOfFieldOfflineOutputType outputType, std::atomic<float>* progress, std::string& resultFilename, std::string& error);
+
+private:
+	RowBandWorkerPool _workerPool;
+	std::thread _compositionThread;
+	std::atomic<bool> _isRunning = false;
+	std::atomic<bool> _cancelRequested = false;
+	std::atomic<float> _progress = 0.0f;
+	std::mutex _resultMutex;
+	std::string _resultFilename;
+	std::string _lastError;
+};
@@ -38,9 +38,28 @@
 #include "Utils.h"
 #include <random>
 #include <algorithm>
+#include <chrono>
 #include "CDataFile.h"
 
-DepthOfFieldController::DepthOfFieldController(CameraToolsConnector& connector) : _cameraToolsConnector(connector), _state(DepthOfFieldControllerState::Off), _quality(4), _numberOfPointsInnermostRing(3)
+namespace
+{
+	// Order has to match DepthOfFieldShaderUniform
+	const std::vector<std::string> DOF_SHADER_UNIFORM_NAMES = { "SessionState", "FocusDelta", "BlendFrame", "BlendFactor", "AlignmentDelta", "HighlightBoost",
+																"SampleWeightR", "SampleWeightG", "SampleWeightB", "HighlightGammaFactor", "ShowMagnifier",
+																"MagnificationFactor", "MagnificationArea", "MagnificationLocationCenter", "CateyeVignette",
+																"CateyeRadiusStart", "CateyeRadiusEnd", "CateyeIntensity" };
+	// the progressive render order has a checkpoint every 1/NUMBER_OF_CHECKPOINTS of the samples, with at least MIN_CHECKPOINT_BLOCK_SIZE samples in between
+	constexpr int NUMBER_OF_CHECKPOINTS = 16;
+	constexpr int MIN_CHECKPOINT_BLOCK_SIZE = 8;
+	// the number of quality levels below and above the current one in the sample reduction report
+	constexpr int SAMPLE_REDUCTION_REPORT_RANGE = 4;
+	constexpr int MAX_QUALITY = 100;
+	// every bracket focus delta costs the compositor an accumulation buffer of 16 bytes per pixel
+	constexpr int MAX_NUMBER_OF_BRACKET_FOCUS_DELTAS = 8;
+}
+
+DepthOfFieldController::DepthOfFieldController(CameraToolsConnector& connector) : _cameraToolsConnector(connector), _state(DepthOfFieldControllerState::Off), _quality(4), _numberOfPointsInnermostRing(3),
+																				   _uniformTable("IgcsDof.fx", DOF_SHADER_UNIFORM_NAMES)
 {
 }
 
@@ -60,6 +79,10 @@ void DepthOfFieldController::setMaxBokehSize(reshade::api::effect_runtime* runti
 	{
 		const float ratio = _maxBokehSize / oldValue;
 		_focusDelta *= ratio;
+		for(float& bracketFocusDelta : _bracketFocusDeltas)
+		{
+			bracketFocusDelta *= ratio;
+		}
 	}
 	calculateShapePoints();
 
@@ -81,11 +104,41 @@ void DepthOfFieldController::setXFocusDelta(reshade::api::effect_runtime* runtim
 	calculateShapePoints();
 
 	// set the uniform in the shader for blending the new framebuffer so the user has visual feedback
-	setUniformFloatVariable(runtime, "FocusDelta", _focusDelta);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::FocusDelta, _focusDelta);
 	// the value is passed to the shader next present call
 }
 
 
+void DepthOfFieldController::addBracketFocusDelta(float newValue)
+{
+	if(_bracketFocusDeltas.size() >= MAX_NUMBER_OF_BRACKET_FOCUS_DELTAS)
+	{
+		return;
+	}
+	_bracketFocusDeltas.push_back(IGCS::Utils::clampEx(newValue, -1.0f, 1.0f));
+}
+
+
+void DepthOfFieldController::setBracketFocusDelta(int index, float newValue)
+{
+	if(index < 0 || index >= (int)_bracketFocusDeltas.size())
+	{
+		return;
+	}
+	_bracketFocusDeltas[index] = IGCS::Utils::clampEx(newValue, -1.0f, 1.0f);
+}
+
+
+void DepthOfFieldController::removeBracketFocusDelta(int index)
+{
+	if(index < 0 || index >= (int)_bracketFocusDeltas.size())
+	{
+		return;
+	}
+	_bracketFocusDeltas.erase(_bracketFocusDeltas.begin() + index);
+}
+
+
 void DepthOfFieldController::displayScreenshotSessionStartError(const ScreenshotSessionStartReturnCode sessionStartResult)
 {
 	std::string reason = "Unknown error.";
@@ -110,33 +163,48 @@ void DepthOfFieldController::displayScreenshotSessionStartError(const Screenshot
 
 void DepthOfFieldController::writeVariableStateToShader(reshade::api::effect_runtime* runtime)
 {
-	if(isReshadeStateEmpty())
 	{
-		std::scoped_lock lock(_reshadeStateMutex);
-		_reshadeStateAtStart.obtainReshadeState(runtime);
+		std::scoped_lock lock(_uniformTableMutex);
+		if(!_uniformTable.isResolved())
+		{
+			_uniformTable.resolve(runtime);
+		}
+		uint32_t width = 0;
+		uint32_t height = 0;
+		runtime->get_screenshot_width_and_height(&width, &height);
+		if(width != _runtimeWidth || height != _runtimeHeight)
+		{
+			// the runtime has been resized, which resets the values of the uniforms.
+			_uniformTable.invalidateCache();
+			_runtimeWidth = width;
+			_runtimeHeight = height;
+		}
+		_uniformTable.startBatch();
 	}
 
-	setUniformIntVariable(runtime, "SessionState", (int)_state);
-	setUniformFloatVariable(runtime, "FocusDelta", _focusDelta);
-	setUniformBoolVariable(runtime, "BlendFrame", _blendFrame);
-	setUniformFloatVariable(runtime, "BlendFactor", _blendFactor);
-	setUniformFloat2Variable(runtime, "AlignmentDelta", _xAlignmentDelta, _yAlignmentDelta);
-	setUniformFloatVariable(runtime, "HighlightBoost", _highlightBoostFactor);
-
-	setUniformFloatVariable(runtime, "SampleWeightR", _sampleWeightRGB[0]);
-	setUniformFloatVariable(runtime, "SampleWeightG", _sampleWeightRGB[1]);
-	setUniformFloatVariable(runtime, "SampleWeightB", _sampleWeightRGB[2]);
-
-	setUniformFloatVariable(runtime, "HighlightGammaFactor", _highlightGammaFactor);
-	setUniformBoolVariable(runtime, "ShowMagnifier", _magnificationSettings.ShowMagnifier);
-	setUniformFloatVariable(runtime, "MagnificationFactor", _magnificationSettings.MagnificationFactor);
-	setUniformFloat2Variable(runtime, "MagnificationArea", _magnificationSettings.WidthMagnifierArea, _magnificationSettings.HeightMagnifierArea);
-	setUniformFloat2Variable(runtime, "MagnificationLocationCenter", _magnificationSettings.XMagnifierLocation, _magnificationSettings.YMagnifierLocation);
-
-	setUniformBoolVariable(runtime, "CateyeVignette", _addCatEyeVignette);
-	setUniformFloatVariable(runtime, "CateyeRadiusStart", _catEyeRadiusStart);
-	setUniformFloatVariable(runtime, "CateyeRadiusEnd", _catEyeRadiusEnd);
-	setUniformFloatVariable(runtime, "CateyeIntensity", _catEyeBokehIntensity);
+	// When rendering offline, the shader has to leave the frames alone as they're captured, and there's no result to show afterwards either.
+	const bool shaderIsIdle = DepthOfFieldRenderMode::Offline == _renderMode && (DepthOfFieldControllerState::Rendering == _state || DepthOfFieldControllerState::Done == _state);
+	setUniformIntVariable(runtime, DepthOfFieldShaderUniform::SessionState, shaderIsIdle ? (int)DepthOfFieldControllerState::Off : (int)_state);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::FocusDelta, _focusDelta);
+	setUniformBoolVariable(runtime, DepthOfFieldShaderUniform::BlendFrame, _blendFrame);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::BlendFactor, _blendFactor);
+	setUniformFloat2Variable(runtime, DepthOfFieldShaderUniform::AlignmentDelta, _xAlignmentDelta, _yAlignmentDelta);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::HighlightBoost, _highlightBoostFactor);
+
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::SampleWeightR, _sampleWeightRGB[0]);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::SampleWeightG, _sampleWeightRGB[1]);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::SampleWeightB, _sampleWeightRGB[2]);
+
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::HighlightGammaFactor, _highlightGammaFactor);
+	setUniformBoolVariable(runtime, DepthOfFieldShaderUniform::ShowMagnifier, _magnificationSettings.ShowMagnifier);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::MagnificationFactor, _magnificationSettings.MagnificationFactor);
+	setUniformFloat2Variable(runtime, DepthOfFieldShaderUniform::MagnificationArea, _magnificationSettings.WidthMagnifierArea, _magnificationSettings.HeightMagnifierArea);
+	setUniformFloat2Variable(runtime, DepthOfFieldShaderUniform::MagnificationLocationCenter, _magnificationSettings.XMagnifierLocation, _magnificationSettings.YMagnifierLocation);
+
+	setUniformBoolVariable(runtime, DepthOfFieldShaderUniform::CateyeVignette, _addCatEyeVignette);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::CateyeRadiusStart, _catEyeRadiusStart);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::CateyeRadiusEnd, _catEyeRadiusEnd);
+	setUniformFloatVariable(runtime, DepthOfFieldShaderUniform::CateyeIntensity, _catEyeBokehIntensity);
 }
 
 
@@ -162,6 +230,8 @@ void DepthOfFieldController::loadIniFileData(CDataFile& iniFile)
 	loadIntFromIni(iniFile, "NumberOfFramesToWaitPerFrame", &_numberOfFramesToWait);
 	loadBoolFromIni(iniFile, "ShowProgressBarAsOverlay", &_showProgressBarAsOverlay, true);
 	loadBoolFromIni(iniFile, "AddCatEyeVignette", &_addCatEyeVignette, false);
+	loadBoolFromIni(iniFile, "MergeNegligibleSamples", &_mergeNegligibleSamples, false);
+	loadFloatFromIni(iniFile, "SampleMergeTolerance", &_sampleMergeTolerance);
 	loadFloatFromIni(iniFile, "CatEyeRadiusStart", &_catEyeRadiusStart);
 	loadFloatFromIni(iniFile, "CatEyeRadiusEnd", &_catEyeRadiusEnd);
 	loadFloatFromIni(iniFile, "CatEyeBokehIntensity", &_catEyeBokehIntensity);
@@ -171,6 +241,17 @@ void DepthOfFieldController::loadIniFileData(CDataFile& iniFile)
 	_blurType = (DepthOfFieldBlurType)intValueFromIni;
 	loadIntFromIni(iniFile, "CAType", &intValueFromIni);
 	_caType = (DepthOfFieldCAType)intValueFromIni;
+	intValueFromIni = (int)_renderMode;
+	loadIntFromIni(iniFile, "RenderMode", &intValueFromIni);
+	_renderMode = (DepthOfFieldRenderMode)intValueFromIni;
+	intValueFromIni = (int)_offlineOutputType;
+	loadIntFromIni(iniFile, "OfflineOutputType", &intValueFromIni);
+	_offlineOutputType = (DepthOfFieldOfflineOutputType)intValueFromIni;
+	const std::string apertureMaskFilename = iniFile.GetValue("ApertureMaskFilename", "DepthOfField");
+	if(!apertureMaskFilename.empty())
+	{
+		_apertureMaskFilename = apertureMaskFilename;
+	}
 }
 
 
@@ -201,6 +282,11 @@ void DepthOfFieldController::saveIniFileData(CDataFile& iniFile)
 	iniFile.SetFloat("CatEyeRadiusStart", _catEyeRadiusStart, "", "DepthOfField");
 	iniFile.SetFloat("CatEyeRadiusEnd", _catEyeRadiusEnd, "", "DepthOfField");
 	iniFile.SetFloat("CatEyeBokehIntensity", _catEyeBokehIntensity, "", "DepthOfField");
+	iniFile.SetBool("MergeNegligibleSamples", _mergeNegligibleSamples, "", "DepthOfField");
+	iniFile.SetFloat("SampleMergeTolerance", _sampleMergeTolerance, "", "DepthOfField");
+	iniFile.SetInt("RenderMode", (int)_renderMode, "", "DepthOfField");
+	iniFile.SetInt("OfflineOutputType", (int)_offlineOutputType, "", "DepthOfField");
+	iniFile.SetValue("ApertureMaskFilename", _apertureMaskFilename, "", "DepthOfField");
 }
 
 
@@ -220,14 +306,14 @@ void DepthOfFieldController::startSession(reshade::api::effect_runtime* runtime)
 	calculateShapePoints();
 
 	{
-		std::scoped_lock lock(_reshadeStateMutex);
-		_reshadeStateAtStart.obtainReshadeState(runtime);
+		std::scoped_lock lock(_uniformTableMutex);
+		_uniformTable.resolve(runtime);
 	}
 
 	// set uniform variable 'SessionState' to 1 (start)
 	_state = DepthOfFieldControllerState::Start;
 	_renderPaused = false;
-	setUniformIntVariable(runtime, "SessionState", (int)_state);
+	setUniformIntVariable(runtime, DepthOfFieldShaderUniform::SessionState, (int)_state);
 	// set framecounter to 3 so we wait 3 frames before moving on to 'Setup'
 	_onPresentWorkCounter = 3;	// wait 3 frames
 	_onPresentWorkFunc = [&](reshade::api::effect_runtime* r)
@@ -241,9 +327,15 @@ void DepthOfFieldController::startSession(reshade::api::effect_runtime* runtime)
 
 void DepthOfFieldController::endSession(reshade::api::effect_runtime* runtime)
 {
+	if(DepthOfFieldControllerState::Rendering == _state)
+	{
+		_renderTelemetry.logSummary(true);
+	}
 	_state = DepthOfFieldControllerState::Off;
 	_renderPaused = false;
-	setUniformIntVariable(runtime, "SessionState", (int)_state);
+	// frames captured but not yet written are of no use anymore. A composition in progress is left alone, it only depends on the files on disk.
+	_frameWriter.cancel();
+	setUniformIntVariable(runtime, DepthOfFieldShaderUniform::SessionState, (int)_state);
 
 	if(_cameraToolsConnector.cameraToolsConnected())
 	{
@@ -284,7 +376,7 @@ void DepthOfFieldController::reshadeBeginEffectsCalled(reshade::api::effect_runt
 
 	// Then make sure the shader knows our changed data...
 
-	// always write the variables, as otherwise they'll lose their value when the user e.g. hotsamples.
+	// always pass the variables, the uniform table only writes the ones which changed since the last write or since the last reload.
 	writeVariableStateToShader(runtime);
 }
 
@@ -298,426 +390,415 @@ void DepthOfFieldController::reshadeFinishEffectsCalled(reshade::api::effect_run
 
 	if(DepthOfFieldControllerState::Rendering == _state)
 	{
-		handlePresentAfterReshadeEffects();
+		handlePresentAfterReshadeEffects(runtime);
 	}
 }
 
 
-void DepthOfFieldController::performRenderFrameSetupWork()
+void DepthOfFieldController::handlePresentBeforeReshadeEffects()
 {
-	// move camera and set counter and move to next state
-	if(_currentStepFrame < _cameraSteps.size())
+	if(_state!=DepthOfFieldControllerState::Rendering)
 	{
-		const auto& currentStepFrameData = _cameraSteps[_currentStepFrame];
-		_cameraToolsConnector.moveCameraMultishot(currentStepFrameData.xDelta, currentStepFrameData.yDelta, 0.0f, true);
+		return;
 	}
-	if(_currentBlendFrame >= 0)
-	{
-		const auto& currentBlendFrameData = _cameraSteps[_currentBlendFrame];
-		_xAlignmentDelta = currentBlendFrameData.xAlignmentDelta;
-		_yAlignmentDelta = currentBlendFrameData.yAlignmentDelta;
-		switch(_frameWaitType)
-		{
-			case DepthOfFieldFrameWaitType::Fast:
-				_frameWaitCounter = 0;
-				break;
-			case DepthOfFieldFrameWaitType::Classic:
-				_frameWaitCounter = _numberOfFramesToWait;
-				break;
-		}
-		_blendFactor = 1.0f / (static_cast<float>(_currentBlendFrame) + 1.0f);		// frame start at 0 so +1, to get 1/1=100% blend factor for first frame
 
-		//since the lerp blending implicitly already divides the sum by N, we must not do it again, so compensate
-		const float numSamples = _cameraSteps.size();
-		_sampleWeightRGB[0] = currentBlendFrameData.sampleWeightRGB[0] * numSamples;
-		_sampleWeightRGB[1] = currentBlendFrameData.sampleWeightRGB[1] * numSamples;
-		_sampleWeightRGB[2] = currentBlendFrameData.sampleWeightRGB[2] * numSamples;
+	const int stepToBlend = _renderPipeline.beginFrame();
+	if(stepToBlend < 0 || stepToBlend >= _cameraSteps.size())
+	{
+		return;
+	}
+	_renderTelemetry.stepBlendStarted(stepToBlend);
+	if(DepthOfFieldRenderMode::Offline == _renderMode)
+	{
+		// the frame is captured after the effects have been rendered. The shader is idle, so the frame is left untouched.
+		_stepToCapture = stepToBlend;
+		return;
 	}
-	// Set the framestate to wait so the counter will take effect.
-	_renderFrameState = DepthOfFieldRenderFrameState::FrameWait;
+	// The camera move for this step is visible in the current frame. As we're currently before the reshade effects are handled but after the frame has
+	// been drawn by the engine we can set blendFrame to true here and the shader will blend the current framebuffer this frame.
+	// This works because after this method, the uniforms are written to the shader, so the shader will pick the new values up when it's being drawn.
+	const auto& stepToBlendData = _cameraSteps[stepToBlend];
+	_xAlignmentDelta = stepToBlendData.xAlignmentDelta;
+	_yAlignmentDelta = stepToBlendData.yAlignmentDelta;
+	_blendFactor = 1.0f / (static_cast<float>(stepToBlend) + 1.0f);		// steps start at 0 so +1, to get 1/1=100% blend factor for first frame
+
+	//since the lerp blending implicitly already divides the sum by N, we must not do it again, so compensate
+	const float numSamples = _cameraSteps.size();
+	_sampleWeightRGB[0] = stepToBlendData.sampleWeightRGB[0] * numSamples;
+	_sampleWeightRGB[1] = stepToBlendData.sampleWeightRGB[1] * numSamples;
+	_sampleWeightRGB[2] = stepToBlendData.sampleWeightRGB[2] * numSamples;
+	_blendFrame = true;
 }
 
 
-void DepthOfFieldController::handlePresentBeforeReshadeEffects()
+void DepthOfFieldController::handlePresentAfterReshadeEffects(reshade::api::effect_runtime* runtime)
 {
-	if(_state!=DepthOfFieldControllerState::Rendering)
+	if(_state != DepthOfFieldControllerState::Rendering)
 	{
 		return;
 	}
 
-	switch(_renderFrameState)
+	if(_stepToCapture >= 0)
 	{
-		case DepthOfFieldRenderFrameState::Off:
-		case DepthOfFieldRenderFrameState::FrameBlending:
-		case DepthOfFieldRenderFrameState::Start:
-			// no-op
-			break;
-		case DepthOfFieldRenderFrameState::FrameWait:
+		captureFrameForOfflineRender(runtime, _stepToCapture);
+		_stepToCapture = -1;
+	}
+
+	// Blending work, if any, has taken place as the shader has run. We switch it off by resetting the variable.
+	// This variable is written to the shader at the end of the handler called before the reshade effects will be rendered (reshadeBeginEffectsCalled), so
+	// it will take effect then. (the shader isn't run before that point so it's ok).
+	_blendFrame = false;
+	if(_renderPipeline.isComplete())
+	{
+		_renderTelemetry.frameEnded(false);
+		if(DepthOfFieldRenderMode::Offline == _renderMode)
+		{
+			// all frames are captured, but the render is only done when they're all on disk.
+			_frameWriter.finish();
+			if(!_frameWriter.isDone())
 			{
-				// check if counter is 0. If so, switch to next state, if not, decrease and do nothing
-				if(_frameWaitCounter <= 0)
-				{
-					_frameWaitCounter = 0;
-					if(_currentBlendFrame >= 0)
-					{
-						// Ready to blend. As we're currently before the reshade effects are handled but after the frame has been drawn by the engine
-						// we can set blendFrame to true here and the shader will blend the current framebuffer this frame.
-						// This works because after this method, the uniforms are written to the shader, so the shader will pick the new value up
-						// when it's being drawn 
-						_blendFrame = true;
-					}
-					// Setting the state to blending as we're blending after this method. The handling of this event is done in handlePresentAfterReshadeEffects
-					_renderFrameState = DepthOfFieldRenderFrameState::FrameBlending;
-				}
-				else
-				{
-					_frameWaitCounter--;
-				}
+				return;
 			}
-			break;
+			if(_frameWriter.hasWriteErrors())
+			{
+				OverlayControl::addNotification("Not all frames of the offline render could be written. The result is composited from the frames which were written.");
+			}
+			_compositor.start(_frameWriter.getCaptureFolder(), _offlineOutputType);
+		}
+		// we're done rendering
+		_renderTelemetry.logSummary(false);
+		_state = DepthOfFieldControllerState::Done;
+		reshade::log_message(reshade::log_level::info, "Dof render session completed");
+		return;
 	}
+
+	// when rendering offline and the disk can't keep up, we don't issue new camera moves till the writer has caught up.
+	const bool waitForFrameWriter = DepthOfFieldRenderMode::Offline == _renderMode && _frameWriter.isBacklogFull();
+	const int stepToMoveTo = _renderPipeline.endFrame(_renderPaused || waitForFrameWriter);
+	if(stepToMoveTo >= 0 && stepToMoveTo < _cameraSteps.size())
+	{
+		const auto& stepToMoveToData = _cameraSteps[stepToMoveTo];
+		const auto commandStartTime = std::chrono::high_resolution_clock::now();
+		_cameraToolsConnector.moveCameraMultishot(stepToMoveToData.xDelta, stepToMoveToData.yDelta, 0.0f, true);
+		_renderTelemetry.stepIssued(stepToMoveTo, commandStartTime);
+	}
+	_renderTelemetry.frameEnded(_renderPaused || waitForFrameWriter);
 }
 
 
-void DepthOfFieldController::handlePresentAfterReshadeEffects()
+void DepthOfFieldController::captureFrameForOfflineRender(reshade::api::effect_runtime* runtime, int stepIndex)
 {
-	if(_state != DepthOfFieldControllerState::Rendering)
+	uint32_t width = 0;
+	uint32_t height = 0;
+	runtime->get_screenshot_width_and_height(&width, &height);
+	if(width != (uint32_t)_offlineCaptureSettings.Width || height != (uint32_t)_offlineCaptureSettings.Height)
 	{
+		// the viewport got resized during the render, this frame can't be used.
 		return;
 	}
-
-	switch(_renderFrameState)
+	std::vector<uint8_t> frameData((size_t)width * height * 4);
+	if(!runtime->capture_screenshot(frameData.data()))
 	{
-		case DepthOfFieldRenderFrameState::Off:
-		case DepthOfFieldRenderFrameState::FrameWait:
-			// no-op
-			break;
-		case DepthOfFieldRenderFrameState::Start:
-			// start state of the whole process. Only arriving here once per render session.
-			performRenderFrameSetupWork();
-			break;
-		case DepthOfFieldRenderFrameState::FrameBlending:
-			{
-				// Blending work has taken place, we're now done with that as the shader has run. We switch it off by resetting the variable.
-				// This variable is written to the shader at the end of the handler called before the reshade effects will be rendered (reshadeBeginEffectsCalled), so
-				// it will take effect then. (the shader isn't run before that point so it's ok).
-				_blendFrame = false;
-				if(!_renderPaused)
-				{
-					_currentStepFrame++;
-					_currentBlendFrame++;
-					if(_currentBlendFrame >= _numberOfFramesToRender)
-					{
-						// we're done rendering
-						_renderFrameState = DepthOfFieldRenderFrameState::Off;
-						_state = DepthOfFieldControllerState::Done;
-						reshade::log_message(reshade::log_level::info, "Dof render session completed");
-					}
-					else
-					{
-						// back to setup for the next frame
-						performRenderFrameSetupWork();
-					}
-				}
-			}
-			break;
+		return;
 	}
+	const auto& stepData = _cameraSteps[stepIndex];
+	DepthOfFieldCapturedStep capturedStep;
+	capturedStep.StepIndex = stepIndex;
+	capturedStep.Filename = IGCS::Utils::formatString("%d.ppm", stepIndex);
+	capturedStep.XAlignmentDelta = stepData.xAlignmentDelta;
+	capturedStep.YAlignmentDelta = stepData.yAlignmentDelta;
+	// the camera deltas are the pattern positions scaled with the bokeh size, which can't change during a render.
+	const float maxBokehRadius = _maxBokehSize / 2.0f;
+	capturedStep.XSamplePosition = stepData.xDelta / maxBokehRadius;
+	capturedStep.YSamplePosition = stepData.yDelta / maxBokehRadius;
+	// same compensation as for the shader, see handlePresentBeforeReshadeEffects
+	const float numSamples = _cameraSteps.size();
+	capturedStep.SampleWeightRGB[0] = stepData.sampleWeightRGB[0] * numSamples;
+	capturedStep.SampleWeightRGB[1] = stepData.sampleWeightRGB[1] * numSamples;
+	capturedStep.SampleWeightRGB[2] = stepData.sampleWeightRGB[2] * numSamples;
+	_frameWriter.addFrame(std::move(frameData), std::move(capturedStep));
 }
 
 
-void DepthOfFieldController::applySphericalAberration(float radiusNormalized, CameraLocation& sample)
+std::string DepthOfFieldController::createOfflineCaptureFolderName()
 {
-	//radius^4 yields plausible results, see for analysis https://jtra.cz/stuff/essays/bokeh/index.html
-	//this is theoretically incorrect, as aberration should be caused by light taking different paths, i.e. it could be
-	//emulated by modifying the camera angles and correctly deliver inverted bokeh in foreground, 
-	//however this would yield blurry focal areas which we don't want. So approximate it with sample masking
-
-	float aberrationCurve = radiusNormalized * radiusNormalized;
-	aberrationCurve *= aberrationCurve; 
-
-	//lerp between flat profile and curve with intensity 0 in center
-	//*0.99 -> ensure samples in center are never _exactly_ zero, this avoids issues with renormalized sample weights
-	const float aberrationFactor = (1.0f - _sphericalAberrationDimFactor * 0.99f) + _sphericalAberrationDimFactor * aberrationCurve * 0.99f;
-
-	sample.sampleWeightRGB[0] *= aberrationFactor;
-	sample.sampleWeightRGB[1] *= aberrationFactor;
-	sample.sampleWeightRGB[2] *= aberrationFactor;
+	time_t t = time(nullptr);
+	tm tm;
+	localtime_s(&tm, &t);
+	const std::string optionalBackslash = (_offlineRootFolder.ends_with('\\')) ? "" : "\\";
+	return IGCS::Utils::formatString("%s%sIgcsDof-%.4d-%.2d-%.2d-%.2d-%.2d-%.2d", _offlineRootFolder.c_str(), optionalBackslash.c_str(), (tm.tm_year + 1900), (tm.tm_mon + 1), tm.tm_mday,
+									 tm.tm_hour, tm.tm_min, tm.tm_sec);
 }
 
 
-float DepthOfFieldController::calculateChannelDimFactor(float angleSegment, float segmentAngleMin, int numberOfSegments)
+void DepthOfFieldController::composeOfflineCapture(const std::string& captureFolder)
 {
-	// using Iq's parabola using k==0.5, see: https://www.desmos.com/calculator/aszway25gw and https://iquilezles.org/articles/functions/
-	const float segmentSize = 1.0f / (float)(numberOfSegments ==0 ? 1 : numberOfSegments);
-	const float angleToSegmentNormalized = IGCS::Utils::clampEx(angleSegment - segmentAngleMin, 0.0f, segmentSize) / segmentSize;
-	return std::pow(4.0f * angleToSegmentNormalized * (1.0 - angleToSegmentNormalized), 0.5f);
+	_compositor.start(captureFolder, _offlineOutputType);
 }
 
 
-void DepthOfFieldController::applyFringe(float ringRadiusNormalized, float sampleAngle, CameraLocation& sample)
+void DepthOfFieldController::applyRenderOrder()
 {
-	const float transitionWidth = 0.5f / (float)_quality;
-	// perform a linear step with the spacing of a ring radius
-	
-	//(x-a)/(b-a)
-	const float fringeRampStart = 1.0f - _fringeWidth - transitionWidth;
-	const float fringeRampEnd   = 1.0f - _fringeWidth + transitionWidth;
-	const float fringeMask = IGCS::Utils::clampEx((ringRadiusNormalized - fringeRampStart) / (fringeRampEnd - fringeRampStart), 0.0f, 1.0f);
-	const float fringeFactor = (1.0f - _fringeIntensity) * (1.0f - fringeMask) + fringeMask;
-
-	// factors for the dimming. 1.0 means visible, 0.0 means dimmed 100%
-	float blueFactor = 1.0f;
-	float greenFactor = 1.0f;
-	float redFactor = 1.0f;
-	const float angleSegment = sampleAngle / 6.28318530717958f;
-	// for 3 segments: 
-	// 0-0.33333: blue, 0.33333-0.6666: green, 0.6666-1: red
-	// for 2 segments, the two colors in the type both have 0.5
-
-	DepthOfFieldColorChannel segmentOneProminentColor = DepthOfFieldColorChannel::Red;
-	DepthOfFieldColorChannel segmentTwoProminentColor = DepthOfFieldColorChannel::Green;
-	DepthOfFieldColorChannel segmentThreeProminentColor = DepthOfFieldColorChannel::Blue;
-
-	int numberOfSegments = 3;
-	switch(_caType)
+	switch(_renderOrder)
 	{
-		case DepthOfFieldCAType::RGB:
-			// The defaults are ok for this setup
+		case DepthOfFieldRenderOrder::InnerRingToOuterRing:
+			// nothing, we're already having the points in the right order
 			break;
-		case DepthOfFieldCAType::RG:
-			numberOfSegments = 2;
-			// prominent color defaults are ok for this setup
+		case DepthOfFieldRenderOrder::OuterRingToInnerRing:
+			// reverse the container.
+			std::ranges::reverse(_cameraSteps);
 			break;
-		case DepthOfFieldCAType::RB:
-			numberOfSegments = 2;
-			segmentTwoProminentColor = DepthOfFieldColorChannel::Blue;
+		case DepthOfFieldRenderOrder::Randomized:
+			std::ranges::shuffle(_cameraSteps, std::random_device());
 			break;
-		case DepthOfFieldCAType::BG:
-			numberOfSegments = 2;
-			segmentOneProminentColor = DepthOfFieldColorChannel::Blue;
+		case DepthOfFieldRenderOrder::Progressive:
+			// the points are already in progressive order (see calculateShapePoints), the weights have to be adjusted so every checkpoint is a valid end point.
+			renormalizeWeightsPerCheckpointBlock();
 			break;
+		default:;
 	}
-	const float segmentOneMaxAngle = 1.0f / (float)numberOfSegments;
-	const float segmentTwoMaxAngle = 2.0f / (float)numberOfSegments;
+}
 
-	bool redChannelDimmable = true;
-	bool greenChannelDimmable = true;
-	bool blueChannelDimmable = true;
-	float dimFactor = 0.0f;
-	// cheap filter out segments and apply operands. Per segment a channel is prominent and the others are dimmed graciously
-	// execution flow will always arrive in 1 if handler below so we can use that to our advantage with setting flags for the final calculations
-	if(angleSegment <= segmentOneMaxAngle)
+
+void DepthOfFieldController::renormalizeWeightsPerCheckpointBlock()
+{
+	// The shader divides the accumulated, weighted samples by the number of samples blended. The weights are scaled with the total number of samples
+	// so after all samples the result is the weighted average. If we stop after k samples, the result is only correct if the weights of these k samples
+	// sum to k/N. We therefore scale the weights per block between two checkpoints so each block sums to its share. As the progressive order spreads
+	// every block over the whole pattern, the scale factors are close to 1 and the full render is practically identical to the other orders.
+	const int numberOfSteps = _cameraSteps.size();
+	const int blockSize = getCheckpointBlockSize();
+	if(numberOfSteps <= 0 || blockSize <= 0)
 	{
-		dimFactor = 1.0f - calculateChannelDimFactor(angleSegment, 0.0f, numberOfSegments);
-		redChannelDimmable = segmentOneProminentColor != DepthOfFieldColorChannel::Red;
-		greenChannelDimmable = segmentOneProminentColor != DepthOfFieldColorChannel::Green;
-		blueChannelDimmable = segmentOneProminentColor != DepthOfFieldColorChannel::Blue;
+		return;
 	}
-	else
+	// weight a block couldn't take (e.g. a channel with only 0 weights due to fringe) is carried over to the next block
+	float carriedOverShare[3] = { 0.0f, 0.0f, 0.0f };
+	for(int blockStart = 0; blockStart < numberOfSteps; blockStart += blockSize)
+	{
+		const int blockEnd = std::min(blockStart + blockSize, numberOfSteps);
+		for(int channel = 0; channel < 3; channel++)
+		{
+			float blockSum = 0.0f;
+			for(int i = blockStart; i < blockEnd; i++)
+			{
+				blockSum += _cameraSteps[i].sampleWeightRGB[channel];
+			}
+			const float blockShare = ((float)(blockEnd - blockStart) / (float)numberOfSteps) + carriedOverShare[channel];
+			if(blockSum < FLT_EPSILON)
+			{
+				carriedOverShare[channel] = blockShare;
+				continue;
+			}
+			carriedOverShare[channel] = 0.0f;
+			const float scaleFactor = blockShare / blockSum;
+			for(int i = blockStart; i < blockEnd; i++)
+			{
+				_cameraSteps[i].sampleWeightRGB[channel] *= scaleFactor;
+			}
+		}
+	}
+	// if the last blocks couldn't take their share, renormalize the whole channel so the full render is still correct.
+	for(int channel = 0; channel < 3; channel++)
 	{
-		if(angleSegment <= segmentTwoMaxAngle)
+		if(carriedOverShare[channel] <= 0.0f)
+		{
+			continue;
+		}
+		float totalSum = 0.0f;
+		for(const auto& step : _cameraSteps)
+		{
+			totalSum += step.sampleWeightRGB[channel];
+		}
+		if(totalSum < FLT_EPSILON)
 		{
-			// last segment for 2 colors, middle segment for 3 colors
-			dimFactor = 1.0f - calculateChannelDimFactor(angleSegment, segmentOneMaxAngle, numberOfSegments);
-			redChannelDimmable = segmentTwoProminentColor != DepthOfFieldColorChannel::Red;
-			greenChannelDimmable = segmentTwoProminentColor != DepthOfFieldColorChannel::Green;
-			blueChannelDimmable = segmentTwoProminentColor != DepthOfFieldColorChannel::Blue;
+			continue;
 		}
-		else
+		for(auto& step : _cameraSteps)
 		{
-			// last segment for 3 colors, for 2 color ca we'll never end up here. 
-			dimFactor = 1.0f - calculateChannelDimFactor(angleSegment, segmentTwoMaxAngle, numberOfSegments);
-			redChannelDimmable = segmentThreeProminentColor != DepthOfFieldColorChannel::Red;
-			greenChannelDimmable = segmentThreeProminentColor != DepthOfFieldColorChannel::Green;
-			blueChannelDimmable = segmentThreeProminentColor != DepthOfFieldColorChannel::Blue;
+			step.sampleWeightRGB[channel] /= totalSum;
 		}
 	}
+}
+
 
-	const float caRampStart = 1.0f - _caWidth - transitionWidth;
-	const float caRampEnd = 1.0f - _caWidth + transitionWidth;
-	const float caMask = IGCS::Utils::clampEx((ringRadiusNormalized - caRampStart) / (caRampEnd - caRampStart), 0.0f, 1.0f);
-	const float caFactor = _caStrength * caMask;
+int DepthOfFieldController::getCheckpointBlockSize()
+{
+	const int numberOfSteps = _cameraSteps.size();
+	return std::min(numberOfSteps, std::max(MIN_CHECKPOINT_BLOCK_SIZE, numberOfSteps / NUMBER_OF_CHECKPOINTS));
+}
 
-	redFactor = redChannelDimmable ? IGCS::Utils::lerp(dimFactor, 1.0f, (1.0f - caFactor)) : redFactor;
-	greenFactor = greenChannelDimmable ? IGCS::Utils::lerp(dimFactor, 1.0f, (1.0f - caFactor)) : greenFactor;
-	blueFactor = blueChannelDimmable ? IGCS::Utils::lerp(dimFactor, 1.0f, (1.0f - caFactor)) : blueFactor;
 
-	sample.sampleWeightRGB[0] *= fringeFactor * redFactor;
-	sample.sampleWeightRGB[1] *= fringeFactor * greenFactor;
-	sample.sampleWeightRGB[2] *= fringeFactor * blueFactor;
+void DepthOfFieldController::stopRenderAtNextCheckpoint()
+{
+	if(_state != DepthOfFieldControllerState::Rendering || DepthOfFieldRenderOrder::Progressive != _renderOrder || _stopAtCheckpointRequested)
+	{
+		return;
+	}
+	const int blockSize = getCheckpointBlockSize();
+	if(blockSize <= 0)
+	{
+		return;
+	}
+	// a render with no frames blended can't be kept, so the first checkpoint is the earliest one to stop at.
+	const int numberOfStepsBlended = _renderPipeline.getNumberOfStepsBlended();
+	const int nextCheckpoint = numberOfStepsBlended <= 0 ? blockSize : ((numberOfStepsBlended + blockSize - 1) / blockSize) * blockSize;
+	_renderPipeline.setNumberOfStepsToRender(std::min(nextCheckpoint, (int)_cameraSteps.size()));
+	_stopAtCheckpointRequested = true;
+	// reaching the checkpoint requires rendering, so a paused render is resumed
+	_renderPaused = false;
+	reshade::log_message(reshade::log_level::info, IGCS::Utils::formatString("Dof render will stop after %d of %d frames", _renderPipeline.getNumberOfStepsToRender(), (int)_cameraSteps.size()).c_str());
 }
 
 
-void DepthOfFieldController::createCircleDoFPoints()
+void DepthOfFieldController::createPatternParameters(DepthOfFieldGeometryParameters& geometryParameters, DepthOfFieldWeightParameters& weightParameters)
 {
-	_cameraSteps.clear();
+	geometryParameters.blurType = _blurType;
+	geometryParameters.quality = _quality;
+	geometryParameters.ringAngleOffset = _ringAngleOffset;
+	geometryParameters.anamorphicFactor = _anamorphicFactor;
+	switch(_blurType)
+	{
+		case DepthOfFieldBlurType::ApertureShape:
+			// sanitize input for 4 vertex elements
+			if(4 == _apertureShapeSettings.NumberOfVertices)
+			{
+				if(_ringAngleOffset<-0.015f || _ringAngleOffset > 0.015f)
+				{
+					_ringAngleOffset = 0.0f;
+					geometryParameters.ringAngleOffset = 0.0f;
+				}
+			}
+			geometryParameters.numberOfVertices = _apertureShapeSettings.NumberOfVertices;
+			geometryParameters.rotationAngle = _apertureShapeSettings.RotationAngle;
+			geometryParameters.roundFactor = _apertureShapeSettings.RoundFactor;
+			break;
+		case DepthOfFieldBlurType::Circular:
+			// the aperture shape settings aren't used for circles, so these keep their defaults in the parameters, to avoid needless cache misses.
+			geometryParameters.numberOfPointsInnermostRing = _numberOfPointsInnermostRing;
+			break;
+		case DepthOfFieldBlurType::ApertureMask:
+			geometryParameters.apertureMaskFilename = _apertureMaskFilename;
+			break;
+	}
+
+	weightParameters.sphericalAberrationDimFactor = _sphericalAberrationDimFactor;
+	weightParameters.fringeIntensity = _fringeIntensity;
+	weightParameters.fringeWidth = _fringeWidth;
+	weightParameters.caStrength = _caStrength;
+	weightParameters.caWidth = _caWidth;
+	weightParameters.caType = _caType;
+}
 
-	CameraLocation center = {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
-	applySphericalAberration(0.0f, center);	
-	applyFringe(0.0f, 0.0f, center);	
-	_cameraSteps.push_back(center);
 
-	const float pointsFirstRing = (float)_numberOfPointsInnermostRing;
-	float pointsOnRing = pointsFirstRing;
+void DepthOfFieldController::calculateShapePoints()
+{
+	DepthOfFieldGeometryParameters geometryParameters;
+	DepthOfFieldWeightParameters weightParameters;
+	createPatternParameters(geometryParameters, weightParameters);
+	// the merge result is cached with the pattern, so dragging e.g. the bokeh size doesn't merge again.
+	const DepthOfFieldSamplePattern& pattern = _mergeNegligibleSamples ? _patternGenerator.getMergedPattern(geometryParameters, weightParameters, _sampleMergeTolerance)
+																	   : _patternGenerator.getPattern(geometryParameters, weightParameters);
+
+	// The pattern is normalized, so we scale it here with the bokeh size and the focus delta. This way changing these doesn't regenerate the pattern.
 	const float maxBokehRadius = _maxBokehSize / 2.0f;
 	const float focusDeltaHalf = _focusDelta / 2.0f;
-	for(int ringNo = 1; ringNo <= _quality; ringNo++)
+	// For the progressive order the samples are taken in the order pre-calculated by the generator, as it's tied to the geometry of the pattern.
+	const bool useProgressiveOrder = DepthOfFieldRenderOrder::Progressive == _renderOrder;
+	_cameraSteps.resize(pattern.size());
+	for(size_t i = 0; i < pattern.size(); i++)
 	{
-		const float anglePerPoint = 6.28318530717958f / pointsOnRing;
-		float angle = ((float)ringNo * _ringAngleOffset);
-		const float ringDistance = (float)ringNo / (float)_quality;
-		for(int pointNumber = 0;pointNumber<pointsOnRing;pointNumber++)
-		{
-			const float sinAngle = sin(angle);
-			const float cosAngle = cos(angle);
-			const float x = ringDistance * cosAngle * _anamorphicFactor;
-			const float y = ringDistance * sinAngle;
-			const float xDelta = maxBokehRadius * x;
-			const float yDelta = maxBokehRadius * y;
-
-			CameraLocation sample = {xDelta, yDelta, x * -focusDeltaHalf, y * focusDeltaHalf, 1.0f, 1.0f, 1.0f};	
-			applySphericalAberration(ringDistance, sample);
-			// angle 0 is on the right of the circle but we want it to be up top, so we subtract 1/2pi from it so the angle for the color is transposed 90 degrees.
-			applyFringe(ringDistance, fmod((angle-(6.28318530717958f / 4.0f)) + 6.28318530717958f, 6.28318530717958f), sample);
-			_cameraSteps.push_back(sample);
-
-			angle += anglePerPoint;
-			angle = fmod(angle, 6.28318530717958f);
-		}
-
-		pointsOnRing += pointsFirstRing;
+		const size_t sampleIndex = useProgressiveOrder ? pattern.progressiveOrder[i] : i;
+		CameraLocation& step = _cameraSteps[i];
+		step.xDelta = maxBokehRadius * pattern.x[sampleIndex];
+		step.yDelta = maxBokehRadius * pattern.y[sampleIndex];
+		step.xAlignmentDelta = pattern.x[sampleIndex] * -focusDeltaHalf;
+		step.yAlignmentDelta = pattern.y[sampleIndex] * focusDeltaHalf;
+		step.sampleWeightRGB[0] = pattern.weightR[sampleIndex];
+		step.sampleWeightRGB[1] = pattern.weightG[sampleIndex];
+		step.sampleWeightRGB[2] = pattern.weightB[sampleIndex];
 	}
-
-	renormalizeBokehWeights();
+	_numberOfMergedSamples = pattern.numberOfMergedSamples;
 	applyRenderOrder();
 }
 
 
-void DepthOfFieldController::createApertureShapedDoFPoints()
+float DepthOfFieldController::getEstimatedSecondsPerFrame()
 {
-	_cameraSteps.clear();
-
-	CameraLocation center = {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
-	applySphericalAberration(0.0f, center);
-	applyFringe(0.0f, 0.0f, center);
-	_cameraSteps.push_back(center);
-
-	// sanitize input for 4 vertex elements
-	if(4 == _apertureShapeSettings.NumberOfVertices)
+	// a frame of the last render is a better estimate than a frame now, as rendering includes the camera moves and the blending.
+	if(_renderTelemetry.getAverageSecondsPerFrame() > 0.0f)
 	{
-		if(_ringAngleOffset<-0.015f || _ringAngleOffset > 0.015f)
-		{
-			_ringAngleOffset = 0.0f;
-		}
+		return _renderTelemetry.getAverageSecondsPerFrame();
 	}
+	const float framerate = ImGui::GetIO().Framerate;
+	return framerate > 0.0f ? 1.0f / framerate : 0.0f;
+}
 
-	const float maxBokehRadius = _maxBokehSize / 2.0f;
-	const float focusDeltaHalf = _focusDelta / 2.0f;
-	const float anglePerVertex = 6.28318530717958f / (float)_apertureShapeSettings.NumberOfVertices;
-	for(int ringNo = 1; ringNo <= _quality; ringNo++)
-	{
-		float vertexAngleForFringe = 0.0f;
-		// ring angle offset is applied stronger on inner rings than on outer rings, to keep the outer ring from staying in the same place. 
-		float vertexAngle = fmod((_apertureShapeSettings.RotationAngle * 6.28318530717958f) + ((float)(_quality-ringNo) * _ringAngleOffset), 6.28318530717958f);
-		const float ringDistance = (float)ringNo / (float)_quality;		
-		for(int vertexNo = 0; vertexNo < _apertureShapeSettings.NumberOfVertices; vertexNo++)
-		{
-			const float sinAngleCurrentVertex = sin(vertexAngle);
-			const float cosAngleCurrentVertex = cos(vertexAngle);
-			const float nextVertexAngle = fmod(vertexAngle + anglePerVertex, 6.28318530717958f);
-			const float sinAngleNextVertex = sin(nextVertexAngle);
-			const float cosAngleNextVertex = cos(nextVertexAngle);
-			const float xCurrentVertex = ringDistance * cosAngleCurrentVertex;
-			const float yCurrentVertex = ringDistance * sinAngleCurrentVertex;
-			const float xNextVertex = ringDistance * cosAngleNextVertex;
-			const float yNextVertex = ringDistance * sinAngleNextVertex;
-			const float pointStepSize = 1.0f / (float)ringNo;
-			float pointStep = pointStepSize;
-			for(int pointNumber = 0; pointNumber < ringNo; pointNumber++)
-			{
-				const float pointAngle = IGCS::Utils::lerp(vertexAngle, vertexAngle + anglePerVertex, pointStep);
-				const float pointAngleForFringe = IGCS::Utils::lerp(vertexAngleForFringe, vertexAngleForFringe + anglePerVertex, pointStep);
-				const float sinPointAngle = sin(pointAngle);
-				const float cosPointAngle = cos(pointAngle);
-				const float xRoundPoint = ringDistance * cosPointAngle;
-				const float yRoundPoint = ringDistance * sinPointAngle;
-				const float xLinePoint = IGCS::Utils::lerp(xCurrentVertex, xNextVertex, pointStep);
-				const float yLinePoint = IGCS::Utils::lerp(yCurrentVertex, yNextVertex, pointStep);
-				float x = IGCS::Utils::lerp(xLinePoint, xRoundPoint, _apertureShapeSettings.RoundFactor);
-				float y = IGCS::Utils::lerp(yLinePoint, yRoundPoint, _apertureShapeSettings.RoundFactor);
-				//cannot use ringDistance in polygonal mode, as spherical aberration is purely a factor of radius and ringDistance follows aperture shape
-				//hence use euclidean distance from center instead. However, spherical aberration happens before anamorphic film squeeze
-				//as the anamorphic lens is the last lens in front of the sensor/film
-				const float radiusNormalized = sqrtf(x * x + y * y); 
-				x *= _anamorphicFactor; //apply scaling here after calculating spherical aberration
-				const float xDelta = maxBokehRadius * x;
-				const float yDelta = maxBokehRadius * y;
-				CameraLocation sample = {xDelta, yDelta, x * -focusDeltaHalf, y * focusDeltaHalf, 1.0f, 1.0f, 1.0f};	
-				applySphericalAberration(radiusNormalized, sample);	
-				applyFringe(ringDistance, pointAngleForFringe, sample);
-				_cameraSteps.push_back(sample);
-				pointStep += pointStepSize;
-			}
-			vertexAngle += anglePerVertex;
-			vertexAngle = fmod(vertexAngle, 6.28318530717958f);
-			vertexAngleForFringe += anglePerVertex;
-			vertexAngleForFringe = fmod(vertexAngleForFringe, 6.28318530717958f);
-		}
-	}
 
-	renormalizeBokehWeights();
-	applyRenderOrder();
+float DepthOfFieldController::getEstimatedSecondsPerStep()
+{
+	const int framesPerStep = DepthOfFieldFrameWaitType::Classic == _frameWaitType ? _numberOfFramesToWait + 1 : 1;
+	return (float)framesPerStep * getEstimatedSecondsPerFrame();
 }
 
 
-void DepthOfFieldController::renormalizeBokehWeights()
+float DepthOfFieldController::getEstimatedRenderSeconds(int numberOfSteps)
 {
-	//renormalize bokeh weights so they do not scale the exposure or add a tint	
-	float weightSumRGB[3] = { 0.0f, 0.0f, 0.0f };
-	for(const auto& step : _cameraSteps)
-	{
-		weightSumRGB[0] += step.sampleWeightRGB[0];
-		weightSumRGB[1] += step.sampleWeightRGB[1];
-		weightSumRGB[2] += step.sampleWeightRGB[2];
-	}
-	for(auto& step : _cameraSteps)
-	{
-		step.sampleWeightRGB[0] /= weightSumRGB[0];
-		step.sampleWeightRGB[1] /= weightSumRGB[1];
-		step.sampleWeightRGB[2] /= weightSumRGB[2];
-	}
+	// the first frame is only blended after the latency of the first camera move, in both frame wait types.
+	const int latencyInFrames = _numberOfFramesToWait + 1;
+	return ((float)numberOfSteps * getEstimatedSecondsPerStep()) + ((float)latencyInFrames * getEstimatedSecondsPerFrame());
 }
 
 
-void DepthOfFieldController::applyRenderOrder()
+void DepthOfFieldController::calculateHighestQualityForTimeBudget()
 {
-	switch(_renderOrder)
+	_qualityForTimeBudget = 0;
+	DepthOfFieldGeometryParameters geometryParameters;
+	DepthOfFieldWeightParameters weightParameters;
+	createPatternParameters(geometryParameters, weightParameters);
+	// the number of steps only grows with the quality, so we can stop at the first quality level which doesn't fit.
+	DepthOfFieldPatternGenerator budgetGenerator;
+	for(int quality = 1; quality <= MAX_QUALITY; quality++)
 	{
-		case DepthOfFieldRenderOrder::InnerRingToOuterRing:
-			// nothing, we're already having the points in the right order
-			break;
-		case DepthOfFieldRenderOrder::OuterRingToInnerRing:
-			// reverse the container.
-			std::ranges::reverse(_cameraSteps);
-			break;
-		case DepthOfFieldRenderOrder::Randomized:
-			std::ranges::shuffle(_cameraSteps, std::random_device());
+		geometryParameters.quality = quality;
+		const DepthOfFieldSamplePattern& pattern = _mergeNegligibleSamples ? budgetGenerator.getMergedPattern(geometryParameters, weightParameters, _sampleMergeTolerance)
+																		   : budgetGenerator.getPattern(geometryParameters, weightParameters);
+		if(getEstimatedRenderSeconds(pattern.size()) > _timeBudgetSeconds)
+		{
 			break;
-		default:;
+		}
+		_qualityForTimeBudget = quality;
 	}
 }
 
 
-void DepthOfFieldController::calculateShapePoints()
+float DepthOfFieldController::getEstimatedSecondsSavedByMerging()
 {
-	switch(_blurType)
+	return (float)_numberOfMergedSamples * getEstimatedSecondsPerStep();
+}
+
+
+void DepthOfFieldController::calculateSampleReductionReport()
+{
+	_sampleReductionReport.clear();
+	DepthOfFieldGeometryParameters geometryParameters;
+	DepthOfFieldWeightParameters weightParameters;
+	createPatternParameters(geometryParameters, weightParameters);
+	const float secondsPerStep = getEstimatedSecondsPerStep();
+	// use a separate generator so the patterns for the other quality levels don't push the ones in use out of the cache.
+	DepthOfFieldPatternGenerator reportGenerator;
+	const int minQuality = std::max(1, _quality - SAMPLE_REDUCTION_REPORT_RANGE);
+	const int maxQuality = std::min(MAX_QUALITY, _quality + SAMPLE_REDUCTION_REPORT_RANGE);
+	for(int quality = minQuality; quality <= maxQuality; quality++)
 	{
-		case DepthOfFieldBlurType::ApertureShape:
-			createApertureShapedDoFPoints();
-			break;
-		case DepthOfFieldBlurType::Circular: 
-			createCircleDoFPoints();
-			break;
+		geometryParameters.quality = quality;
+		const DepthOfFieldSamplePattern& mergedPattern = reportGenerator.getMergedPattern(geometryParameters, weightParameters, _sampleMergeTolerance);
+		SampleReductionReportLine line;
+		line.Quality = quality;
+		line.NumberOfSteps = mergedPattern.size() + mergedPattern.numberOfMergedSamples;
+		line.NumberOfStepsSaved = mergedPattern.numberOfMergedSamples;
+		line.SecondsSaved = (float)line.NumberOfStepsSaved * secondsPerStep;
+		_sampleReductionReport.push_back(line);
 	}
 }
 
@@ -735,54 +816,70 @@ void DepthOfFieldController::startRender(reshade::api::effect_runtime* runtime)
 		return;
 	}
 
+	if(DepthOfFieldRenderMode::Offline == _renderMode)
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		runtime->get_screenshot_width_and_height(&width, &height);
+		_offlineCaptureSettings.Width = width;
+		_offlineCaptureSettings.Height = height;
+		_offlineCaptureSettings.NumberOfSteps = _cameraSteps.size();
+		_offlineCaptureSettings.FocusDelta = _focusDelta;
+		_offlineCaptureSettings.HighlightBoost = _highlightBoostFactor;
+		_offlineCaptureSettings.HighlightGammaFactor = _highlightGammaFactor;
+		_offlineCaptureSettings.CateyeRadiusStart = _catEyeRadiusStart;
+		_offlineCaptureSettings.CateyeRadiusEnd = _catEyeRadiusEnd;
+		_offlineCaptureSettings.CateyeIntensity = _catEyeBokehIntensity;
+		_offlineCaptureSettings.CateyeVignette = _addCatEyeVignette;
+		_offlineCaptureSettings.BracketFocusDeltas = _bracketFocusDeltas;
+		if(!_frameWriter.start(createOfflineCaptureFolderName(), _offlineCaptureSettings))
+		{
+			OverlayControl::addNotification("The folder for the offline render couldn't be created. Please check the screenshot folder.");
+			return;
+		}
+	}
+
 	reshade::log_message(reshade::log_level::info, "Dof render session started");
 
 	// set initial shader start state
 	_blendFrame = false;
 	_blendFactor = 0.0f;
-	_currentStepFrame = 0;
-	switch(_frameWaitType)
-	{
-		case DepthOfFieldFrameWaitType::Classic:
-			_currentBlendFrame = 0;
-			break;
-		case DepthOfFieldFrameWaitType::Fast:
-			_currentBlendFrame = 0-_numberOfFramesToWait;
-			break;
-	}
-	_numberOfFramesToRender = _cameraSteps.size();
-	_renderFrameState = DepthOfFieldRenderFrameState::Start;
+	// A camera move issued after the effects of a frame shows up in the next frame, so waiting N frames means a latency of N+1 frames. 
+	// Fast keeps a camera move in flight for every frame of latency, so every frame after warm-up is blended, Classic waits for each move.
+	const int latencyInFrames = _numberOfFramesToWait + 1;
+	_renderPipeline.start(_cameraSteps.size(), latencyInFrames, DepthOfFieldFrameWaitType::Fast == _frameWaitType ? latencyInFrames : 1);
+	_renderTelemetry.start(_cameraSteps.size());
+	_stopAtCheckpointRequested = false;
+	_stepToCapture = -1;
 	_state = DepthOfFieldControllerState::Rendering;
 }
 
 
 void DepthOfFieldController::migrateReshadeState(reshade::api::effect_runtime* runtime)
 {
-	if(!_cameraToolsConnector.cameraToolsConnected())
+	if(nullptr == runtime || !isUniformTableResolved())
 	{
 		return;
 	}
-	switch(_state)
+
 	{
-		case DepthOfFieldControllerState::Cancelling:
-			return;
+		std::scoped_lock lock(_uniformTableMutex);
+		// the handles are invalid after a reload, so resolve them again. This also invalidates the cached values, as the reloaded effects have their
+		// default values. If our effect isn't loaded anymore, the table is empty, which is fine, setting variables takes care of that.
+		_uniformTable.resolve(runtime);
 	}
-	if(isReshadeStateEmpty())
+	if(!_cameraToolsConnector.cameraToolsConnected())
 	{
 		return;
 	}
-
+	switch(_state)
 	{
-		std::scoped_lock lock(_reshadeStateMutex);
-		ReshadeStateSnapshot newState;
-		newState.obtainReshadeState(runtime);
-		// we don't care about the variable values, only about id's and variable names. So we can replace what we have with the new state.
-		// If the new state is empty, that's fine, setting variables takes care of that. 
-		_reshadeStateAtStart = newState;
+		case DepthOfFieldControllerState::Cancelling:
+			return;
 	}
-		
-	// if the newstate is empty we do nothing. If the new state isn't empty we had a migration and the variables are valid.
-	if(!isReshadeStateEmpty() && _state == DepthOfFieldControllerState::Setup)
+
+	// if the table is empty we do nothing. If it isn't empty we had a migration and the variables are valid.
+	if(isUniformTableResolved() && _state == DepthOfFieldControllerState::Setup)
 	{
 		// we now restart the session. This is necessary because we lose the cached start texture.
 		endSession(runtime);
@@ -827,11 +924,25 @@ void DepthOfFieldController::drawShape(ImDrawList* drawList, ImVec2 topLeftScree
 void DepthOfFieldController::renderProgressBar()
 {
 	const int totalAmountOfSteps = _cameraSteps.size();
-	const float progress = (float)_currentBlendFrame / (float)totalAmountOfSteps;
+	const float progress = (float)_renderPipeline.getNumberOfStepsBlended() / (float)totalAmountOfSteps;
 	const float progress_saturated = IGCS::Utils::clampEx(progress, 0.0f, 1.0f);
 	char buf[128];
-	sprintf(buf, "%d/%d", (int)(progress_saturated * totalAmountOfSteps), totalAmountOfSteps);
+	if(_stopAtCheckpointRequested)
+	{
+		sprintf(buf, "%d/%d (stopping at %d)", (int)(progress_saturated * totalAmountOfSteps), totalAmountOfSteps, _renderPipeline.getNumberOfStepsToRender());
+	}
+	else
+	{
+		sprintf(buf, "%d/%d", (int)(progress_saturated * totalAmountOfSteps), totalAmountOfSteps);
+	}
 	ImGui::ProgressBar(progress, ImVec2(0.f, 0.f), buf);
+	if(!_renderTelemetry.hasMeasurements())
+	{
+		return;
+	}
+	const int numberOfStepsRemaining = std::max(_renderPipeline.getNumberOfStepsToRender() - _renderPipeline.getNumberOfStepsBlended(), 0);
+	ImGui::Text("%s remaining. %.1f ms per step, %.2f frames per step", DepthOfFieldRenderTelemetry::formatDuration(_renderTelemetry.getEstimatedSecondsRemaining(numberOfStepsRemaining)).c_str(),
+				_renderTelemetry.getAverageSecondsPerStep() * 1000.0f, _renderTelemetry.getAverageFramesPerStep());
 }
 
 
@@ -852,31 +963,31 @@ void DepthOfFieldController::renderOverlay()
 }
 
 
-void DepthOfFieldController::setUniformIntVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, int valueToWrite)
+void DepthOfFieldController::setUniformIntVariable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, int valueToWrite)
 {
-	std::scoped_lock lock(_reshadeStateMutex);
-	_reshadeStateAtStart.setUniformIntVariable(runtime, "IgcsDof.fx", uniformName, valueToWrite);
+	std::scoped_lock lock(_uniformTableMutex);
+	_uniformTable.setInt(runtime, (int)uniform, valueToWrite);
 }
 
 
-void DepthOfFieldController::setUniformFloatVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float valueToWrite)
+void DepthOfFieldController::setUniformFloatVariable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, float valueToWrite)
 {
-	std::scoped_lock lock(_reshadeStateMutex);
-	_reshadeStateAtStart.setUniformFloatVariable(runtime, "IgcsDof.fx", uniformName, valueToWrite);
+	std::scoped_lock lock(_uniformTableMutex);
+	_uniformTable.setFloat(runtime, (int)uniform, valueToWrite);
 }
 
 
-void DepthOfFieldController::setUniformBoolVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, bool valueToWrite)
+void DepthOfFieldController::setUniformBoolVariable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, bool valueToWrite)
 {
-	std::scoped_lock lock(_reshadeStateMutex);
-	_reshadeStateAtStart.setUniformBoolVariable(runtime, "IgcsDof.fx", uniformName, valueToWrite);
+	std::scoped_lock lock(_uniformTableMutex);
+	_uniformTable.setBool(runtime, (int)uniform, valueToWrite);
 }
 
 
-void DepthOfFieldController::setUniformFloat2Variable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float value1ToWrite, float value2ToWrite)
+void DepthOfFieldController::setUniformFloat2Variable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, float value1ToWrite, float value2ToWrite)
 {
-	std::scoped_lock lock(_reshadeStateMutex);
-	_reshadeStateAtStart.setUniformFloat2Variable(runtime, "IgcsDof.fx", uniformName, value1ToWrite, value2ToWrite);
+	std::scoped_lock lock(_uniformTableMutex);
+	_uniformTable.setFloat2(runtime, (int)uniform, value1ToWrite, value2ToWrite);
 }
 
 
@@ -44,7 +44,12 @@
 #include "CDataFile.h"
 #include "Utils.h"
 
-#include "ReshadeStateSnapshot.h"
+#include "DepthOfFieldCapture.h"
+#include "DepthOfFieldCompositor.h"
+#include "DepthOfFieldPatternGenerator.h"
+#include "DepthOfFieldRenderPipeline.h"
+#include "DepthOfFieldRenderTelemetry.h"
+#include "ShaderUniformTable.h"
 
 class DepthOfFieldController
 {
@@ -78,6 +83,17 @@ class DepthOfFieldController
 		float RoundFactor = 0.25f;
 	};
 
+	/// <summary>
+	/// The effect of merging negligible samples for a single quality level.
+	/// </summary>
+	struct SampleReductionReportLine
+	{
+		int Quality = 0;
+		int NumberOfSteps = 0;
+		int NumberOfStepsSaved = 0;
+		float SecondsSaved = 0.0f;
+	};
+
 public:
 	DepthOfFieldController(CameraToolsConnector& connector);
 	~DepthOfFieldController() = default;
@@ -118,7 +134,13 @@ public:
 	/// <param name="runtime"></param>
 	void startRender(reshade::api::effect_runtime* runtime);
 	/// <summary>
-	/// Migrates the grabbed reshade state to the new one passed in. Occurs when the user reloads the reshade preset or the viewport got resized
+	/// Stops the render in progress at the next checkpoint and keeps the result. Only possible with the progressive render order, as only then
+	/// every checkpoint is a normalized subset of the samples.
+	/// </summary>
+	void stopRenderAtNextCheckpoint();
+	/// <summary>
+	/// Migrates the grabbed reshade state to the new one passed in. Occurs when the user reloads the reshade preset or the viewport got resized.
+	/// Resolves the uniforms of the shader again, which invalidates their cached values, also when no session is active.
 	/// </summary>
 	/// <param name="runtime">Can be empty, in which case it's ignored</param>
 	void migrateReshadeState(reshade::api::effect_runtime* runtime);
@@ -127,6 +149,27 @@ public:
 	/// </summary>
 	void calculateShapePoints();
 	/// <summary>
+	/// Calculates for the quality levels around the current one how many steps merging negligible samples saves, with the current settings.
+	/// </summary>
+	void calculateSampleReductionReport();
+	/// <summary>
+	/// Estimates the time saved by merging negligible samples, based on the current framerate. Has to be called when ImGui is active.
+	/// </summary>
+	float getEstimatedSecondsSavedByMerging();
+	/// <summary>
+	/// Estimates how long rendering the number of steps specified takes with the current frame wait settings, based on the frame time measured
+	/// during the last render, or on the current framerate if nothing has been rendered yet. Has to be called when ImGui is active.
+	/// </summary>
+	float getEstimatedRenderSeconds(int numberOfSteps);
+	/// <summary>
+	/// Determines the highest quality level which renders within the time budget with the current settings. 
+	/// </summary>
+	void calculateHighestQualityForTimeBudget();
+	/// <summary>
+	/// Starts the composition of the offline capture in the folder specified, in the background. Used to (re)composite a capture of an earlier render.
+	/// </summary>
+	void composeOfflineCapture(const std::string& captureFolder);
+	/// <summary>
 	/// Renders the overlay which contains the progress bar
 	/// </summary>
 	void renderOverlay();
@@ -221,7 +264,29 @@ public:
 	void setHighlightBoostFactor(float newValue) { _highlightBoostFactor = IGCS::Utils::clampEx(newValue, 0.0f, 1.0f); }
 	void setHighlightGammaFactor(float newValue) { _highlightGammaFactor = IGCS::Utils::clampEx(newValue, 0.1f, 5.0f); }
 	void setRenderPaused(bool newValue) { _renderPaused = newValue; }
+	void setRenderMode(DepthOfFieldRenderMode newValue) { _renderMode = newValue; }
+	void setOfflineOutputType(DepthOfFieldOfflineOutputType newValue) { _offlineOutputType = newValue; }
+	void setOfflineRootFolder(const std::string& newValue) { _offlineRootFolder = newValue; }
+	void setMergeNegligibleSamples(bool newValue)
+	{
+		_mergeNegligibleSamples = newValue;
+		calculateShapePoints();
+	}
+	void setSampleMergeTolerance(float newValue)
+	{
+		_sampleMergeTolerance = IGCS::Utils::clampEx(newValue, 0.0f, 0.1f);
+		calculateShapePoints();
+	}
 	void setShowProgressBarAsOverlay(bool newValue) { _showProgressBarAsOverlay = newValue; }
+	void setTimeBudgetSeconds(float newValue) { _timeBudgetSeconds = IGCS::Utils::clampEx(newValue, 1.0f, 36000.0f); }
+	void addBracketFocusDelta(float newValue);
+	void setBracketFocusDelta(int index, float newValue);
+	void removeBracketFocusDelta(int index);
+	void setApertureMaskFilename(const std::string& newValue)
+	{
+		_apertureMaskFilename = newValue;
+		calculateShapePoints();
+	}
 
 	// getters
 	DepthOfFieldRenderOrder getRenderOrder() { return _renderOrder; }
@@ -234,7 +299,21 @@ public:
 	int getNumberOfPointsInnermostRing() { return _numberOfPointsInnermostRing; }
 	int getNumberOfFramesToWaitPerFrame() { return _numberOfFramesToWait; }
 	bool getRenderPaused() { return _renderPaused; }
+	bool getStopAtCheckpointRequested() { return _stopAtCheckpointRequested; }
+	bool getMergeNegligibleSamples() { return _mergeNegligibleSamples; }
+	DepthOfFieldRenderMode getRenderMode() { return _renderMode; }
+	DepthOfFieldOfflineOutputType getOfflineOutputType() { return _offlineOutputType; }
+	bool isWritingOfflineFrames() { return DepthOfFieldRenderMode::Offline == _renderMode && _renderPipeline.isComplete() && !_frameWriter.isDone(); }
+	int getNumberOfOfflineFramesWritten() { return _frameWriter.getNumberOfFramesWritten(); }
+	std::string getOfflineCaptureFolder() { return _frameWriter.getCaptureFolder(); }
+	DepthOfFieldCompositor& getCompositor() { return _compositor; }
+	const std::vector<float>& getBracketFocusDeltas() { return _bracketFocusDeltas; }
+	float getSampleMergeTolerance() { return _sampleMergeTolerance; }
+	int getNumberOfMergedSamples() { return _numberOfMergedSamples; }
+	const std::vector<SampleReductionReportLine>& getSampleReductionReport() { return _sampleReductionReport; }
 	int getTotalNumberOfStepsToTake() { return _cameraSteps.size(); }
+	float getTimeBudgetSeconds() { return _timeBudgetSeconds; }
+	int getQualityForTimeBudget() { return _qualityForTimeBudget; }
 	bool getShowProgressBarAsOverlay() { return _showProgressBarAsOverlay; }
 	float getAnamorphicFactor() { return _anamorphicFactor; }
 	float getRingAngleOffset() { return _ringAngleOffset; }
@@ -249,6 +328,8 @@ public:
 	float getCatEyeRadiusEnd() { return _catEyeRadiusEnd; }
 	float getCatEyeBokehIntensity() { return _catEyeBokehIntensity; }
 	bool getAddCatEyeVignette() { return _addCatEyeVignette; }
+	std::string getApertureMaskFilename() { return _apertureMaskFilename; }
+	const std::string& getApertureMaskError() { return _patternGenerator.getApertureMaskError(); }
 
 	MagnifierSettings& getMagnifierSettings() { return _magnificationSettings; }				// this is a bit dirty...
 	ApertureShapeSettings& getApertureShapeSettings() { return _apertureShapeSettings; }		// same
@@ -261,22 +342,34 @@ public:
 	bool getDebugBool2() { return _debugBool2; }
 	float getDebugVal1() { return _debugVal1; }
 	float getDebugVal2() { return _debugVal2; }
+	int getNumberOfUniformWritesLastFrame()
+	{
+		std::scoped_lock lock(_uniformTableMutex);
+		return _uniformTable.getNumberOfWritesInLastBatch();
+	}
+	int getNumberOfUniformWriteRequestsLastFrame()
+	{
+		std::scoped_lock lock(_uniformTableMutex);
+		return _uniformTable.getNumberOfWriteRequestsInLastBatch();
+	}
 
 private:
-	void setUniformIntVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, int valueToWrite);
-	void setUniformFloatVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float valueToWrite);
-	void setUniformBoolVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, bool valueToWrite);
-	void setUniformFloat2Variable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float value1ToWrite, float value2ToWrite);
+	void setUniformIntVariable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, int valueToWrite);
+	void setUniformFloatVariable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, float valueToWrite);
+	void setUniformBoolVariable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, bool valueToWrite);
+	void setUniformFloat2Variable(reshade::api::effect_runtime* runtime, DepthOfFieldShaderUniform uniform, float value1ToWrite, float value2ToWrite);
 	void loadFloatFromIni(CDataFile& iniFile, const std::string& key, float* toWriteTo);
 	void loadIntFromIni(CDataFile& iniFile, const std::string& key, int* toWriteTo);
 	void loadBoolFromIni(CDataFile& iniFile, const std::string& key, bool* toWriteTo, bool defaultValue);
+	void applyRenderOrder();
 	/// <summary>
-	/// Create a set of circular points using nested circles, which are used to build the camera steps array
+	/// Scales the sample weights per block of samples between two checkpoints so each prefix ending at a checkpoint sums to its share of the total weight.
 	/// </summary>
-	void createCircleDoFPoints();
-	void applyRenderOrder();
-	void renormalizeBokehWeights();
-	void createApertureShapedDoFPoints();
+	void renormalizeWeightsPerCheckpointBlock();
+	int getCheckpointBlockSize();
+	void createPatternParameters(DepthOfFieldGeometryParameters& geometryParameters, DepthOfFieldWeightParameters& weightParameters);
+	float getEstimatedSecondsPerFrame();
+	float getEstimatedSecondsPerStep();
 
 	void displayScreenshotSessionStartError(const ScreenshotSessionStartReturnCode sessionStartResult);
 	/// <summary>
@@ -286,39 +379,17 @@ private:
 	/// <summary>
 	/// Method called after the game has rendered a frame and after reshade has rendered the reshade effects (and thus our shader)
 	/// </summary>
-	void handlePresentAfterReshadeEffects();
-	/// <summary>
-	/// Modifies the sample weight for the camera steps to produce spherical aberration based on radius from center
-	/// </summary>
-	/// <param name="radiusNormalized"></param>
-	/// <param name="sample"></param>
-	/// <returns></returns>
-	void applySphericalAberration(float radiusNormalized, CameraLocation& sample);
-	/// <summary>
-	/// Calculates the factor of the bokeh disc outline (fringe)
-	/// </summary>
-	/// <param name="ringRadiusNormalized"></param>
-	/// <param name="sampleAngle"></param>
-	/// <param name="sample"></param>
-	/// <returns></returns>
-	void applyFringe(float ringRadiusNormalized, float sampleAngle, CameraLocation& sample);
-	/// <summary>
-	/// Method which will setup the frame for blending, moving the camera, configuring the shader.
-	/// </summary>
-	void performRenderFrameSetupWork();
+	void handlePresentAfterReshadeEffects(reshade::api::effect_runtime* runtime);
 	/// <summary>
-	/// Calculates a dim factor for red/green/blue for a segment (1/3rd of the space has one channel be more prominent, the others are dimmed with this factor)
+	/// Captures the current frame as the frame of the step specified and hands it to the frame writer.
 	/// </summary>
-	/// <param name="angleSegment"></param>
-	/// <param name="segmentAngleMin"></param>
-	/// <param name="numberOfSegments"></param>
-	/// <returns></returns>
-	float calculateChannelDimFactor(float angleSegment, float segmentAngleMin, int numberOfSegments);
+	void captureFrameForOfflineRender(reshade::api::effect_runtime* runtime, int stepIndex);
+	std::string createOfflineCaptureFolderName();
 
-	bool isReshadeStateEmpty()
+	bool isUniformTableResolved()
 	{
-		std::scoped_lock lock(_reshadeStateMutex);
-		return _reshadeStateAtStart.isEmpty();
+		std::scoped_lock lock(_uniformTableMutex);
+		return _uniformTable.isResolved();
 	}
 
 	CameraToolsConnector& _cameraToolsConnector;
@@ -352,13 +423,11 @@ private:
 	int _onPresentWorkCounter = 0;		// if 0, reshadeBeginEffectsCalled will call onPresentWorkFunc (if set), otherwise this counter is decreased.
 
 	DepthOfFieldBlurType _blurType = DepthOfFieldBlurType::Circular;
-	DepthOfFieldRenderFrameState _renderFrameState = DepthOfFieldRenderFrameState::Off;
-	int _frameWaitCounter = 0;	// When 0 move the frameblend state to the next state, otherwise decrease
-	int _currentStepFrame = -1;		// < 0: no frame, >= 0 the current frame data to step the camera to, 0 based.
-	int _currentBlendFrame = -1;	// < 0: no frame, >= 0 the current frame data to blend, 0 based.
+	DepthOfFieldRenderPipeline _renderPipeline;
+	DepthOfFieldRenderTelemetry _renderTelemetry;
 	bool _renderPaused = false;
+	bool _stopAtCheckpointRequested = false;
 
-	int _numberOfFramesToRender = 0;
 	int _numberOfFramesToWait = 1;
 	int _quality;		// # of circles
 	int _numberOfPointsInnermostRing;
@@ -367,10 +436,29 @@ private:
 	DepthOfFieldRenderOrder _renderOrder = DepthOfFieldRenderOrder::InnerRingToOuterRing;
 	bool _showProgressBarAsOverlay = true;
 	ApertureShapeSettings _apertureShapeSettings;
+	std::string _apertureMaskFilename;		// grayscale image with the transmission of the aperture, for the ApertureMask blur type
 	DepthOfFieldFrameWaitType _frameWaitType = DepthOfFieldFrameWaitType::Fast;
+	bool _mergeNegligibleSamples = false;
+	float _sampleMergeTolerance = 0.01f;		// relative error allowed in the bokeh moments when merging samples
+	int _numberOfMergedSamples = 0;
+	std::vector<SampleReductionReportLine> _sampleReductionReport;
+	float _timeBudgetSeconds = 60.0f;
+	int _qualityForTimeBudget = -1;		// the result of calculateHighestQualityForTimeBudget, 0 if not even the lowest quality fits, -1 if not calculated
+	DepthOfFieldRenderMode _renderMode = DepthOfFieldRenderMode::Live;
+	DepthOfFieldOfflineOutputType _offlineOutputType = DepthOfFieldOfflineOutputType::Png;
+	std::string _offlineRootFolder;
+	std::vector<float> _bracketFocusDeltas;		// focus deltas composited from the frames of an offline render next to _focusDelta
+	DepthOfFieldCaptureSettings _offlineCaptureSettings;
+	DepthOfFieldFrameWriter _frameWriter;
+	DepthOfFieldCompositor _compositor;
+	int _stepToCapture = -1;		// the step of which the frame has to be captured after the effects have been rendered, -1 if none
 
-	ReshadeStateSnapshot _reshadeStateAtStart;
-	std::mutex _reshadeStateMutex;
+	DepthOfFieldPatternGenerator _patternGenerator;
+	ShaderUniformTable _uniformTable;		// handles of the uniforms in IgcsDof.fx, indexed by DepthOfFieldShaderUniform
+	std::mutex _uniformTableMutex;
+	// the size of the runtime the uniform values were written to. The value cache of _uniformTable is invalidated when it changes. Render thread only.
+	uint32_t _runtimeWidth = 0;
+	uint32_t _runtimeHeight = 0;
 
 	float _debugVal1 = 0.0f;
 	float _debugVal2 = 0.0f;
@@ -0,0 +1,685 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldPatternGenerator.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	constexpr float TWO_PI = 6.28318530717958f;
+	// a sample is a merge candidate if its weight is below this factor times the average weight
+	constexpr float NEGLIGIBLE_WEIGHT_FACTOR = 0.5f;
+	// the average number of samples per cell of the grid used to find the nearest neighbour when merging
+	constexpr int SAMPLES_PER_GRID_CELL = 2;
+
+	/// <summary>
+	/// Uniform grid over the samples of a pattern, to find the nearest neighbour of a sample without visiting all samples. Samples can be removed and
+	/// moved, as long as they stay within the bounds of the samples the grid was created with.
+	/// </summary>
+	class SampleGrid
+	{
+	public:
+		SampleGrid(const std::vector<float>& x, const std::vector<float>& y) : _x(x), _y(y)
+		{
+			const auto [minX, maxX] = std::ranges::minmax_element(x);
+			const auto [minY, maxY] = std::ranges::minmax_element(y);
+			_minX = *minX;
+			_minY = *minY;
+			const float extent = std::max(*maxX - _minX, *maxY - _minY);
+			const int cellsPerSide = std::max(1, (int)sqrtf((float)x.size() / (float)SAMPLES_PER_GRID_CELL));
+			_cellSize = extent > FLT_EPSILON ? extent / (float)cellsPerSide : 1.0f;
+			_numberOfCellsX = std::min(cellsPerSide, (int)((*maxX - _minX) / _cellSize)) + 1;
+			_numberOfCellsY = std::min(cellsPerSide, (int)((*maxY - _minY) / _cellSize)) + 1;
+			_cells.resize((size_t)_numberOfCellsX * _numberOfCellsY);
+			_cellPerSample.resize(x.size());
+			for(int i = 0; i < (int)x.size(); i++)
+			{
+				add(i);
+			}
+		}
+
+		void add(int sampleIndex)
+		{
+			const int cellIndex = getCellX(_x[sampleIndex]) + (getCellY(_y[sampleIndex]) * _numberOfCellsX);
+			_cellPerSample[sampleIndex] = cellIndex;
+			_cells[cellIndex].push_back(sampleIndex);
+		}
+
+		void remove(int sampleIndex)
+		{
+			auto& cell = _cells[_cellPerSample[sampleIndex]];
+			*std::ranges::find(cell, sampleIndex) = cell.back();
+			cell.pop_back();
+		}
+
+		/// <summary>
+		/// Returns the sample in the grid nearest to the position specified, the one with the lowest index if several are equally near, or -1 if the
+		/// grid is empty. The same sample a search over all samples in index order would return.
+		/// </summary>
+		int findNearest(float positionX, float positionY) const
+		{
+			const int centerX = getCellX(positionX);
+			const int centerY = getCellY(positionY);
+			const int maxRing = std::max(_numberOfCellsX, _numberOfCellsY);
+			int nearestIndex = -1;
+			float smallestDistanceSquared = FLT_MAX;
+			for(int ring = 0; ring <= maxRing; ring++)
+			{
+				// the cells of this ring are at least ring-1 cells away, so once that's further than the nearest sample found, we're done.
+				const float ringDistance = (float)(ring - 1) * _cellSize;
+				if(nearestIndex >= 0 && ring > 0 && (ringDistance * ringDistance) > smallestDistanceSquared)
+				{
+					break;
+				}
+				for(int cellY = std::max(0, centerY - ring); cellY <= std::min(_numberOfCellsY - 1, centerY + ring); cellY++)
+				{
+					const bool isEdgeRow = cellY == centerY - ring || cellY == centerY + ring;
+					// only the cells on the edge of the ring, the ones inside have been visited in an earlier ring.
+					const int stepX = isEdgeRow || 0 == ring ? 1 : 2 * ring;
+					for(int cellX = centerX - ring; cellX <= centerX + ring; cellX += stepX)
+					{
+						if(cellX < 0 || cellX >= _numberOfCellsX)
+						{
+							continue;
+						}
+						for(const int sampleIndex : _cells[cellX + (cellY * _numberOfCellsX)])
+						{
+							const float dx = _x[sampleIndex] - positionX;
+							const float dy = _y[sampleIndex] - positionY;
+							const float distanceSquared = (dx * dx) + (dy * dy);
+							if(distanceSquared < smallestDistanceSquared || (distanceSquared == smallestDistanceSquared && sampleIndex < nearestIndex))
+							{
+								smallestDistanceSquared = distanceSquared;
+								nearestIndex = sampleIndex;
+							}
+						}
+					}
+				}
+			}
+			return nearestIndex;
+		}
+
+	private:
+		int getCellX(float positionX) const { return std::clamp((int)((positionX - _minX) / _cellSize), 0, _numberOfCellsX - 1); }
+		int getCellY(float positionY) const { return std::clamp((int)((positionY - _minY) / _cellSize), 0, _numberOfCellsY - 1); }
+
+		const std::vector<float>& _x;
+		const std::vector<float>& _y;
+		float _minX = 0.0f;
+		float _minY = 0.0f;
+		float _cellSize = 1.0f;
+		int _numberOfCellsX = 1;
+		int _numberOfCellsY = 1;
+		std::vector<std::vector<int>> _cells;
+		std::vector<int> _cellPerSample;
+	};
+}
+
+
+void DepthOfFieldPatternGenerator::PatternGeometry::addSample(float sampleX, float sampleY, float saRadius, float ringRadius, float angle, float sampleTransmission)
+{
+	x.push_back(sampleX);
+	y.push_back(sampleY);
+	sphericalAberrationRadius.push_back(saRadius);
+	fringeRadius.push_back(ringRadius);
+	fringeAngle.push_back(angle);
+	transmission.push_back(sampleTransmission);
+}
+
+
+const DepthOfFieldSamplePattern& DepthOfFieldPatternGenerator::getPattern(const DepthOfFieldGeometryParameters& geometryParameters, const DepthOfFieldWeightParameters& weightParameters)
+{
+	// the mask cache reloads a mask if its file changed, in which case the geometry created from the old mask has to be recreated too.
+	std::shared_ptr<const DepthOfFieldApertureMask> apertureMask;
+	_apertureMaskError.clear();
+	if(DepthOfFieldBlurType::ApertureMask == geometryParameters.blurType)
+	{
+		apertureMask = _apertureMaskCache.getMask(geometryParameters.apertureMaskFilename, _apertureMaskError);
+	}
+	const auto cachedEntry = std::ranges::find_if(_cache, [&](const CacheEntry& entry) { return entry.geometryParameters == geometryParameters && entry.apertureMask == apertureMask; });
+	if(cachedEntry == _cache.end())
+	{
+		CacheEntry newEntry;
+		newEntry.geometryParameters = geometryParameters;
+		newEntry.apertureMask = apertureMask;
+		switch(geometryParameters.blurType)
+		{
+			case DepthOfFieldBlurType::ApertureMask:
+				createApertureMaskGeometry(geometryParameters, apertureMask.get(), newEntry.geometry);
+				break;
+			case DepthOfFieldBlurType::ApertureShape:
+				createApertureShapedGeometry(geometryParameters, newEntry.geometry);
+				break;
+			case DepthOfFieldBlurType::Circular:
+				createCircleGeometry(geometryParameters, newEntry.geometry);
+				break;
+		}
+		newEntry.pattern.x = newEntry.geometry.x;
+		newEntry.pattern.y = newEntry.geometry.y;
+		std::vector<int> indices(newEntry.geometry.x.size());
+		std::iota(indices.begin(), indices.end(), 0);
+		newEntry.pattern.progressiveOrder = createProgressiveOrder(std::move(indices), newEntry.geometry.x, newEntry.geometry.y);
+		if(_cache.size() >= MAX_NUMBER_OF_CACHED_PATTERNS)
+		{
+			_cache.pop_back();
+		}
+		_cache.insert(_cache.begin(), std::move(newEntry));
+	}
+	else
+	{
+		// move the entry to the front, so the least recently used entry is always at the back.
+		std::rotate(_cache.begin(), cachedEntry, cachedEntry + 1);
+	}
+
+	CacheEntry& entry = _cache.front();
+	if(!entry.hasWeights || !(entry.weightParameters == weightParameters))
+	{
+		calculateWeights(entry.geometry, weightParameters, geometryParameters.quality, entry.pattern);
+		entry.weightParameters = weightParameters;
+		entry.hasWeights = true;
+		entry.hasMergedPattern = false;
+	}
+	return entry.pattern;
+}
+
+
+const DepthOfFieldSamplePattern& DepthOfFieldPatternGenerator::getMergedPattern(const DepthOfFieldGeometryParameters& geometryParameters,
+																				 const DepthOfFieldWeightParameters& weightParameters, float mergeTolerance)
+{
+	getPattern(geometryParameters, weightParameters);
+	// getPattern moved the entry of the pattern to the front
+	CacheEntry& entry = _cache.front();
+	if(!entry.hasMergedPattern || entry.mergeTolerance != mergeTolerance)
+	{
+		entry.mergedPattern = entry.pattern;
+		mergeNegligibleSamples(entry.mergedPattern, mergeTolerance);
+		entry.mergeTolerance = mergeTolerance;
+		entry.hasMergedPattern = true;
+	}
+	return entry.mergedPattern;
+}
+
+
+void DepthOfFieldPatternGenerator::createCircleGeometry(const DepthOfFieldGeometryParameters& parameters, PatternGeometry& geometry)
+{
+	// center
+	geometry.addSample(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	const float pointsFirstRing = (float)parameters.numberOfPointsInnermostRing;
+	float pointsOnRing = pointsFirstRing;
+	for(int ringNo = 1; ringNo <= parameters.quality; ringNo++)
+	{
+		const float anglePerPoint = TWO_PI / pointsOnRing;
+		float angle = ((float)ringNo * parameters.ringAngleOffset);
+		const float ringDistance = (float)ringNo / (float)parameters.quality;
+		for(int pointNumber = 0; pointNumber < pointsOnRing; pointNumber++)
+		{
+			const float x = ringDistance * cos(angle) * parameters.anamorphicFactor;
+			const float y = ringDistance * sin(angle);
+			// angle 0 is on the right of the circle but we want it to be up top, so we subtract 1/2pi from it so the angle for the color is transposed 90 degrees.
+			geometry.addSample(x, y, ringDistance, ringDistance, fmod((angle - (TWO_PI / 4.0f)) + TWO_PI, TWO_PI));
+
+			angle += anglePerPoint;
+			angle = fmod(angle, TWO_PI);
+		}
+
+		pointsOnRing += pointsFirstRing;
+	}
+}
+
+
+void DepthOfFieldPatternGenerator::createApertureShapedGeometry(const DepthOfFieldGeometryParameters& parameters, PatternGeometry& geometry)
+{
+	// center
+	geometry.addSample(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	const float anglePerVertex = TWO_PI / (float)parameters.numberOfVertices;
+	for(int ringNo = 1; ringNo <= parameters.quality; ringNo++)
+	{
+		float vertexAngleForFringe = 0.0f;
+		// ring angle offset is applied stronger on inner rings than on outer rings, to keep the outer ring from staying in the same place. 
+		float vertexAngle = fmod((parameters.rotationAngle * TWO_PI) + ((float)(parameters.quality - ringNo) * parameters.ringAngleOffset), TWO_PI);
+		const float ringDistance = (float)ringNo / (float)parameters.quality;
+		for(int vertexNo = 0; vertexNo < parameters.numberOfVertices; vertexNo++)
+		{
+			const float nextVertexAngle = fmod(vertexAngle + anglePerVertex, TWO_PI);
+			const float xCurrentVertex = ringDistance * cos(vertexAngle);
+			const float yCurrentVertex = ringDistance * sin(vertexAngle);
+			const float xNextVertex = ringDistance * cos(nextVertexAngle);
+			const float yNextVertex = ringDistance * sin(nextVertexAngle);
+			const float pointStepSize = 1.0f / (float)ringNo;
+			float pointStep = pointStepSize;
+			for(int pointNumber = 0; pointNumber < ringNo; pointNumber++)
+			{
+				const float pointAngle = IGCS::Utils::lerp(vertexAngle, vertexAngle + anglePerVertex, pointStep);
+				const float pointAngleForFringe = IGCS::Utils::lerp(vertexAngleForFringe, vertexAngleForFringe + anglePerVertex, pointStep);
+				const float xRoundPoint = ringDistance * cos(pointAngle);
+				const float yRoundPoint = ringDistance * sin(pointAngle);
+				const float xLinePoint = IGCS::Utils::lerp(xCurrentVertex, xNextVertex, pointStep);
+				const float yLinePoint = IGCS::Utils::lerp(yCurrentVertex, yNextVertex, pointStep);
+				const float x = IGCS::Utils::lerp(xLinePoint, xRoundPoint, parameters.roundFactor);
+				const float y = IGCS::Utils::lerp(yLinePoint, yRoundPoint, parameters.roundFactor);
+				//cannot use ringDistance in polygonal mode, as spherical aberration is purely a factor of radius and ringDistance follows aperture shape
+				//hence use euclidean distance from center instead. However, spherical aberration happens before anamorphic film squeeze
+				//as the anamorphic lens is the last lens in front of the sensor/film
+				const float radiusNormalized = sqrtf(x * x + y * y);
+				geometry.addSample(x * parameters.anamorphicFactor, y, radiusNormalized, ringDistance, pointAngleForFringe);
+				pointStep += pointStepSize;
+			}
+			vertexAngle += anglePerVertex;
+			vertexAngle = fmod(vertexAngle, TWO_PI);
+			vertexAngleForFringe += anglePerVertex;
+			vertexAngleForFringe = fmod(vertexAngleForFringe, TWO_PI);
+		}
+	}
+}
+
+
+void DepthOfFieldPatternGenerator::createApertureMaskGeometry(const DepthOfFieldGeometryParameters& parameters, const DepthOfFieldApertureMask* mask, PatternGeometry& geometry)
+{
+	if(nullptr == mask)
+	{
+		geometry.addSample(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+		return;
+	}
+	const int numberOfSamples = 1 + (3 * parameters.quality * (parameters.quality + 1));
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> weights;
+	mask->createSamples(numberOfSamples, x, y, weights);
+	for(int i = 0; i < numberOfSamples; i++)
+	{
+		// the mask has no rings, so the fringe follows the radius, like with a circle.
+		const float radius = sqrtf((x[i] * x[i]) + (y[i] * y[i]));
+		const float angle = fmod(atan2f(y[i], x[i]) - (TWO_PI / 4.0f) + TWO_PI, TWO_PI);
+		geometry.addSample(x[i] * parameters.anamorphicFactor, y[i], radius, radius, angle, weights[i]);
+	}
+}
+
+
+std::vector<int> DepthOfFieldPatternGenerator::createProgressiveOrder(std::vector<int> indices, const std::vector<float>& x, const std::vector<float>& y)
+{
+	if(indices.size() <= 1)
+	{
+		return indices;
+	}
+
+	float minX = x[indices[0]];
+	float maxX = minX;
+	float minY = y[indices[0]];
+	float maxY = minY;
+	for(const int index : indices)
+	{
+		minX = std::min(minX, x[index]);
+		maxX = std::max(maxX, x[index]);
+		minY = std::min(minY, y[index]);
+		maxY = std::max(maxY, y[index]);
+	}
+	const std::vector<float>& splitAxis = (maxX - minX) >= (maxY - minY) ? x : y;
+	// ties are broken on index, so the order is deterministic
+	const auto middle = indices.begin() + (indices.size() / 2);
+	std::nth_element(indices.begin(), middle, indices.end(), [&](int a, int b) { return splitAxis[a] < splitAxis[b] || (splitAxis[a] == splitAxis[b] && a < b); });
+	const std::vector<int> firstHalf = createProgressiveOrder(std::vector<int>(indices.begin(), middle), x, y);
+	const std::vector<int> secondHalf = createProgressiveOrder(std::vector<int>(middle, indices.end()), x, y);
+
+	// interleave the two halves so after every pick the number of samples taken from each half is proportional to its size.
+	std::vector<int> toReturn;
+	toReturn.reserve(indices.size());
+	size_t firstIndex = 0;
+	size_t secondIndex = 0;
+	while(toReturn.size() < indices.size())
+	{
+		const bool takeFromFirst = secondIndex >= secondHalf.size() || 
+								   (firstIndex < firstHalf.size() && ((float)firstIndex + 0.5f) * (float)secondHalf.size() <= ((float)secondIndex + 0.5f) * (float)firstHalf.size());
+		toReturn.push_back(takeFromFirst ? firstHalf[firstIndex++] : secondHalf[secondIndex++]);
+	}
+	return toReturn;
+}
+
+
+void DepthOfFieldPatternGenerator::calculateWeights(const PatternGeometry& geometry, const DepthOfFieldWeightParameters& parameters, int quality, DepthOfFieldSamplePattern& pattern)
+{
+	const size_t numberOfSamples = geometry.x.size();
+	pattern.weightR.resize(numberOfSamples);
+	pattern.weightG.resize(numberOfSamples);
+	pattern.weightB.resize(numberOfSamples);
+
+	float weightSumRGB[3] = { 0.0f, 0.0f, 0.0f };
+	for(size_t i = 0; i < numberOfSamples; i++)
+	{
+		const float aberrationFactor = calculateSphericalAberrationFactor(geometry.sphericalAberrationRadius[i], parameters.sphericalAberrationDimFactor) * geometry.transmission[i];
+		float fringeFactorsRGB[3];
+		calculateFringeFactors(geometry.fringeRadius[i], geometry.fringeAngle[i], parameters, quality, fringeFactorsRGB);
+		pattern.weightR[i] = aberrationFactor * fringeFactorsRGB[0];
+		pattern.weightG[i] = aberrationFactor * fringeFactorsRGB[1];
+		pattern.weightB[i] = aberrationFactor * fringeFactorsRGB[2];
+		weightSumRGB[0] += pattern.weightR[i];
+		weightSumRGB[1] += pattern.weightG[i];
+		weightSumRGB[2] += pattern.weightB[i];
+	}
+
+	//renormalize bokeh weights so they do not scale the exposure or add a tint	
+	for(size_t i = 0; i < numberOfSamples; i++)
+	{
+		pattern.weightR[i] /= weightSumRGB[0];
+		pattern.weightG[i] /= weightSumRGB[1];
+		pattern.weightB[i] /= weightSumRGB[2];
+	}
+}
+
+
+float DepthOfFieldPatternGenerator::calculateSphericalAberrationFactor(float radiusNormalized, float dimFactor)
+{
+	//radius^4 yields plausible results, see for analysis https://jtra.cz/stuff/essays/bokeh/index.html
+	//this is theoretically incorrect, as aberration should be caused by light taking different paths, i.e. it could be
+	//emulated by modifying the camera angles and correctly deliver inverted bokeh in foreground, 
+	//however this would yield blurry focal areas which we don't want. So approximate it with sample masking
+
+	float aberrationCurve = radiusNormalized * radiusNormalized;
+	aberrationCurve *= aberrationCurve;
+
+	//lerp between flat profile and curve with intensity 0 in center
+	//*0.99 -> ensure samples in center are never _exactly_ zero, this avoids issues with renormalized sample weights
+	return (1.0f - dimFactor * 0.99f) + dimFactor * aberrationCurve * 0.99f;
+}
+
+
+float DepthOfFieldPatternGenerator::calculateChannelDimFactor(float angleSegment, float segmentAngleMin, int numberOfSegments)
+{
+	// using Iq's parabola using k==0.5, see: https://www.desmos.com/calculator/aszway25gw and https://iquilezles.org/articles/functions/
+	const float segmentSize = 1.0f / (float)(numberOfSegments == 0 ? 1 : numberOfSegments);
+	const float angleToSegmentNormalized = IGCS::Utils::clampEx(angleSegment - segmentAngleMin, 0.0f, segmentSize) / segmentSize;
+	return std::pow(4.0f * angleToSegmentNormalized * (1.0 - angleToSegmentNormalized), 0.5f);
+}
+
+
+void DepthOfFieldPatternGenerator::calculateFringeFactors(float ringRadiusNormalized, float sampleAngle, const DepthOfFieldWeightParameters& parameters, int quality, float factorsRGB[3])
+{
+	const float transitionWidth = 0.5f / (float)quality;
+	// perform a linear step with the spacing of a ring radius
+
+	//(x-a)/(b-a)
+	const float fringeRampStart = 1.0f - parameters.fringeWidth - transitionWidth;
+	const float fringeRampEnd = 1.0f - parameters.fringeWidth + transitionWidth;
+	const float fringeMask = IGCS::Utils::clampEx((ringRadiusNormalized - fringeRampStart) / (fringeRampEnd - fringeRampStart), 0.0f, 1.0f);
+	const float fringeFactor = (1.0f - parameters.fringeIntensity) * (1.0f - fringeMask) + fringeMask;
+
+	// factors for the dimming. 1.0 means visible, 0.0 means dimmed 100%
+	float blueFactor = 1.0f;
+	float greenFactor = 1.0f;
+	float redFactor = 1.0f;
+	const float angleSegment = sampleAngle / TWO_PI;
+	// for 3 segments: 
+	// 0-0.33333: blue, 0.33333-0.6666: green, 0.6666-1: red
+	// for 2 segments, the two colors in the type both have 0.5
+
+	DepthOfFieldColorChannel segmentOneProminentColor = DepthOfFieldColorChannel::Red;
+	DepthOfFieldColorChannel segmentTwoProminentColor = DepthOfFieldColorChannel::Green;
+	DepthOfFieldColorChannel segmentThreeProminentColor = DepthOfFieldColorChannel::Blue;
+
+	int numberOfSegments = 3;
+	switch(parameters.caType)
+	{
+		case DepthOfFieldCAType::RGB:
+			// The defaults are ok for this setup
+			break;
+		case DepthOfFieldCAType::RG:
+			numberOfSegments = 2;
+			// prominent color defaults are ok for this setup
+			break;
+		case DepthOfFieldCAType::RB:
+			numberOfSegments = 2;
+			segmentTwoProminentColor = DepthOfFieldColorChannel::Blue;
+			break;
+		case DepthOfFieldCAType::BG:
+			numberOfSegments = 2;
+			segmentOneProminentColor = DepthOfFieldColorChannel::Blue;
+			break;
+	}
+	const float segmentOneMaxAngle = 1.0f / (float)numberOfSegments;
+	const float segmentTwoMaxAngle = 2.0f / (float)numberOfSegments;
+
+	bool redChannelDimmable = true;
+	bool greenChannelDimmable = true;
+	bool blueChannelDimmable = true;
+	float dimFactor = 0.0f;
+	// cheap filter out segments and apply operands. Per segment a channel is prominent and the others are dimmed graciously
+	// execution flow will always arrive in 1 if handler below so we can use that to our advantage with setting flags for the final calculations
+	if(angleSegment <= segmentOneMaxAngle)
+	{
+		dimFactor = 1.0f - calculateChannelDimFactor(angleSegment, 0.0f, numberOfSegments);
+		redChannelDimmable = segmentOneProminentColor != DepthOfFieldColorChannel::Red;
+		greenChannelDimmable = segmentOneProminentColor != DepthOfFieldColorChannel::Green;
+		blueChannelDimmable = segmentOneProminentColor != DepthOfFieldColorChannel::Blue;
+	}
+	else
+	{
+		if(angleSegment <= segmentTwoMaxAngle)
+		{
+			// last segment for 2 colors, middle segment for 3 colors
+			dimFactor = 1.0f - calculateChannelDimFactor(angleSegment, segmentOneMaxAngle, numberOfSegments);
+			redChannelDimmable = segmentTwoProminentColor != DepthOfFieldColorChannel::Red;
+			greenChannelDimmable = segmentTwoProminentColor != DepthOfFieldColorChannel::Green;
+			blueChannelDimmable = segmentTwoProminentColor != DepthOfFieldColorChannel::Blue;
+		}
+		else
+		{
+			// last segment for 3 colors, for 2 color ca we'll never end up here. 
+			dimFactor = 1.0f - calculateChannelDimFactor(angleSegment, segmentTwoMaxAngle, numberOfSegments);
+			redChannelDimmable = segmentThreeProminentColor != DepthOfFieldColorChannel::Red;
+			greenChannelDimmable = segmentThreeProminentColor != DepthOfFieldColorChannel::Green;
+			blueChannelDimmable = segmentThreeProminentColor != DepthOfFieldColorChannel::Blue;
+		}
+	}
+
+	const float caRampStart = 1.0f - parameters.caWidth - transitionWidth;
+	const float caRampEnd = 1.0f - parameters.caWidth + transitionWidth;
+	const float caMask = IGCS::Utils::clampEx((ringRadiusNormalized - caRampStart) / (caRampEnd - caRampStart), 0.0f, 1.0f);
+	const float caFactor = parameters.caStrength * caMask;
+
+	redFactor = redChannelDimmable ? IGCS::Utils::lerp(dimFactor, 1.0f, (1.0f - caFactor)) : redFactor;
+	greenFactor = greenChannelDimmable ? IGCS::Utils::lerp(dimFactor, 1.0f, (1.0f - caFactor)) : greenFactor;
+	blueFactor = blueChannelDimmable ? IGCS::Utils::lerp(dimFactor, 1.0f, (1.0f - caFactor)) : blueFactor;
+
+	factorsRGB[0] = fringeFactor * redFactor;
+	factorsRGB[1] = fringeFactor * greenFactor;
+	factorsRGB[2] = fringeFactor * blueFactor;
+}
+
+
+void DepthOfFieldPatternGenerator::mergeNegligibleSamples(DepthOfFieldSamplePattern& pattern, float tolerance)
+{
+	pattern.numberOfMergedSamples = 0;
+	const int numberOfSamples = pattern.size();
+	if(numberOfSamples <= 2 || tolerance <= 0.0f)
+	{
+		return;
+	}
+	std::vector<float>* weightsPerChannel[3] = { &pattern.weightR, &pattern.weightG, &pattern.weightB };
+	auto getSampleWeight = [&](int index) { return pattern.weightR[index] + pattern.weightG[index] + pattern.weightB[index]; };
+
+	// The moments we keep within the tolerance, per channel: the first moment (the weighted center of the bokeh) relative to the weighted mean radius
+	// and the second moment (the weighted spread, so the size of the bokeh) relative to its total. 
+	float meanRadiusPerChannel[3] = { 0.0f, 0.0f, 0.0f };
+	float secondMomentPerChannel[3] = { 0.0f, 0.0f, 0.0f };
+	float totalWeight = 0.0f;
+	for(int i = 0; i < numberOfSamples; i++)
+	{
+		const float radiusSquared = (pattern.x[i] * pattern.x[i]) + (pattern.y[i] * pattern.y[i]);
+		for(int channel = 0; channel < 3; channel++)
+		{
+			const float channelWeight = (*weightsPerChannel[channel])[i];
+			meanRadiusPerChannel[channel] += channelWeight * sqrtf(radiusSquared);
+			secondMomentPerChannel[channel] += channelWeight * radiusSquared;
+			totalWeight += channelWeight;
+		}
+	}
+	const float negligibleWeight = NEGLIGIBLE_WEIGHT_FACTOR * (totalWeight / (float)numberOfSamples);
+
+	std::vector<int> candidates;
+	for(int i = 0; i < numberOfSamples; i++)
+	{
+		if(getSampleWeight(i) < negligibleWeight)
+		{
+			candidates.push_back(i);
+		}
+	}
+	// merge the lightest samples first, as these have the least impact
+	std::ranges::stable_sort(candidates, [&](int a, int b) { return getSampleWeight(a) < getSampleWeight(b); });
+
+	SampleGrid grid(pattern.x, pattern.y);
+	std::vector<bool> isMerged(numberOfSamples, false);
+	float firstMomentError[3] = { 0.0f, 0.0f, 0.0f };
+	float secondMomentError[3] = { 0.0f, 0.0f, 0.0f };
+	int numberOfMergedSamples = 0;
+	for(const int candidateIndex : candidates)
+	{
+		// the candidate isn't its own neighbour. It's added back if it's not merged.
+		grid.remove(candidateIndex);
+		const int neighbourIndex = grid.findNearest(pattern.x[candidateIndex], pattern.y[candidateIndex]);
+		if(neighbourIndex < 0)
+		{
+			break;
+		}
+		const float candidateX = pattern.x[candidateIndex];
+		const float candidateY = pattern.y[candidateIndex];
+		const float neighbourX = pattern.x[neighbourIndex];
+		const float neighbourY = pattern.y[neighbourIndex];
+
+		// the merged sample is placed at the weighted center of the two, which keeps the overall first moment unchanged.
+		const float candidateWeight = getSampleWeight(candidateIndex);
+		const float neighbourWeight = getSampleWeight(neighbourIndex);
+		const float mergedWeight = candidateWeight + neighbourWeight;
+		const float candidateFactor = mergedWeight > FLT_EPSILON ? candidateWeight / mergedWeight : 0.0f;
+		const float neighbourFactor = 1.0f - candidateFactor;
+		const float mergedX = (candidateX * candidateFactor) + (neighbourX * neighbourFactor);
+		const float mergedY = (candidateY * candidateFactor) + (neighbourY * neighbourFactor);
+		const float mergedRadiusSquared = (mergedX * mergedX) + (mergedY * mergedY);
+
+		// with chromatic aberration the channels have different ratios, so per channel the moments do shift.
+		float newFirstMomentError[3];
+		float newSecondMomentError[3];
+		bool withinTolerance = true;
+		for(int channel = 0; channel < 3; channel++)
+		{
+			const float candidateChannelWeight = (*weightsPerChannel[channel])[candidateIndex];
+			const float neighbourChannelWeight = (*weightsPerChannel[channel])[neighbourIndex];
+			const float mergedChannelWeight = candidateChannelWeight + neighbourChannelWeight;
+			const float firstMomentDeltaX = (candidateChannelWeight * candidateX) + (neighbourChannelWeight * neighbourX) - (mergedChannelWeight * mergedX);
+			const float firstMomentDeltaY = (candidateChannelWeight * candidateY) + (neighbourChannelWeight * neighbourY) - (mergedChannelWeight * mergedY);
+			const float secondMomentDelta = (candidateChannelWeight * ((candidateX * candidateX) + (candidateY * candidateY))) +
+											(neighbourChannelWeight * ((neighbourX * neighbourX) + (neighbourY * neighbourY))) -
+											(mergedChannelWeight * mergedRadiusSquared);
+			newFirstMomentError[channel] = firstMomentError[channel] + sqrtf((firstMomentDeltaX * firstMomentDeltaX) + (firstMomentDeltaY * firstMomentDeltaY));
+			newSecondMomentError[channel] = secondMomentError[channel] + fabsf(secondMomentDelta);
+			withinTolerance &= newFirstMomentError[channel] <= tolerance * meanRadiusPerChannel[channel] &&
+							   newSecondMomentError[channel] <= tolerance * secondMomentPerChannel[channel];
+		}
+		if(!withinTolerance)
+		{
+			// a heavier candidate further along might still fit, so keep going
+			grid.add(candidateIndex);
+			continue;
+		}
+
+		for(int channel = 0; channel < 3; channel++)
+		{
+			firstMomentError[channel] = newFirstMomentError[channel];
+			secondMomentError[channel] = newSecondMomentError[channel];
+			(*weightsPerChannel[channel])[neighbourIndex] += (*weightsPerChannel[channel])[candidateIndex];
+		}
+		grid.remove(neighbourIndex);
+		pattern.x[neighbourIndex] = mergedX;
+		pattern.y[neighbourIndex] = mergedY;
+		grid.add(neighbourIndex);
+		isMerged[candidateIndex] = true;
+		numberOfMergedSamples++;
+	}
+	if(numberOfMergedSamples <= 0)
+	{
+		return;
+	}
+
+	// remove the merged samples, keeping the order of the others, also in the progressive order, and renormalize so each channel sums to 1 again.
+	std::vector<int> newIndexPerSample(numberOfSamples, -1);
+	int writeIndex = 0;
+	for(int i = 0; i < numberOfSamples; i++)
+	{
+		if(isMerged[i])
+		{
+			continue;
+		}
+		newIndexPerSample[i] = writeIndex;
+		pattern.x[writeIndex] = pattern.x[i];
+		pattern.y[writeIndex] = pattern.y[i];
+		for(auto* channelWeights : weightsPerChannel)
+		{
+			(*channelWeights)[writeIndex] = (*channelWeights)[i];
+		}
+		writeIndex++;
+	}
+	pattern.x.resize(writeIndex);
+	pattern.y.resize(writeIndex);
+	for(auto* channelWeights : weightsPerChannel)
+	{
+		channelWeights->resize(writeIndex);
+		float channelSum = 0.0f;
+		for(const float weight : *channelWeights)
+		{
+			channelSum += weight;
+		}
+		if(channelSum < FLT_EPSILON)
+		{
+			continue;
+		}
+		for(float& weight : *channelWeights)
+		{
+			weight /= channelSum;
+		}
+	}
+	std::vector<int> mergedProgressiveOrder;
+	mergedProgressiveOrder.reserve(writeIndex);
+	for(const int sampleIndex : pattern.progressiveOrder)
+	{
+		if(newIndexPerSample[sampleIndex] >= 0)
+		{
+			mergedProgressiveOrder.push_back(newIndexPerSample[sampleIndex]);
+		}
+	}
+	pattern.progressiveOrder = std::move(mergedProgressiveOrder);
+	pattern.numberOfMergedSamples = numberOfMergedSamples;
+}
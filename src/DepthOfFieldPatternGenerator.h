@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ConstantsEnums.h"
+#include "DepthOfFieldApertureMask.h"
+
+/// <summary>
+/// The parameters which define the positions of the samples in a depth of field pattern. 
+/// </summary>
+struct DepthOfFieldGeometryParameters
+{
+	DepthOfFieldBlurType blurType = DepthOfFieldBlurType::Circular;
+	int quality = 4;
+	int numberOfPointsInnermostRing = 3;
+	float ringAngleOffset = 0.0f;
+	float anamorphicFactor = 1.0f;
+	int numberOfVertices = 4;
+	float rotationAngle = 0.0f;
+	float roundFactor = 0.25f;
+	std::string apertureMaskFilename;			// only used for the ApertureMask blur type
+
+	bool operator==(const DepthOfFieldGeometryParameters&) const = default;
+};
+
+/// <summary>
+/// The parameters which define the weights of the samples in a depth of field pattern. These don't change the sample positions.
+/// </summary>
+struct DepthOfFieldWeightParameters
+{
+	float sphericalAberrationDimFactor = 0.5f;
+	float fringeIntensity = 0.0f;
+	float fringeWidth = 0.1f;
+	float caStrength = 0.0f;
+	float caWidth = 0.1f;
+	DepthOfFieldCAType caType = DepthOfFieldCAType::RGB;
+
+	bool operator==(const DepthOfFieldWeightParameters&) const = default;
+};
+
+/// <summary>
+/// A depth of field sample pattern, in structure-of-arrays form, ordered from the center sample to the outer ring. Positions are normalized, so a
+/// position of 1.0 is at the max bokeh radius, anamorphic scaling has been applied. Weights per channel are normalized to sum up to 1.
+/// </summary>
+struct DepthOfFieldSamplePattern
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> weightR;
+	std::vector<float> weightG;
+	std::vector<float> weightB;
+	std::vector<int> progressiveOrder;		// sample indices in an order where every prefix is spread evenly over the pattern.
+	int numberOfMergedSamples = 0;			// the number of samples merged away, see DepthOfFieldPatternGenerator::getMergedPattern
+
+	size_t size() const { return x.size(); }
+};
+
+/// <summary>
+/// Generates depth of field sample patterns. Generation is split in a geometry pass, which produces the sample positions and the per sample
+/// inputs for the weight calculations, and a weight pass which runs over these arrays. Both are cached: geometries in a small most-recently-used cache
+/// keyed by the geometry parameters, and per geometry the last weights, keyed by the weight parameters. Dragging a fringe or CA slider therefore only
+/// reruns the weight pass, and going back to an earlier shape doesn't regenerate anything. The pattern with the negligible samples merged is cached
+/// per geometry as well, with the weights, so only a change of the pattern or the tolerance merges again.
+/// </summary>
+class DepthOfFieldPatternGenerator
+{
+public:
+	DepthOfFieldPatternGenerator() = default;
+	~DepthOfFieldPatternGenerator() = default;
+
+	/// <summary>
+	/// Gets the pattern for the parameters specified, from the cache if possible. The returned reference is valid till the next call.
+	/// </summary>
+	/// <param name="geometryParameters"></param>
+	/// <param name="weightParameters"></param>
+	/// <returns></returns>
+	const DepthOfFieldSamplePattern& getPattern(const DepthOfFieldGeometryParameters& geometryParameters, const DepthOfFieldWeightParameters& weightParameters);
+	/// <summary>
+	/// Gets the pattern for the parameters specified with the samples with a negligible weight merged into their nearest neighbour, as long as the
+	/// weighted first and second moments of the bokeh per channel stay within mergeTolerance (relative). The remaining samples are renormalized and
+	/// keep their order, also in the progressive order. The merged pattern is cached with the pattern, keyed on the tolerance. The returned reference
+	/// is valid till the next call.
+	/// </summary>
+	const DepthOfFieldSamplePattern& getMergedPattern(const DepthOfFieldGeometryParameters& geometryParameters, const DepthOfFieldWeightParameters& weightParameters,
+													  float mergeTolerance);
+	/// <summary>
+	/// The reason the aperture mask of the last pattern requested couldn't be used, or empty if it could be used or wasn't needed. Without a usable
+	/// mask the ApertureMask pattern only contains the center sample.
+	/// </summary>
+	const std::string& getApertureMaskError() { return _apertureMaskError; }
+
+private:
+	/// <summary>
+	/// Sample positions plus the values the weight pass needs per sample, in structure-of-arrays form.
+	/// </summary>
+	struct PatternGeometry
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> sphericalAberrationRadius;		// radius before the anamorphic squeeze
+		std::vector<float> fringeRadius;					// ring distance, which follows the aperture shape
+		std::vector<float> fringeAngle;						// angle in radians, 0 is up
+		std::vector<float> transmission;					// weight factor of the aperture at the sample, 1.0 for the generated shapes
+
+		void addSample(float sampleX, float sampleY, float saRadius, float ringRadius, float angle, float sampleTransmission = 1.0f);
+	};
+
+	struct CacheEntry
+	{
+		DepthOfFieldGeometryParameters geometryParameters;
+		PatternGeometry geometry;
+		std::shared_ptr<const DepthOfFieldApertureMask> apertureMask;		// the mask the geometry was created from, if any
+		bool hasWeights = false;
+		DepthOfFieldWeightParameters weightParameters;
+		DepthOfFieldSamplePattern pattern;
+		bool hasMergedPattern = false;		// reset when the weights change
+		float mergeTolerance = 0.0f;
+		DepthOfFieldSamplePattern mergedPattern;
+	};
+
+	static void createCircleGeometry(const DepthOfFieldGeometryParameters& parameters, PatternGeometry& geometry);
+	static void createApertureShapedGeometry(const DepthOfFieldGeometryParameters& parameters, PatternGeometry& geometry);
+	/// <summary>
+	/// Creates the geometry by sampling the aperture mask. The number of samples is the same as the one of a circle with 6 points on the innermost ring
+	/// at the same quality, so quality levels are comparable between the blur types.
+	/// </summary>
+	static void createApertureMaskGeometry(const DepthOfFieldGeometryParameters& parameters, const DepthOfFieldApertureMask* mask, PatternGeometry& geometry);
+	/// <summary>
+	/// Creates an ordering of the samples where every prefix is spatially stratified: the samples are recursively split at the median of the axis with
+	/// the largest extent, and the orderings of the two halves are interleaved proportionally to their sizes. A prefix therefore contains samples from
+	/// every kd-tree cell at the level matching its length, instead of e.g. only the inner rings.
+	/// </summary>
+	static std::vector<int> createProgressiveOrder(std::vector<int> indices, const std::vector<float>& x, const std::vector<float>& y);
+	static void calculateWeights(const PatternGeometry& geometry, const DepthOfFieldWeightParameters& parameters, int quality, DepthOfFieldSamplePattern& pattern);
+	/// <summary>
+	/// Merges the samples with a negligible weight in pattern, see getMergedPattern. The nearest neighbours are looked up in a uniform grid, so this is
+	/// cheap enough to run for every quality level.
+	/// </summary>
+	static void mergeNegligibleSamples(DepthOfFieldSamplePattern& pattern, float tolerance);
+	/// <summary>
+	/// Calculates the dim factor for spherical aberration based on radius from center
+	/// </summary>
+	static float calculateSphericalAberrationFactor(float radiusNormalized, float dimFactor);
+	/// <summary>
+	/// Calculates the factors per channel for the bokeh disc outline (fringe) and the chromatic aberration
+	/// </summary>
+	static void calculateFringeFactors(float ringRadiusNormalized, float sampleAngle, const DepthOfFieldWeightParameters& parameters, int quality, float factorsRGB[3]);
+	/// <summary>
+	/// Calculates a dim factor for red/green/blue for a segment (1/3rd of the space has one channel be more prominent, the others are dimmed with this factor)
+	/// </summary>
+	static float calculateChannelDimFactor(float angleSegment, float segmentAngleMin, int numberOfSegments);
+
+	static constexpr size_t MAX_NUMBER_OF_CACHED_PATTERNS = 8;
+	std::vector<CacheEntry> _cache;		// most recently used first
+	DepthOfFieldApertureMaskCache _apertureMaskCache;
+	std::string _apertureMaskError;
+};
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldRenderPipeline.h"
+#include <algorithm>
+
+void DepthOfFieldRenderPipeline::start(int numberOfSteps, int latencyInFrames, int maxNumberOfStepsInFlight)
+{
+	_stepsInFlight.clear();
+	_currentFrame = 0;
+	_numberOfStepsToRender = std::max(numberOfSteps, 0);
+	_nextStepToIssue = 0;
+	_numberOfStepsBlended = 0;
+	_latencyInFrames = std::max(latencyInFrames, 1);
+	_maxNumberOfStepsInFlight = std::clamp(maxNumberOfStepsInFlight, 1, _latencyInFrames);
+}
+
+
+int DepthOfFieldRenderPipeline::beginFrame()
+{
+	_currentFrame++;
+	if(_stepsInFlight.empty())
+	{
+		return -1;
+	}
+	const StepInFlight& oldestStep = _stepsInFlight.front();
+	if(oldestStep.frameIssued + _latencyInFrames > _currentFrame)
+	{
+		// the camera move isn't visible yet
+		return -1;
+	}
+	// At most one move is issued per frame and a visible move is always blended in the frame it becomes visible, so the oldest move is the one visible now.
+	const int stepToBlend = oldestStep.stepIndex;
+	_stepsInFlight.pop_front();
+	_numberOfStepsBlended++;
+	return stepToBlend;
+}
+
+
+int DepthOfFieldRenderPipeline::endFrame(bool paused)
+{
+	if(paused || _nextStepToIssue >= _numberOfStepsToRender || (int)_stepsInFlight.size() >= _maxNumberOfStepsInFlight)
+	{
+		return -1;
+	}
+	const int stepToIssue = _nextStepToIssue;
+	_stepsInFlight.push_back({ stepToIssue, _currentFrame });
+	_nextStepToIssue++;
+	return stepToIssue;
+}
+
+
+void DepthOfFieldRenderPipeline::setNumberOfStepsToRender(int numberOfSteps)
+{
+	_numberOfStepsToRender = std::max(numberOfSteps, 0);
+	// steps are issued in order, so the ones beyond the new end are at the back.
+	while(!_stepsInFlight.empty() && _stepsInFlight.back().stepIndex >= _numberOfStepsToRender)
+	{
+		_stepsInFlight.pop_back();
+	}
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+/// <summary>
+/// Schedules the camera moves and frame blends of a depth of field render. A camera move issued at the end of frame F is visible in the frame presented
+/// at F + latency. The pipeline keeps up to a given number of moves in flight: with as many moves in flight as the latency, a camera move is issued every
+/// frame and after warm-up every presented frame is blended; with a single move in flight every step waits the full latency. Each blended frame
+/// is the step whose camera move is visible in that frame, so the alignment and weights of that step have to be used for it.
+/// When paused, no new moves are issued but the moves in flight are still blended (the pipeline drains), so after unpausing no frame is blended
+/// with a camera position belonging to another step.
+/// </summary>
+class DepthOfFieldRenderPipeline
+{
+public:
+	DepthOfFieldRenderPipeline() = default;
+	~DepthOfFieldRenderPipeline() = default;
+
+	/// <summary>
+	/// Resets the pipeline and starts a new render.
+	/// </summary>
+	/// <param name="numberOfSteps">the number of camera steps in the render</param>
+	/// <param name="latencyInFrames">the number of frames between issuing a camera move and the frame which shows it. At least 1.</param>
+	/// <param name="maxNumberOfStepsInFlight">the max number of camera moves issued but not yet blended. Clamped to 1...latencyInFrames.</param>
+	void start(int numberOfSteps, int latencyInFrames, int maxNumberOfStepsInFlight);
+	/// <summary>
+	/// Called at the start of a presented frame, before the effects are rendered.
+	/// </summary>
+	/// <returns>the index of the step to blend in this frame, or -1 if this frame doesn't have to be blended</returns>
+	int beginFrame();
+	/// <summary>
+	/// Called at the end of a presented frame, after the effects have been rendered.
+	/// </summary>
+	/// <param name="paused">if true, no new camera move is issued</param>
+	/// <returns>the index of the step to move the camera to, or -1 if the camera doesn't have to move</returns>
+	int endFrame(bool paused);
+	/// <summary>
+	/// Limits the render to the first numberOfSteps steps. Moves in flight for steps beyond that are dropped.
+	/// </summary>
+	void setNumberOfStepsToRender(int numberOfSteps);
+
+	bool isComplete() { return _numberOfStepsBlended >= _numberOfStepsToRender; }
+	int getNumberOfStepsBlended() { return _numberOfStepsBlended; }
+	int getNumberOfStepsToRender() { return _numberOfStepsToRender; }
+	int getNumberOfStepsInFlight() { return _stepsInFlight.size(); }
+
+private:
+	struct StepInFlight
+	{
+		int stepIndex = 0;
+		int64_t frameIssued = 0;
+	};
+
+	std::deque<StepInFlight> _stepsInFlight;
+	int64_t _currentFrame = 0;
+	int _numberOfStepsToRender = 0;
+	int _nextStepToIssue = 0;
+	int _numberOfStepsBlended = 0;
+	int _latencyInFrames = 1;
+	int _maxNumberOfStepsInFlight = 1;
+};
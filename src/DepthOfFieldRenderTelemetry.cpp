@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldRenderTelemetry.h"
+#include "Utils.h"
+#include <algorithm>
+
+using namespace std::chrono;
+
+namespace
+{
+	// Weight of a new interval in the moving averages. Low enough to smooth out frame time spikes, high enough to follow e.g. a change in the
+	// framerate of the game within a few dozen steps.
+	constexpr double AVERAGE_SMOOTHING_FACTOR = 0.1;
+
+
+	double secondsBetween(high_resolution_clock::time_point start, high_resolution_clock::time_point end)
+	{
+		return duration<double>(end - start).count();
+	}
+}
+
+
+void DepthOfFieldRenderTelemetry::start(int numberOfSteps)
+{
+	_stepTimings.assign(std::max(numberOfSteps, 0), StepTiming());
+	_renderStartTime = high_resolution_clock::now();
+	_currentFrame = 0;
+	_lastBlendFrame = -1;
+	_stepBlendedThisFrame = -1;
+	_intervalContainsPause = false;
+	_numberOfIntervalsMeasured = 0;
+	_averageSecondsPerStep = 0.0;
+	_averageFramesPerStep = 0.0;
+	_minSecondsPerStep = 0.0;
+	_maxSecondsPerStep = 0.0;
+}
+
+
+void DepthOfFieldRenderTelemetry::stepIssued(int stepIndex, high_resolution_clock::time_point commandStartTime)
+{
+	if(stepIndex < 0 || stepIndex >= (int)_stepTimings.size())
+	{
+		return;
+	}
+	StepTiming& timing = _stepTimings[stepIndex];
+	timing.issueTime = commandStartTime;
+	timing.issueFrame = _currentFrame;
+	timing.commandSeconds = secondsBetween(commandStartTime, high_resolution_clock::now());
+}
+
+
+void DepthOfFieldRenderTelemetry::stepBlendStarted(int stepIndex)
+{
+	if(stepIndex < 0 || stepIndex >= (int)_stepTimings.size())
+	{
+		return;
+	}
+	const auto now = high_resolution_clock::now();
+	StepTiming& timing = _stepTimings[stepIndex];
+	timing.blendStartTime = now;
+	timing.blendFrame = _currentFrame;
+	_stepBlendedThisFrame = stepIndex;
+
+	// the interval between two blends is the time a step effectively takes, also when several camera moves are in flight.
+	if(_lastBlendFrame >= 0 && !_intervalContainsPause)
+	{
+		const double secondsPerStep = secondsBetween(_lastBlendTime, now);
+		const double framesPerStep = (double)(_currentFrame - _lastBlendFrame);
+		const double secondsPerFrame = secondsPerStep / std::max(framesPerStep, 1.0);
+		if(0 == _numberOfIntervalsMeasured)
+		{
+			_averageSecondsPerStep = secondsPerStep;
+			_averageFramesPerStep = framesPerStep;
+			_averageSecondsPerFrame = secondsPerFrame;
+			_minSecondsPerStep = secondsPerStep;
+			_maxSecondsPerStep = secondsPerStep;
+		}
+		else
+		{
+			_averageSecondsPerStep += AVERAGE_SMOOTHING_FACTOR * (secondsPerStep - _averageSecondsPerStep);
+			_averageFramesPerStep += AVERAGE_SMOOTHING_FACTOR * (framesPerStep - _averageFramesPerStep);
+			_averageSecondsPerFrame += AVERAGE_SMOOTHING_FACTOR * (secondsPerFrame - _averageSecondsPerFrame);
+			_minSecondsPerStep = std::min(_minSecondsPerStep, secondsPerStep);
+			_maxSecondsPerStep = std::max(_maxSecondsPerStep, secondsPerStep);
+		}
+		_numberOfIntervalsMeasured++;
+	}
+	_lastBlendTime = now;
+	_lastBlendFrame = _currentFrame;
+	_intervalContainsPause = false;
+}
+
+
+void DepthOfFieldRenderTelemetry::frameEnded(bool paused)
+{
+	if(_stepBlendedThisFrame >= 0)
+	{
+		StepTiming& timing = _stepTimings[_stepBlendedThisFrame];
+		timing.blendFrameSeconds = secondsBetween(timing.blendStartTime, high_resolution_clock::now());
+		_stepBlendedThisFrame = -1;
+	}
+	_intervalContainsPause |= paused;
+	_currentFrame++;
+}
+
+
+void DepthOfFieldRenderTelemetry::logSummary(bool wasCancelled)
+{
+	int numberOfStepsBlended = 0;
+	double totalCommandSeconds = 0.0;
+	double totalWaitSeconds = 0.0;
+	double totalBlendFrameSeconds = 0.0;
+	int64_t totalWaitFrames = 0;
+	for(const StepTiming& timing : _stepTimings)
+	{
+		if(timing.blendFrame < 0 || timing.issueFrame < 0)
+		{
+			continue;
+		}
+		numberOfStepsBlended++;
+		totalCommandSeconds += timing.commandSeconds;
+		totalWaitSeconds += secondsBetween(timing.issueTime, timing.blendStartTime);
+		totalWaitFrames += timing.blendFrame - timing.issueFrame;
+		totalBlendFrameSeconds += timing.blendFrameSeconds;
+	}
+	const double totalSeconds = secondsBetween(_renderStartTime, high_resolution_clock::now());
+	const double divisor = (double)std::max(numberOfStepsBlended, 1);
+	IGCS::Utils::logLineToReshade(reshade::log_level::info, "Dof render %s: %d of %d steps in %s, %lld frames. Per step: %.1f ms (min %.1f ms, max %.1f ms), %.2f frames. "
+								  "Camera command: %.2f ms, camera move to blend: %.1f ms (%.2f frames), blend frame: %.2f ms",
+								  wasCancelled ? "cancelled" : "completed", numberOfStepsBlended, (int)_stepTimings.size(), formatDuration((float)totalSeconds).c_str(), 
+								  (long long)_currentFrame, totalSeconds * 1000.0 / divisor, _minSecondsPerStep * 1000.0, _maxSecondsPerStep * 1000.0, 
+								  (double)_currentFrame / divisor, totalCommandSeconds * 1000.0 / divisor, totalWaitSeconds * 1000.0 / divisor,
+								  (double)totalWaitFrames / divisor, totalBlendFrameSeconds * 1000.0 / divisor);
+}
+
+
+std::string DepthOfFieldRenderTelemetry::formatDuration(float seconds)
+{
+	const int totalSeconds = std::max(0, (int)(seconds + 0.5f));
+	if(totalSeconds >= 3600)
+	{
+		return IGCS::Utils::formatString("%d:%.2d:%.2d", totalSeconds / 3600, (totalSeconds / 60) % 60, totalSeconds % 60);
+	}
+	return IGCS::Utils::formatString("%d:%.2d", totalSeconds / 60, totalSeconds % 60);
+}
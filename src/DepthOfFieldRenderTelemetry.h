@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Measures the timing of a depth of field render per step: how long issuing the camera command took, how long and how many frames it took before
+/// the frame showing the camera move was presented, and how long that blend frame took. From the interval between blended frames it keeps a
+/// rolling (exponential moving) average of the seconds and frames per step, which gives the ETA of the render in progress. The seconds per frame
+/// measured are kept after the render, so the next render can be estimated before it starts.
+/// Intervals which contain a pause aren't used for the averages.
+/// </summary>
+class DepthOfFieldRenderTelemetry
+{
+public:
+	DepthOfFieldRenderTelemetry() = default;
+	~DepthOfFieldRenderTelemetry() = default;
+
+	/// <summary>
+	/// Resets the per step measurements for a new render of numberOfSteps steps. The seconds per frame of the previous render are kept till
+	/// the first interval of this render has been measured.
+	/// </summary>
+	void start(int numberOfSteps);
+	/// <summary>
+	/// Called when the camera command for the step specified has been issued, before frameEnded of the frame it was issued in.
+	/// </summary>
+	/// <param name="stepIndex"></param>
+	/// <param name="commandStartTime">the time the camera command was started</param>
+	void stepIssued(int stepIndex, std::chrono::high_resolution_clock::time_point commandStartTime);
+	/// <summary>
+	/// Called at the start of the frame in which the step specified is blended (or captured).
+	/// </summary>
+	void stepBlendStarted(int stepIndex);
+	/// <summary>
+	/// Called at the end of every frame of the render, after the effects have been rendered.
+	/// </summary>
+	/// <param name="paused">true if the render is paused, or is waiting for something else than the game</param>
+	void frameEnded(bool paused);
+	/// <summary>
+	/// Logs the summary of the render: totals, averages and extremes of the measured durations.
+	/// </summary>
+	/// <param name="wasCancelled">true if the render didn't complete</param>
+	void logSummary(bool wasCancelled);
+
+	bool hasMeasurements() { return _averageSecondsPerStep > 0.0; }
+	float getAverageSecondsPerStep() { return (float)_averageSecondsPerStep; }
+	float getAverageFramesPerStep() { return (float)_averageFramesPerStep; }
+	/// <summary>
+	/// The average duration of a frame during the last render, or 0 if nothing has been measured yet.
+	/// </summary>
+	float getAverageSecondsPerFrame() { return (float)_averageSecondsPerFrame; }
+	float getEstimatedSecondsRemaining(int numberOfStepsRemaining) { return (float)(_averageSecondsPerStep * numberOfStepsRemaining); }
+
+	/// <summary>
+	/// Formats the duration specified as m:ss, or h:mm:ss if it's an hour or longer.
+	/// </summary>
+	static std::string formatDuration(float seconds);
+
+private:
+	struct StepTiming
+	{
+		std::chrono::high_resolution_clock::time_point issueTime;
+		std::chrono::high_resolution_clock::time_point blendStartTime;
+		double commandSeconds = 0.0;
+		double blendFrameSeconds = 0.0;
+		int64_t issueFrame = -1;
+		int64_t blendFrame = -1;
+	};
+
+	std::vector<StepTiming> _stepTimings;
+	std::chrono::high_resolution_clock::time_point _renderStartTime;
+	std::chrono::high_resolution_clock::time_point _lastBlendTime;
+	int64_t _currentFrame = 0;
+	int64_t _lastBlendFrame = -1;
+	int _stepBlendedThisFrame = -1;
+	bool _intervalContainsPause = false;
+	int _numberOfIntervalsMeasured = 0;
+	double _averageSecondsPerStep = 0.0;
+	double _averageFramesPerStep = 0.0;
+	double _averageSecondsPerFrame = 0.0;
+	double _minSecondsPerStep = 0.0;
+	double _maxSecondsPerStep = 0.0;
+};
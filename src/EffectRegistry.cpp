@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "EffectRegistry.h"
+#include "NameTable.h"
+#include <algorithm>
+
+namespace
+{
+	/// <summary>
+	/// Sorts the uniforms on name id and removes the ones with a name id already present, like EffectState::sortUniforms does.
+	/// </summary>
+	void sortAndDeduplicateUniforms(std::vector<EffectRegistry::RegisteredUniform>& uniforms)
+	{
+		std::stable_sort(uniforms.begin(), uniforms.end(), [](const auto& a, const auto& b) { return a.nameId < b.nameId; });
+		uniforms.erase(std::unique(uniforms.begin(), uniforms.end(), [](const auto& a, const auto& b) { return a.nameId == b.nameId; }), uniforms.end());
+	}
+}
+
+
+void EffectRegistry::build(reshade::api::effect_runtime* runtime)
+{
+	clear();
+	NameTable& nameTable = NameTable::instance();
+	// techniques first. The effect index is set to the effect name id for now, as we don't know the effects yet.
+	runtime->enumerate_techniques(nullptr, [this, &nameTable](reshade::api::effect_runtime* sourceRuntime, reshade::api::effect_technique technique)
+	{
+		char nameBuffer[1024] = { 0 };
+		size_t nameBufferLength = 1024;
+		sourceRuntime->get_technique_effect_name(technique, nameBuffer, &nameBufferLength);
+		const uint32_t effectNameId = nameTable.intern(nameBuffer);
+
+		nameBuffer[0] = '\0';
+		nameBufferLength = 1024;
+		sourceRuntime->get_technique_name(technique, nameBuffer, &nameBufferLength);
+		const uint32_t techniqueNameId = nameTable.intern(nameBuffer);
+		if(NameTable::INVALID_NAME_ID == effectNameId || NameTable::INVALID_NAME_ID == techniqueNameId)
+		{
+			// the name table is full (and has logged it), the technique can't be registered.
+			return;
+		}
+		_techniques.push_back({ techniqueNameId, technique.handle, effectNameId });
+	});
+
+	std::vector<uint32_t> effectNameIds;
+	effectNameIds.reserve(_techniques.size());
+	for(const auto& technique : _techniques)
+	{
+		effectNameIds.push_back(technique.effectIndex);
+	}
+	std::sort(effectNameIds.begin(), effectNameIds.end());
+	effectNameIds.erase(std::unique(effectNameIds.begin(), effectNameIds.end()), effectNameIds.end());
+
+	// per effect, its uniforms
+	_effects.reserve(effectNameIds.size());
+	for(const auto effectNameId : effectNameIds)
+	{
+		RegisteredEffect effect{ effectNameId };
+		runtime->enumerate_uniform_variables(nameTable.getName(effectNameId).c_str(), [&effect, &nameTable](reshade::api::effect_runtime* sourceRuntime, reshade::api::effect_uniform_variable variable)
+		{
+			char nameBuffer[1024] = { 0 };
+			size_t nameBufferLength = 1024;
+			sourceRuntime->get_uniform_variable_name(variable, nameBuffer, &nameBufferLength);
+			const uint32_t uniformNameId = nameTable.intern(nameBuffer);
+			if(NameTable::INVALID_NAME_ID == uniformNameId)
+			{
+				return;
+			}
+
+			reshade::api::format typeFormat;
+			uint32_t numberOfRows;
+			uint32_t numberOfColumns;
+			uint32_t arrayLength;
+			sourceRuntime->get_uniform_variable_type(variable, &typeFormat, &numberOfRows, &numberOfColumns, &arrayLength);
+
+			// we only interpolate r32_floats with # of rows 1-4. (float4 has 4 rows, cols is 1).
+			if(typeFormat == reshade::api::format::r32_float && numberOfColumns == 1 && (numberOfRows >= 1 && numberOfRows < 5))
+			{
+				effect.floatUniforms.push_back({ uniformNameId, variable.handle });
+			}
+			effect.uniforms.push_back({ uniformNameId, variable.handle });
+		});
+		sortAndDeduplicateUniforms(effect.floatUniforms);
+		sortAndDeduplicateUniforms(effect.uniforms);
+		_effects.push_back(std::move(effect));
+	}
+
+	for(auto& technique : _techniques)
+	{
+		technique.effectIndex = (uint32_t)(std::lower_bound(effectNameIds.begin(), effectNameIds.end(), technique.effectIndex) - effectNameIds.begin());
+	}
+	std::stable_sort(_techniques.begin(), _techniques.end(), [](const auto& a, const auto& b) { return a.nameId < b.nameId; });
+}
+
+
+void EffectRegistry::clear()
+{
+	_effects.clear();
+	_techniques.clear();
+}
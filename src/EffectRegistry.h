@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <reshade.hpp>
+#include <vector>
+
+/// <summary>
+/// The techniques of the effects loaded in a runtime and the uniforms of these effects, with their names resolved to NameTable ids and the float
+/// uniforms we can interpolate filtered out by type. Names, types and handles only change when the effects are reloaded, so the registry is built
+/// once after a reload and a snapshot only has to read the current technique states and uniform values. All arrays are sorted on name id, so
+/// the states read from the registry are in the order the snapshots keep them in.
+/// </summary>
+class EffectRegistry
+{
+public:
+	struct RegisteredUniform
+	{
+		uint32_t nameId;
+		uint64_t handle;
+	};
+
+	struct RegisteredEffect
+	{
+		uint32_t nameId;
+		std::vector<RegisteredUniform> floatUniforms;		// float, float2, float3 and float4 uniforms
+		std::vector<RegisteredUniform> uniforms;			// all uniforms, floats and others
+	};
+
+	struct RegisteredTechnique
+	{
+		uint32_t nameId;
+		uint64_t handle;
+		uint32_t effectIndex;		// index in the effects of the registry
+	};
+
+	/// <summary>
+	/// Replaces the contents with the techniques and uniforms of the effects currently loaded in the runtime specified. Adds their names to the NameTable.
+	/// </summary>
+	void build(reshade::api::effect_runtime* runtime);
+	void clear();
+
+	bool isEmpty() const { return _techniques.empty(); }
+	const std::vector<RegisteredEffect>& getEffects() const { return _effects; }
+	const std::vector<RegisteredTechnique>& getTechniques() const { return _techniques; }
+
+private:
+	std::vector<RegisteredEffect> _effects;				// sorted on nameId
+	std::vector<RegisteredTechnique> _techniques;		// sorted on nameId
+};
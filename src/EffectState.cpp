@@ -31,166 +31,193 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /////////////////////////////////////////////////////////////////////////
 
-#include "ReshadeStateSnapshot.h"
+#include "EffectState.h"
+#include "NameTable.h"
 #include "Utils.h"
+#include <cstring>
+#include <string_view>
 
-EffectState::EffectState(std::string name) : _name(name)
+namespace
+{
+	template<typename T>
+	size_t combineArrayHash(size_t seed, const std::vector<T>& elements)
+	{
+		const size_t elementsHash = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(T)));
+		return seed ^ (elementsHash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+	}
+
+
+	template<typename T>
+	bool haveSameBits(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+}
+
+EffectState::EffectState(uint32_t nameId) : _nameId(nameId)
 {}
 
-void EffectState::addUniform(reshade::api::effect_uniform_variable id, std::string name, float* values)
+
+EffectState::EffectState(uint32_t nameId, std::vector<uint32_t> floatUniformNameIds, std::vector<DirectX::XMFLOAT4A> floatUniformValues, std::vector<uint32_t> uniformNameIds) :
+	_nameId(nameId), _floatUniformNameIds(std::move(floatUniformNameIds)), _floatUniformHandles(_floatUniformNameIds.size(), 0), _floatUniformValues(std::move(floatUniformValues)),
+	_uniformNameIds(std::move(uniformNameIds)), _uniformHandles(_uniformNameIds.size(), 0)
+{}
+
+void EffectState::addFloatUniform(uint32_t nameId, uint64_t handle, const float* values)
 {
-	_uniformFloatValuePerName.emplace(name, DirectX::XMFLOAT4(values));
-	_uniformFloatVariableIdPerName.emplace(name, id.handle);
+	_floatUniformNameIds.push_back(nameId);
+	_floatUniformHandles.push_back(handle);
+	_floatUniformValues.push_back(DirectX::XMFLOAT4A(values));
 }
 
 
-void EffectState::applyState(reshade::api::effect_runtime* runtime)
+void EffectState::addUniformHandle(uint32_t nameId, uint64_t handle)
 {
-	for(auto& nameValuePair : _uniformFloatValuePerName)
+	_uniformNameIds.push_back(nameId);
+	_uniformHandles.push_back(handle);
+}
+
+
+void EffectState::sortUniforms()
+{
+	IGCS::Utils::sortParallelArrays(_floatUniformNameIds, _floatUniformHandles, _floatUniformValues);
+	IGCS::Utils::sortParallelArrays(_uniformNameIds, _uniformHandles);
+}
+
+
+void EffectState::applyState(reshade::api::effect_runtime* runtime) const
+{
+	for(size_t i = 0; i < _floatUniformHandles.size(); i++)
 	{
-		// grab the id so we can use it to set the variable.
-		const auto id = _uniformFloatVariableIdPerName[nameValuePair.first];
+		const auto id = _floatUniformHandles[i];
 		if(id==0)
 		{
 			continue;
 		}
-		runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(id), nameValuePair.second.x, nameValuePair.second.y, nameValuePair.second.z, nameValuePair.second.w);
+		const auto& values = _floatUniformValues[i];
+		runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(id), values.x, values.y, values.z, values.w);
 	}
 }
 
 
-void EffectState::obtainEffectState(reshade::api::effect_runtime* runtime)
+void EffectState::obtainEffectState(reshade::api::effect_runtime* runtime, const EffectRegistry::RegisteredEffect& registeredEffect)
 {
-	runtime->enumerate_uniform_variables(_name.c_str(), [&](reshade::api::effect_runtime* sourceRuntime, reshade::api::effect_uniform_variable variable)
+	_floatUniformNameIds.reserve(registeredEffect.floatUniforms.size());
+	_floatUniformHandles.reserve(registeredEffect.floatUniforms.size());
+	_floatUniformValues.reserve(registeredEffect.floatUniforms.size());
+	for(const auto& uniform : registeredEffect.floatUniforms)
 	{
-		// get name
-		char nameBuffer[1024];
-		size_t nameBufferLength = 1024;
-		sourceRuntime->get_uniform_variable_name(variable, nameBuffer, &nameBufferLength);
-		const std::string uniformName(nameBuffer);
-
-		// get type
-		reshade::api::format typeFormat;
-		uint32_t numberOfRows;
-		uint32_t numberOfColumns;
-		uint32_t arrayLength;
-		sourceRuntime->get_uniform_variable_type(variable, &typeFormat, &numberOfRows, &numberOfColumns, &arrayLength);
-
-		// we only store r32_floats with # of rows 1-4. (float4 has 4 rows, cols is 1). We don't support other types as we can't interpolate between them anyway.
-		if(typeFormat == reshade::api::format::r32_float && numberOfColumns == 1 && (numberOfRows >= 1 && numberOfRows < 5))
-		{
-			// get value
-			float values[4] = {};
-			sourceRuntime->get_uniform_value_float(variable, values, 4);
-			addUniform(variable, uniformName, values);
-		}
-		// Always store the id as well in the general map, so we can use it to set a value different from a float if we need to using another context than the paths/interpolation
-		_uniformVariableIdPerName.emplace(uniformName, variable.handle);
-	});
+		float values[4] = {};
+		runtime->get_uniform_value_float(reshade::api::effect_uniform_variable(uniform.handle), values, 4);
+		addFloatUniform(uniform.nameId, uniform.handle, values);
+	}
+	// Always store the id as well in the general list, so we can use it to set a value different from a float if we need to using another context than the paths/interpolation
+	_uniformNameIds.reserve(registeredEffect.uniforms.size());
+	_uniformHandles.reserve(registeredEffect.uniforms.size());
+	for(const auto& uniform : registeredEffect.uniforms)
+	{
+		addUniformHandle(uniform.nameId, uniform.handle);
+	}
 }
 
 
 void EffectState::migrateIds(const EffectState& idSource)
 {
-	_uniformFloatVariableIdPerName.clear();
-	_uniformVariableIdPerName.clear();
-
-	for(auto& nameValuePair : idSource._uniformFloatValuePerName)
-	{
-		auto sourceIdsPerName = idSource._uniformFloatVariableIdPerName;
-		const auto id = sourceIdsPerName[nameValuePair.first];
-		if(!_uniformFloatValuePerName.contains(nameValuePair.first))
-		{
-			// add it, it was not yet known
-			_uniformFloatValuePerName[nameValuePair.first] = nameValuePair.second;
-		}
-		_uniformFloatVariableIdPerName[nameValuePair.first] = id;
-	}
-	// it might be the new state has less variables than we had in the previous state. Check if there are left over variables.
-	std::vector<std::string> toRemove;
-	for(auto& nameValuePair : _uniformFloatValuePerName)
+	// The uniforms of the source are the ones present now. We keep our values for the uniforms we already had, and take the value of the source
+	// for the ones which are new. Uniforms which are no longer there are dropped. Both are sorted on name id, so we can walk them side by side.
+	std::vector<DirectX::XMFLOAT4A> migratedValues;
+	migratedValues.reserve(idSource._floatUniformValues.size());
+	size_t ourIndex = 0;
+	for(size_t sourceIndex = 0; sourceIndex < idSource._floatUniformNameIds.size(); sourceIndex++)
 	{
-		if(!_uniformFloatVariableIdPerName.contains(nameValuePair.first))
+		const uint32_t nameId = idSource._floatUniformNameIds[sourceIndex];
+		while(ourIndex < _floatUniformNameIds.size() && _floatUniformNameIds[ourIndex] < nameId)
 		{
-			// no longer there
-			toRemove.push_back(nameValuePair.first);
+			ourIndex++;
 		}
+		const bool isKnown = ourIndex < _floatUniformNameIds.size() && _floatUniformNameIds[ourIndex] == nameId;
+		migratedValues.push_back(isKnown ? _floatUniformValues[ourIndex] : idSource._floatUniformValues[sourceIndex]);
 	}
+	_floatUniformNameIds = idSource._floatUniformNameIds;
+	_floatUniformHandles = idSource._floatUniformHandles;
+	_floatUniformValues = std::move(migratedValues);
 
-	for(auto& nameValuePair : idSource._uniformVariableIdPerName)
-	{
-		// simply copy over
-		_uniformVariableIdPerName[nameValuePair.first] = nameValuePair.second;
-	}
-
-	for(auto& it : toRemove)
-	{
-		_uniformFloatValuePerName.erase(it);
-	}
+	// simply copy over
+	_uniformNameIds = idSource._uniformNameIds;
+	_uniformHandles = idSource._uniformHandles;
 }
 
 
-void EffectState::applyStateFromTo(reshade::api::effect_runtime* runtime, EffectState destinationEffect, float interpolationFactor)
+void EffectState::collectValuePairs(const EffectState& destinationEffect, std::vector<uint64_t>& handles, std::vector<uint64_t>& keys, std::vector<DirectX::XMFLOAT4A>& fromValues,
+									std::vector<DirectX::XMFLOAT4A>& toValues) const
 {
-	auto& destinationValuesPerName = destinationEffect._uniformFloatValuePerName;
+	if(_floatUniformNameIds == destinationEffect._floatUniformNameIds)
+	{
+		// the same uniforms on both sides, which is the common case, so the arrays line up and can be copied as a whole.
+		handles.insert(handles.end(), _floatUniformHandles.begin(), _floatUniformHandles.end());
+		for(const auto uniformNameId : _floatUniformNameIds)
+		{
+			keys.push_back(createUniformKey(_nameId, uniformNameId));
+		}
+		fromValues.insert(fromValues.end(), _floatUniformValues.begin(), _floatUniformValues.end());
+		toValues.insert(toValues.end(), destinationEffect._floatUniformValues.begin(), destinationEffect._floatUniformValues.end());
+		return;
+	}
 
-	for(auto& nameValuePair : _uniformFloatValuePerName)
+	// the uniforms differ, e.g. the shader was changed between the snapshots. Only the uniforms present in both are interpolated.
+	size_t destinationIndex = 0;
+	const auto& destinationNameIds = destinationEffect._floatUniformNameIds;
+	for(size_t i = 0; i < _floatUniformNameIds.size(); i++)
 	{
-		if(!destinationValuesPerName.contains(nameValuePair.first))
+		while(destinationIndex < destinationNameIds.size() && destinationNameIds[destinationIndex] < _floatUniformNameIds[i])
+		{
+			destinationIndex++;
+		}
+		if(destinationIndex >= destinationNameIds.size() || destinationNameIds[destinationIndex] != _floatUniformNameIds[i])
 		{
 			continue;
 		}
-		const auto& destinationValues = destinationValuesPerName[nameValuePair.first];
-		const auto& id = _uniformFloatVariableIdPerName[nameValuePair.first];
-
-		const float x = IGCS::Utils::lerp(nameValuePair.second.x, destinationValues.x, interpolationFactor);
-		const float y = IGCS::Utils::lerp(nameValuePair.second.y, destinationValues.y, interpolationFactor);
-		const float z = IGCS::Utils::lerp(nameValuePair.second.z, destinationValues.z, interpolationFactor);
-		const float w = IGCS::Utils::lerp(nameValuePair.second.w, destinationValues.w, interpolationFactor);
-		runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(id), x, y, z, w);
+		handles.push_back(_floatUniformHandles[i]);
+		keys.push_back(createUniformKey(_nameId, _floatUniformNameIds[i]));
+		fromValues.push_back(_floatUniformValues[i]);
+		toValues.push_back(destinationEffect._floatUniformValues[destinationIndex]);
 	}
 }
 
 
-void EffectState::setUniformIntVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, int valueToWrite)
+int EffectState::findFloatUniform(uint32_t nameId, size_t startIndex) const
 {
-	if(!_uniformVariableIdPerName.contains(uniformName))
+	for(size_t i = startIndex; i < _floatUniformNameIds.size() && _floatUniformNameIds[i] <= nameId; i++)
 	{
-		return;
+		if(_floatUniformNameIds[i] == nameId)
+		{
+			return (int)i;
+		}
 	}
-	const uint64_t uniformId = _uniformVariableIdPerName[uniformName];
-	runtime->set_uniform_value_int(reshade::api::effect_uniform_variable(uniformId), valueToWrite);
+	return -1;
 }
 
 
-void EffectState::setUniformFloatVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float valueToWrite)
+size_t EffectState::calculateMemoryUsage() const
 {
-	if(!_uniformVariableIdPerName.contains(uniformName))
-	{
-		return;
-	}
-	const uint64_t uniformId = _uniformVariableIdPerName[uniformName];
-	runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(uniformId), valueToWrite);
+	return sizeof(EffectState) + (_floatUniformNameIds.capacity() * sizeof(uint32_t)) + (_floatUniformHandles.capacity() * sizeof(uint64_t)) +
+		   (_floatUniformValues.capacity() * sizeof(DirectX::XMFLOAT4A)) + (_uniformNameIds.capacity() * sizeof(uint32_t)) + (_uniformHandles.capacity() * sizeof(uint64_t));
 }
 
 
-void EffectState::setUniformFloat2Variable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float value1ToWrite, float value2ToWrite)
+size_t EffectState::calculateContentHash() const
 {
-	if(!_uniformVariableIdPerName.contains(uniformName))
-	{
-		return;
-	}
-	const uint64_t uniformId = _uniformVariableIdPerName[uniformName];
-	runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(uniformId), value1ToWrite, value2ToWrite);
+	size_t toReturn = std::hash<uint32_t>()(_nameId);
+	toReturn = combineArrayHash(toReturn, _floatUniformNameIds);
+	toReturn = combineArrayHash(toReturn, _floatUniformHandles);
+	toReturn = combineArrayHash(toReturn, _floatUniformValues);
+	toReturn = combineArrayHash(toReturn, _uniformNameIds);
+	return combineArrayHash(toReturn, _uniformHandles);
 }
 
 
-void EffectState::setUniformBoolVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, bool valueToWrite)
+bool EffectState::hasSameContents(const EffectState& other) const
 {
-	if(!_uniformVariableIdPerName.contains(uniformName))
-	{
-		return;
-	}
-	const uint64_t uniformId = _uniformVariableIdPerName[uniformName];
-	runtime->set_uniform_value_bool(reshade::api::effect_uniform_variable(uniformId), valueToWrite);
+	return _nameId == other._nameId && haveSameBits(_floatUniformNameIds, other._floatUniformNameIds) && haveSameBits(_floatUniformHandles, other._floatUniformHandles) &&
+		   haveSameBits(_floatUniformValues, other._floatUniformValues) && haveSameBits(_uniformNameIds, other._uniformNameIds) && haveSameBits(_uniformHandles, other._uniformHandles);
 }
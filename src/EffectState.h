@@ -34,48 +34,94 @@
 #pragma once
 
 #include <DirectXMath.h>
+#include <cstdint>
 #include <reshade.hpp>
-#include <string>
-#include <unordered_map>
-
+#include <vector>
+#include "EffectRegistry.h"
 
+/// <summary>
+/// The state of the uniforms of a single effect. Uniforms are stored as parallel arrays sorted on the id of their name in the NameTable, so the state of
+/// the same effect in two snapshots lines up element by element and interpolating between them is a single lerp over the two value arrays.
+/// </summary>
 class EffectState
 {
 public:
 	EffectState() = default;
-	EffectState(std::string name);
+	EffectState(uint32_t nameId);
+	/// <summary>
+	/// Creates an effect state with the uniforms specified, which have no handles yet: these are set by migrateIds. Call sortUniforms afterwards.
+	/// </summary>
+	EffectState(uint32_t nameId, std::vector<uint32_t> floatUniformNameIds, std::vector<DirectX::XMFLOAT4A> floatUniformValues, std::vector<uint32_t> uniformNameIds);
 
 	/// <summary>
 	/// Applies the state contained by this effect state to the runtime specified
 	/// </summary>
 	/// <param name="runtime"></param>
-	void applyState(reshade::api::effect_runtime* runtime);
+	void applyState(reshade::api::effect_runtime* runtime) const;
 	/// <summary>
-	/// Obtains the effect state from the runtime specified and stors it inside this effectstate object
+	/// Obtains the values of the uniforms of registeredEffect from the runtime specified and stores them inside this effectstate object. The uniforms
+	/// are added in the order of the registry, which is sorted, so sortUniforms isn't needed.
 	/// </summary>
-	/// <param name="runtime"></param>
-	void obtainEffectState(reshade::api::effect_runtime* runtime);
+	void obtainEffectState(reshade::api::effect_runtime* runtime, const EffectRegistry::RegisteredEffect& registeredEffect);
 	/// <summary>
 	/// Migrated the contained variables' id's to their new id values using the passed in idsource
 	/// </summary>
 	/// <param name="idSource"></param>
 	void migrateIds(const EffectState& idSource);
-	void applyStateFromTo(reshade::api::effect_runtime* runtime, EffectState destinationEffect, float interpolationFactor);
-	void setUniformIntVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, int valueToWrite);
-	void setUniformFloatVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float valueToWrite);
-	void setUniformFloat2Variable(reshade::api::effect_runtime* runtime, const std::string& uniformName, float value1ToWrite, float value2ToWrite);
-	void setUniformBoolVariable(reshade::api::effect_runtime* runtime, const std::string& uniformName, bool valueToWrite);
+	/// <summary>
+	/// Appends the handles of the float uniforms present in both this state and destinationEffect to handles, their keys (see createUniformKey) to keys,
+	/// their values in this state to fromValues and their values in destinationEffect to toValues.
+	/// </summary>
+	void collectValuePairs(const EffectState& destinationEffect, std::vector<uint64_t>& handles, std::vector<uint64_t>& keys, std::vector<DirectX::XMFLOAT4A>& fromValues,
+						   std::vector<DirectX::XMFLOAT4A>& toValues) const;
+	/// <summary>
+	/// Returns the index of the float uniform with the name id specified, starting the search at startIndex, or -1 if it's not present. As the uniforms
+	/// are sorted, startIndex can be the index found for the previous, lower, name id.
+	/// </summary>
+	int findFloatUniform(uint32_t nameId, size_t startIndex) const;
+	/// <summary>
+	/// Adds a float uniform. Call sortUniforms after all uniforms have been added.
+	/// </summary>
+	void addFloatUniform(uint32_t nameId, uint64_t handle, const float* values);
+	/// <summary>
+	/// Adds the handle of a uniform which isn't a float, so it can be set using another context than the paths/interpolation. Call sortUniforms after all uniforms have been added.
+	/// </summary>
+	void addUniformHandle(uint32_t nameId, uint64_t handle);
+	void sortUniforms();
 
-	std::string name() { return _name; }
+	uint32_t nameId() const { return _nameId; }
+	size_t numberOfFloatUniforms() const { return _floatUniformNameIds.size(); }
+	const DirectX::XMFLOAT4A& getFloatUniformValue(size_t index) const { return _floatUniformValues[index]; }
+	const std::vector<uint32_t>& getFloatUniformNameIds() const { return _floatUniformNameIds; }
+	const std::vector<DirectX::XMFLOAT4A>& getFloatUniformValues() const { return _floatUniformValues; }
+	const std::vector<uint32_t>& getUniformNameIds() const { return _uniformNameIds; }
+	/// <summary>
+	/// Returns the number of bytes used by this effect state, including the heap memory of its arrays.
+	/// </summary>
+	size_t calculateMemoryUsage() const;
+	/// <summary>
+	/// Returns a hash over the name id and all uniform ids, handles and values, used by the EffectStatePool to find identical effect states.
+	/// </summary>
+	size_t calculateContentHash() const;
+	/// <summary>
+	/// Returns true if other has the same name id and the same uniform ids, handles and values, bit for bit.
+	/// </summary>
+	bool hasSameContents(const EffectState& other) const;
 
-private:
-	void addUniform(reshade::api::effect_uniform_variable id, std::string name, float* values);
+	/// <summary>
+	/// Creates the key of a float uniform which is unique within a snapshot: the effect name id in the upper 32 bits, the uniform name id in the lower.
+	/// Keys of the uniforms collected in snapshot order are therefore ascending.
+	/// </summary>
+	static uint64_t createUniformKey(uint32_t effectNameId, uint32_t uniformNameId) { return ((uint64_t)effectNameId << 32) | uniformNameId; }
 
-	std::string _name;
+private:
+	uint32_t _nameId = 0;
 	// Names are usable across reloads of a preset. It might still be names aren't present after a reload (e.g. a shader changed). But for our use case this isn't important. 
-	std::unordered_map<std::string, uint64_t> _uniformFloatVariableIdPerName;			// for Floats only
-	std::unordered_map<std::string, DirectX::XMFLOAT4> _uniformFloatValuePerName;		// stored with their uniform name for this effect. We store floats as float4.
-	std::unordered_map<std::string, uint64_t> _uniformVariableIdPerName;				// all variables of the effect, floats and others.
+	// Floats only. We store floats as float4. 
+	std::vector<uint32_t> _floatUniformNameIds;
+	std::vector<uint64_t> _floatUniformHandles;
+	std::vector<DirectX::XMFLOAT4A> _floatUniformValues;
+	// all variables of the effect, floats and others.
+	std::vector<uint32_t> _uniformNameIds;
+	std::vector<uint64_t> _uniformHandles;
 };
-
-
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "EffectStatePool.h"
+#include <algorithm>
+
+namespace
+{
+	constexpr size_t MINIMUM_PURGE_THRESHOLD = 1024;
+	// per entry in the multimap: the node with the key and the weak pointer, the bucket pointer and the shared_ptr control block of make_shared.
+	constexpr size_t ESTIMATED_BYTES_PER_ENTRY = sizeof(size_t) + sizeof(std::weak_ptr<const EffectState>) + (3 * sizeof(void*)) + 16;
+}
+
+
+EffectStatePool& EffectStatePool::instance()
+{
+	static EffectStatePool theInstance;
+	return theInstance;
+}
+
+
+std::shared_ptr<const EffectState> EffectStatePool::intern(EffectState&& toIntern)
+{
+	const size_t contentHash = toIntern.calculateContentHash();
+	std::scoped_lock lock(_mutex);
+	auto range = _effectStatesPerContentHash.equal_range(contentHash);
+	for(auto it = range.first; it != range.second;)
+	{
+		std::shared_ptr<const EffectState> pooled = it->second.lock();
+		if(nullptr == pooled)
+		{
+			it = _effectStatesPerContentHash.erase(it);
+			continue;
+		}
+		if(pooled->hasSameContents(toIntern))
+		{
+			_numberOfSharedInterns++;
+			return pooled;
+		}
+		++it;
+	}
+	std::shared_ptr<const EffectState> toReturn = std::make_shared<const EffectState>(std::move(toIntern));
+	_effectStatesPerContentHash.emplace(contentHash, toReturn);
+	if(_effectStatesPerContentHash.size() >= _purgeThreshold)
+	{
+		purgeExpiredEntries();
+		_purgeThreshold = std::max(MINIMUM_PURGE_THRESHOLD, _effectStatesPerContentHash.size() * 2);
+	}
+	return toReturn;
+}
+
+
+uint32_t EffectStatePool::getNumberOfEffectStates()
+{
+	std::scoped_lock lock(_mutex);
+	uint32_t toReturn = 0;
+	for(const auto& hashEffectStatePair : _effectStatesPerContentHash)
+	{
+		if(!hashEffectStatePair.second.expired())
+		{
+			toReturn++;
+		}
+	}
+	return toReturn;
+}
+
+
+size_t EffectStatePool::calculateMemoryUsage()
+{
+	std::scoped_lock lock(_mutex);
+	size_t toReturn = sizeof(EffectStatePool) + (_effectStatesPerContentHash.bucket_count() * sizeof(void*)) + (_effectStatesPerContentHash.size() * ESTIMATED_BYTES_PER_ENTRY);
+	for(const auto& hashEffectStatePair : _effectStatesPerContentHash)
+	{
+		const std::shared_ptr<const EffectState> effectState = hashEffectStatePair.second.lock();
+		if(nullptr != effectState)
+		{
+			toReturn += effectState->calculateMemoryUsage();
+		}
+	}
+	return toReturn;
+}
+
+
+uint64_t EffectStatePool::getNumberOfSharedInterns()
+{
+	std::scoped_lock lock(_mutex);
+	return _numberOfSharedInterns;
+}
+
+
+void EffectStatePool::purgeExpiredEntries()
+{
+	for(auto it = _effectStatesPerContentHash.begin(); it != _effectStatesPerContentHash.end();)
+	{
+		if(it->second.expired())
+		{
+			it = _effectStatesPerContentHash.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
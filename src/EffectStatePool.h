@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "EffectState.h"
+
+/// <summary>
+/// Process wide pool of immutable effect states, shared between the snapshots of all paths. An effect state is looked up by the hash of its contents
+/// when it's interned, so identical states (e.g. an effect which isn't changed between nodes, or an effect copied to later nodes when it's newly enabled)
+/// are stored once and referenced by all snapshots containing it. Changing an effect state means interning a changed copy, so a block is only copied
+/// when a node really changes it. Blocks are freed when the last snapshot referencing them is gone; the pool itself only holds weak references.
+/// </summary>
+class EffectStatePool
+{
+public:
+	static EffectStatePool& instance();
+
+	/// <summary>
+	/// Returns the pooled effect state with the same contents as toIntern, adding toIntern to the pool if there's none.
+	/// </summary>
+	std::shared_ptr<const EffectState> intern(EffectState&& toIntern);
+	/// <summary>
+	/// Returns the number of effect states in the pool which are still referenced.
+	/// </summary>
+	uint32_t getNumberOfEffectStates();
+	/// <summary>
+	/// Returns the number of bytes used by the effect states in the pool which are still referenced, including the pool's own administration.
+	/// </summary>
+	size_t calculateMemoryUsage();
+	/// <summary>
+	/// Returns the number of calls to intern which returned an already pooled effect state instead of adding a new one.
+	/// </summary>
+	uint64_t getNumberOfSharedInterns();
+
+private:
+	EffectStatePool() = default;
+
+	/// <summary>
+	/// Removes the entries of effect states which are no longer referenced. Has to be called with _mutex locked.
+	/// </summary>
+	void purgeExpiredEntries();
+
+	std::mutex _mutex;
+	std::unordered_multimap<size_t, std::weak_ptr<const EffectState>> _effectStatesPerContentHash;
+	size_t _purgeThreshold = 1024;
+	uint64_t _numberOfSharedInterns = 0;
+};
@@ -0,0 +1,446 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "EncoderBenchmark.h"
+#include "ImageFileIO.h"
+#include "OverlayControl.h"
+#include "std_image_write.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <thread>
+
+using namespace std::chrono;
+
+namespace
+{
+	struct BenchmarkResolution
+	{
+		const char* name;
+		int width;
+		int height;
+	};
+
+	struct BenchmarkEncoder
+	{
+		const char* name;
+		const char* extension;
+		bool (*encode)(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData);
+	};
+
+	struct BenchmarkFrame
+	{
+		const char* name;
+		void (*generate)(std::vector<uint8_t>& rgbData, int width, int height);
+	};
+
+	// Number of times each thread encodes the frame in a timed run. The first encode is a separate, untimed, warm up run.
+	constexpr int ITERATIONS_PER_THREAD = 2;
+
+
+	uint32_t hashCoordinates(uint32_t x, uint32_t y, uint32_t seed)
+	{
+		uint32_t h = seed ^ (x * 0x8da6b343u) ^ (y * 0xd8163841u);
+		h ^= h >> 16;
+		h *= 0x7feb352du;
+		h ^= h >> 15;
+		h *= 0x846ca68bu;
+		h ^= h >> 16;
+		return h;
+	}
+
+
+	float hashToUnitFloat(uint32_t h)
+	{
+		return (float)(h >> 8) * (1.0f / 16777216.0f);
+	}
+
+
+	float valueNoise(float x, float y, uint32_t seed)
+	{
+		const float xFloor = floorf(x);
+		const float yFloor = floorf(y);
+		const uint32_t ix = (uint32_t)(int32_t)xFloor;
+		const uint32_t iy = (uint32_t)(int32_t)yFloor;
+		float fx = x - xFloor;
+		float fy = y - yFloor;
+		fx = fx * fx * (3.0f - 2.0f * fx);
+		fy = fy * fy * (3.0f - 2.0f * fy);
+		const float topRow = IGCS::Utils::lerp(hashToUnitFloat(hashCoordinates(ix, iy, seed)), hashToUnitFloat(hashCoordinates(ix + 1, iy, seed)), fx);
+		const float bottomRow = IGCS::Utils::lerp(hashToUnitFloat(hashCoordinates(ix, iy + 1, seed)), hashToUnitFloat(hashCoordinates(ix + 1, iy + 1, seed)), fx);
+		return IGCS::Utils::lerp(topRow, bottomRow, fy);
+	}
+
+
+	uint8_t toByte(float value)
+	{
+		return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+
+	void setPixel(std::vector<uint8_t>& rgbData, int width, int x, int y, float r, float g, float b)
+	{
+		uint8_t* pixel = rgbData.data() + ((size_t)y * width + x) * 3;
+		pixel[0] = toByte(r);
+		pixel[1] = toByte(g);
+		pixel[2] = toByte(b);
+	}
+
+
+	/// <summary>
+	/// Sky to horizon to ground gradient, with a faint horizontal variation. Smooth content, which compresses well.
+	/// </summary>
+	void generateGradientFrame(std::vector<uint8_t>& rgbData, int width, int height)
+	{
+		for(int y = 0; y < height; y++)
+		{
+			const float v = (float)y / (float)height;
+			for(int x = 0; x < width; x++)
+			{
+				const float u = (float)x / (float)width;
+				const float haze = 0.04f * sinf(u * 6.2831853f);
+				if(v < 0.6f)
+				{
+					const float t = v / 0.6f;
+					setPixel(rgbData, width, x, y, IGCS::Utils::lerp(0.10f, 0.95f, t * t) + haze, IGCS::Utils::lerp(0.25f, 0.70f, t) + haze, IGCS::Utils::lerp(0.60f, 0.45f, t));
+				}
+				else
+				{
+					const float t = (v - 0.6f) / 0.4f;
+					setPixel(rgbData, width, x, y, IGCS::Utils::lerp(0.35f, 0.15f, t), IGCS::Utils::lerp(0.30f, 0.12f, t) + haze, IGCS::Utils::lerp(0.20f, 0.08f, t));
+				}
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Multi-octave value noise colored like foliage, plus per pixel grain. High frequency content, which is the worst case for most encoders.
+	/// Feature sizes are relative to the frame height, so the frame looks the same at every resolution.
+	/// </summary>
+	void generateFoliageFrame(std::vector<uint8_t>& rgbData, int width, int height)
+	{
+		const float baseScale = 24.0f / (float)height;
+		for(int y = 0; y < height; y++)
+		{
+			for(int x = 0; x < width; x++)
+			{
+				float noise = 0.0f;
+				float amplitude = 0.5f;
+				float scale = baseScale;
+				for(int octave = 0; octave < 5; octave++)
+				{
+					noise += amplitude * valueNoise((float)x * scale, (float)y * scale, 0x51ED270Bu + octave);
+					amplitude *= 0.5f;
+					scale *= 2.0f;
+				}
+				const float grain = (hashToUnitFloat(hashCoordinates(x, y, 0x9E3779B9u)) - 0.5f) * 0.12f;
+				const float leaf = noise * noise;
+				setPixel(rgbData, width, x, y, 0.05f + 0.35f * leaf + grain, 0.15f + 0.65f * noise + grain, 0.04f + 0.15f * leaf + grain);
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Gradient background with HUD panels filled with rows of pseudo-random glyphs. Sharp edges and flat areas, like UI text in a game.
+	/// </summary>
+	void generateHudFrame(std::vector<uint8_t>& rgbData, int width, int height)
+	{
+		generateGradientFrame(rgbData, width, height);
+		// glyphs are 5x7 bits in a 6x9 cell, scaled with the resolution so the text is as large as it would be at 1080p.
+		const int cellScale = std::max(1, height / 540);
+		const int cellWidth = 6 * cellScale;
+		const int cellHeight = 9 * cellScale;
+		const int panelHeight = height / 6;
+		const int panelTops[] = { height / 20, height - panelHeight - height / 20 };
+		const int panelLeft = width / 20;
+		const int panelRight = width - width / 20;
+		for(int panelTop : panelTops)
+		{
+			for(int y = panelTop; y < panelTop + panelHeight; y++)
+			{
+				for(int x = panelLeft; x < panelRight; x++)
+				{
+					uint8_t* pixel = rgbData.data() + ((size_t)y * width + x) * 3;
+					// translucent dark panel
+					pixel[0] = (uint8_t)(pixel[0] / 4);
+					pixel[1] = (uint8_t)(pixel[1] / 4);
+					pixel[2] = (uint8_t)(pixel[2] / 4 + 20);
+					const int column = (x - panelLeft) / cellWidth;
+					const int row = (y - panelTop) / cellHeight;
+					const int bitX = ((x - panelLeft) % cellWidth) / cellScale;
+					const int bitY = ((y - panelTop) % cellHeight) / cellScale;
+					if(bitX >= 5 || bitY >= 7)
+					{
+						continue;
+					}
+					// every 7th to 13th glyph is a space, so rows look like words.
+					const uint32_t glyphHash = hashCoordinates(column, row + panelTop, 0xC0FFEEu);
+					if((column % (7 + (int)(glyphHash % 7))) == 0)
+					{
+						continue;
+					}
+					if((glyphHash >> ((bitY * 5 + bitX) % 32)) & 1)
+					{
+						pixel[0] = 235;
+						pixel[1] = 235;
+						pixel[2] = 220;
+					}
+				}
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Dark night scene with soft-edged bright discs of varying size and color, like out of focus highlights.
+	/// </summary>
+	void generateBokehFrame(std::vector<uint8_t>& rgbData, int width, int height)
+	{
+		std::vector<float> accumulation((size_t)width * height * 3);
+		for(int y = 0; y < height; y++)
+		{
+			const float v = (float)y / (float)height;
+			for(int x = 0; x < width; x++)
+			{
+				float* pixel = accumulation.data() + ((size_t)y * width + x) * 3;
+				pixel[0] = 0.02f + 0.05f * v;
+				pixel[1] = 0.02f + 0.03f * v;
+				pixel[2] = 0.06f;
+			}
+		}
+		constexpr int numberOfBlobs = 60;
+		for(int i = 0; i < numberOfBlobs; i++)
+		{
+			const float centerX = hashToUnitFloat(hashCoordinates(i, 0, 0xB0CE4u)) * (float)width;
+			const float centerY = hashToUnitFloat(hashCoordinates(i, 1, 0xB0CE4u)) * (float)height;
+			const float radius = (0.01f + 0.05f * hashToUnitFloat(hashCoordinates(i, 2, 0xB0CE4u))) * (float)height;
+			const float warmth = hashToUnitFloat(hashCoordinates(i, 3, 0xB0CE4u));
+			const float intensity = 0.25f + 0.5f * hashToUnitFloat(hashCoordinates(i, 4, 0xB0CE4u));
+			const float color[3] = { intensity, intensity * (0.55f + 0.3f * warmth), intensity * (1.0f - warmth) * 0.8f };
+			const int minX = std::max(0, (int)(centerX - radius));
+			const int maxX = std::min(width - 1, (int)(centerX + radius));
+			const int minY = std::max(0, (int)(centerY - radius));
+			const int maxY = std::min(height - 1, (int)(centerY + radius));
+			for(int y = minY; y <= maxY; y++)
+			{
+				for(int x = minX; x <= maxX; x++)
+				{
+					const float distance = sqrtf(((float)x - centerX) * ((float)x - centerX) + ((float)y - centerY) * ((float)y - centerY)) / radius;
+					if(distance >= 1.0f)
+					{
+						continue;
+					}
+					// slightly brighter rim with a soft edge, like a real bokeh highlight.
+					const float edge = std::clamp((1.0f - distance) * 12.0f, 0.0f, 1.0f);
+					const float rim = 0.8f + 0.2f * distance * distance;
+					float* pixel = accumulation.data() + ((size_t)y * width + x) * 3;
+					for(int channel = 0; channel < 3; channel++)
+					{
+						pixel[channel] += color[channel] * edge * rim;
+					}
+				}
+			}
+		}
+		for(size_t i = 0; i < accumulation.size(); i++)
+		{
+			rgbData[i] = toByte(accumulation[i]);
+		}
+	}
+
+
+	void appendToBuffer(void* context, void* data, int size)
+	{
+		std::vector<uint8_t>* encodedData = static_cast<std::vector<uint8_t>*>(context);
+		encodedData->insert(encodedData->end(), static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+	}
+
+
+	bool encodeStbBmp(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData)
+	{
+		encodedData.clear();
+		return stbi_write_bmp_to_func(&appendToBuffer, &encodedData, width, height, 3, rgbData) != 0;
+	}
+
+
+	bool encodeStbJpeg(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData)
+	{
+		encodedData.clear();
+		// same quality as used for screenshots
+		return stbi_write_jpg_to_func(&appendToBuffer, &encodedData, width, height, 3, rgbData, 98) != 0;
+	}
+
+
+	const BenchmarkResolution RESOLUTIONS[] = { {"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4K", 3840, 2160}, {"8K", 7680, 4320} };
+	const BenchmarkFrame FRAMES[] = { {"Gradient", &generateGradientFrame}, {"Foliage", &generateFoliageFrame}, {"Hud", &generateHudFrame}, {"Bokeh", &generateBokehFrame} };
+	const BenchmarkEncoder ENCODERS[] = { {"stb BMP", "bmp", &encodeStbBmp}, {"stb JPEG", "jpg", &encodeStbJpeg}, {"fpng PNG", "png", &IGCS::ImageFileIO::encodePng},
+										  {"BMP", "bmp", &IGCS::ImageFileIO::encodeBmp}, {"TGA", "tga", &IGCS::ImageFileIO::encodeTga}, {"PPM", "ppm", &IGCS::ImageFileIO::encodePpm} };
+}
+
+
+void EncoderBenchmark::start(const std::string& outputFolder)
+{
+	bool expected = false;
+	if(!_isRunning.compare_exchange_strong(expected, true))
+	{
+		return;
+	}
+	std::thread t(&EncoderBenchmark::run, this, outputFolder);
+	t.detach();
+}
+
+
+void EncoderBenchmark::run(std::string outputFolder)
+{
+	const std::string optionalBackslash = (outputFolder.ends_with('\\')) ? "" : "\\";
+	const std::string benchmarkFolder = outputFolder + optionalBackslash + "EncoderBenchmark";
+	std::error_code errorCode;
+	std::filesystem::create_directories(benchmarkFolder, errorCode);
+
+	// thread counts to measure scaling with: 1, half the cores and all cores.
+	const int numberOfCores = std::max(1, (int)std::thread::hardware_concurrency());
+	std::vector<int> threadCounts = { 1 };
+	if(numberOfCores / 2 > 1)
+	{
+		threadCounts.push_back(numberOfCores / 2);
+	}
+	if(numberOfCores > 1)
+	{
+		threadCounts.push_back(numberOfCores);
+	}
+
+	OverlayControl::addNotification("Encoder benchmark started. This can take a while...");
+	std::vector<EncoderResult> results;
+	std::vector<uint8_t> frameData;
+	for(const BenchmarkResolution& resolution : RESOLUTIONS)
+	{
+		const size_t frameSizeInBytes = (size_t)resolution.width * resolution.height * 3;
+		frameData.resize(frameSizeInBytes);
+		for(const BenchmarkFrame& frame : FRAMES)
+		{
+			frame.generate(frameData, resolution.width, resolution.height);
+			for(const BenchmarkEncoder& encoder : ENCODERS)
+			{
+				// the warm up encode gives the output size. Writing its result to disk is timed on its own, so the disk doesn't end up in the encode timings.
+				std::vector<uint8_t> encodedData;
+				if(!encoder.encode(frameData.data(), resolution.width, resolution.height, encodedData))
+				{
+					IGCS::Utils::logLineToReshade(reshade::log_level::warning, "Encoder benchmark: %s failed to encode a %s %s frame", encoder.name, resolution.name, frame.name);
+					continue;
+				}
+				const std::string filename = IGCS::Utils::formatString("%s\\%s_%s_%s.%s", benchmarkFolder.c_str(), resolution.name, frame.name, encoder.name, encoder.extension);
+				const auto fileWriteStartTime = high_resolution_clock::now();
+				const bool fileWritten = IGCS::ImageFileIO::writeEncodedData(filename, encodedData);
+				const double msFileWrite = duration<double, std::milli>(high_resolution_clock::now() - fileWriteStartTime).count();
+				if(!fileWritten)
+				{
+					IGCS::Utils::logLineToReshade(reshade::log_level::warning, "Encoder benchmark: couldn't write %s", filename.c_str());
+				}
+				std::filesystem::remove(filename, errorCode);
+
+				for(const int numberOfThreads : threadCounts)
+				{
+					// a buffer per thread, sized by the warm up encode, so the timed encodes only measure the encoder.
+					std::vector<std::vector<uint8_t>> threadBuffers(numberOfThreads);
+					for(std::vector<uint8_t>& threadBuffer : threadBuffers)
+					{
+						threadBuffer.reserve(encodedData.size());
+					}
+					std::vector<std::thread> encoderThreads;
+					const auto startTime = high_resolution_clock::now();
+					for(int threadIndex = 0; threadIndex < numberOfThreads; threadIndex++)
+					{
+						encoderThreads.emplace_back([&encoder, &frameData, &resolution, &threadBuffer = threadBuffers[threadIndex]]()
+						{
+							for(int i = 0; i < ITERATIONS_PER_THREAD; i++)
+							{
+								encoder.encode(frameData.data(), resolution.width, resolution.height, threadBuffer);
+							}
+						});
+					}
+					for(std::thread& encoderThread : encoderThreads)
+					{
+						encoderThread.join();
+					}
+					const double elapsedSeconds = duration<double>(high_resolution_clock::now() - startTime).count();
+
+					const int numberOfFramesEncoded = numberOfThreads * ITERATIONS_PER_THREAD;
+					EncoderResult result;
+					result.encoderName = encoder.name;
+					result.frameName = frame.name;
+					result.width = resolution.width;
+					result.height = resolution.height;
+					result.numberOfThreads = numberOfThreads;
+					// average duration of a single encode. With more than 1 thread the encodes overlap, so the throughput is higher than 1000/msPerFrame.
+					result.msPerFrame = (elapsedSeconds * 1000.0 * numberOfThreads) / numberOfFramesEncoded;
+					result.megabytesPerSecond = ((double)frameSizeInBytes * numberOfFramesEncoded) / (1024.0 * 1024.0) / std::max(elapsedSeconds, 0.000001);
+					result.outputSizeInBytes = encodedData.size();
+					result.msFileWrite = msFileWrite;
+					results.push_back(result);
+					IGCS::Utils::logLineToReshade(reshade::log_level::info, "Encoder benchmark: %-8s %-9s %-5s threads: %2d. %9.2f ms/frame, %9.2f MB/s, %llu bytes, %8.2f ms file write",
+												  encoder.name, frame.name, resolution.name, numberOfThreads, result.msPerFrame, result.megabytesPerSecond,
+												  (unsigned long long)result.outputSizeInBytes, msFileWrite);
+				}
+			}
+		}
+		OverlayControl::addNotification(IGCS::Utils::formatString("Encoder benchmark: %s done.", resolution.name));
+	}
+	writeResults(benchmarkFolder, results);
+	OverlayControl::addNotification("Encoder benchmark completed. Results written to " + benchmarkFolder);
+	_isRunning = false;
+}
+
+
+void EncoderBenchmark::writeResults(const std::string& outputFolder, const std::vector<EncoderResult>& results)
+{
+	const std::string filename = outputFolder + "\\results.json";
+	FILE* resultsFile = nullptr;
+	if(fopen_s(&resultsFile, filename.c_str(), "w") != 0 || nullptr == resultsFile)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Encoder benchmark: couldn't write results to %s", filename.c_str());
+		return;
+	}
+	fprintf(resultsFile, "{\n\t\"hardwareThreads\": %u,\n\t\"iterationsPerThread\": %d,\n\t\"results\": [\n", std::thread::hardware_concurrency(), ITERATIONS_PER_THREAD);
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const EncoderResult& result = results[i];
+		fprintf(resultsFile, "\t\t{ \"encoder\": \"%s\", \"frame\": \"%s\", \"width\": %d, \"height\": %d, \"threads\": %d, \"msPerFrame\": %.3f, \"megabytesPerSecond\": %.3f, \"outputSizeInBytes\": %llu, \"msFileWrite\": %.3f }%s\n",
+				result.encoderName.c_str(), result.frameName.c_str(), result.width, result.height, result.numberOfThreads, result.msPerFrame, result.megabytesPerSecond,
+				(unsigned long long)result.outputSizeInBytes, result.msFileWrite, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(resultsFile, "\t]\n}\n");
+	fclose(resultsFile);
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Benchmarks the image encoders reachable from the screenshot controller against a set of deterministic, synthetic game-like frames
+/// (sky gradients, foliage noise, HUD text and bokeh highlights) at 1080p, 1440p, 4K and 8K. Per encoder / frame / resolution it measures ms per frame,
+/// MB/s (of uncompressed input), thread scaling and output size, and writes the results as JSON to the output folder so encoder changes can be compared.
+/// Frames are encoded into memory, so the encode timings don't include the disk. Writing one encoded frame to disk is timed separately.
+/// The benchmark runs on its own thread as it takes a while. Only available in debug builds.
+/// </summary>
+class EncoderBenchmark
+{
+public:
+	EncoderBenchmark() = default;
+	~EncoderBenchmark() = default;
+
+	/// <summary>
+	/// Starts the benchmark on a background thread, writing the results to outputFolder. Ignored if a benchmark is already running.
+	/// </summary>
+	/// <param name="outputFolder"></param>
+	void start(const std::string& outputFolder);
+	bool isRunning() { return _isRunning; }
+
+private:
+	struct EncoderResult
+	{
+		std::string encoderName;
+		std::string frameName;
+		int width = 0;
+		int height = 0;
+		int numberOfThreads = 0;
+		double msPerFrame = 0.0;
+		double megabytesPerSecond = 0.0;
+		uint64_t outputSizeInBytes = 0;
+		double msFileWrite = 0.0;			// writing a single encoded frame to disk
+	};
+
+	void run(std::string outputFolder);
+	void writeResults(const std::string& outputFolder, const std::vector<EncoderResult>& results);
+
+	std::atomic<bool> _isRunning = false;
+};
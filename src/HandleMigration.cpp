@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "HandleMigration.h"
+#include "EffectStatePool.h"
+
+
+HandleMigration::HandleMigration(const ReshadeStateSnapshot& currentState) : _currentState(currentState)
+{
+	const auto& currentEffectStates = currentState.getEffectStates();
+	_currentEffectStatePerNameId.reserve(currentEffectStates.size());
+	for(const auto& effectState : currentEffectStates)
+	{
+		_currentEffectStatePerNameId.emplace(effectState->nameId(), effectState.get());
+	}
+}
+
+
+HandleMigration::HandleMigration(const ReshadeStateSnapshot& currentState, const EffectRegistry& registry, reshade::api::effect_runtime* runtime) :
+	HandleMigration(currentState)
+{
+	_runtime = runtime;
+	for(const auto& registeredEffect : registry.getEffects())
+	{
+		if(!_currentEffectStatePerNameId.contains(registeredEffect.nameId))
+		{
+			_registeredEffectPerNameId.emplace(registeredEffect.nameId, &registeredEffect);
+		}
+	}
+}
+
+
+std::shared_ptr<const EffectState> HandleMigration::migrate(const std::shared_ptr<const EffectState>& effectState)
+{
+	const auto migratedIt = _migratedEffectStates.find(effectState.get());
+	if(migratedIt != _migratedEffectStates.end())
+	{
+		return migratedIt->second;
+	}
+	const EffectState* currentEffectState = findCurrentEffectState(effectState->nameId());
+	if(nullptr == currentEffectState)
+	{
+		// Effects not known to us are ignored as we don't store uniforms for unknown effects (it's the same as having an effect / technique being disabled).
+		_migratedEffectStates.emplace(effectState.get(), effectState);
+		_numberOfEffectStatesNotLoaded++;
+		return effectState;
+	}
+	// The effect state is shared, so we migrate a copy, which is again shared with the other snapshots migrating the same state.
+	EffectState migratedEffectState = *effectState;
+	migratedEffectState.migrateIds(*currentEffectState);
+	auto toReturn = EffectStatePool::instance().intern(std::move(migratedEffectState));
+	_migratedEffectStates.emplace(effectState.get(), toReturn);
+	return toReturn;
+}
+
+
+const EffectState* HandleMigration::findCurrentEffectState(uint32_t nameId)
+{
+	const auto currentIt = _currentEffectStatePerNameId.find(nameId);
+	if(currentIt != _currentEffectStatePerNameId.end())
+	{
+		return currentIt->second;
+	}
+	const auto registeredIt = _registeredEffectPerNameId.find(nameId);
+	if(registeredIt == _registeredEffectPerNameId.end())
+	{
+		return nullptr;
+	}
+	// loaded but without an enabled technique, so it's not in the current state. Read it once, for the handles and the values of new uniforms.
+	auto [obtainedIt, isAdded] = _obtainedEffectStatePerNameId.try_emplace(nameId, nameId);
+	if(isAdded)
+	{
+		obtainedIt->second.obtainEffectState(_runtime, *registeredIt->second);
+	}
+	return &obtainedIt->second;
+}
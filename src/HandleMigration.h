@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <reshade.hpp>
+#include "EffectRegistry.h"
+#include "EffectState.h"
+#include "ReshadeStateSnapshot.h"
+
+/// <summary>
+/// The index used to migrate the handles of all snapshots to the effects loaded after a reload, built once per reload from the current state.
+/// It maps effect name ids to the current effect states, and remembers the result of every effect state it migrated, so an effect state shared by
+/// many snapshots is migrated once instead of once per snapshot. Only valid as long as the current state it's built from is.
+/// </summary>
+class HandleMigration
+{
+public:
+	/// <summary>
+	/// Creates the index for the effects in currentState only, which are the effects which have an enabled technique.
+	/// </summary>
+	explicit HandleMigration(const ReshadeStateSnapshot& currentState);
+	/// <summary>
+	/// Creates the index for all effects loaded in runtime, using its registry. The current state of an effect without an enabled technique, which
+	/// isn't in currentState, is read from the runtime the first time a snapshot needs it.
+	/// </summary>
+	HandleMigration(const ReshadeStateSnapshot& currentState, const EffectRegistry& registry, reshade::api::effect_runtime* runtime);
+
+	/// <summary>
+	/// Returns effectState with the handles of the current state, or effectState itself if its effect isn't loaded anymore.
+	/// </summary>
+	std::shared_ptr<const EffectState> migrate(const std::shared_ptr<const EffectState>& effectState);
+
+	const ReshadeStateSnapshot& getCurrentState() const { return _currentState; }
+	/// <summary>
+	/// Returns true if no techniques are loaded, e.g. as the effects are being destroyed, so there's nothing to migrate to.
+	/// </summary>
+	bool isEmpty() const { return _currentState.getTechniqueNameIds().empty(); }
+	size_t getNumberOfEffectStatesMigrated() const { return _migratedEffectStates.size() - _numberOfEffectStatesNotLoaded; }
+	/// <summary>
+	/// Returns the number of effect states which couldn't be migrated as their effect isn't loaded. They keep their handles until the next reload.
+	/// </summary>
+	size_t getNumberOfEffectStatesNotLoaded() const { return _numberOfEffectStatesNotLoaded; }
+
+private:
+	/// <summary>
+	/// Returns the current state of the effect with the name id specified, or nullptr if the effect isn't loaded.
+	/// </summary>
+	const EffectState* findCurrentEffectState(uint32_t nameId);
+
+	const ReshadeStateSnapshot& _currentState;
+	reshade::api::effect_runtime* _runtime = nullptr;
+	std::unordered_map<uint32_t, const EffectState*> _currentEffectStatePerNameId;
+	// the loaded effects which aren't in the current state, and the states read for them so far
+	std::unordered_map<uint32_t, const EffectRegistry::RegisteredEffect*> _registeredEffectPerNameId;
+	std::unordered_map<uint32_t, EffectState> _obtainedEffectStatePerNameId;
+	std::unordered_map<const EffectState*, std::shared_ptr<const EffectState>> _migratedEffectStates;
+	size_t _numberOfEffectStatesNotLoaded = 0;
+};
@@ -0,0 +1,542 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "ImageFileIO.h"
+#include "Utils.h"
+#include "fpng.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <intrin.h>
+#include <tmmintrin.h>
+#include <vector>
+
+namespace IGCS::ImageFileIO
+{
+	namespace
+	{
+		// Size of the block of converted rows we hand to a single fwrite call. Large enough to keep the per-call overhead out of the picture.
+		constexpr size_t STAGING_BUFFER_SIZE = 8 * 1024 * 1024;
+		// Largest width and height we read from a PPM/PGM header. The files read are masks and test images, which are far smaller, and the header comes
+		// from a file the user picked, so it can't make us allocate whatever it claims.
+		constexpr int MAX_READ_DIMENSION = 16384;
+		// BITMAPFILEHEADER + BITMAPINFOHEADER
+		constexpr uint32_t BMP_HEADER_LENGTH = 14 + 40;
+		constexpr uint32_t TGA_HEADER_LENGTH = 18;
+
+		bool cpuSupportsSsse3()
+		{
+			static const bool supported = []()
+			{
+				int cpuInfo[4] = {};
+				__cpuid(cpuInfo, 1);
+				return (cpuInfo[2] & (1 << 9)) != 0;
+			}();
+			return supported;
+		}
+
+
+		void writeLE16(uint8_t* destination, uint16_t value)
+		{
+			destination[0] = (uint8_t)(value & 0xFF);
+			destination[1] = (uint8_t)(value >> 8);
+		}
+
+
+		void writeLE32(uint8_t* destination, uint32_t value)
+		{
+			destination[0] = (uint8_t)(value & 0xFF);
+			destination[1] = (uint8_t)((value >> 8) & 0xFF);
+			destination[2] = (uint8_t)((value >> 16) & 0xFF);
+			destination[3] = (uint8_t)(value >> 24);
+		}
+
+
+		FILE* openForWriting(const std::string& filename)
+		{
+			FILE* outFile = nullptr;
+			if(fopen_s(&outFile, filename.c_str(), "wb") != 0)
+			{
+				return nullptr;
+			}
+			// we write in large blocks ourselves, so the crt buffer would only add a copy.
+			setvbuf(outFile, nullptr, _IONBF, 0);
+			return outFile;
+		}
+
+
+		void writeLE64(uint8_t* destination, uint64_t value)
+		{
+			writeLE32(destination, (uint32_t)(value & 0xFFFFFFFF));
+			writeLE32(destination + 4, (uint32_t)(value >> 32));
+		}
+
+
+		/// <summary>
+		/// Appends an OpenEXR header attribute: name, type name, the size of the value and the value itself.
+		/// </summary>
+		void appendExrAttribute(std::vector<uint8_t>& header, const char* name, const char* typeName, const uint8_t* value, uint32_t valueLength)
+		{
+			header.insert(header.end(), name, name + strlen(name) + 1);
+			header.insert(header.end(), typeName, typeName + strlen(typeName) + 1);
+			uint8_t length[4];
+			writeLE32(length, valueLength);
+			header.insert(header.end(), length, length + 4);
+			header.insert(header.end(), value, value + valueLength);
+		}
+
+
+		/// <summary>
+		/// Reads the width*height*bytesPerPixel bytes of pixel data following a PPM/PGM header into data. Returns false, without allocating, if the
+		/// dimensions exceed MAX_READ_DIMENSION or the rest of the file is too short to contain the data.
+		/// </summary>
+		bool readPpmPixelData(FILE* inFile, int width, int height, int bytesPerPixel, std::vector<uint8_t>& data)
+		{
+			if(width <= 0 || height <= 0 || width > MAX_READ_DIMENSION || height > MAX_READ_DIMENSION)
+			{
+				return false;
+			}
+			// the single whitespace after the max value has been consumed by the header reader.
+			const int64_t dataOffset = _ftelli64(inFile);
+			if(dataOffset < 0 || _fseeki64(inFile, 0, SEEK_END) != 0)
+			{
+				return false;
+			}
+			const int64_t fileLength = _ftelli64(inFile);
+			const size_t dataLength = (size_t)width * height * bytesPerPixel;
+			if(fileLength < dataOffset || (uint64_t)(fileLength - dataOffset) < dataLength || _fseeki64(inFile, dataOffset, SEEK_SET) != 0)
+			{
+				return false;
+			}
+			data.resize(dataLength);
+			return fread(data.data(), 1, dataLength, inFile) == dataLength;
+		}
+
+
+		/// <summary>
+		/// Reads the next whitespace separated number from a PPM header, skipping comments.
+		/// </summary>
+		bool readPpmHeaderValue(FILE* inFile, int& value)
+		{
+			int character = fgetc(inFile);
+			while(EOF != character && (isspace(character) || '#' == character))
+			{
+				if('#' == character)
+				{
+					while(EOF != character && '\n' != character)
+					{
+						character = fgetc(inFile);
+					}
+				}
+				character = fgetc(inFile);
+			}
+			if(!isdigit(character))
+			{
+				return false;
+			}
+			value = 0;
+			while(isdigit(character))
+			{
+				if(value > (INT32_MAX / 10) - 1)
+				{
+					return false;
+				}
+				value = (value * 10) + (character - '0');
+				character = fgetc(inFile);
+			}
+			// the single whitespace character after the value is consumed, which is what PPM requires after the max value.
+			return EOF != character && isspace(character);
+		}
+
+
+		/// <summary>
+		/// Writes the header specified followed by the rgb data as BGR rows in bottom-up order, each row padded to paddedRowLength bytes.
+		/// </summary>
+		bool writeHeaderAndBgrRowsBottomUp(const std::string& filename, const uint8_t* header, size_t headerLength, const uint8_t* rgbData, int width, int height,
+										   size_t paddedRowLength)
+		{
+			FILE* outFile = openForWriting(filename);
+			if(nullptr == outFile)
+			{
+				return false;
+			}
+
+			bool success = fwrite(header, 1, headerLength, outFile) == headerLength;
+			const size_t sourceRowLength = (size_t)width * 3;
+			const int rowsPerBlock = std::max(1, (int)(STAGING_BUFFER_SIZE / paddedRowLength));
+			// Zero initialized, and the swizzle never touches the padding bytes at the end of a row, so these stay 0.
+			std::vector<uint8_t> stagingBuffer((size_t)std::min(rowsPerBlock, height) * paddedRowLength, 0);
+			for(int rowsWritten = 0; success && rowsWritten < height;)
+			{
+				const int rowsInBlock = std::min(rowsPerBlock, height - rowsWritten);
+				for(int i = 0; i < rowsInBlock; i++)
+				{
+					// first row in the file is the last row of the image.
+					const int sourceRow = height - 1 - (rowsWritten + i);
+					swizzleRgbToBgr(rgbData + (size_t)sourceRow * sourceRowLength, stagingBuffer.data() + (size_t)i * paddedRowLength, width);
+				}
+				const size_t blockLength = (size_t)rowsInBlock * paddedRowLength;
+				success = fwrite(stagingBuffer.data(), 1, blockLength, outFile) == blockLength;
+				rowsWritten += rowsInBlock;
+			}
+			fclose(outFile);
+			return success;
+		}
+
+
+		/// <summary>
+		/// Same layout as writeHeaderAndBgrRowsBottomUp, but into encodedData, which is resized to the length of the file.
+		/// </summary>
+		void encodeHeaderAndBgrRowsBottomUp(const uint8_t* header, size_t headerLength, const uint8_t* rgbData, int width, int height, size_t paddedRowLength,
+											std::vector<uint8_t>& encodedData)
+		{
+			encodedData.resize(headerLength + (size_t)height * paddedRowLength);
+			memcpy(encodedData.data(), header, headerLength);
+			const size_t sourceRowLength = (size_t)width * 3;
+			for(int row = 0; row < height; row++)
+			{
+				uint8_t* destinationRow = encodedData.data() + headerLength + (size_t)row * paddedRowLength;
+				swizzleRgbToBgr(rgbData + (size_t)(height - 1 - row) * sourceRowLength, destinationRow, width);
+				// the buffer can be reused, so the padding has to be cleared.
+				memset(destinationRow + sourceRowLength, 0, paddedRowLength - sourceRowLength);
+			}
+		}
+
+
+		bool createBmpHeader(int width, int height, uint8_t (&header)[BMP_HEADER_LENGTH], size_t& paddedRowLength)
+		{
+			if(width <= 0 || height <= 0)
+			{
+				return false;
+			}
+			paddedRowLength = ((size_t)width * 3 + 3) & ~(size_t)3;
+			const uint64_t imageSize = (uint64_t)paddedRowLength * height;
+			if(imageSize + BMP_HEADER_LENGTH > UINT32_MAX)
+			{
+				return false;
+			}
+			memset(header, 0, BMP_HEADER_LENGTH);
+			// BITMAPFILEHEADER
+			header[0] = 'B';
+			header[1] = 'M';
+			writeLE32(header + 2, (uint32_t)(imageSize + BMP_HEADER_LENGTH));
+			writeLE32(header + 10, BMP_HEADER_LENGTH);
+			// BITMAPINFOHEADER. Positive height means bottom-up rows.
+			writeLE32(header + 14, 40);
+			writeLE32(header + 18, (uint32_t)width);
+			writeLE32(header + 22, (uint32_t)height);
+			writeLE16(header + 26, 1);				// planes
+			writeLE16(header + 28, 24);				// bits per pixel
+			writeLE32(header + 30, 0);				// BI_RGB
+			writeLE32(header + 34, (uint32_t)imageSize);
+			return true;
+		}
+
+
+		bool createTgaHeader(int width, int height, uint8_t (&header)[TGA_HEADER_LENGTH])
+		{
+			if(width <= 0 || height <= 0 || width > UINT16_MAX || height > UINT16_MAX)
+			{
+				return false;
+			}
+			memset(header, 0, TGA_HEADER_LENGTH);
+			header[2] = 2;							// uncompressed true-color
+			writeLE16(header + 12, (uint16_t)width);
+			writeLE16(header + 14, (uint16_t)height);
+			header[16] = 24;						// bits per pixel
+			header[17] = 0;							// no alpha, origin bottom-left
+			return true;
+		}
+	}
+
+
+	void swizzleRgbToBgr(const uint8_t* source, uint8_t* destination, int numberOfPixels)
+	{
+		size_t pixel = 0;
+		const size_t pixelCount = numberOfPixels > 0 ? (size_t)numberOfPixels : 0;
+		if(cpuSupportsSsse3())
+		{
+			// 5 pixels (15 bytes) per 16 byte register. The 16th byte is written as 0 and overwritten by the next iteration (or the scalar tail). 
+			// We stop 6 pixels before the end so the unaligned 16 byte load and store never reach outside the row.
+			const __m128i shuffleMask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1);
+			for(; pixel + 6 <= pixelCount; pixel += 5)
+			{
+				const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + pixel * 3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + pixel * 3), _mm_shuffle_epi8(rgb, shuffleMask));
+			}
+		}
+		for(; pixel < pixelCount; pixel++)
+		{
+			const uint8_t* sourcePixel = source + pixel * 3;
+			uint8_t* destinationPixel = destination + pixel * 3;
+			destinationPixel[0] = sourcePixel[2];
+			destinationPixel[1] = sourcePixel[1];
+			destinationPixel[2] = sourcePixel[0];
+		}
+	}
+
+
+	bool writeBmp(const std::string& filename, const uint8_t* rgbData, int width, int height)
+	{
+		uint8_t header[BMP_HEADER_LENGTH];
+		size_t paddedRowLength = 0;
+		if(nullptr == rgbData || !createBmpHeader(width, height, header, paddedRowLength))
+		{
+			return false;
+		}
+		return writeHeaderAndBgrRowsBottomUp(filename, header, BMP_HEADER_LENGTH, rgbData, width, height, paddedRowLength);
+	}
+
+
+	bool encodeBmp(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData)
+	{
+		uint8_t header[BMP_HEADER_LENGTH];
+		size_t paddedRowLength = 0;
+		if(nullptr == rgbData || !createBmpHeader(width, height, header, paddedRowLength))
+		{
+			return false;
+		}
+		encodeHeaderAndBgrRowsBottomUp(header, BMP_HEADER_LENGTH, rgbData, width, height, paddedRowLength, encodedData);
+		return true;
+	}
+
+
+	bool writeTga(const std::string& filename, const uint8_t* rgbData, int width, int height)
+	{
+		uint8_t header[TGA_HEADER_LENGTH];
+		if(nullptr == rgbData || !createTgaHeader(width, height, header))
+		{
+			return false;
+		}
+		return writeHeaderAndBgrRowsBottomUp(filename, header, TGA_HEADER_LENGTH, rgbData, width, height, (size_t)width * 3);
+	}
+
+
+	bool encodeTga(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData)
+	{
+		uint8_t header[TGA_HEADER_LENGTH];
+		if(nullptr == rgbData || !createTgaHeader(width, height, header))
+		{
+			return false;
+		}
+		encodeHeaderAndBgrRowsBottomUp(header, TGA_HEADER_LENGTH, rgbData, width, height, (size_t)width * 3, encodedData);
+		return true;
+	}
+
+
+	bool writePpm(const std::string& filename, const uint8_t* rgbData, int width, int height)
+	{
+		if(nullptr == rgbData || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+		FILE* outFile = openForWriting(filename);
+		if(nullptr == outFile)
+		{
+			return false;
+		}
+		// not formatString, as the string it returns includes the terminating 0, which would end up in the file.
+		char header[64];
+		const size_t headerLength = (size_t)snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+		bool success = fwrite(header, 1, headerLength, outFile) == headerLength;
+		// PPM is top-down RGB, same as our input, so we can write the data in large blocks directly from the source.
+		const size_t dataLength = (size_t)width * height * 3;
+		for(size_t offset = 0; success && offset < dataLength; offset += STAGING_BUFFER_SIZE)
+		{
+			const size_t blockLength = std::min(STAGING_BUFFER_SIZE, dataLength - offset);
+			success = fwrite(rgbData + offset, 1, blockLength, outFile) == blockLength;
+		}
+		fclose(outFile);
+		return success;
+	}
+
+
+	bool encodePpm(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData)
+	{
+		if(nullptr == rgbData || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+		char header[64];
+		const size_t headerLength = (size_t)snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+		const size_t dataLength = (size_t)width * height * 3;
+		encodedData.resize(headerLength + dataLength);
+		memcpy(encodedData.data(), header, headerLength);
+		memcpy(encodedData.data() + headerLength, rgbData, dataLength);
+		return true;
+	}
+
+
+	bool writeExr(const std::string& filename, const float* rgbData, int width, int height)
+	{
+		if(nullptr == rgbData || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+
+		// magic number and version 2, single part scanline file.
+		std::vector<uint8_t> header = { 0x76, 0x2f, 0x31, 0x01, 0x02, 0x00, 0x00, 0x00 };
+		// channels have to be sorted by name, so B, G, R. Per channel: name, pixel type (2: float), pLinear + 3 reserved bytes, x and y sampling.
+		std::vector<uint8_t> channelList;
+		for(const char* channelName : { "B", "G", "R" })
+		{
+			uint8_t channel[18] = {};
+			channel[0] = channelName[0];
+			writeLE32(channel + 2, 2);
+			writeLE32(channel + 10, 1);
+			writeLE32(channel + 14, 1);
+			channelList.insert(channelList.end(), channel, channel + sizeof(channel));
+		}
+		channelList.push_back(0);
+		appendExrAttribute(header, "channels", "chlist", channelList.data(), (uint32_t)channelList.size());
+		const uint8_t noCompression = 0;
+		appendExrAttribute(header, "compression", "compression", &noCompression, 1);
+		uint8_t window[16] = {};
+		writeLE32(window + 8, (uint32_t)(width - 1));
+		writeLE32(window + 12, (uint32_t)(height - 1));
+		appendExrAttribute(header, "dataWindow", "box2i", window, sizeof(window));
+		appendExrAttribute(header, "displayWindow", "box2i", window, sizeof(window));
+		const uint8_t increasingY = 0;
+		appendExrAttribute(header, "lineOrder", "lineOrder", &increasingY, 1);
+		const float one = 1.0f;
+		appendExrAttribute(header, "pixelAspectRatio", "float", reinterpret_cast<const uint8_t*>(&one), sizeof(float));
+		const float screenWindowCenter[2] = { 0.0f, 0.0f };
+		appendExrAttribute(header, "screenWindowCenter", "v2f", reinterpret_cast<const uint8_t*>(screenWindowCenter), sizeof(screenWindowCenter));
+		appendExrAttribute(header, "screenWindowWidth", "float", reinterpret_cast<const uint8_t*>(&one), sizeof(float));
+		header.push_back(0);
+
+		// Uncompressed files have a block per scanline: y, the size of the pixel data and then the row of each channel.
+		const size_t rowDataLength = (size_t)width * 3 * sizeof(float);
+		const size_t blockLength = 8 + rowDataLength;
+		const size_t firstBlockOffset = header.size() + ((size_t)height * 8);
+		const size_t headerLength = header.size();
+		header.resize(firstBlockOffset);
+		for(int y = 0; y < height; y++)
+		{
+			writeLE64(header.data() + headerLength + ((size_t)y * 8), firstBlockOffset + ((size_t)y * blockLength));
+		}
+
+		FILE* outFile = openForWriting(filename);
+		if(nullptr == outFile)
+		{
+			return false;
+		}
+		bool success = fwrite(header.data(), 1, header.size(), outFile) == header.size();
+		const int rowsPerBlock = std::max(1, (int)(STAGING_BUFFER_SIZE / blockLength));
+		std::vector<uint8_t> stagingBuffer((size_t)std::min(rowsPerBlock, height) * blockLength);
+		for(int rowsWritten = 0; success && rowsWritten < height;)
+		{
+			const int rowsInBlock = std::min(rowsPerBlock, height - rowsWritten);
+			for(int i = 0; i < rowsInBlock; i++)
+			{
+				const int row = rowsWritten + i;
+				uint8_t* block = stagingBuffer.data() + (size_t)i * blockLength;
+				writeLE32(block, (uint32_t)row);
+				writeLE32(block + 4, (uint32_t)rowDataLength);
+				float* channelData = reinterpret_cast<float*>(block + 8);
+				const float* sourceRow = rgbData + (size_t)row * width * 3;
+				for(int x = 0; x < width; x++)
+				{
+					channelData[x] = sourceRow[(x * 3) + 2];
+					channelData[width + x] = sourceRow[(x * 3) + 1];
+					channelData[(2 * width) + x] = sourceRow[x * 3];
+				}
+			}
+			const size_t bytesToWrite = (size_t)rowsInBlock * blockLength;
+			success = fwrite(stagingBuffer.data(), 1, bytesToWrite, outFile) == bytesToWrite;
+			rowsWritten += rowsInBlock;
+		}
+		fclose(outFile);
+		return success;
+	}
+
+
+	bool readPpm(const std::string& filename, std::vector<uint8_t>& rgbData, int& width, int& height)
+	{
+		FILE* inFile = nullptr;
+		if(fopen_s(&inFile, filename.c_str(), "rb") != 0 || nullptr == inFile)
+		{
+			return false;
+		}
+		int maxValue = 0;
+		const bool success = fgetc(inFile) == 'P' && fgetc(inFile) == '6' && readPpmHeaderValue(inFile, width) && readPpmHeaderValue(inFile, height) &&
+					   readPpmHeaderValue(inFile, maxValue) && 255 == maxValue && readPpmPixelData(inFile, width, height, 3, rgbData);
+		fclose(inFile);
+		return success;
+	}
+
+
+	bool readPgm(const std::string& filename, std::vector<uint8_t>& grayData, int& width, int& height)
+	{
+		FILE* inFile = nullptr;
+		if(fopen_s(&inFile, filename.c_str(), "rb") != 0 || nullptr == inFile)
+		{
+			return false;
+		}
+		int maxValue = 0;
+		const bool success = fgetc(inFile) == 'P' && fgetc(inFile) == '5' && readPpmHeaderValue(inFile, width) && readPpmHeaderValue(inFile, height) &&
+					   readPpmHeaderValue(inFile, maxValue) && 255 == maxValue && readPpmPixelData(inFile, width, height, 1, grayData);
+		fclose(inFile);
+		return success;
+	}
+
+
+	bool writePng(const std::string& filename, const uint8_t* rgbData, int width, int height)
+	{
+		std::vector<uint8_t> encodedData;
+		return encodePng(rgbData, width, height, encodedData) && writeEncodedData(filename, encodedData);
+	}
+
+
+	bool encodePng(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData)
+	{
+		if(nullptr == rgbData || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+		return fpng::fpng_encode_image_to_memory(rgbData, width, height, 3, encodedData);
+	}
+
+
+	bool writeEncodedData(const std::string& filename, const std::vector<uint8_t>& encodedData)
+	{
+		FILE* outFile = openForWriting(filename);
+		if(nullptr == outFile)
+		{
+			return false;
+		}
+		const bool success = fwrite(encodedData.data(), 1, encodedData.size(), outFile) == encodedData.size();
+		fclose(outFile);
+		return success;
+	}
+}
@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace IGCS::ImageFileIO
+{
+	/// <summary>
+	/// Writes the packed RGB (3 bytes per pixel, top-down) image data specified as an uncompressed 24bpp BMP file. Rows are swizzled to BGR and emitted
+	/// bottom-up with their 4-byte padding in large blocks, instead of the per-pixel path stb_image_write uses.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool writeBmp(const std::string& filename, const uint8_t* rgbData, int width, int height);
+	/// <summary>
+	/// Encodes the packed RGB (3 bytes per pixel, top-down) image data specified as an uncompressed 24bpp BMP into encodedData, the same bytes writeBmp writes to a file.
+	/// encodedData is resized to the encoded length, so reusing it avoids an allocation per image.
+	/// </summary>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="encodedData">receives the encoded file</param>
+	/// <returns>true if the image was encoded successfully, false otherwise</returns>
+	bool encodeBmp(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData);
+	/// <summary>
+	/// Writes the packed RGB (3 bytes per pixel, top-down) image data specified as an uncompressed 24bpp TGA file, bottom-up and in BGR order.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool writeTga(const std::string& filename, const uint8_t* rgbData, int width, int height);
+	/// <summary>
+	/// Encodes the packed RGB (3 bytes per pixel, top-down) image data specified as an uncompressed 24bpp TGA into encodedData, the same bytes writeTga writes to a file.
+	/// encodedData is resized to the encoded length, so reusing it avoids an allocation per image.
+	/// </summary>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="encodedData">receives the encoded file</param>
+	/// <returns>true if the image was encoded successfully, false otherwise</returns>
+	bool encodeTga(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData);
+	/// <summary>
+	/// Writes the packed RGB (3 bytes per pixel, top-down) image data specified as a binary (P6) PPM file. As PPM's pixel layout is equal to the
+	/// input layout, the data is written as-is.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool writePpm(const std::string& filename, const uint8_t* rgbData, int width, int height);
+	/// <summary>
+	/// Encodes the packed RGB (3 bytes per pixel, top-down) image data specified as a binary (P6) PPM into encodedData, the same bytes writePpm writes to a file.
+	/// encodedData is resized to the encoded length, so reusing it avoids an allocation per image.
+	/// </summary>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="encodedData">receives the encoded file</param>
+	/// <returns>true if the image was encoded successfully, false otherwise</returns>
+	bool encodePpm(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData);
+	/// <summary>
+	/// Writes the packed RGB (3 bytes per pixel, top-down) image data specified as a PNG file, encoded with fpng.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool writePng(const std::string& filename, const uint8_t* rgbData, int width, int height);
+	/// <summary>
+	/// Encodes the packed RGB (3 bytes per pixel, top-down) image data specified as a PNG into encodedData, the same bytes writePng writes to a file.
+	/// encodedData is resized to the encoded length, so reusing it avoids an allocation per image.
+	/// </summary>
+	/// <param name="rgbData">packed RGB data, width*height*3 bytes</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="encodedData">receives the encoded file</param>
+	/// <returns>true if the image was encoded successfully, false otherwise</returns>
+	bool encodePng(const uint8_t* rgbData, int width, int height, std::vector<uint8_t>& encodedData);
+	/// <summary>
+	/// Writes the data of an encoded file, as produced by one of the encode functions, to the file specified.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="encodedData"></param>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool writeEncodedData(const std::string& filename, const std::vector<uint8_t>& encodedData);
+	/// <summary>
+	/// Writes the packed RGB float image data specified (3 floats per pixel, top-down) as an uncompressed, scanline based OpenEXR file with 32bit float channels.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="rgbData">packed RGB float data, width*height*3 floats</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns>true if the file was written successfully, false otherwise</returns>
+	bool writeExr(const std::string& filename, const float* rgbData, int width, int height);
+	/// <summary>
+	/// Reads a binary (P6) PPM file with 8 bits per channel, as written by writePpm, into packed RGB (3 bytes per pixel, top-down) image data.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="rgbData">receives the packed RGB data, width*height*3 bytes</param>
+	/// <param name="width">receives the width of the image</param>
+	/// <param name="height">receives the height of the image</param>
+	/// <returns>true if the file was read successfully, false otherwise</returns>
+	bool readPpm(const std::string& filename, std::vector<uint8_t>& rgbData, int& width, int& height);
+	/// <summary>
+	/// Reads a binary (P5) PGM file with 8 bits per pixel into grayscale (1 byte per pixel, top-down) image data.
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="grayData">receives the grayscale data, width*height bytes</param>
+	/// <param name="width">receives the width of the image</param>
+	/// <param name="height">receives the height of the image</param>
+	/// <returns>true if the file was read successfully, false otherwise</returns>
+	bool readPgm(const std::string& filename, std::vector<uint8_t>& grayData, int& width, int& height);
+	/// <summary>
+	/// Converts a row of packed RGB pixels to packed BGR pixels. Uses SSSE3 if the cpu supports it. Source and destination can't overlap.
+	/// </summary>
+	/// <param name="source"></param>
+	/// <param name="destination"></param>
+	/// <param name="numberOfPixels"></param>
+	void swizzleRgbToBgr(const uint8_t* source, uint8_t* destination, int numberOfPixels);
+}
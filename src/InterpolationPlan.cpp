@@ -0,0 +1,293 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "InterpolationPlan.h"
+#include <cmath>
+
+namespace
+{
+	/// <summary>
+	/// Calculates the coefficients of the uniform Catmull-Rom segment between p1 and p2.
+	/// </summary>
+	void calculateCatmullRomCoefficients(float p0, float p1, float p2, float p3, float& constantTerm, float& linearTerm, float& quadraticTerm, float& cubicTerm)
+	{
+		constantTerm = p1;
+		linearTerm = 0.5f * (p2 - p0);
+		quadraticTerm = p0 - (2.5f * p1) + (2.0f * p2) - (0.5f * p3);
+		cubicTerm = (0.5f * (p3 - p0)) + (1.5f * (p1 - p2));
+	}
+
+
+	/// <summary>
+	/// Calculates the coefficients of the monotone cubic Hermite segment between p1 and p2, using the Fritsch-Carlson tangents: the average of the
+	/// secants, zero at a local extreme and scaled down if they would make the segment overshoot.
+	/// </summary>
+	void calculateMonotoneCubicCoefficients(float p0, float p1, float p2, float p3, float& constantTerm, float& linearTerm, float& quadraticTerm, float& cubicTerm)
+	{
+		const float previousSecant = p1 - p0;
+		const float secant = p2 - p1;
+		const float nextSecant = p3 - p2;
+		float startTangent = 0.0f;
+		float endTangent = 0.0f;
+		if(secant != 0.0f)
+		{
+			startTangent = (previousSecant * secant) > 0.0f ? 0.5f * (previousSecant + secant) : 0.0f;
+			endTangent = (secant * nextSecant) > 0.0f ? 0.5f * (secant + nextSecant) : 0.0f;
+			const float alpha = startTangent / secant;
+			const float beta = endTangent / secant;
+			const float lengthSquared = (alpha * alpha) + (beta * beta);
+			if(lengthSquared > 9.0f)
+			{
+				const float tau = 3.0f / std::sqrt(lengthSquared);
+				startTangent = tau * alpha * secant;
+				endTangent = tau * beta * secant;
+			}
+		}
+		constantTerm = p1;
+		linearTerm = startTangent;
+		quadraticTerm = (3.0f * secant) - (2.0f * startTangent) - endTangent;
+		cubicTerm = startTangent + endTangent - (2.0f * secant);
+	}
+}
+
+
+void InterpolationPlan::compile(const ReshadeStateSnapshot* previousState, const ReshadeStateSnapshot& fromState, const ReshadeStateSnapshot& toState,
+								const ReshadeStateSnapshot* nextState, StateInterpolationMode mode)
+{
+	clear();
+	fromState.collectValuePairs(toState, _uniformHandles, _uniformKeys, _fromValues, _toValues);
+	fromState.collectTechniqueStates(toState, _techniquesToEnable, _techniquesToDisable);
+	const size_t numberOfValues = _uniformHandles.size();
+	_interpolatedValues.resize(numberOfValues);
+	_constantTerms = _fromValues;
+	_linearTerms.resize(numberOfValues);
+	_isCubic = (mode != StateInterpolationMode::Linear);
+	if(!_isCubic)
+	{
+		for(size_t i = 0; i < numberOfValues; i++)
+		{
+			DirectX::XMStoreFloat4A(&_linearTerms[i], DirectX::XMVectorSubtract(DirectX::XMLoadFloat4A(&_toValues[i]), DirectX::XMLoadFloat4A(&_fromValues[i])));
+		}
+		return;
+	}
+
+	// at the ends of the path, or for uniforms not present in the neighbouring snapshot, the node value itself is used as neighbour, which flattens
+	// the tangent there.
+	if(nullptr == previousState)
+	{
+		_previousValues = _fromValues;
+	}
+	else
+	{
+		previousState->collectValues(_uniformKeys, _fromValues, _previousValues);
+	}
+	if(nullptr == nextState)
+	{
+		_nextValues = _toValues;
+	}
+	else
+	{
+		nextState->collectValues(_uniformKeys, _toValues, _nextValues);
+	}
+	_quadraticTerms.resize(numberOfValues);
+	_cubicTerms.resize(numberOfValues);
+	const bool isCatmullRom = (mode == StateInterpolationMode::CatmullRom);
+	for(size_t i = 0; i < numberOfValues; i++)
+	{
+		const float* previousValues = &_previousValues[i].x;
+		const float* fromValues = &_fromValues[i].x;
+		const float* toValues = &_toValues[i].x;
+		const float* nextValues = &_nextValues[i].x;
+		float* constantTerms = &_constantTerms[i].x;
+		float* linearTerms = &_linearTerms[i].x;
+		float* quadraticTerms = &_quadraticTerms[i].x;
+		float* cubicTerms = &_cubicTerms[i].x;
+		for(int component = 0; component < 4; component++)
+		{
+			if(isCatmullRom)
+			{
+				calculateCatmullRomCoefficients(previousValues[component], fromValues[component], toValues[component], nextValues[component], constantTerms[component],
+												linearTerms[component], quadraticTerms[component], cubicTerms[component]);
+			}
+			else
+			{
+				calculateMonotoneCubicCoefficients(previousValues[component], fromValues[component], toValues[component], nextValues[component], constantTerms[component],
+												   linearTerms[component], quadraticTerms[component], cubicTerms[component]);
+			}
+		}
+	}
+}
+
+
+void InterpolationPlan::clear()
+{
+	// keeps the capacity, so recompiling for the next segment doesn't allocate if it's not bigger.
+	_isCubic = false;
+	_uniformHandles.clear();
+	_constantTerms.clear();
+	_linearTerms.clear();
+	_quadraticTerms.clear();
+	_cubicTerms.clear();
+	_interpolatedValues.clear();
+	_techniquesToEnable.clear();
+	_techniquesToDisable.clear();
+	_uniformSlots.clear();
+	_techniqueToEnableSlots.clear();
+	_techniqueToDisableSlots.clear();
+	_boundCache = nullptr;
+	_uniformKeys.clear();
+	_fromValues.clear();
+	_toValues.clear();
+	_previousValues.clear();
+	_nextValues.clear();
+}
+
+
+void InterpolationPlan::shrinkToFit()
+{
+	_uniformKeys = std::vector<uint64_t>();
+	_fromValues = std::vector<DirectX::XMFLOAT4A>();
+	_toValues = std::vector<DirectX::XMFLOAT4A>();
+	_previousValues = std::vector<DirectX::XMFLOAT4A>();
+	_nextValues = std::vector<DirectX::XMFLOAT4A>();
+	_uniformHandles.shrink_to_fit();
+	_constantTerms.shrink_to_fit();
+	_linearTerms.shrink_to_fit();
+	_quadraticTerms.shrink_to_fit();
+	_cubicTerms.shrink_to_fit();
+	_interpolatedValues.shrink_to_fit();
+	_techniquesToEnable.shrink_to_fit();
+	_techniquesToDisable.shrink_to_fit();
+}
+
+
+size_t InterpolationPlan::calculateMemoryUsage() const
+{
+	const size_t numberOfValueArrayElements = _constantTerms.capacity() + _linearTerms.capacity() + _quadraticTerms.capacity() + _cubicTerms.capacity() +
+											  _interpolatedValues.capacity() + _fromValues.capacity() + _toValues.capacity() + _previousValues.capacity() + _nextValues.capacity();
+	return sizeof(InterpolationPlan) + (numberOfValueArrayElements * sizeof(DirectX::XMFLOAT4A)) +
+		   ((_uniformHandles.capacity() + _techniquesToEnable.capacity() + _techniquesToDisable.capacity() + _uniformKeys.capacity()) * sizeof(uint64_t)) +
+		   ((_uniformSlots.capacity() + _techniqueToEnableSlots.capacity() + _techniqueToDisableSlots.capacity()) * sizeof(uint32_t));
+}
+
+
+void InterpolationPlan::evaluate(float interpolationFactor)
+{
+	const DirectX::XMVECTOR factor = DirectX::XMVectorReplicate(interpolationFactor);
+	if(!_isCubic)
+	{
+		for(size_t i = 0; i < _interpolatedValues.size(); i++)
+		{
+			DirectX::XMStoreFloat4A(&_interpolatedValues[i], DirectX::XMVectorMultiplyAdd(DirectX::XMLoadFloat4A(&_linearTerms[i]), factor, DirectX::XMLoadFloat4A(&_constantTerms[i])));
+		}
+		return;
+	}
+	for(size_t i = 0; i < _interpolatedValues.size(); i++)
+	{
+		// Horner: ((cubic * t + quadratic) * t + linear) * t + constant
+		DirectX::XMVECTOR value = DirectX::XMVectorMultiplyAdd(DirectX::XMLoadFloat4A(&_cubicTerms[i]), factor, DirectX::XMLoadFloat4A(&_quadraticTerms[i]));
+		value = DirectX::XMVectorMultiplyAdd(value, factor, DirectX::XMLoadFloat4A(&_linearTerms[i]));
+		value = DirectX::XMVectorMultiplyAdd(value, factor, DirectX::XMLoadFloat4A(&_constantTerms[i]));
+		DirectX::XMStoreFloat4A(&_interpolatedValues[i], value);
+	}
+}
+
+
+void InterpolationPlan::apply(reshade::api::effect_runtime* runtime, float interpolationFactor, RuntimeStateCache& cache)
+{
+	evaluate(interpolationFactor);
+	if(&cache != _boundCache || cache.getGeneration() != _boundCacheGeneration)
+	{
+		bindToCache(cache);
+	}
+	RuntimeCallStatistics frameStatistics;
+	for(size_t i = 0; i < _uniformHandles.size(); i++)
+	{
+		if(0 == _uniformHandles[i])
+		{
+			// not migrated yet, e.g. the effect was loaded from a file and isn't enabled in the runtime
+			continue;
+		}
+		const auto& values = _interpolatedValues[i];
+		if(!cache.updateUniformValue(_uniformSlots[i], values))
+		{
+			frameStatistics.uniformWritesSkipped++;
+			continue;
+		}
+		runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(_uniformHandles[i]), values.x, values.y, values.z, values.w);
+		frameStatistics.uniformWrites++;
+	}
+	for(size_t i = 0; i < _techniquesToEnable.size(); i++)
+	{
+		if(!cache.updateTechniqueState(_techniqueToEnableSlots[i], true))
+		{
+			frameStatistics.techniqueWritesSkipped++;
+			continue;
+		}
+		runtime->set_technique_state(reshade::api::effect_technique(_techniquesToEnable[i]), true);
+		frameStatistics.techniqueWrites++;
+	}
+	for(size_t i = 0; i < _techniquesToDisable.size(); i++)
+	{
+		if(!cache.updateTechniqueState(_techniqueToDisableSlots[i], false))
+		{
+			frameStatistics.techniqueWritesSkipped++;
+			continue;
+		}
+		runtime->set_technique_state(reshade::api::effect_technique(_techniquesToDisable[i]), false);
+		frameStatistics.techniqueWrites++;
+	}
+	cache.recordFrame(frameStatistics);
+}
+
+
+void InterpolationPlan::bindToCache(RuntimeStateCache& cache)
+{
+	_uniformSlots.resize(_uniformHandles.size());
+	for(size_t i = 0; i < _uniformHandles.size(); i++)
+	{
+		_uniformSlots[i] = cache.getUniformSlot(_uniformHandles[i]);
+	}
+	_techniqueToEnableSlots.resize(_techniquesToEnable.size());
+	for(size_t i = 0; i < _techniquesToEnable.size(); i++)
+	{
+		_techniqueToEnableSlots[i] = cache.getTechniqueSlot(_techniquesToEnable[i]);
+	}
+	_techniqueToDisableSlots.resize(_techniquesToDisable.size());
+	for(size_t i = 0; i < _techniquesToDisable.size(); i++)
+	{
+		_techniqueToDisableSlots[i] = cache.getTechniqueSlot(_techniquesToDisable[i]);
+	}
+	_boundCache = &cache;
+	_boundCacheGeneration = cache.getGeneration();
+}
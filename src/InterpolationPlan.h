@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <reshade.hpp>
+#include <vector>
+#include "ConstantsEnums.h"
+#include "ReshadeStateSnapshot.h"
+#include "RuntimeStateCache.h"
+
+/// <summary>
+/// The interpolation between two snapshots of a path segment, compiled to flat arrays: per float uniform present in both snapshots its handle and the
+/// coefficients of the polynomial over the segment, and the techniques to enable and disable. Matching the snapshots and calculating the coefficients is
+/// done once in compile, so applying the plan every frame during path playback is a Horner evaluation over the coefficient arrays followed by the runtime
+/// calls, without lookups or allocations.
+/// </summary>
+class InterpolationPlan
+{
+public:
+	InterpolationPlan() = default;
+	~InterpolationPlan() = default;
+
+	/// <summary>
+	/// Compiles the plan for the segment fromState - toState. previousState and nextState are the snapshots before fromState and after toState, used
+	/// by the cubic modes for the tangents at the nodes. They can be nullptr at the ends of the path, and are ignored by the linear mode.
+	/// </summary>
+	void compile(const ReshadeStateSnapshot* previousState, const ReshadeStateSnapshot& fromState, const ReshadeStateSnapshot& toState, const ReshadeStateSnapshot* nextState,
+				 StateInterpolationMode mode);
+	void clear();
+	/// <summary>
+	/// Calculates the values of the uniforms for the interpolation factor specified. The result is returned by getInterpolatedValues.
+	/// </summary>
+	void evaluate(float interpolationFactor);
+	/// <summary>
+	/// Evaluates the plan for the interpolation factor specified and sets the resulting uniform values and technique states in the runtime specified.
+	/// Values and states equal to what cache says was last written to the runtime aren't written again. cache has to be the cache of runtime.
+	/// </summary>
+	void apply(reshade::api::effect_runtime* runtime, float interpolationFactor, RuntimeStateCache& cache);
+	/// <summary>
+	/// Releases the buffers only used during compile and the unused capacity of the others. For plans which are kept after compiling, like the ones of a PathTimeline.
+	/// </summary>
+	void shrinkToFit();
+	/// <summary>
+	/// Returns the number of bytes used by this plan, including the heap memory of its arrays.
+	/// </summary>
+	size_t calculateMemoryUsage() const;
+
+	const std::vector<uint64_t>& getUniformHandles() const { return _uniformHandles; }
+	const std::vector<DirectX::XMFLOAT4A>& getInterpolatedValues() const { return _interpolatedValues; }
+
+private:
+	/// <summary>
+	/// Maps the handles of the plan to their slots in the cache specified.
+	/// </summary>
+	void bindToCache(RuntimeStateCache& cache);
+
+	bool _isCubic = false;
+	std::vector<uint64_t> _uniformHandles;
+	// value(t) = constant + (linear * t) + (quadratic * t^2) + (cubic * t^3), per uniform. The quadratic and cubic terms are empty if the plan is linear.
+	std::vector<DirectX::XMFLOAT4A> _constantTerms;
+	std::vector<DirectX::XMFLOAT4A> _linearTerms;
+	std::vector<DirectX::XMFLOAT4A> _quadraticTerms;
+	std::vector<DirectX::XMFLOAT4A> _cubicTerms;
+	std::vector<DirectX::XMFLOAT4A> _interpolatedValues;
+	std::vector<uint64_t> _techniquesToEnable;
+	std::vector<uint64_t> _techniquesToDisable;
+	// slots in the cache the plan was last applied with, parallel with the handles above.
+	std::vector<uint32_t> _uniformSlots;
+	std::vector<uint32_t> _techniqueToEnableSlots;
+	std::vector<uint32_t> _techniqueToDisableSlots;
+	const RuntimeStateCache* _boundCache = nullptr;
+	uint32_t _boundCacheGeneration = 0;
+
+	// only used during compile, kept to reuse their capacity.
+	std::vector<uint64_t> _uniformKeys;
+	std::vector<DirectX::XMFLOAT4A> _fromValues;
+	std::vector<DirectX::XMFLOAT4A> _toValues;
+	std::vector<DirectX::XMFLOAT4A> _previousValues;
+	std::vector<DirectX::XMFLOAT4A> _nextValues;
+};
@@ -48,12 +48,20 @@
 #include "CameraToolsData.h"
 #include "CDataFile.h"
 #include "DepthOfFieldController.h"
+#ifdef _DEBUG
+#include "EncoderBenchmark.h"
+#endif
 #include "ScreenshotController.h"
 #include "ScreenshotSettings.h"
+#include "EffectStatePool.h"
+#include "NameTable.h"
 #include "OverlayControl.h"
+#include "ReshadeStateBenchmark.h"
+#include "ReshadeStateStressTest.h"
 #include "ReshadeStateController.h"
-#include "ThreadSafeQueue.h"
+#include "CoalescingWorkQueue.h"
 #include "WorkItem.h"
+#include "WorkQueueBenchmark.h"
 
 using namespace reshade::api;
 using namespace std::chrono;
@@ -74,9 +82,13 @@ extern "C" __declspec(dllexport) void removeCameraPath(int pathIndex);
 extern "C" __declspec(dllexport) void removeStateSnapshotFromPath(int pathIndex, int stateIndex);
 extern "C" __declspec(dllexport) void setReshadeStateInterpolated(int pathIndex, int fromStateIndex, int toStateIndex, float interpolationFactor);
 extern "C" __declspec(dllexport) void setReshadeState(int pathIndex, int stateIndex);
+extern "C" __declspec(dllexport) bool startReshadeStateTimeline(int pathIndex, const float* segmentDurations, int numberOfSegments);
+extern "C" __declspec(dllexport) void stopReshadeStateTimeline();
 extern "C" __declspec(dllexport) void updateStateSnapshotOnPath(int pathIndex, int stateIndex);
 
 #define SETTINGS_FILE_NAME "IgcsConnector.ini"
+#define CAMERA_PATHS_FILE_NAME "IgcsConnectorPaths.bin"
+#define PRESENT_WORK_QUEUE_CAPACITY 1024
 #define MULTI_VIEW_KEY VK_F6 // Define the key for starting multi-view screenshots
 
 static LPBYTE g_dataFromCameraToolsBuffer = nullptr;		// 8192 bytes buffer
@@ -85,7 +97,13 @@ static ScreenshotSettings g_screenshotSettings;
 static ScreenshotController g_screenshotController(g_cameraToolsConnector);
 static DepthOfFieldController g_depthOfFieldController(g_cameraToolsConnector);
 static ReshadeStateController g_reshadeStateController;
-static IGCS::ThreadSafeQueue<WorkItem> g_presentWorkQueue;
+#ifdef _DEBUG
+static EncoderBenchmark g_encoderBenchmark;
+#endif
+static ReshadeStateBenchmark g_reshadeStateBenchmark;
+static WorkQueueBenchmark g_workQueueBenchmark;
+static ReshadeStateStressTest g_reshadeStateStressTest;
+static CoalescingWorkQueue g_presentWorkQueue(PRESENT_WORK_QUEUE_CAPACITY);
 static bool g_recordReshadeState = true;
 static bool g_multiViewActive = false;  // Flag to check if multi-view is active
 static high_resolution_clock::time_point g_lastScreenshotTime; // Last screenshot time
@@ -242,11 +260,11 @@ void setReshadeStateInterpolated(int pathIndex, int fromStateIndex, int toStateI
 		return;
 	}
 
-	// done deferred
+	// done deferred. Supersedes the states requested before it which haven't been set yet.
 	g_presentWorkQueue.push({ [pathIndex, fromStateIndex, toStateIndex, interpolationFactor](effect_runtime* lambdaRuntime)
 	{
 		g_reshadeStateController.setReshadeState(pathIndex, fromStateIndex, toStateIndex, interpolationFactor, lambdaRuntime);
-	} });
+	}, WorkItemCoalescingKey::ReshadeState });
 }
 
 
@@ -262,24 +280,45 @@ void setReshadeState(int pathIndex, int stateIndex)
 		return;
 	}
 
-	// done deferred
-	g_presentWorkQueue.push({ [pathIndex, stateIndex](effect_runtime* lambdaRuntime) {g_reshadeStateController.setReshadeState(pathIndex, stateIndex, lambdaRuntime); } });
+	// done deferred. Supersedes the states requested before it which haven't been set yet.
+	g_presentWorkQueue.push({ [pathIndex, stateIndex](effect_runtime* lambdaRuntime) {g_reshadeStateController.setReshadeState(pathIndex, stateIndex, lambdaRuntime); },
+							  WorkItemCoalescingKey::ReshadeState });
 }
 
 
-
-void handleWorkQueue(effect_runtime* runtime)
+/// <summary>
+/// Starts playing back the reshade states of the path with index pathIndex by time, for when the timing of the camera path is known up front. Call this
+/// instead of setReshadeStateInterpolated every frame. The addon bakes the path once and applies the state for the time elapsed since the next present
+/// itself every frame. The timeline stops after its end has been reached.
+/// </summary>
+/// <param name="pathIndex"></param>
+/// <param name="segmentDurations">the duration in seconds of each segment of the path: segment i is between state i and state i+1</param>
+/// <param name="numberOfSegments">the number of elements in segmentDurations, which has to be the number of states on the path minus 1</param>
+/// <returns>true if the timeline was started, false if the path doesn't exist or the durations don't match its segments</returns>
+bool startReshadeStateTimeline(int pathIndex, const float* segmentDurations, int numberOfSegments)
 {
-	for(;;)
+	if(!g_recordReshadeState || nullptr == segmentDurations || numberOfSegments <= 0)
 	{
-		auto topElement = g_presentWorkQueue.pop();
-		if(!topElement.has_value())
-		{
-			break;
-		}
-		auto workItem = topElement.value();
-		workItem.perform(runtime);
+		return false;
 	}
+	return g_reshadeStateController.startTimelinePlayback(pathIndex, std::vector<float>(segmentDurations, segmentDurations + numberOfSegments));
+}
+
+
+/// <summary>
+/// Stops the timeline started with startReshadeStateTimeline. The reshade state is left as it is.
+/// </summary>
+void stopReshadeStateTimeline()
+{
+	g_reshadeStateController.stopTimelinePlayback();
+}
+
+
+
+void handleWorkQueue(effect_runtime* runtime)
+{
+	// one batch, without locks. Of the states requested since the previous present only the last one is set.
+	g_presentWorkQueue.performPendingWork(runtime);
 }
 
 void handleMultiViewScreenshot()
@@ -311,6 +350,10 @@ static void onReshadePresent(effect_runtime* runtime)
 	g_screenshotController.presentCalled();
 	handleMultiViewScreenshot(); // Add this line to handle multi-view screenshot
 	handleWorkQueue(runtime);
+	g_reshadeStateController.applyTimeline(runtime);
+#ifdef _DEBUG
+	g_reshadeStateStressTest.presentCalled(runtime);
+#endif
 }
 
 
@@ -325,6 +368,29 @@ static void onReshadeOverlay(effect_runtime* runtime)
 }
 
 
+static void renderCompositorStatus()
+{
+	DepthOfFieldCompositor& compositor = g_depthOfFieldController.getCompositor();
+	if(compositor.isRunning())
+	{
+		ImGui::Text("Compositing the captured frames...");
+		ImGui::ProgressBar(compositor.getProgress(), ImVec2(0.f, 0.f));
+		return;
+	}
+	const std::string lastError = compositor.getLastError();
+	if(!lastError.empty())
+	{
+		ImGui::TextWrapped("Compositing failed: %s", lastError.c_str());
+		return;
+	}
+	const std::string resultFilename = compositor.getResultFilename();
+	if(!resultFilename.empty())
+	{
+		ImGui::TextWrapped("Result written to '%s'.", resultFilename.c_str());
+	}
+}
+
+
 static void showHelpMarker(const char* desc)
 {
 	ImGui::TextDisabled("(?)");
@@ -369,6 +435,10 @@ void loadGeneralSettingsFromIniFile(CDataFile& iniFile)
 	{
 		g_recordReshadeState = iniFile.GetBool("RecordReshadeState", "General");
 	}
+	if(iniFile.GetValue("StateInterpolationMode", "General").length() > 0)
+	{
+		g_reshadeStateController.setStateInterpolationMode((StateInterpolationMode)iniFile.GetInt("StateInterpolationMode", "General"));
+	}
 
 	// more settings here
 }
@@ -377,6 +447,7 @@ void loadGeneralSettingsFromIniFile(CDataFile& iniFile)
 void saveGeneralSettingsToIniFile(CDataFile& iniFile)
 {
 	iniFile.SetBool("RecordReshadeState", g_recordReshadeState, "", "General");
+	iniFile.SetInt("StateInterpolationMode", (int)g_reshadeStateController.getStateInterpolationMode(), "", "General");
 
 	// more settings here
 }
@@ -480,7 +551,7 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 #else
 						ImGui::Combo("Multi-screenshot type", &g_screenshotSettings.typeOfScreenshot, "Horizontal panorama\0Lightfield\0\0");
 #endif
-						ImGui::Combo("File type", &g_screenshotSettings.screenshotFileType, "Bmp\0Jpeg\0Png\0\0");
+						ImGui::Combo("File type", &g_screenshotSettings.screenshotFileType, "Bmp\0Jpeg\0Png\0Tga\0Ppm\0\0");
 						switch(g_screenshotSettings.typeOfScreenshot)
 						{
 							case (int)ScreenshotType::HorizontalPanorama:
@@ -513,6 +584,24 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 						{
 							ImGui::Text("Camera disabled so no screenshot session can be started");
 						}
+#ifdef _DEBUG
+						if(ImGui::TreeNode("Encoder benchmark"))
+						{
+							if(g_encoderBenchmark.isRunning())
+							{
+								ImGui::Text("Encoder benchmark is running...");
+							}
+							else
+							{
+								ImGui::TextWrapped("Encodes synthetic frames with all file types at 1080p up to 8K and writes the timings to a json file in the screenshot output directory. Takes a while.");
+								if(ImGui::Button("Run encoder benchmark"))
+								{
+									g_encoderBenchmark.start(g_screenshotSettings.screenshotFolder);
+								}
+							}
+							ImGui::TreePop();
+						}
+#endif
 					}
 					break;
 				case ScreenshotControllerState::InSession:
@@ -657,7 +746,7 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 
 							ImGui::SeparatorText("Bokeh setup");
 							int blurType = (int)g_depthOfFieldController.getBlurType();
-							changed = ImGui::Combo("Blur type", &blurType, "Aperture shaped\0Circular\0\0");
+							changed = ImGui::Combo("Blur type", &blurType, "Aperture shaped\0Circular\0Aperture mask\0\0");
 							if(changed)
 							{
 								g_depthOfFieldController.setBlurType((DepthOfFieldBlurType)blurType);
@@ -695,6 +784,29 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 										}
 									}
 									break;
+								case DepthOfFieldBlurType::ApertureMask:
+									{
+										static char apertureMaskFilename[_MAX_PATH + 1] = "";
+										if(0 == apertureMaskFilename[0])
+										{
+											strncpy_s(apertureMaskFilename, g_depthOfFieldController.getApertureMaskFilename().c_str(), _TRUNCATE);
+										}
+										ImGui::InputText("Aperture mask file", apertureMaskFilename, _MAX_PATH);
+										if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+										{
+											ImGui::SetTooltip("A grayscale binary PGM or PPM image with the shape of the aperture.\nWhite lets all light through, black none.\nThe mask is reloaded when the file changes.");
+										}
+										if(ImGui::Button("Load mask"))
+										{
+											g_depthOfFieldController.setApertureMaskFilename(apertureMaskFilename);
+										}
+										const std::string& apertureMaskError = g_depthOfFieldController.getApertureMaskError();
+										if(!apertureMaskError.empty())
+										{
+											ImGui::TextWrapped("%s", apertureMaskError.c_str());
+										}
+									}
+									break;
 							}
 							float ringAngleOffset = g_depthOfFieldController.getRingAngleOffset();
 							changed = ImGui::DragFloat("Ring angle offset", &ringAngleOffset, 0.001f, -0.015f, 0.015f);
@@ -817,7 +929,11 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 							}
 
 							int renderOrder = (int)g_depthOfFieldController.getRenderOrder();
-							changed = ImGui::Combo("Render order", &renderOrder, "Inner to outer ring\0Outer to inner ring\0Random\0\0");
+							changed = ImGui::Combo("Render order", &renderOrder, "Inner to outer ring\0Outer to inner ring\0Random\0Progressive\0\0");
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("Progressive spreads the samples evenly over the whole render, so you can stop\nthe render early and keep a complete, slightly noisier result.");
+							}
 							if(changed)
 							{
 								g_depthOfFieldController.setRenderOrder((DepthOfFieldRenderOrder)renderOrder);
@@ -836,7 +952,73 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 								g_depthOfFieldController.setHighlightGammaFactor(highlightGammaFactor);
 							}
 
+							bool mergeNegligibleSamples = g_depthOfFieldController.getMergeNegligibleSamples();
+							changed = ImGui::Checkbox("Merge negligible samples", &mergeNegligibleSamples);
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("If checked, samples with a very low weight (e.g. due to spherical aberration or fringe)\nare merged into their nearest neighbour, as long as the shape and size of the bokeh\nstay within the tolerance. This saves camera steps and thus render time.");
+							}
+							if(changed)
+							{
+								g_depthOfFieldController.setMergeNegligibleSamples(mergeNegligibleSamples);
+							}
+							if(mergeNegligibleSamples)
+							{
+								float sampleMergeTolerance = g_depthOfFieldController.getSampleMergeTolerance() * 100.0f;
+								changed = ImGui::DragFloat("Merge tolerance (%)", &sampleMergeTolerance, 0.01f, 0.0f, 10.0f, "%.2f");
+								if(changed)
+								{
+									g_depthOfFieldController.setSampleMergeTolerance(sampleMergeTolerance / 100.0f);
+								}
+								ImGui::Text("Steps saved: %d (about %.1f seconds)", g_depthOfFieldController.getNumberOfMergedSamples(), g_depthOfFieldController.getEstimatedSecondsSavedByMerging());
+								if(ImGui::TreeNode("Savings per quality level"))
+								{
+									if(ImGui::Button("Calculate"))
+									{
+										g_depthOfFieldController.calculateSampleReductionReport();
+									}
+									for(const auto& line : g_depthOfFieldController.getSampleReductionReport())
+									{
+										ImGui::Text("Quality %d: %d of %d steps saved (about %.1f seconds)", line.Quality, line.NumberOfStepsSaved, line.NumberOfSteps, line.SecondsSaved);
+									}
+									ImGui::TreePop();
+								}
+							}
+
 							// show the shape canvas
+							ImGui::Text("Estimated render time: %s", DepthOfFieldRenderTelemetry::formatDuration(g_depthOfFieldController.getEstimatedRenderSeconds(g_depthOfFieldController.getTotalNumberOfStepsToTake())).c_str());
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("Based on the frame time measured during the last render,\nor on the current framerate if nothing has been rendered yet.");
+							}
+							if(ImGui::TreeNode("Time budget"))
+							{
+								float timeBudgetSeconds = g_depthOfFieldController.getTimeBudgetSeconds();
+								changed = ImGui::DragFloat("Time budget (seconds)", &timeBudgetSeconds, 1.0f, 1.0f, 36000.0f, "%.0f");
+								if(changed)
+								{
+									g_depthOfFieldController.setTimeBudgetSeconds(timeBudgetSeconds);
+								}
+								if(ImGui::Button("Find highest quality"))
+								{
+									g_depthOfFieldController.calculateHighestQualityForTimeBudget();
+								}
+								const int qualityForTimeBudget = g_depthOfFieldController.getQualityForTimeBudget();
+								if(0 == qualityForTimeBudget)
+								{
+									ImGui::Text("Even the lowest quality doesn't fit in the time budget.");
+								}
+								else if(qualityForTimeBudget > 0)
+								{
+									ImGui::Text("Highest quality within the time budget: %d", qualityForTimeBudget);
+									ImGui::SameLine();
+									if(ImGui::Button("Use"))
+									{
+										g_depthOfFieldController.setQuality(qualityForTimeBudget);
+									}
+								}
+								ImGui::TreePop();
+							}
 							ImGui::Text("Blur shape. Number of shots to take: %d", g_depthOfFieldController.getTotalNumberOfStepsToTake());
 							ImGui::InvisibleButton("canvas", ImVec2(250.0f, 250.0f), ImGuiButtonFlags_None);
 							const ImVec2 topLeftCoords = ImGui::GetItemRectMin();
@@ -847,6 +1029,66 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 							g_depthOfFieldController.drawShape(drawList, topLeftCoords, 250.0f);
 
 							ImGui::Separator();
+							int renderMode = (int)g_depthOfFieldController.getRenderMode();
+							changed = ImGui::Combo("Render mode", &renderMode, "Live\0Offline (capture frames)\0\0");
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("Live blends the frames on the gpu while rendering.\n\nOffline captures every frame to the screenshot output directory and composites\nthe result on the cpu afterwards, in full float precision. The capture folder can be\ncomposited again later, also on another machine.");
+							}
+							if(changed)
+							{
+								g_depthOfFieldController.setRenderMode((DepthOfFieldRenderMode)renderMode);
+							}
+							if(DepthOfFieldRenderMode::Offline == (DepthOfFieldRenderMode)renderMode)
+							{
+								int offlineOutputType = (int)g_depthOfFieldController.getOfflineOutputType();
+								changed = ImGui::Combo("Offline output type", &offlineOutputType, "Png (8 bit)\0Exr (32 bit float)\0\0");
+								if(changed)
+								{
+									g_depthOfFieldController.setOfflineOutputType((DepthOfFieldOfflineOutputType)offlineOutputType);
+								}
+								if(ImGui::TreeNode("Focus bracketing"))
+								{
+									ImGui::TextWrapped("Every focus delta added here is composited from the same captured frames, next to the result for the focus delta set above.");
+									const std::vector<float> bracketFocusDeltas = g_depthOfFieldController.getBracketFocusDeltas();
+									for(int i = 0; i < (int)bracketFocusDeltas.size(); i++)
+									{
+										ImGui::PushID(i);
+										float bracketFocusDelta = bracketFocusDeltas[i];
+										if(ImGui::DragFloat("##bracketFocusDelta", &bracketFocusDelta, 0.00005f, -1.0f, 1.0f, "%.5f"))
+										{
+											g_depthOfFieldController.setBracketFocusDelta(i, bracketFocusDelta);
+										}
+										ImGui::SameLine();
+										if(ImGui::Button("Remove"))
+										{
+											g_depthOfFieldController.removeBracketFocusDelta(i);
+										}
+										ImGui::PopID();
+									}
+									if(ImGui::Button("Add current focus delta"))
+									{
+										g_depthOfFieldController.addBracketFocusDelta(g_depthOfFieldController.getXFocusDelta());
+									}
+									if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+									{
+										ImGui::SetTooltip("Adds the focus delta set above as a bracket. Change the focus delta afterwards\nto the one you want for the regular result.");
+									}
+									ImGui::TreePop();
+								}
+								if(ImGui::TreeNode("Composite an earlier capture"))
+								{
+									static char captureFolder[256] = "";
+									ImGui::InputText("Capture folder", captureFolder, 256);
+									const bool compositorIsRunning = g_depthOfFieldController.getCompositor().isRunning();
+									if(!compositorIsRunning && ImGui::Button("Composite"))
+									{
+										g_depthOfFieldController.composeOfflineCapture(captureFolder);
+									}
+									renderCompositorStatus();
+									ImGui::TreePop();
+								}
+							}
 							bool showProgressBarAsOverlay = g_depthOfFieldController.getShowProgressBarAsOverlay();
 							changed = ImGui::Checkbox("Show progress bar as overlay", &showProgressBarAsOverlay);
 							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
@@ -859,6 +1101,7 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 							}
 							if(ImGui::Button("Start render"))
 							{
+								g_depthOfFieldController.setOfflineRootFolder(g_screenshotSettings.screenshotFolder);
 								g_depthOfFieldController.startRender(runtime);
 							}
 							ImGui::SameLine();
@@ -869,6 +1112,8 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 #if _DEBUG
 							if(ImGui::CollapsingHeader("Debug"))
 							{
+								ImGui::Text("Uniform writes last frame: %d of %d", g_depthOfFieldController.getNumberOfUniformWritesLastFrame(), 
+											g_depthOfFieldController.getNumberOfUniformWriteRequestsLastFrame());
 								float debugVal1 = g_depthOfFieldController.getDebugVal1();
 								changed = ImGui::DragFloat("Debug val1", &debugVal1, 0.001f, -2.0f, 2.0f, "%.3f");
 								if(changed)
@@ -910,6 +1155,11 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 							g_depthOfFieldController.renderProgressBar();
 						}
 
+						if(g_depthOfFieldController.isWritingOfflineFrames())
+						{
+							ImGui::Text("Writing captured frames to disk (%d written), please wait...", g_depthOfFieldController.getNumberOfOfflineFramesWritten());
+							break;
+						}
 						const bool isPaused = g_depthOfFieldController.getRenderPaused();
 						if(isPaused)
 						{
@@ -932,11 +1182,32 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 						{
 							g_depthOfFieldController.endSession(runtime);
 						}
+						if(DepthOfFieldRenderOrder::Progressive == g_depthOfFieldController.getRenderOrder() && !g_depthOfFieldController.getStopAtCheckpointRequested())
+						{
+							ImGui::SameLine();
+							if(ImGui::Button("Stop now and keep result"))
+							{
+								g_depthOfFieldController.stopRenderAtNextCheckpoint();
+							}
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("Renders up to the next checkpoint and then stops, keeping the result rendered so far.");
+							}
+						}
 					}
 					break;
 				case DepthOfFieldControllerState::Done:
-					ImGui::Text("Done. You can now take a screenshot.\n\n");
-					ImGui::Text("Click 'End session' to end this session.\nThis will remove the rendering result.");
+					if(DepthOfFieldRenderMode::Offline == g_depthOfFieldController.getRenderMode())
+					{
+						ImGui::TextWrapped("Done capturing. The frames are in '%s'.", g_depthOfFieldController.getOfflineCaptureFolder().c_str());
+						renderCompositorStatus();
+						ImGui::Text("Click 'End session' to end this session.");
+					}
+					else
+					{
+						ImGui::Text("Done. You can now take a screenshot.\n\n");
+						ImGui::Text("Click 'End session' to end this session.\nThis will remove the rendering result.");
+					}
 					if(ImGui::Button("End session"))
 					{
 						g_depthOfFieldController.endSession(runtime);
@@ -1012,6 +1283,15 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 		else
 		{
 			ImGui::Checkbox("Record ReShade state with camera nodes", &g_recordReshadeState);
+			int stateInterpolationMode = (int)g_reshadeStateController.getStateInterpolationMode();
+			if(ImGui::Combo("ReShade state interpolation", &stateInterpolationMode, "Linear\0Catmull-Rom\0Monotone cubic (no overshoot)\0\0"))
+			{
+				g_reshadeStateController.setStateInterpolationMode((StateInterpolationMode)stateInterpolationMode);
+			}
+			if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+			{
+				ImGui::SetTooltip("How effect values are interpolated between the ReShade states of the camera nodes. The cubic modes are smooth across the nodes,\nCatmull-Rom can overshoot the values of the nodes.");
+			}
 			ImGui::Text("Number of saved ReShade states per path:");
 
 			const auto numberOfPaths = g_reshadeStateController.numberOfPaths();
@@ -1024,9 +1304,124 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 				for (int i = 0; i < numberOfPaths; i++)
 				{
 					// path no's are starting at 0 but for display purposes we start at 1.
-					ImGui::Text("Path: %d. # of saved Reshade states: %d.", (i + 1), g_reshadeStateController.numberOfSnapshotsOnPath(i));
+					ImGui::Text("Path: %d. # of saved Reshade states: %d. Memory used: %.1f KB", (i + 1), g_reshadeStateController.numberOfSnapshotsOnPath(i),
+								(float)g_reshadeStateController.calculateMemoryUsageOfPath(i) / 1024.0f);
 				}
 			}
+			NameTable& nameTable = NameTable::instance();
+			ImGui::Text("Names of effects, techniques and uniforms: %u. Memory used: %.1f KB", nameTable.getNumberOfNames(), (float)nameTable.calculateMemoryUsage() / 1024.0f);
+			EffectStatePool& effectStatePool = EffectStatePool::instance();
+			ImGui::Text("Unique effect states of all paths: %u, shared %llu times. Memory used: %.1f KB", effectStatePool.getNumberOfEffectStates(),
+						(unsigned long long)effectStatePool.getNumberOfSharedInterns(), (float)effectStatePool.calculateMemoryUsage() / 1024.0f);
+			RuntimeCallStatistics lastFrameCallStatistics;
+			RuntimeCallStatistics totalCallStatistics;
+			g_reshadeStateController.getRuntimeCallStatistics(lastFrameCallStatistics, totalCallStatistics);
+			ImGui::Text("Uniform writes last frame: %llu, skipped: %llu. Technique writes: %llu, skipped: %llu", (unsigned long long)lastFrameCallStatistics.uniformWrites,
+						(unsigned long long)lastFrameCallStatistics.uniformWritesSkipped, (unsigned long long)lastFrameCallStatistics.techniqueWrites,
+						(unsigned long long)lastFrameCallStatistics.techniqueWritesSkipped);
+			ImGui::Text("Runtime calls saved during path playback: %llu", (unsigned long long)totalCallStatistics.callsSaved());
+			if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+			{
+				ImGui::SetTooltip("Values which didn't change since the previous frame aren't written to ReShade again.");
+			}
+			const WorkQueueStatistics workQueueStatistics = g_presentWorkQueue.getStatistics();
+			ImGui::Text("Work queue depth: %llu, max per present: %llu. Requests performed: %llu, coalesced: %llu, overflowed: %llu",
+						(unsigned long long)workQueueStatistics.itemsPending, (unsigned long long)workQueueStatistics.maxItemsPerPresent,
+						(unsigned long long)workQueueStatistics.itemsPerformed, (unsigned long long)workQueueStatistics.itemsCoalesced,
+						(unsigned long long)workQueueStatistics.itemsOverflowed);
+			if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+			{
+				ImGui::SetTooltip("Of the ReShade states requested by the camera tools between two presents, only the last one is set.\nEdits are kept in an overflow list when the queue is full because there were no presents for a while.");
+			}
+			double timelineElapsedSeconds = 0.0;
+			double timelineDurationSeconds = 0.0;
+			size_t timelineMemoryUsage = 0;
+			if(g_reshadeStateController.getTimelineProgress(timelineElapsedSeconds, timelineDurationSeconds, timelineMemoryUsage))
+			{
+				ImGui::Text("Playing timeline: %.1f of %.1f seconds. Memory used: %.1f KB", timelineElapsedSeconds, timelineDurationSeconds, (float)timelineMemoryUsage / 1024.0f);
+				ImGui::SameLine();
+				if(ImGui::Button("Stop timeline"))
+				{
+					g_reshadeStateController.stopTimelinePlayback();
+				}
+			}
+			if(ImGui::Button("Save ReShade states of paths"))
+			{
+				if(g_reshadeStateController.savePaths(CAMERA_PATHS_FILE_NAME))
+				{
+					OverlayControl::addNotification("ReShade states of the camera paths saved to " CAMERA_PATHS_FILE_NAME);
+				}
+				else
+				{
+					OverlayControl::addNotification("Saving the ReShade states of the camera paths failed. Please check the ReShade log.");
+				}
+			}
+			ImGui::SameLine();
+			if(ImGui::Button("Load ReShade states of paths"))
+			{
+				if(g_reshadeStateController.loadPaths(CAMERA_PATHS_FILE_NAME))
+				{
+					OverlayControl::addNotification("ReShade states of the camera paths loaded from " CAMERA_PATHS_FILE_NAME);
+				}
+				else
+				{
+					OverlayControl::addNotification("Loading the ReShade states of the camera paths failed. Please check the ReShade log.");
+				}
+			}
+			if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+			{
+				ImGui::SetTooltip("Replaces the ReShade states of all paths with the ones last saved. The paths in the camera tools have to match.");
+			}
+#ifdef _DEBUG
+			if(ImGui::TreeNode("Reshade state benchmark"))
+			{
+				if(g_reshadeStateBenchmark.isRunning())
+				{
+					ImGui::Text("Reshade state benchmark is running...");
+				}
+				else
+				{
+					ImGui::TextWrapped("Measures the memory per snapshot and the interpolation time for 100 effects with 50 uniforms each, and writes the results to a json file in the screenshot output directory.");
+					if(ImGui::Button("Run reshade state benchmark"))
+					{
+						g_reshadeStateBenchmark.start(g_screenshotSettings.screenshotFolder);
+					}
+				}
+				ImGui::TreePop();
+			}
+			if(ImGui::TreeNode("Work queue benchmark"))
+			{
+				if(g_workQueueBenchmark.isRunning())
+				{
+					ImGui::Text("Work queue benchmark is running...");
+				}
+				else
+				{
+					ImGui::TextWrapped("Measures the throughput and latency of the present work queue against the mutex based queue it replaced, with 1 to 8 producer threads, and writes the results to a json file in the screenshot output directory.");
+					if(ImGui::Button("Run work queue benchmark"))
+					{
+						g_workQueueBenchmark.start(g_screenshotSettings.screenshotFolder);
+					}
+				}
+				ImGui::TreePop();
+			}
+			if(ImGui::TreeNode("Reshade state stress test"))
+			{
+				if(g_reshadeStateStressTest.isRunning())
+				{
+					ImGui::Text("Reshade state stress test is running...");
+				}
+				else
+				{
+					ImGui::TextWrapped("Plays back paths recorded from the current ReShade state every frame while other threads edit, save and load them for 10 seconds. Checks the paths stay consistent, and writes the playback times to a json file in the screenshot output directory.");
+					if(ImGui::Button("Run reshade state stress test"))
+					{
+						g_reshadeStateStressTest.start(g_screenshotSettings.screenshotFolder);
+					}
+				}
+				ImGui::TreePop();
+			}
+#endif
 		}
 	}
 }
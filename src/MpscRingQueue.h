@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace IGCS
+{
+	/// <summary>
+	/// Bounded lock-free queue for multiple producers and a single consumer, after Dmitry Vyukov's bounded MPMC queue. Every cell has a sequence number
+	/// which tells producers and the consumer whose turn it is: producers claim a cell by advancing the enqueue position with a CAS, and the consumer,
+	/// being the only one, advances the dequeue position without one. Items are moved in and out, so T can be move-only.
+	/// </summary>
+	/// <typeparam name="T"></typeparam>
+	template<typename T>
+	class MpscRingQueue
+	{
+	public:
+		/// <summary>
+		/// Creates the queue with room for capacity items, rounded up to a power of 2.
+		/// </summary>
+		explicit MpscRingQueue(size_t capacity)
+		{
+			size_t roundedCapacity = 2;
+			while(roundedCapacity < capacity)
+			{
+				roundedCapacity *= 2;
+			}
+			_mask = roundedCapacity - 1;
+			_cells = std::make_unique<Cell[]>(roundedCapacity);
+			for(size_t i = 0; i < roundedCapacity; i++)
+			{
+				_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		~MpscRingQueue()
+		{
+			drain([](T&&) {});
+		}
+
+		MpscRingQueue(const MpscRingQueue&) = delete;
+		MpscRingQueue& operator=(const MpscRingQueue&) = delete;
+
+		/// <summary>
+		/// Moves item into the queue. Returns false if the queue is full, item is then left untouched.
+		/// </summary>
+		bool tryPush(T&& item)
+		{
+			Cell* cell = nullptr;
+			size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				cell = &_cells[position & _mask];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+				if(0 == difference)
+				{
+					// the cell is free for this position, claim it
+					if(_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if(difference < 0)
+				{
+					// the cell still holds the item of the previous round: full
+					return false;
+				}
+				else
+				{
+					// another producer claimed this position
+					position = _enqueuePosition.load(std::memory_order_relaxed);
+				}
+			}
+			new(cell->storage) T(std::move(item));
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// <summary>
+		/// Moves item into the queue, yielding while it's full, which is forever if the consumer stops draining. Only for producers which can afford that,
+		/// never for the consumer thread, as it would wait for itself.
+		/// </summary>
+		void push(T&& item)
+		{
+			while(!tryPush(std::move(item)))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		/// <summary>
+		/// Passes the items in the queue to consumer, as T&&, in the order they were pushed, and returns the number of items passed. At most one queue full
+		/// is drained per call, so producers can't keep the consumer busy forever. Only to be called by the consumer thread.
+		/// </summary>
+		template<typename TConsumer>
+		size_t drain(TConsumer&& consumer)
+		{
+			size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+			size_t numberOfItemsDrained = 0;
+			for(; numberOfItemsDrained <= _mask; numberOfItemsDrained++)
+			{
+				Cell& cell = _cells[position & _mask];
+				if(cell.sequence.load(std::memory_order_acquire) != position + 1)
+				{
+					// empty, or the producer of the next item hasn't finished writing it yet. It's picked up by the next drain.
+					break;
+				}
+				T* item = std::launder(reinterpret_cast<T*>(cell.storage));
+				consumer(std::move(*item));
+				item->~T();
+				// free the cell for the position one round further
+				cell.sequence.store(position + _mask + 1, std::memory_order_release);
+				position++;
+				_dequeuePosition.store(position, std::memory_order_relaxed);
+			}
+			return numberOfItemsDrained;
+		}
+
+		/// <summary>
+		/// Returns the number of items in the queue. Only a snapshot when producers are pushing, but never more than the capacity.
+		/// </summary>
+		size_t size() const
+		{
+			const size_t dequeuePosition = _dequeuePosition.load(std::memory_order_relaxed);
+			const size_t enqueuePosition = _enqueuePosition.load(std::memory_order_relaxed);
+			return enqueuePosition > dequeuePosition ? std::min(enqueuePosition - dequeuePosition, capacity()) : 0;
+		}
+
+		size_t capacity() const { return _mask + 1; }
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		std::unique_ptr<Cell[]> _cells;
+		size_t _mask = 0;
+		// on their own cache lines, as producers hammer the first and the consumer the second.
+		alignas(64) std::atomic<size_t> _enqueuePosition = 0;
+		alignas(64) std::atomic<size_t> _dequeuePosition = 0;
+	};
+}
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "NameTable.h"
+#include "Utils.h"
+#include <mutex>
+
+namespace
+{
+	// std::string's small string buffer in the MS STL. Longer names are allocated on the heap.
+	constexpr size_t SMALL_STRING_CAPACITY = 15;
+}
+
+
+NameTable& NameTable::instance()
+{
+	static NameTable theInstance;
+	return theInstance;
+}
+
+
+NameTable::~NameTable()
+{
+	for(auto& chunk : _chunks)
+	{
+		delete[] chunk.load();
+	}
+}
+
+
+uint32_t NameTable::intern(std::string_view name)
+{
+	{
+		std::shared_lock lock(_mutex);
+		const auto it = _idPerName.find(name);
+		if(it != _idPerName.end())
+		{
+			return it->second;
+		}
+	}
+	std::unique_lock lock(_mutex);
+	// another thread might have added it in the meantime
+	const auto it = _idPerName.find(name);
+	if(it != _idPerName.end())
+	{
+		return it->second;
+	}
+	const uint32_t id = _numberOfNames.load(std::memory_order_relaxed);
+	const uint32_t chunkIndex = id / CHUNK_SIZE;
+	if(chunkIndex >= MAX_NUMBER_OF_CHUNKS)
+	{
+		// a million names, something is very wrong.
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "The name table is full, the name '%.*s' can't be added", (int)name.size(), name.data());
+		return INVALID_NAME_ID;
+	}
+	std::string* chunk = _chunks[chunkIndex].load(std::memory_order_relaxed);
+	if(nullptr == chunk)
+	{
+		chunk = new std::string[CHUNK_SIZE];
+		_chunks[chunkIndex].store(chunk, std::memory_order_release);
+	}
+	std::string& slot = chunk[id % CHUNK_SIZE];
+	slot = name;
+	if(slot.capacity() > SMALL_STRING_CAPACITY)
+	{
+		_numberOfNameBytesOnHeap += slot.capacity() + 1;
+	}
+	_idPerName.emplace(slot, id);
+	// only now the name is in place, readers can see it.
+	_numberOfNames.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+
+const std::string& NameTable::getName(uint32_t id) const
+{
+	static const std::string emptyName;
+	if(id >= _numberOfNames.load(std::memory_order_acquire))
+	{
+		return emptyName;
+	}
+	return _chunks[id / CHUNK_SIZE].load(std::memory_order_acquire)[id % CHUNK_SIZE];
+}
+
+
+size_t NameTable::calculateMemoryUsage() const
+{
+	std::shared_lock lock(_mutex);
+	const size_t numberOfChunks = (_numberOfNames.load(std::memory_order_relaxed) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	// the map: bucket array, plus per element a list node with two pointers and a copy of the name.
+	size_t mapSize = (_idPerName.bucket_count() * 2 * sizeof(void*)) + (_idPerName.size() * (sizeof(std::pair<const std::string, uint32_t>) + (2 * sizeof(void*))));
+	return sizeof(NameTable) + (numberOfChunks * CHUNK_SIZE * sizeof(std::string)) + (2 * _numberOfNameBytesOnHeap) + mapSize;
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// <summary>
+/// Process wide table which interns the names of effects, techniques and uniforms as small integer ids. The reshade state snapshots store these ids
+/// instead of the names, so they don't contain string copies and the state of two snapshots can be matched without hashing strings.
+/// The table is append only: ids are never reused or removed, so an id obtained once stays valid for the lifetime of the process. The names of newly
+/// loaded effects are added when the handles of the snapshots are migrated after a reload of the effects (see ReshadeStateController::migrateContainedHandles).
+/// Names are stored in fixed size chunks which never move, so getName doesn't need a lock.
+/// </summary>
+class NameTable
+{
+public:
+	/// <summary>
+	/// The id intern returns if the table is full. It's never the id of a name, so getName returns an empty string for it. Callers have to reject it.
+	/// </summary>
+	static constexpr uint32_t INVALID_NAME_ID = UINT32_MAX;
+
+	static NameTable& instance();
+
+	/// <summary>
+	/// Returns the id of the name specified, adding the name to the table if it's not yet known. Returns INVALID_NAME_ID if the name isn't known and the table is full.
+	/// </summary>
+	uint32_t intern(std::string_view name);
+	/// <summary>
+	/// Returns the name with the id specified, or an empty string if the id is unknown. Lock free.
+	/// </summary>
+	const std::string& getName(uint32_t id) const;
+	uint32_t getNumberOfNames() const { return _numberOfNames.load(std::memory_order_acquire); }
+	/// <summary>
+	/// Returns the number of bytes used by the table, including the names and the lookup map.
+	/// </summary>
+	size_t calculateMemoryUsage() const;
+
+private:
+	NameTable() = default;
+	~NameTable();
+
+	/// <summary>
+	/// Hashes string_views and strings the same way, so the lookup map can be searched with a string_view without creating a string.
+	/// </summary>
+	struct NameHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+	};
+
+	static constexpr uint32_t CHUNK_SIZE = 1024;
+	static constexpr uint32_t MAX_NUMBER_OF_CHUNKS = 1024;
+
+	mutable std::shared_mutex _mutex;		// guards the lookup map and the adding of names. Not needed for reading names.
+	std::unordered_map<std::string, uint32_t, NameHash, std::equal_to<>> _idPerName;
+	std::array<std::atomic<std::string*>, MAX_NUMBER_OF_CHUNKS> _chunks = {};
+	std::atomic<uint32_t> _numberOfNames = 0;
+	size_t _numberOfNameBytesOnHeap = 0;
+};
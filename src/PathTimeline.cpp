@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "PathTimeline.h"
+#include <algorithm>
+
+
+bool PathTimeline::bake(const CameraPathData& path, const std::vector<float>& segmentDurations, StateInterpolationMode mode)
+{
+	clear();
+	if(path.numberOfSnapshots() < 2 || (int)segmentDurations.size() != path.numberOfSnapshots() - 1)
+	{
+		return false;
+	}
+	_segmentPlans.resize(segmentDurations.size());
+	_segmentEndTimes.reserve(segmentDurations.size());
+	double endTime = 0.0;
+	for(size_t i = 0; i < segmentDurations.size(); i++)
+	{
+		if(!(segmentDurations[i] > 0.0f))
+		{
+			clear();
+			return false;
+		}
+		path.compileInterpolationPlan((int)i, (int)i + 1, mode, _segmentPlans[i]);
+		// the plans are kept for the whole playback, so they shouldn't hold on to their compile buffers.
+		_segmentPlans[i].shrinkToFit();
+		endTime += segmentDurations[i];
+		_segmentEndTimes.push_back(endTime);
+	}
+	return true;
+}
+
+
+bool PathTimeline::apply(reshade::api::effect_runtime* runtime, double time, RuntimeStateCache& cache)
+{
+	if(isEmpty())
+	{
+		return false;
+	}
+	if(time >= getDuration())
+	{
+		_segmentPlans.back().apply(runtime, 1.0f, cache);
+		return false;
+	}
+	const size_t segmentIndex = std::upper_bound(_segmentEndTimes.begin(), _segmentEndTimes.end(), time) - _segmentEndTimes.begin();
+	const double segmentStartTime = segmentIndex > 0 ? _segmentEndTimes[segmentIndex - 1] : 0.0;
+	const double interpolationFactor = (time - segmentStartTime) / (_segmentEndTimes[segmentIndex] - segmentStartTime);
+	_segmentPlans[segmentIndex].apply(runtime, (float)std::clamp(interpolationFactor, 0.0, 1.0), cache);
+	return true;
+}
+
+
+void PathTimeline::clear()
+{
+	_segmentPlans.clear();
+	_segmentEndTimes.clear();
+}
+
+
+size_t PathTimeline::calculateMemoryUsage() const
+{
+	size_t toReturn = sizeof(PathTimeline) + (_segmentEndTimes.capacity() * sizeof(double)) + ((_segmentPlans.capacity() - _segmentPlans.size()) * sizeof(InterpolationPlan));
+	for(const auto& plan : _segmentPlans)
+	{
+		toReturn += plan.calculateMemoryUsage();
+	}
+	return toReturn;
+}
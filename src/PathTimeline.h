@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <reshade.hpp>
+#include <vector>
+#include "CameraPathData.h"
+#include "ConstantsEnums.h"
+#include "InterpolationPlan.h"
+#include "RuntimeStateCache.h"
+
+/// <summary>
+/// A path baked for playback by time. The camera tools upload the duration of every segment once, and the interpolation plans of all segments are compiled
+/// ahead of time. A plan holds the polynomial of every uniform over its segment, which is an exact piecewise encoding of the timeline that is far smaller
+/// than sampled values. During playback the state is evaluated locally every present from the time elapsed since the start, so the camera tools don't
+/// call into the addon per frame and nothing is compiled on the render thread.
+/// </summary>
+class PathTimeline
+{
+public:
+	/// <summary>
+	/// Compiles the plans of all segments of path. segmentDurations contains the duration in seconds of each segment, so it has one element less than
+	/// the path has snapshots. Returns false if the number of durations doesn't match or a duration isn't positive, the timeline is then empty.
+	/// </summary>
+	bool bake(const CameraPathData& path, const std::vector<float>& segmentDurations, StateInterpolationMode mode);
+	/// <summary>
+	/// Applies the state at the time specified, in seconds since the start of the timeline, to the runtime specified. cache has to be the cache of runtime.
+	/// Returns false if time is at or past the end of the timeline. The state at the end is then applied.
+	/// </summary>
+	bool apply(reshade::api::effect_runtime* runtime, double time, RuntimeStateCache& cache);
+	void clear();
+
+	bool isEmpty() const { return _segmentPlans.empty(); }
+	double getDuration() const { return _segmentEndTimes.empty() ? 0.0 : _segmentEndTimes.back(); }
+	int numberOfSegments() const { return (int)_segmentPlans.size(); }
+	/// <summary>
+	/// Returns the number of bytes used by the timeline, including its plans.
+	/// </summary>
+	size_t calculateMemoryUsage() const;
+
+private:
+	std::vector<InterpolationPlan> _segmentPlans;
+	// per segment the time its end is reached, in seconds since the start. Ascending.
+	std::vector<double> _segmentEndTimes;
+};
@@ -0,0 +1,374 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "ReshadeStateBenchmark.h"
+#include "CameraPathData.h"
+#include "HandleMigration.h"
+#include "InterpolationPlan.h"
+#include "NameTable.h"
+#include "OverlayControl.h"
+#include "ReshadeStateSnapshot.h"
+#include "Utils.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+
+using namespace std::chrono;
+
+namespace
+{
+	constexpr int NUMBER_OF_EFFECTS = 100;
+	constexpr int NUMBER_OF_UNIFORMS_PER_EFFECT = 50;
+	constexpr int NUMBER_OF_TECHNIQUES_PER_EFFECT = 2;
+	constexpr int NUMBER_OF_ITERATIONS = 1000;
+	constexpr int NUMBER_OF_PATH_NODES = 200;
+	constexpr int NUMBER_OF_PATH_INSERTS = 50;
+	constexpr int NUMBER_OF_RELOAD_PATHS = 10;
+	constexpr int NUMBER_OF_RELOAD_PATH_NODES = 100;
+	// handles after the simulated reload, so every effect state gets new handles
+	constexpr uint64_t RELOADED_FIRST_HANDLE = 1000000;
+	// std::string's small string buffer in the MS STL. Longer names are allocated on the heap.
+	constexpr size_t SMALL_STRING_CAPACITY = 15;
+
+	/// <summary>
+	/// The layout of EffectState and ReshadeStateSnapshot before the flat layout: everything keyed on the name.
+	/// </summary>
+	struct MapEffectState
+	{
+		std::unordered_map<std::string, uint64_t> uniformFloatVariableIdPerName;
+		std::unordered_map<std::string, DirectX::XMFLOAT4> uniformFloatValuePerName;
+		std::unordered_map<std::string, uint64_t> uniformVariableIdPerName;
+	};
+
+	struct MapSnapshot
+	{
+		std::unordered_map<std::string, MapEffectState> effectStatePerEffectName;
+		std::unordered_map<std::string, uint64_t> techniqueIdPerName;
+		std::unordered_map<std::string, bool> techniqueEnabledPerName;
+	};
+
+
+	std::string createEffectName(int effectIndex) { return IGCS::Utils::formatString("IgcsBenchmarkEffect%d.fx", effectIndex); }
+	std::string createUniformName(int uniformIndex) { return IGCS::Utils::formatString("BenchmarkUniform%d", uniformIndex); }
+	std::string createTechniqueName(int effectIndex, int techniqueIndex) { return IGCS::Utils::formatString("IgcsBenchmarkTechnique%d_%d", effectIndex, techniqueIndex); }
+
+
+	void fillValues(int effectIndex, int uniformIndex, int snapshotIndex, float* values)
+	{
+		for(int component = 0; component < 4; component++)
+		{
+			values[component] = (float)((effectIndex * 31) + (uniformIndex * 7) + component) * 0.01f * (float)(snapshotIndex + 1);
+		}
+	}
+
+
+	/// <summary>
+	/// Creates a snapshot with the values of snapshotIndex. If changedEffectIndex is specified, only that effect gets the values of snapshotIndex and the
+	/// others the values of snapshot 0, like a path node on which the user changed a single effect. Handles are numbered from firstHandle.
+	/// </summary>
+	ReshadeStateSnapshot createFlatSnapshot(int snapshotIndex, int changedEffectIndex = -1, uint64_t firstHandle = 1)
+	{
+		NameTable& nameTable = NameTable::instance();
+		ReshadeStateSnapshot toReturn;
+		uint64_t handle = firstHandle;
+		for(int effectIndex = 0; effectIndex < NUMBER_OF_EFFECTS; effectIndex++)
+		{
+			EffectState effectState(nameTable.intern(createEffectName(effectIndex)));
+			for(int uniformIndex = 0; uniformIndex < NUMBER_OF_UNIFORMS_PER_EFFECT; uniformIndex++)
+			{
+				float values[4];
+				fillValues(effectIndex, uniformIndex, (changedEffectIndex < 0 || changedEffectIndex == effectIndex) ? snapshotIndex : 0, values);
+				const uint32_t uniformNameId = nameTable.intern(createUniformName(uniformIndex));
+				effectState.addFloatUniform(uniformNameId, handle, values);
+				effectState.addUniformHandle(uniformNameId, handle);
+				handle++;
+			}
+			effectState.sortUniforms();
+			toReturn.addEffectState(std::move(effectState));
+			for(int techniqueIndex = 0; techniqueIndex < NUMBER_OF_TECHNIQUES_PER_EFFECT; techniqueIndex++)
+			{
+				toReturn.addTechnique(nameTable.intern(createTechniqueName(effectIndex, techniqueIndex)), handle++, techniqueIndex == 0);
+			}
+		}
+		toReturn.sortOnNameIds();
+		return toReturn;
+	}
+
+
+	MapSnapshot createMapSnapshot(int snapshotIndex)
+	{
+		MapSnapshot toReturn;
+		uint64_t handle = 1;
+		for(int effectIndex = 0; effectIndex < NUMBER_OF_EFFECTS; effectIndex++)
+		{
+			MapEffectState effectState;
+			for(int uniformIndex = 0; uniformIndex < NUMBER_OF_UNIFORMS_PER_EFFECT; uniformIndex++)
+			{
+				float values[4];
+				fillValues(effectIndex, uniformIndex, snapshotIndex, values);
+				const std::string uniformName = createUniformName(uniformIndex);
+				effectState.uniformFloatValuePerName.emplace(uniformName, DirectX::XMFLOAT4(values));
+				effectState.uniformFloatVariableIdPerName.emplace(uniformName, handle);
+				effectState.uniformVariableIdPerName.emplace(uniformName, handle);
+				handle++;
+			}
+			toReturn.effectStatePerEffectName.emplace(createEffectName(effectIndex), effectState);
+			for(int techniqueIndex = 0; techniqueIndex < NUMBER_OF_TECHNIQUES_PER_EFFECT; techniqueIndex++)
+			{
+				const std::string techniqueName = createTechniqueName(effectIndex, techniqueIndex);
+				toReturn.techniqueIdPerName.emplace(techniqueName, handle++);
+				toReturn.techniqueEnabledPerName.emplace(techniqueName, techniqueIndex == 0);
+			}
+		}
+		return toReturn;
+	}
+
+
+	/// <summary>
+	/// Estimates the memory of a string keyed unordered_map of the MS STL: the bucket array plus per element a list node with two pointers, and the key if
+	/// it doesn't fit in the small string buffer. Heap memory owned by the values isn't included.
+	/// </summary>
+	template <typename TValue>
+	size_t estimateMapMemoryUsage(const std::unordered_map<std::string, TValue>& map)
+	{
+		size_t toReturn = sizeof(map) + (map.bucket_count() * 2 * sizeof(void*));
+		for(const auto& pair : map)
+		{
+			toReturn += sizeof(pair) + (2 * sizeof(void*));
+			if(pair.first.capacity() > SMALL_STRING_CAPACITY)
+			{
+				toReturn += pair.first.capacity() + 1;
+			}
+		}
+		return toReturn;
+	}
+
+
+	size_t estimateMapSnapshotMemoryUsage(const MapSnapshot& snapshot)
+	{
+		size_t toReturn = sizeof(MapSnapshot) - (3 * sizeof(std::unordered_map<std::string, uint64_t>)) + estimateMapMemoryUsage(snapshot.effectStatePerEffectName) +
+						  estimateMapMemoryUsage(snapshot.techniqueIdPerName) + estimateMapMemoryUsage(snapshot.techniqueEnabledPerName);
+		for(const auto& pair : snapshot.effectStatePerEffectName)
+		{
+			// the maps themselves are already counted as part of the node.
+			toReturn += estimateMapMemoryUsage(pair.second.uniformFloatVariableIdPerName) + estimateMapMemoryUsage(pair.second.uniformFloatValuePerName) +
+						estimateMapMemoryUsage(pair.second.uniformVariableIdPerName) - (3 * sizeof(std::unordered_map<std::string, uint64_t>));
+		}
+		return toReturn;
+	}
+
+
+	/// <summary>
+	/// What interpolating two snapshots did with the map layout, minus the calls into the runtime: copy the destination maps, then look up every
+	/// effect and uniform by name.
+	/// </summary>
+	void calculateInterpolatedValues(const MapSnapshot& from, const MapSnapshot& to, float interpolationFactor, std::vector<uint64_t>& handles, std::vector<DirectX::XMFLOAT4>& values)
+	{
+		std::unordered_map<std::string, MapEffectState> destinationEffectsPerName = to.effectStatePerEffectName;
+		for(const auto& nameEffectPair : from.effectStatePerEffectName)
+		{
+			if(!destinationEffectsPerName.contains(nameEffectPair.first))
+			{
+				continue;
+			}
+			MapEffectState destinationEffect = destinationEffectsPerName[nameEffectPair.first];
+			for(const auto& nameValuePair : nameEffectPair.second.uniformFloatValuePerName)
+			{
+				if(!destinationEffect.uniformFloatValuePerName.contains(nameValuePair.first))
+				{
+					continue;
+				}
+				const auto& destinationValues = destinationEffect.uniformFloatValuePerName[nameValuePair.first];
+				handles.push_back(nameEffectPair.second.uniformFloatVariableIdPerName.at(nameValuePair.first));
+				values.push_back(DirectX::XMFLOAT4(IGCS::Utils::lerp(nameValuePair.second.x, destinationValues.x, interpolationFactor),
+												   IGCS::Utils::lerp(nameValuePair.second.y, destinationValues.y, interpolationFactor),
+												   IGCS::Utils::lerp(nameValuePair.second.z, destinationValues.z, interpolationFactor),
+												   IGCS::Utils::lerp(nameValuePair.second.w, destinationValues.w, interpolationFactor)));
+			}
+		}
+	}
+}
+
+
+void ReshadeStateBenchmark::start(const std::string& outputFolder)
+{
+	bool expected = false;
+	if(!_isRunning.compare_exchange_strong(expected, true))
+	{
+		return;
+	}
+	std::thread t(&ReshadeStateBenchmark::run, this, outputFolder);
+	t.detach();
+}
+
+
+void ReshadeStateBenchmark::run(std::string outputFolder)
+{
+	const ReshadeStateSnapshot flatPrevious = createFlatSnapshot(0);
+	const ReshadeStateSnapshot flatFrom = createFlatSnapshot(1);
+	const ReshadeStateSnapshot flatTo = createFlatSnapshot(2);
+	const ReshadeStateSnapshot flatNext = createFlatSnapshot(3);
+	InterpolationPlan plan;
+	auto startTime = high_resolution_clock::now();
+	for(int i = 0; i < NUMBER_OF_ITERATIONS; i++)
+	{
+		plan.compile(nullptr, flatFrom, flatTo, nullptr, StateInterpolationMode::Linear);
+	}
+	const double microsecondsPerPlanCompile = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_ITERATIONS;
+	startTime = high_resolution_clock::now();
+	for(int i = 0; i < NUMBER_OF_ITERATIONS; i++)
+	{
+		plan.evaluate((float)i / (float)NUMBER_OF_ITERATIONS);
+	}
+	const double flatMicrosecondsPerInterpolation = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_ITERATIONS;
+	const size_t numberOfInterpolatedValues = plan.getInterpolatedValues().size();
+
+	startTime = high_resolution_clock::now();
+	for(int i = 0; i < NUMBER_OF_ITERATIONS; i++)
+	{
+		plan.compile(&flatPrevious, flatFrom, flatTo, &flatNext, StateInterpolationMode::MonotoneCubic);
+	}
+	const double microsecondsPerCubicPlanCompile = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_ITERATIONS;
+	startTime = high_resolution_clock::now();
+	for(int i = 0; i < NUMBER_OF_ITERATIONS; i++)
+	{
+		plan.evaluate((float)i / (float)NUMBER_OF_ITERATIONS);
+	}
+	const double microsecondsPerCubicInterpolation = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_ITERATIONS;
+
+	const MapSnapshot mapFrom = createMapSnapshot(0);
+	const MapSnapshot mapTo = createMapSnapshot(1);
+	std::vector<uint64_t> handles;
+	std::vector<DirectX::XMFLOAT4> mapValues;
+	startTime = high_resolution_clock::now();
+	for(int i = 0; i < NUMBER_OF_ITERATIONS; i++)
+	{
+		handles.clear();
+		mapValues.clear();
+		calculateInterpolatedValues(mapFrom, mapTo, (float)i / (float)NUMBER_OF_ITERATIONS, handles, mapValues);
+	}
+	const double mapMicrosecondsPerInterpolation = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_ITERATIONS;
+
+	// a path on which every node changes one effect. Appending and inserting copies the snapshot, which only copies the references to the effect states.
+	std::vector<ReshadeStateSnapshot> nodeSnapshots;
+	for(int i = 0; i < NUMBER_OF_PATH_NODES; i++)
+	{
+		nodeSnapshots.push_back(createFlatSnapshot(i + 1, i % NUMBER_OF_EFFECTS));
+	}
+	CameraPathData path;
+	startTime = high_resolution_clock::now();
+	for(const auto& nodeSnapshot : nodeSnapshots)
+	{
+		path.appendStateSnapshot(nodeSnapshot);
+	}
+	const double microsecondsPerPathAppend = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_PATH_NODES;
+	startTime = high_resolution_clock::now();
+	for(int i = 0; i < NUMBER_OF_PATH_INSERTS; i++)
+	{
+		path.insertStateSnapshotBeforeSnapshot(path.numberOfSnapshots() / 2, nodeSnapshots[i]);
+	}
+	const double microsecondsPerPathInsert = duration<double, std::micro>(high_resolution_clock::now() - startTime).count() / NUMBER_OF_PATH_INSERTS;
+	const size_t pathBytes = path.calculateMemoryUsage();
+	size_t unsharedPathBytes = sizeof(CameraPathData);
+	for(int i = 0; i < NUMBER_OF_PATH_NODES; i++)
+	{
+		unsharedPathBytes += nodeSnapshots[i].calculateMemoryUsage() * (i < NUMBER_OF_PATH_INSERTS ? 2 : 1);
+	}
+
+	// a reload of the preset with several paths: the handles of all snapshots are migrated. Per snapshot is how it was done before the migration
+	// was shared by all snapshots: every snapshot migrated the effect states it refers to, even if another snapshot had already migrated the same state.
+	std::vector<CameraPathData> reloadPaths(NUMBER_OF_RELOAD_PATHS);
+	for(int pathIndex = 0; pathIndex < NUMBER_OF_RELOAD_PATHS; pathIndex++)
+	{
+		for(int i = 0; i < NUMBER_OF_RELOAD_PATH_NODES; i++)
+		{
+			reloadPaths[pathIndex].appendStateSnapshot(createFlatSnapshot((pathIndex * NUMBER_OF_RELOAD_PATH_NODES) + i + 1, i % NUMBER_OF_EFFECTS));
+		}
+	}
+	const ReshadeStateSnapshot reloadedState = createFlatSnapshot(0, -1, RELOADED_FIRST_HANDLE);
+	std::vector<ReshadeStateSnapshot> snapshotsToMigrate;
+	for(const auto& reloadPath : reloadPaths)
+	{
+		snapshotsToMigrate.insert(snapshotsToMigrate.end(), reloadPath.getSnapshots().begin(), reloadPath.getSnapshots().end());
+	}
+	startTime = high_resolution_clock::now();
+	for(auto& snapshot : snapshotsToMigrate)
+	{
+		HandleMigration migration(reloadedState);
+		snapshot.migrateState(migration);
+	}
+	const double millisecondsPerReloadPerSnapshot = duration<double, std::milli>(high_resolution_clock::now() - startTime).count();
+	snapshotsToMigrate.clear();
+	startTime = high_resolution_clock::now();
+	HandleMigration reloadMigration(reloadedState);
+	for(auto& reloadPath : reloadPaths)
+	{
+		reloadPath.migratedContainedHandles(reloadMigration);
+	}
+	const double millisecondsPerReload = duration<double, std::milli>(high_resolution_clock::now() - startTime).count();
+	const size_t numberOfEffectStatesMigrated = reloadMigration.getNumberOfEffectStatesMigrated();
+
+	const size_t flatBytesPerSnapshot = flatFrom.calculateMemoryUsage();
+	const size_t mapBytesPerSnapshot = estimateMapSnapshotMemoryUsage(mapFrom);
+	IGCS::Utils::logLineToReshade(reshade::log_level::info, "Reshade state benchmark: flat layout %llu bytes per snapshot, %.2f us per plan compile, %.2f us per interpolation, monotone cubic: %.2f us per plan compile, %.2f us per interpolation. Map layout %llu bytes per snapshot, %.2f us per interpolation.",
+								  (unsigned long long)flatBytesPerSnapshot, microsecondsPerPlanCompile, flatMicrosecondsPerInterpolation, microsecondsPerCubicPlanCompile,
+								  microsecondsPerCubicInterpolation, (unsigned long long)mapBytesPerSnapshot, mapMicrosecondsPerInterpolation);
+	IGCS::Utils::logLineToReshade(reshade::log_level::info, "Reshade state benchmark: path of %d nodes: %llu bytes (%llu bytes without shared effect states), %.2f us per append, %.2f us per insert.",
+								  path.numberOfSnapshots(), (unsigned long long)pathBytes, (unsigned long long)unsharedPathBytes, microsecondsPerPathAppend, microsecondsPerPathInsert);
+	IGCS::Utils::logLineToReshade(reshade::log_level::info, "Reshade state benchmark: reload with %d paths of %d nodes: %.2f ms (%llu effect states migrated), %.2f ms when migrated per snapshot.",
+								  NUMBER_OF_RELOAD_PATHS, NUMBER_OF_RELOAD_PATH_NODES, millisecondsPerReload, (unsigned long long)numberOfEffectStatesMigrated, millisecondsPerReloadPerSnapshot);
+
+	const std::string filename = (std::filesystem::path(outputFolder) / "ReshadeStateBenchmark.json").string();
+	FILE* resultsFile = nullptr;
+	if(fopen_s(&resultsFile, filename.c_str(), "w") != 0 || nullptr == resultsFile)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Reshade state benchmark: couldn't write results to %s", filename.c_str());
+		_isRunning = false;
+		return;
+	}
+	fprintf(resultsFile, "{\n\t\"numberOfEffects\": %d,\n\t\"numberOfUniformsPerEffect\": %d,\n\t\"numberOfTechniquesPerEffect\": %d,\n\t\"numberOfInterpolatedValues\": %llu,\n",
+			NUMBER_OF_EFFECTS, NUMBER_OF_UNIFORMS_PER_EFFECT, NUMBER_OF_TECHNIQUES_PER_EFFECT, (unsigned long long)numberOfInterpolatedValues);
+	fprintf(resultsFile, "\t\"flat\": { \"bytesPerSnapshot\": %llu, \"microsecondsPerPlanCompile\": %.3f, \"microsecondsPerInterpolation\": %.3f },\n", (unsigned long long)flatBytesPerSnapshot,
+			microsecondsPerPlanCompile, flatMicrosecondsPerInterpolation);
+	fprintf(resultsFile, "\t\"flatMonotoneCubic\": { \"microsecondsPerPlanCompile\": %.3f, \"microsecondsPerInterpolation\": %.3f },\n", microsecondsPerCubicPlanCompile,
+			microsecondsPerCubicInterpolation);
+	fprintf(resultsFile, "\t\"map\": { \"bytesPerSnapshot\": %llu, \"microsecondsPerInterpolation\": %.3f },\n", (unsigned long long)mapBytesPerSnapshot, mapMicrosecondsPerInterpolation);
+	fprintf(resultsFile, "\t\"path\": { \"numberOfNodes\": %d, \"bytes\": %llu, \"bytesWithoutSharedEffectStates\": %llu, \"microsecondsPerAppend\": %.3f, \"microsecondsPerInsert\": %.3f },\n",
+			path.numberOfSnapshots(), (unsigned long long)pathBytes, (unsigned long long)unsharedPathBytes, microsecondsPerPathAppend, microsecondsPerPathInsert);
+	fprintf(resultsFile, "\t\"reload\": { \"numberOfPaths\": %d, \"numberOfNodesPerPath\": %d, \"milliseconds\": %.3f, \"effectStatesMigrated\": %llu, \"millisecondsMigratedPerSnapshot\": %.3f }\n}\n",
+			NUMBER_OF_RELOAD_PATHS, NUMBER_OF_RELOAD_PATH_NODES, millisecondsPerReload, (unsigned long long)numberOfEffectStatesMigrated, millisecondsPerReloadPerSnapshot);
+	fclose(resultsFile);
+	OverlayControl::addNotification("Reshade state benchmark completed. Results written to " + filename);
+	_isRunning = false;
+}
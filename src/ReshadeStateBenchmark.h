@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <string>
+
+/// <summary>
+/// Benchmarks the reshade state snapshots used for camera paths with a synthetic state of 100 effects with 50 float uniforms and 2 techniques each.
+/// It measures the memory per snapshot and the time to calculate the interpolated state between two snapshots (for the flat layout using a compiled
+/// InterpolationPlan, for which the compile time is reported separately), for the flat snapshot layout and for the
+/// string keyed map layout it replaced (replicated in the benchmark). The calls into the runtime to set the values aren't included as they're the same
+/// for both. It also measures the memory and the append and insert times of a path of 200 nodes on which every node changes one effect, with the
+/// unchanged effect states shared between the nodes, and the time to migrate the handles of 10 such paths of 100 nodes after a reload of the preset.
+/// Results are written as JSON to the output folder. The names of the synthetic effects are added to the NameTable.
+/// </summary>
+class ReshadeStateBenchmark
+{
+public:
+	ReshadeStateBenchmark() = default;
+	~ReshadeStateBenchmark() = default;
+
+	/// <summary>
+	/// Starts the benchmark on a background thread, writing the results to outputFolder. Ignored if a benchmark is already running.
+	/// </summary>
+	/// <param name="outputFolder"></param>
+	void start(const std::string& outputFolder);
+	bool isRunning() { return _isRunning; }
+
+private:
+	void run(std::string outputFolder);
+
+	std::atomic<bool> _isRunning = false;
+};
@@ -33,155 +33,486 @@
 
 #include "ReshadeStateController.h"
 #include "CameraPathData.h"
+#include "CameraPathFile.h"
+#include "Utils.h"
+#include <chrono>
+
+
+ReshadeStateController::ReshadeStateController() : _cameraPaths(std::make_shared<const CameraPaths>())
+{
+}
 
 
 void ReshadeStateController::removeCameraPath(int pathIndex)
 {
-	std::scoped_lock lock(_apiMutex);
-	if(pathIndex<0 || pathIndex>=_cameraPathsData.size())
+	std::scoped_lock lock(_writeMutex);
+	const auto paths = _cameraPaths.load();
+	if(pathIndex<0 || pathIndex>=paths->size())
 	{
 		return;
 	}
-	_cameraPathsData.erase(_cameraPathsData.begin() + pathIndex);
+	auto newPaths = std::make_shared<CameraPaths>(*paths);
+	newPaths->erase(newPaths->begin() + pathIndex);
+	_cameraPaths.store(std::move(newPaths));
 }
 
 
 void ReshadeStateController::addCameraPath()
 {
-	std::scoped_lock lock(_apiMutex);
-	_cameraPathsData.push_back(CameraPathData());
+	std::scoped_lock lock(_writeMutex);
+	auto newPaths = std::make_shared<CameraPaths>(*_cameraPaths.load());
+	newPaths->push_back(std::make_shared<const CameraPathData>());
+	_cameraPaths.store(std::move(newPaths));
 }
 
 
 void ReshadeStateController::appendStateSnapshotToPath(int pathIndex, reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	migrateHandlesIfNeeded(runtime);
+	std::scoped_lock lock(_writeMutex);
+	auto path = copyCameraPath(pathIndex);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.appendStateSnapshot(getCurrentReshadeStateSnapshot(runtime));
+	path->appendStateSnapshot(getCurrentReshadeStateSnapshot(runtime));
+	publishCameraPath(pathIndex, std::move(path));
 }
 
 
 void ReshadeStateController::insertStateSnapshotBeforeSnapshotOnPath(int pathIndex, int indexToInsertBefore, reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	migrateHandlesIfNeeded(runtime);
+	std::scoped_lock lock(_writeMutex);
+	auto path = copyCameraPath(pathIndex);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.insertStateSnapshotBeforeSnapshot(indexToInsertBefore, getCurrentReshadeStateSnapshot(runtime));
+	path->insertStateSnapshotBeforeSnapshot(indexToInsertBefore, getCurrentReshadeStateSnapshot(runtime));
+	publishCameraPath(pathIndex, std::move(path));
 }
 
 
 void ReshadeStateController::appendStateSnapshotAfterSnapshotOnPath(int pathIndex, int indexToAppendAfter, reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	migrateHandlesIfNeeded(runtime);
+	std::scoped_lock lock(_writeMutex);
+	auto path = copyCameraPath(pathIndex);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.appendStateSnapshotAfterSnapshot(indexToAppendAfter, getCurrentReshadeStateSnapshot(runtime));
+	path->appendStateSnapshotAfterSnapshot(indexToAppendAfter, getCurrentReshadeStateSnapshot(runtime));
+	publishCameraPath(pathIndex, std::move(path));
 }
 
 
 void ReshadeStateController::removeStateSnapshotFromPath(int pathIndex, int stateIndex)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	std::scoped_lock lock(_writeMutex);
+	auto path = copyCameraPath(pathIndex);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.removeStateSnapshot(stateIndex);
+	path->removeStateSnapshot(stateIndex);
+	publishCameraPath(pathIndex, std::move(path));
 }
 
 
 void ReshadeStateController::updateStateSnapshotOnPath(int pathIndex, int stateIndex, reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	migrateHandlesIfNeeded(runtime);
+	std::scoped_lock lock(_writeMutex);
+	auto path = copyCameraPath(pathIndex);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.updateStateSnapshot(getCurrentReshadeStateSnapshot(runtime), stateIndex);
+	path->updateStateSnapshot(getCurrentReshadeStateSnapshot(runtime), stateIndex);
+	publishCameraPath(pathIndex, std::move(path));
 }
 
 
 void ReshadeStateController::migrateContainedHandles(reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	const ReshadeStateSnapshot currentState = getCurrentReshadeStateSnapshot(runtime);
-
-	for(auto& path : _cameraPathsData)
+	std::scoped_lock lock(_writeMutex);
+	// the effects have been reloaded, so handles, names and types are different. This also adds the names of newly loaded effects, techniques and uniforms to the NameTable.
+	EffectRegistry& registry = _effectRegistryPerRuntime[runtime];
+	registry.build(runtime);
+	publishMigratedCameraPaths(runtime, getCurrentReshadeStateSnapshot(runtime));
+	// handles of the reloaded effects can be the same values as the ones of the old effects, so nothing the caches know about is valid anymore.
+	invalidateStateCaches();
+	rebakeTimeline();
+	if(!registry.isEmpty())
 	{
-		path.migratedContainedHandles(currentState);
+		_hasUnmigratedHandles = false;
 	}
 }
 
 
 void ReshadeStateController::setReshadeState(int pathIndex, int fromStateIndex, int toStateIndex, float interpolationFactor, reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	auto path = getMigratedCameraPath(pathIndex, runtime);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.setReshadeState(fromStateIndex, toStateIndex, interpolationFactor, runtime);
+	const StateInterpolationMode mode = _stateInterpolationMode;
+	std::scoped_lock lock(_playbackMutex);
+	if(path != _planPath || fromStateIndex != _planFromStateIndex || toStateIndex != _planToStateIndex || mode != _planMode)
+	{
+		if(!path->compileInterpolationPlan(fromStateIndex, toStateIndex, mode, _interpolationPlan))
+		{
+			return;
+		}
+		_planPath = std::move(path);
+		_planFromStateIndex = fromStateIndex;
+		_planToStateIndex = toStateIndex;
+		_planMode = mode;
+	}
+	_interpolationPlan.apply(runtime, interpolationFactor, _stateCachePerRuntime[runtime]);
 }
 
 
 void ReshadeStateController::setReshadeState(int pathIndex, int stateIndex, reshade::api::effect_runtime* runtime)
 {
-	std::scoped_lock lock(_apiMutex);
-	CameraPathData& path = getCameraPath(pathIndex);
-
-	if(path.isNonExisting())
+	const auto path = getMigratedCameraPath(pathIndex, runtime);
+	if(nullptr == path)
 	{
 		return;
 	}
-	path.setReshadeState(stateIndex, runtime);
+	std::scoped_lock lock(_playbackMutex);
+	path->setReshadeState(stateIndex, runtime);
+	// this bypasses the cache, so what it knows about the values in the runtime is outdated.
+	_stateCachePerRuntime[runtime].invalidateValues();
 }
 
 
 void ReshadeStateController::clearPaths()
 {
-	_cameraPathsData.clear(); 
+	std::scoped_lock lock(_writeMutex);
+	_cameraPaths.store(std::make_shared<const CameraPaths>());
 }
 
 
 int ReshadeStateController::numberOfSnapshotsOnPath(int pathIndex)
 {
-	auto& path = getCameraPath(pathIndex);
-	if(path.isNonExisting())
+	const auto path = getCameraPath(pathIndex);
+	if(nullptr == path)
 	{
 		return 0;
 	}
-	return path.numberOfSnapshots();
+	return path->numberOfSnapshots();
+}
+
+
+size_t ReshadeStateController::calculateMemoryUsageOfPath(int pathIndex)
+{
+	const auto path = getCameraPath(pathIndex);
+	if(nullptr == path)
+	{
+		return 0;
+	}
+	return path->calculateMemoryUsage();
+}
+
+
+void ReshadeStateController::setStateInterpolationMode(StateInterpolationMode mode)
+{
+	_stateInterpolationMode = mode;
+}
+
+
+StateInterpolationMode ReshadeStateController::getStateInterpolationMode()
+{
+	return _stateInterpolationMode;
+}
+
+
+void ReshadeStateController::getRuntimeCallStatistics(RuntimeCallStatistics& lastFrame, RuntimeCallStatistics& total)
+{
+	std::scoped_lock lock(_playbackMutex);
+	lastFrame = RuntimeCallStatistics();
+	total = RuntimeCallStatistics();
+	for(const auto& [runtime, cache] : _stateCachePerRuntime)
+	{
+		const auto& cacheLastFrame = cache.getLastFrameStatistics();
+		lastFrame.uniformWrites += cacheLastFrame.uniformWrites;
+		lastFrame.uniformWritesSkipped += cacheLastFrame.uniformWritesSkipped;
+		lastFrame.techniqueWrites += cacheLastFrame.techniqueWrites;
+		lastFrame.techniqueWritesSkipped += cacheLastFrame.techniqueWritesSkipped;
+		const auto& cacheTotal = cache.getTotalStatistics();
+		total.uniformWrites += cacheTotal.uniformWrites;
+		total.uniformWritesSkipped += cacheTotal.uniformWritesSkipped;
+		total.techniqueWrites += cacheTotal.techniqueWrites;
+		total.techniqueWritesSkipped += cacheTotal.techniqueWritesSkipped;
+	}
+}
+
+
+bool ReshadeStateController::startTimelinePlayback(int pathIndex, const std::vector<float>& segmentDurations)
+{
+	// a migration can't run between taking the version of the path and publishing the timeline, so the timeline never starts with stale handles.
+	std::scoped_lock writeLock(_writeMutex);
+	auto path = getCameraPath(pathIndex);
+	if(nullptr == path)
+	{
+		return false;
+	}
+	// baked on the calling thread, so the render thread only has to swap it in.
+	PathTimeline timeline;
+	const StateInterpolationMode mode = _stateInterpolationMode;
+	if(!timeline.bake(*path, segmentDurations, mode))
+	{
+		return false;
+	}
+	_timelinePath = std::move(path);
+	std::scoped_lock playbackLock(_playbackMutex);
+	_timeline = std::move(timeline);
+	_timelineSegmentDurations = segmentDurations;
+	_timelineMode = mode;
+	_hasTimelineStarted = false;
+	_isTimelinePlaying = true;
+	return true;
+}
+
+
+void ReshadeStateController::stopTimelinePlayback()
+{
+	std::scoped_lock lock(_writeMutex);
+	clearTimeline();
+}
+
+
+void ReshadeStateController::applyTimeline(reshade::api::effect_runtime* runtime)
+{
+	if(!_isTimelinePlaying)
+	{
+		return;
+	}
+	migrateHandlesIfNeeded(runtime);
+	std::scoped_lock lock(_playbackMutex);
+	if(_timeline.isEmpty())
+	{
+		return;
+	}
+	const auto now = std::chrono::steady_clock::now();
+	if(!_hasTimelineStarted)
+	{
+		// the time starts at the first present after the start, which is the first frame the camera tools render on the path.
+		_timelineStartTime = now;
+		_hasTimelineStarted = true;
+	}
+	const double elapsedSeconds = std::chrono::duration<double>(now - _timelineStartTime).count();
+	if(!_timeline.apply(runtime, elapsedSeconds, _stateCachePerRuntime[runtime]))
+	{
+		// the end has been applied
+		_isTimelinePlaying = false;
+		_timeline.clear();
+	}
+}
+
+
+bool ReshadeStateController::getTimelineProgress(double& elapsedSeconds, double& durationSeconds, size_t& memoryUsage)
+{
+	std::scoped_lock lock(_playbackMutex);
+	if(!_isTimelinePlaying)
+	{
+		return false;
+	}
+	elapsedSeconds = _hasTimelineStarted ? std::chrono::duration<double>(std::chrono::steady_clock::now() - _timelineStartTime).count() : 0.0;
+	durationSeconds = _timeline.getDuration();
+	memoryUsage = _timeline.calculateMemoryUsage();
+	return true;
+}
+
+
+bool ReshadeStateController::savePaths(const std::string& filename)
+{
+	// the version is immutable, so it can be written while paths are edited.
+	return IGCS::CameraPathFile::write(filename, *_cameraPaths.load());
+}
+
+
+bool ReshadeStateController::loadPaths(const std::string& filename)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	CameraPaths pathsRead;
+	if(!IGCS::CameraPathFile::read(filename, pathsRead))
+	{
+		return false;
+	}
+	int numberOfSnapshots = 0;
+	for(const auto& path : pathsRead)
+	{
+		numberOfSnapshots += path->numberOfSnapshots();
+	}
+	const int numberOfPathsRead = (int)pathsRead.size();
+	{
+		std::scoped_lock lock(_writeMutex);
+		// the handles in the file are from another runtime, so they're resolved the first time we get a runtime. The flag is set before the paths are
+		// published, so a reader which gets the loaded paths also sees it, see getMigratedCameraPath.
+		_hasUnmigratedHandles = true;
+		_cameraPaths.store(std::make_shared<const CameraPaths>(std::move(pathsRead)));
+		invalidateStateCaches();
+		clearTimeline();
+	}
+	IGCS::Utils::logLineToReshade(reshade::log_level::info, "Loaded %d camera paths with %d reshade state snapshots from %s in %.2f ms", numberOfPathsRead, numberOfSnapshots,
+								  filename.c_str(), std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count());
+	return true;
+}
+
+
+bool ReshadeStateController::migrateHandlesIfNeeded(reshade::api::effect_runtime* runtime)
+{
+	if(!_hasUnmigratedHandles)
+	{
+		return false;
+	}
+	std::scoped_lock lock(_writeMutex);
+	if(!_hasUnmigratedHandles)
+	{
+		// another thread migrated them in the meantime
+		return true;
+	}
+	const ReshadeStateSnapshot currentState = getCurrentReshadeStateSnapshot(runtime);
+	if(_effectRegistryPerRuntime[runtime].isEmpty())
+	{
+		// no effects loaded, nothing to migrate to yet. Snapshots without handles are skipped when applied.
+		return false;
+	}
+	// the effects which aren't loaded can't be resolved now. They're resolved when they're loaded, as that's a reload of the effects.
+	const size_t numberOfEffectStatesNotLoaded = publishMigratedCameraPaths(runtime, currentState);
+	if(numberOfEffectStatesNotLoaded > 0)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::warning, "%llu effect states of the loaded camera paths are of effects which aren't loaded. They're migrated when the effects are reloaded.",
+									  (unsigned long long)numberOfEffectStatesNotLoaded);
+	}
+	invalidateStateCaches();
+	rebakeTimeline();
+	_hasUnmigratedHandles = false;
+	return true;
 }
 
 
-CameraPathData& ReshadeStateController::getCameraPath(int index)
+std::shared_ptr<const CameraPathData> ReshadeStateController::getMigratedCameraPath(int pathIndex, reshade::api::effect_runtime* runtime)
 {
-	if(index<0 || index >= _cameraPathsData.size())
+	// the path is taken before the flag is checked: a load sets the flag before it publishes the loaded paths, so if we got a loaded path, we see the
+	// flag and take the path again after migrating, until no load has been published in the meantime. Checking the flag first would miss a load
+	// published between the check and taking the path, and play back a path without handles. The flag is only cleared by a migration, which is
+	// done by the render thread, the only thread with a runtime.
+	auto path = getCameraPath(pathIndex);
+	while(migrateHandlesIfNeeded(runtime))
 	{
-		return CameraPathData::getNonExisting();
+		path = getCameraPath(pathIndex);
 	}
+	return path;
+}
+
 
-	return _cameraPathsData[index];
+void ReshadeStateController::invalidateStateCaches()
+{
+	std::scoped_lock lock(_playbackMutex);
+	for(auto& [runtime, cache] : _stateCachePerRuntime)
+	{
+		cache.invalidate();
+	}
+}
+
+
+void ReshadeStateController::rebakeTimeline()
+{
+	if(!_isTimelinePlaying)
+	{
+		// ended by itself, so its path can go.
+		_timelinePath = nullptr;
+		return;
+	}
+	std::scoped_lock lock(_playbackMutex);
+	if(nullptr == _timelinePath || !_timeline.bake(*_timelinePath, _timelineSegmentDurations, _timelineMode))
+	{
+		_isTimelinePlaying = false;
+		_timeline.clear();
+	}
+}
+
+
+void ReshadeStateController::clearTimeline()
+{
+	_timelinePath = nullptr;
+	std::scoped_lock lock(_playbackMutex);
+	_isTimelinePlaying = false;
+	_timeline.clear();
+}
+
+
+std::shared_ptr<const CameraPathData> ReshadeStateController::getCameraPath(int pathIndex)
+{
+	const auto paths = _cameraPaths.load();
+	if(pathIndex<0 || pathIndex >= paths->size())
+	{
+		return nullptr;
+	}
+	return (*paths)[pathIndex];
+}
+
+
+std::shared_ptr<CameraPathData> ReshadeStateController::copyCameraPath(int pathIndex)
+{
+	const auto path = getCameraPath(pathIndex);
+	if(nullptr == path)
+	{
+		return nullptr;
+	}
+	return std::make_shared<CameraPathData>(*path);
+}
+
+
+void ReshadeStateController::publishCameraPath(int pathIndex, std::shared_ptr<const CameraPathData> path)
+{
+	// only writers replace the version and we hold _writeMutex, so the path is still at pathIndex.
+	auto newPaths = std::make_shared<CameraPaths>(*_cameraPaths.load());
+	(*newPaths)[pathIndex] = std::move(path);
+	_cameraPaths.store(std::move(newPaths));
+}
+
+
+size_t ReshadeStateController::publishMigratedCameraPaths(reshade::api::effect_runtime* runtime, const ReshadeStateSnapshot& currentState)
+{
+	// one index for all snapshots of all paths, covering all loaded effects, also the ones without an enabled technique.
+	HandleMigration migration(currentState, _effectRegistryPerRuntime[runtime], runtime);
+	const auto paths = _cameraPaths.load();
+	auto newPaths = std::make_shared<CameraPaths>();
+	newPaths->reserve(paths->size());
+	for(const auto& path : *paths)
+	{
+		auto migratedPath = std::make_shared<CameraPathData>(*path);
+		migratedPath->migratedContainedHandles(migration);
+		newPaths->push_back(std::move(migratedPath));
+	}
+	_cameraPaths.store(std::move(newPaths));
+	if(nullptr != _timelinePath)
+	{
+		// mostly the same effect states as the paths, which are migrated already.
+		auto migratedTimelinePath = std::make_shared<CameraPathData>(*_timelinePath);
+		migratedTimelinePath->migratedContainedHandles(migration);
+		_timelinePath = std::move(migratedTimelinePath);
+	}
+	return migration.getNumberOfEffectStatesNotLoaded();
 }
 
 
 ReshadeStateSnapshot ReshadeStateController::getCurrentReshadeStateSnapshot(reshade::api::effect_runtime* runtime)
 {
 	ReshadeStateSnapshot currentState;
-
-	currentState.obtainReshadeState(runtime);
+	EffectRegistry& registry = _effectRegistryPerRuntime[runtime];
+	if(registry.isEmpty())
+	{
+		// not built yet, or built before any effect was loaded.
+		registry.build(runtime);
+	}
+	currentState.obtainReshadeState(runtime, registry);
 	return currentState;
 }
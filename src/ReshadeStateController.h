@@ -32,18 +32,32 @@
 /////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <reshade.hpp>
 #include "CameraPathData.h"
+#include "EffectRegistry.h"
+#include "InterpolationPlan.h"
+#include "PathTimeline.h"
 #include "ReshadeStateSnapshot.h"
+#include "RuntimeStateCache.h"
 
 
 /// <summary>
 /// Class which maintains reshade state snapshots for various paths.
+/// The paths are published as immutable versions: readers, like path playback on the render thread, take a reference to the current version and never
+/// wait for a writer. Writers are serialized by _writeMutex, build a new version with copies of the paths they change and swap it in. A version is
+/// destroyed when the last reader holding it lets go of it.
 /// </summary>
 class ReshadeStateController
 {
 public:
+	ReshadeStateController();
+
 	void removeCameraPath(int pathIndex);
 	void addCameraPath();
 	void appendStateSnapshotToPath(int pathIndex, reshade::api::effect_runtime* runtime);
@@ -56,14 +70,113 @@ public:
 	void setReshadeState(int pathIndex, int stateIndex, reshade::api::effect_runtime* runtime);
 	void clearPaths();
 	int numberOfSnapshotsOnPath(int pathIndex);
+	size_t calculateMemoryUsageOfPath(int pathIndex);
+	/// <summary>
+	/// Writes the reshade state snapshots of all paths to the file specified. Returns true if succeeded.
+	/// </summary>
+	bool savePaths(const std::string& filename);
+	/// <summary>
+	/// Replaces all paths with the ones in the file specified. Returns true if succeeded. The handles of the loaded snapshots are migrated to the
+	/// current runtime the first time a snapshot is used.
+	/// </summary>
+	bool loadPaths(const std::string& filename);
+	void setStateInterpolationMode(StateInterpolationMode mode);
+	StateInterpolationMode getStateInterpolationMode();
+	/// <summary>
+	/// Fills lastFrame with the runtime calls made and skipped during the last frame of path playback and total with the ones since the start, summed over all runtimes.
+	/// </summary>
+	void getRuntimeCallStatistics(RuntimeCallStatistics& lastFrame, RuntimeCallStatistics& total);
+	/// <summary>
+	/// Bakes a timeline of the path at pathIndex with the segment durations specified (in seconds, one per segment) and plays it back from the next present
+	/// on, replacing the timeline being played back, if any. The timeline isn't affected by later edits of the path. Returns false if the path doesn't
+	/// exist or the durations don't match its segments.
+	/// </summary>
+	bool startTimelinePlayback(int pathIndex, const std::vector<float>& segmentDurations);
+	void stopTimelinePlayback();
+	/// <summary>
+	/// Applies the state of the timeline being played back for the time elapsed since its start. Has to be called every present. The timeline is stopped
+	/// after its end has been applied.
+	/// </summary>
+	void applyTimeline(reshade::api::effect_runtime* runtime);
+	/// <summary>
+	/// Returns true if a timeline is being played back, with its elapsed time and duration in seconds and the bytes used by it.
+	/// </summary>
+	bool getTimelineProgress(double& elapsedSeconds, double& durationSeconds, size_t& memoryUsage);
 
-	int numberOfPaths() { return _cameraPathsData.size(); }
+	int numberOfPaths() { return _cameraPaths.load()->size(); }
 
 private:
-	std::vector<CameraPathData> _cameraPathsData;
-	std::mutex _apiMutex;
+	std::atomic<std::shared_ptr<const CameraPaths>> _cameraPaths;
+	std::atomic<StateInterpolationMode> _stateInterpolationMode = StateInterpolationMode::MonotoneCubic;
+	std::atomic<bool> _hasUnmigratedHandles = false;			// set when paths are loaded from a file, until they're migrated to a runtime
+	// serializes the writers of _cameraPaths, and guards the effect registries as snapshots are obtained by writers. Lock before _playbackMutex.
+	std::mutex _writeMutex;
+	// per runtime its techniques and uniforms, rebuilt when its effects are reloaded
+	std::unordered_map<reshade::api::effect_runtime*, EffectRegistry> _effectRegistryPerRuntime;
+
+	// guards the playback state below. Only the render thread plays back paths, so it's uncontended unless the caches are invalidated.
+	std::mutex _playbackMutex;
+	// per runtime the values last written to it by path playback
+	std::unordered_map<reshade::api::effect_runtime*, RuntimeStateCache> _stateCachePerRuntime;
+	// the plan for the segment last interpolated. Playback interpolates the same segment for many frames in a row, so it's compiled once per segment.
+	// The path it was compiled from is kept alive, so a changed path is always a different object and the plan is recompiled.
+	InterpolationPlan _interpolationPlan;
+	std::shared_ptr<const CameraPathData> _planPath;
+	int _planFromStateIndex = -1;
+	int _planToStateIndex = -1;
+	StateInterpolationMode _planMode = StateInterpolationMode::Linear;
+	// the timeline being played back. What it was baked from is kept to bake it again when the handles change: the version of the path it was
+	// started with, which is migrated along with the paths, so later edits of the path don't affect it. _timelinePath is guarded by _writeMutex.
+	PathTimeline _timeline;
+	std::shared_ptr<const CameraPathData> _timelinePath;
+	std::vector<float> _timelineSegmentDurations;
+	StateInterpolationMode _timelineMode = StateInterpolationMode::Linear;
+	std::chrono::steady_clock::time_point _timelineStartTime;
+	bool _hasTimelineStarted = false;
+	std::atomic<bool> _isTimelinePlaying = false;		// read without lock every present
 
-	CameraPathData& getCameraPath(int pathIndex);
+	/// <summary>
+	/// Returns the path at pathIndex in the current version, or nullptr if there's no such path.
+	/// </summary>
+	std::shared_ptr<const CameraPathData> getCameraPath(int pathIndex);
+	/// <summary>
+	/// Returns a copy of the path at pathIndex in the current version to change and publish with publishCameraPath, or nullptr if there's no such path.
+	/// Call with _writeMutex locked.
+	/// </summary>
+	std::shared_ptr<CameraPathData> copyCameraPath(int pathIndex);
+	/// <summary>
+	/// Publishes a new version in which the path at pathIndex is replaced with path. Call with _writeMutex locked.
+	/// </summary>
+	void publishCameraPath(int pathIndex, std::shared_ptr<const CameraPathData> path);
+	/// <summary>
+	/// Publishes a new version in which the handles of all paths are migrated to the effects loaded in runtime, using its registry and currentState.
+	/// The path of the timeline being played back is migrated with them. Returns the number of effect states which couldn't be migrated as their effect isn't loaded. Call with _writeMutex locked.
+	/// </summary>
+	size_t publishMigratedCameraPaths(reshade::api::effect_runtime* runtime, const ReshadeStateSnapshot& currentState);
+	/// <summary>
+	/// Migrates the handles of the snapshots to the runtime specified if they were loaded from a file and haven't been migrated yet. Call without locks.
+	/// Returns true if the paths have been migrated since the caller last saw them, so it has to take them again.
+	/// </summary>
+	bool migrateHandlesIfNeeded(reshade::api::effect_runtime* runtime);
+	/// <summary>
+	/// Returns the path with the index specified, with its handles migrated to the runtime specified. Call without locks.
+	/// </summary>
+	std::shared_ptr<const CameraPathData> getMigratedCameraPath(int pathIndex, reshade::api::effect_runtime* runtime);
+	/// <summary>
+	/// Invalidates the caches of all runtimes, as the handles they contain aren't valid anymore. Call with _writeMutex locked, locks _playbackMutex.
+	/// </summary>
+	void invalidateStateCaches();
+	/// <summary>
+	/// Bakes the timeline being played back again from its migrated path, as the handles in its plans aren't valid anymore. Keeps its start time.
+	/// Call with _writeMutex locked, locks _playbackMutex.
+	/// </summary>
+	void rebakeTimeline();
+	/// <summary>
+	/// Stops the timeline being played back, if any. Call with _writeMutex locked, locks _playbackMutex.
+	/// </summary>
+	void clearTimeline();
+	/// <summary>
+	/// Obtains the current state of the runtime specified, using its effect registry. The registry is built first if it's empty. Call with _writeMutex locked.
+	/// </summary>
 	ReshadeStateSnapshot getCurrentReshadeStateSnapshot(reshade::api::effect_runtime* runtime);
 };
-
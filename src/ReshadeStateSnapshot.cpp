@@ -33,229 +33,297 @@
 
 #include "ReshadeStateSnapshot.h"
 
-#include <ranges>
+#include <algorithm>
 #include <unordered_set>
-#include <unordered_map>
 
 #include "EffectState.h"
+#include "EffectStatePool.h"
+#include "HandleMigration.h"
+#include "NameTable.h"
 #include "Utils.h"
 
 
-void ReshadeStateSnapshot::logContents()
+namespace
 {
-	reshade::log_message(reshade::log_level::info, "\tTechniques: ");
-	for(auto& kvp : _techniqueEnabledPerName)
+	/// <summary>
+	/// Returns the index of the effect with the name id specified in the effects specified, which are sorted on name id, or -1 if not found
+	/// </summary>
+	bool hasLowerNameId(const std::shared_ptr<const EffectState>& effect, uint32_t nameId)
 	{
-		reshade::log_message(reshade::log_level::info, IGCS::Utils::formatString("\t\t%s. Enabled: %s", kvp.first.c_str(), kvp.second ? "true" : "false").c_str());
+		return effect->nameId() < nameId;
 	}
 
-	reshade::log_message(reshade::log_level::info, "\tEffects: ");
-	for(const auto& effectName : _effectStatePerEffectName | std::views::keys)
+
+	int findEffect(const std::vector<std::shared_ptr<const EffectState>>& effects, uint32_t nameId)
 	{
-		reshade::log_message(reshade::log_level::info, IGCS::Utils::formatString("\t\t%s", effectName.c_str()).c_str());
+		const auto it = std::lower_bound(effects.begin(), effects.end(), nameId, hasLowerNameId);
+		return (it != effects.end() && (*it)->nameId() == nameId) ? (int)(it - effects.begin()) : -1;
 	}
-}
 
 
-void ReshadeStateSnapshot::setUniformIntVariable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, int valueToWrite)
-{
-	if(isEmpty() || !_effectStatePerEffectName.contains(effectName))
+	int findTechnique(const std::vector<uint32_t>& techniqueNameIds, uint32_t nameId)
 	{
-		return;
+		const auto it = std::lower_bound(techniqueNameIds.begin(), techniqueNameIds.end(), nameId);
+		return (it != techniqueNameIds.end() && *it == nameId) ? (int)(it - techniqueNameIds.begin()) : -1;
 	}
-	auto& effectState = _effectStatePerEffectName[effectName];
-	effectState.setUniformIntVariable(runtime, uniformName, valueToWrite);
 }
 
 
-void ReshadeStateSnapshot::setUniformFloatVariable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, float valueToWrite)
+void ReshadeStateSnapshot::logContents() const
 {
-	if(isEmpty() || !_effectStatePerEffectName.contains(effectName))
+	NameTable& nameTable = NameTable::instance();
+	reshade::log_message(reshade::log_level::info, "\tTechniques: ");
+	for(size_t i = 0; i < _techniqueNameIds.size(); i++)
 	{
-		return;
+		reshade::log_message(reshade::log_level::info, IGCS::Utils::formatString("\t\t%s. Enabled: %s", nameTable.getName(_techniqueNameIds[i]).c_str(), isTechniqueEnabled(i) ? "true" : "false").c_str());
+	}
+
+	reshade::log_message(reshade::log_level::info, "\tEffects: ");
+	for(const auto& effectState : _effectStates)
+	{
+		reshade::log_message(reshade::log_level::info, IGCS::Utils::formatString("\t\t%s", nameTable.getName(effectState->nameId()).c_str()).c_str());
 	}
-	auto& effectState = _effectStatePerEffectName[effectName];
-	effectState.setUniformFloatVariable(runtime, uniformName, valueToWrite);
 }
 
 
-void ReshadeStateSnapshot::setUniformFloat2Variable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, float value1ToWrite, float value2ToWrite)
+void ReshadeStateSnapshot::addEffectState(EffectState toAdd)
+{
+	_effectStates.push_back(EffectStatePool::instance().intern(std::move(toAdd)));
+}
+
+
+void ReshadeStateSnapshot::addEffectState(std::shared_ptr<const EffectState> toAdd)
 {
-	if(isEmpty() || !_effectStatePerEffectName.contains(effectName))
+	_effectStates.push_back(std::move(toAdd));
+}
+
+
+void ReshadeStateSnapshot::addTechnique(uint32_t nameId, uint64_t handle, bool isEnabled)
+{
+	const size_t index = _techniqueNameIds.size();
+	_techniqueNameIds.push_back(nameId);
+	_techniqueHandles.push_back(handle);
+	if(index % 64 == 0)
 	{
-		return;
+		_techniqueEnabledBits.push_back(0);
+	}
+	if(isEnabled)
+	{
+		_techniqueEnabledBits[index / 64] |= (uint64_t)1 << (index % 64);
 	}
-	auto& effectState = _effectStatePerEffectName[effectName];
-	effectState.setUniformFloat2Variable(runtime, uniformName, value1ToWrite, value2ToWrite);
 }
 
 
-void ReshadeStateSnapshot::setUniformBoolVariable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, bool valueToWrite)
+void ReshadeStateSnapshot::sortOnNameIds()
 {
-	if(isEmpty() || !_effectStatePerEffectName.contains(effectName))
+	std::stable_sort(_effectStates.begin(), _effectStates.end(), [](const auto& a, const auto& b) { return a->nameId() < b->nameId(); });
+	_effectStates.erase(std::unique(_effectStates.begin(), _effectStates.end(), [](const auto& a, const auto& b) { return a->nameId() == b->nameId(); }),
+						_effectStates.end());
+	std::vector<bool> enabledFlags = getTechniqueEnabledFlags();
+	IGCS::Utils::sortParallelArrays(_techniqueNameIds, _techniqueHandles, enabledFlags);
+	setTechniqueEnabledBits(enabledFlags);
+}
+
+
+std::vector<bool> ReshadeStateSnapshot::getTechniqueEnabledFlags() const
+{
+	std::vector<bool> toReturn(_techniqueNameIds.size());
+	for(size_t i = 0; i < toReturn.size(); i++)
 	{
-		return;
+		toReturn[i] = isTechniqueEnabled(i);
 	}
-	auto& effectState = _effectStatePerEffectName[effectName];
-	effectState.setUniformBoolVariable(runtime, uniformName, valueToWrite);
+	return toReturn;
 }
 
 
-void ReshadeStateSnapshot::addEffectState(EffectState toAdd)
+void ReshadeStateSnapshot::setTechniqueEnabledBits(const std::vector<bool>& enabledFlags)
 {
-	_effectStatePerEffectName.emplace(toAdd.name(), toAdd);
+	_techniqueEnabledBits.assign((enabledFlags.size() + 63) / 64, 0);
+	for(size_t i = 0; i < enabledFlags.size(); i++)
+	{
+		if(enabledFlags[i])
+		{
+			_techniqueEnabledBits[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
 }
 
 
-void ReshadeStateSnapshot::applyState(reshade::api::effect_runtime* runtime)
+void ReshadeStateSnapshot::applyState(reshade::api::effect_runtime* runtime) const
 {
 	// Apply uniform value state
-	for(auto& it : _effectStatePerEffectName)
+	for(const auto& effectState : _effectStates)
 	{
-		it.second.applyState(runtime);
+		effectState->applyState(runtime);
 	}
 
-	// Apply technique state
-	for(auto& nameIdPair : _techniqueIdPerName)
+	// Apply technique state. Techniques loaded from a file have no handle until the state has been migrated.
+	for(size_t i = 0; i < _techniqueHandles.size(); i++)
 	{
-		runtime->set_technique_state(reshade::api::effect_technique(nameIdPair.second), _techniqueEnabledPerName[nameIdPair.first]);
+		if(0 == _techniqueHandles[i])
+		{
+			continue;
+		}
+		runtime->set_technique_state(reshade::api::effect_technique(_techniqueHandles[i]), isTechniqueEnabled(i));
 	}
 }
 
 
-void ReshadeStateSnapshot::migrateState(const ReshadeStateSnapshot& currentState)
+void ReshadeStateSnapshot::migrateState(HandleMigration& migration)
 {
 	// we have to collect new id's for our collected variables. Do this by using the name and check if they're still there. If so, migrate
 	// the id they had to their new id.
 	// This call can be made in various scenarios, but they have either one of 2 characteristics: 1) there are 0 effects or 2) there are effects but they're changing.
 	// We can safely ignore the first one, as that's the one originating from the call to destroy_effects. All the other scenarios are from update_effects which is
 	// called in on_present and will end up raising the event in multiple scenarios.
-
-	if(currentState.isEmpty())
+	if(migration.isEmpty())
 	{
 		// safely ignore this.
 		return;
 	}
 
-	// now migrate to this new state. 
-	for(auto& nameEffectPair : currentState._effectStatePerEffectName)
+	const ReshadeStateSnapshot& currentState = migration.getCurrentState();
+	// now migrate to this new state. Effects not known to us are kept as they are.
+	for(auto& effectState : _effectStates)
 	{
-		if(!_effectStatePerEffectName.contains(nameEffectPair.first))
-		{
-			// not known. We can ignore it as we don't store uniforms for unknown effects (it's the same as having an effect / technique being disabled).
-			continue;
-		}
-		// it's there, migrate id's
-		EffectState& toMigrate = _effectStatePerEffectName[nameEffectPair.first];
-		toMigrate.migrateIds(nameEffectPair.second);
+		effectState = migration.migrate(effectState);
 	}
 
-	_techniqueIdPerName.clear();
-	// migrate technique ids
-	for(auto& nameIsEnabledPair : currentState._techniqueEnabledPerName)
+	// migrate technique ids. The techniques of the current state are the ones present now. It's a bit nonsense to alter shader files while setting up a path
+	// and reloading the preset, but let's cover all the basis... Techniques we already had keep their enabled state, new ones get the current state and
+	// techniques which are no longer there are dropped. Both are sorted on name id, so we can walk them side by side.
+	std::vector<bool> migratedEnabledFlags(currentState._techniqueNameIds.size());
+	size_t ourIndex = 0;
+	for(size_t i = 0; i < currentState._techniqueNameIds.size(); i++)
 	{
-		// It's a bit nonsense to alter shader files while setting up a path and reloading the preset, but let's cover all the basis... 
-		auto sourceIdsPerName = currentState._techniqueIdPerName;
-		const auto id = sourceIdsPerName[nameIsEnabledPair.first];
-		if(!_techniqueEnabledPerName.contains(nameIsEnabledPair.first))
+		const uint32_t nameId = currentState._techniqueNameIds[i];
+		while(ourIndex < _techniqueNameIds.size() && _techniqueNameIds[ourIndex] < nameId)
 		{
-			// add it, it was not yet known
-			_techniqueEnabledPerName[nameIsEnabledPair.first] = nameIsEnabledPair.second;
+			ourIndex++;
 		}
-		_techniqueIdPerName[nameIsEnabledPair.first] = id;
+		const bool isKnown = ourIndex < _techniqueNameIds.size() && _techniqueNameIds[ourIndex] == nameId;
+		migratedEnabledFlags[i] = isKnown ? isTechniqueEnabled(ourIndex) : currentState.isTechniqueEnabled(i);
 	}
+	_techniqueNameIds = currentState._techniqueNameIds;
+	_techniqueHandles = currentState._techniqueHandles;
+	setTechniqueEnabledBits(migratedEnabledFlags);
+}
+
 
-	// it might be the new state has less techniques than we had in the previous state. Check if there are left over techniques.
-	std::vector<std::string> toRemove;
-	for(auto& nameValuePair : _techniqueEnabledPerName)
+void ReshadeStateSnapshot::obtainReshadeState(reshade::api::effect_runtime* runtime, const EffectRegistry& registry)
+{
+	// read the state of all techniques. If a technique is enabled, grab the values of the uniforms of its effect. We don't store uniforms for effects which have no
+	// enabled technique, as we won't lerp to these values anyway. 
+	const auto& techniques = registry.getTechniques();
+	const auto& effects = registry.getEffects();
+	std::vector<bool> isEffectEnabled(effects.size(), false);
+	_techniqueNameIds.reserve(techniques.size());
+	_techniqueHandles.reserve(techniques.size());
+	for(const auto& technique : techniques)
 	{
-		if(!_techniqueIdPerName.contains(nameValuePair.first))
+		const bool isEnabled = runtime->get_technique_state(reshade::api::effect_technique(technique.handle));
+		if(isEnabled)
 		{
-			// no longer there
-			toRemove.push_back(nameValuePair.first);
+			isEffectEnabled[technique.effectIndex] = true;
 		}
+		addTechnique(technique.nameId, technique.handle, isEnabled);
 	}
 
-	for(auto& it : toRemove)
+	for(size_t i = 0; i < effects.size(); i++)
 	{
-		_techniqueEnabledPerName.erase(it);
+		if(!isEffectEnabled[i])
+		{
+			continue;
+		}
+		EffectState state(effects[i].nameId);
+		state.obtainEffectState(runtime, effects[i]);
+		addEffectState(std::move(state));
 	}
+	sortOnNameIds();
 }
 
 
-void ReshadeStateSnapshot::addTechnique(reshade::api::effect_technique id, std::string name, bool isEnabled)
+void ReshadeStateSnapshot::collectValuePairs(const ReshadeStateSnapshot& snapShotDestination, std::vector<uint64_t>& handles, std::vector<uint64_t>& keys,
+											 std::vector<DirectX::XMFLOAT4A>& fromValues, std::vector<DirectX::XMFLOAT4A>& toValues) const
 {
-	_techniqueEnabledPerName[name] = isEnabled;
-	_techniqueIdPerName.emplace(name, id.handle);
-}
-
-
-void ReshadeStateSnapshot::obtainReshadeState(reshade::api::effect_runtime* runtime)
-{
-	// enumerate techniques. if a technique is enabled, grab the effect name and its uniforms and per uniform its value. We don't store uniforms for effects which have no
-	// enabled technique, as we won't lerp to these values anyway. 
-	std::unordered_set<std::string> effectNamesWithEnabledTechniques;
-	runtime->enumerate_techniques(nullptr, [this, &effectNamesWithEnabledTechniques](reshade::api::effect_runtime* sourceRuntime, reshade::api::effect_technique technique)
+	// traverse our effects and pair their values with the values in snapShotDestination. Both are sorted on name id.
+	size_t destinationIndex = 0;
+	const auto& destinationEffects = snapShotDestination._effectStates;
+	for(const auto& effectState : _effectStates)
 	{
-		const bool isEnabled = sourceRuntime->get_technique_state(technique);
-		char nameBuffer[1024] = { 0 };
-		size_t nameBufferLength = 1024;
-
-		if(isEnabled)
+		while(destinationIndex < destinationEffects.size() && destinationEffects[destinationIndex]->nameId() < effectState->nameId())
 		{
-			// grab the effect name
-			sourceRuntime->get_technique_effect_name(technique, nameBuffer, &nameBufferLength);
-			std::string effectName(nameBuffer);
-			effectNamesWithEnabledTechniques.emplace(effectName);
+			destinationIndex++;
 		}
-
-		memset(nameBuffer, 0, sizeof(char));
-		nameBufferLength = 1024;
-		sourceRuntime->get_technique_name(technique, nameBuffer, &nameBufferLength);
-		const std::string techniqueName(nameBuffer);
-
-		addTechnique(technique, techniqueName, isEnabled);
-	});
-
-	// per effect name, obtain all uniforms.
-	for(const auto it : effectNamesWithEnabledTechniques)
-	{
-		const auto effectName = it;
-		EffectState state(effectName);
-		state.obtainEffectState(runtime);
-		addEffectState(state);
+		if(destinationIndex >= destinationEffects.size() || destinationEffects[destinationIndex]->nameId() != effectState->nameId())
+		{
+			continue;
+		}
+		effectState->collectValuePairs(*destinationEffects[destinationIndex], handles, keys, fromValues, toValues);
 	}
 }
 
 
-void ReshadeStateSnapshot::applyStateFromTo(const ReshadeStateSnapshot& snapShotDestination, float interpolationFactor, reshade::api::effect_runtime* runtime)
+void ReshadeStateSnapshot::collectValues(const std::vector<uint64_t>& keys, const std::vector<DirectX::XMFLOAT4A>& fallbackValues, std::vector<DirectX::XMFLOAT4A>& values) const
 {
-	// traverse our effects and interpolate their values to the values in snapShotDestination using the interpolation factor
-	std::unordered_map<std::string, EffectState> destinationEffectsPerName = snapShotDestination._effectStatePerEffectName;
-	for(auto& nameEffectPair : _effectStatePerEffectName)
+	// keys are ascending, so the effects and their uniforms are walked once, front to back.
+	size_t effectIndex = 0;
+	size_t uniformStartIndex = 0;
+	for(size_t i = 0; i < keys.size(); i++)
 	{
-		if(!destinationEffectsPerName.contains(nameEffectPair.first))
+		const uint32_t effectNameId = (uint32_t)(keys[i] >> 32);
+		const uint32_t uniformNameId = (uint32_t)keys[i];
+		if(effectIndex < _effectStates.size() && _effectStates[effectIndex]->nameId() < effectNameId)
 		{
+			while(effectIndex < _effectStates.size() && _effectStates[effectIndex]->nameId() < effectNameId)
+			{
+				effectIndex++;
+			}
+			uniformStartIndex = 0;
+		}
+		if(effectIndex >= _effectStates.size() || _effectStates[effectIndex]->nameId() != effectNameId)
+		{
+			values.push_back(fallbackValues[i]);
+			continue;
+		}
+		const EffectState& effectState = *_effectStates[effectIndex];
+		const int uniformIndex = effectState.findFloatUniform(uniformNameId, uniformStartIndex);
+		if(uniformIndex < 0)
+		{
+			values.push_back(fallbackValues[i]);
 			continue;
 		}
-		const auto& destinationEffect = destinationEffectsPerName[nameEffectPair.first];
-		nameEffectPair.second.applyStateFromTo(runtime, destinationEffect, interpolationFactor);
+		values.push_back(effectState.getFloatUniformValue(uniformIndex));
+		uniformStartIndex = uniformIndex + 1;
 	}
+}
 
+
+void ReshadeStateSnapshot::collectTechniqueStates(const ReshadeStateSnapshot& snapShotDestination, std::vector<uint64_t>& techniquesToEnable, std::vector<uint64_t>& techniquesToDisable) const
+{
 	// if techniques are enabled in both this snapshot and the destination snapshot, we're going to enable the technique. Otherwise the technique is disabled.
-	std::unordered_map<std::string, bool> destinationTechniqueEnabledPerName = snapShotDestination._techniqueEnabledPerName;
-	for(auto& nameIsEnabledPair : _techniqueEnabledPerName)
+	size_t destinationIndex = 0;
+	const auto& destinationNameIds = snapShotDestination._techniqueNameIds;
+	for(size_t i = 0; i < _techniqueNameIds.size(); i++)
 	{
-		bool newTechniqueState = false;
-
-		if(destinationTechniqueEnabledPerName.contains(nameIsEnabledPair.first))
+		while(destinationIndex < destinationNameIds.size() && destinationNameIds[destinationIndex] < _techniqueNameIds[i])
 		{
-			const auto& destinationIsEnabled = destinationTechniqueEnabledPerName[nameIsEnabledPair.first];
-			newTechniqueState = nameIsEnabledPair.second && destinationIsEnabled;
+			destinationIndex++;
+		}
+		if(0 == _techniqueHandles[i])
+		{
+			// not migrated yet
+			continue;
+		}
+		const bool isInDestination = destinationIndex < destinationNameIds.size() && destinationNameIds[destinationIndex] == _techniqueNameIds[i];
+		if(isInDestination && isTechniqueEnabled(i) && snapShotDestination.isTechniqueEnabled(destinationIndex))
+		{
+			techniquesToEnable.push_back(_techniqueHandles[i]);
+		}
+		else
+		{
+			techniquesToDisable.push_back(_techniqueHandles[i]);
 		}
-
-		const auto id = _techniqueIdPerName[nameIsEnabledPair.first];
-		runtime->set_technique_state(reshade::api::effect_technique(id), newTechniqueState);
 	}
 }
 
@@ -266,27 +334,27 @@ ReshadeStateSnapshot ReshadeStateSnapshot::getNewlyEnabledEffects(const ReshadeS
 	ReshadeStateSnapshot toReturn;
 
 	// techniques
-	for (const auto& [techniqueName, isEnabled] : _techniqueEnabledPerName)
+	for(size_t i = 0; i < _techniqueNameIds.size(); i++)
 	{
-		auto originalKvp = originalSnapshot._techniqueEnabledPerName.find(techniqueName);
-		if(originalKvp == originalSnapshot._techniqueEnabledPerName.end() || (isEnabled && !originalKvp->second))
+		const int originalIndex = findTechnique(originalSnapshot._techniqueNameIds, _techniqueNameIds[i]);
+		const bool isEnabled = isTechniqueEnabled(i);
+		if(originalIndex < 0 || (isEnabled && !originalSnapshot.isTechniqueEnabled(originalIndex)))
 		{
 			// this technique is now enabled or wasn't present in the original and is now present, so copy it over.
-			toReturn._techniqueEnabledPerName[techniqueName] = isEnabled;
-			toReturn._techniqueIdPerName[techniqueName] = _techniqueIdPerName.at(techniqueName);		// id entry is there as we add them together.
+			toReturn.addTechnique(_techniqueNameIds[i], _techniqueHandles[i], isEnabled);
 		}
 	}
 
 	// effects
-	for(const auto& [effectName, effectState] : _effectStatePerEffectName)
+	for(const auto& effectState : _effectStates)
 	{
-		if(!originalSnapshot._effectStatePerEffectName.contains(effectName))
+		if(findEffect(originalSnapshot._effectStates, effectState->nameId()) < 0)
 		{
-			// not found, so it's new in this snapshot, so we have to copy it over.
-			toReturn._effectStatePerEffectName[effectName] = effectState;
+			// not found, so it's new in this snapshot, so we have to copy it over. The state itself is shared, not copied.
+			toReturn._effectStates.push_back(effectState);
 		}
 	}
-
+	// we added in name id order, so the result is already sorted.
 	return toReturn;
 }
 
@@ -295,26 +363,76 @@ void ReshadeStateSnapshot::addNewlyEnabledEffects(const ReshadeStateSnapshot& sn
 {
 	// snapShotWithNewlyEnabledEffectsToCopy contains effects that should be copied to this snapshot. If we already have the effects
 	// we'll skip it, otherwise we'll copy the effects. We'll also set the enabled flags on the techniques if they're set in the snapShotWithNewlyEnabledEffectsToCopy.
+	const auto& source = snapShotWithNewlyEnabledEffectsToCopy;
 
 	// techniques
-	for(const auto& [techniqueName, isEnabled] : snapShotWithNewlyEnabledEffectsToCopy._techniqueEnabledPerName)
+	std::vector<bool> enabledFlags = getTechniqueEnabledFlags();
+	std::vector<uint32_t> addedNameIds;
+	std::vector<uint64_t> addedHandles;
+	std::vector<bool> addedEnabledFlags;
+	for(size_t i = 0; i < source._techniqueNameIds.size(); i++)
 	{
-		auto currentKvp = _techniqueEnabledPerName.find(techniqueName);
-		if(currentKvp == _techniqueEnabledPerName.end() || (isEnabled && !currentKvp->second))
+		const bool isEnabled = source.isTechniqueEnabled(i);
+		const int currentIndex = findTechnique(_techniqueNameIds, source._techniqueNameIds[i]);
+		if(currentIndex < 0)
 		{
-			// this technique is now enabled or wasn't present yet, so copy it over.
-			_techniqueEnabledPerName[techniqueName] = isEnabled;
-			_techniqueIdPerName[techniqueName] = _techniqueIdPerName.at(techniqueName);		// id entry is there as we add them together.
+			// wasn't present yet, so copy it over.
+			addedNameIds.push_back(source._techniqueNameIds[i]);
+			addedHandles.push_back(source._techniqueHandles[i]);
+			addedEnabledFlags.push_back(isEnabled);
 		}
+		else if(isEnabled)
+		{
+			// this technique is now enabled
+			enabledFlags[currentIndex] = true;
+		}
+	}
+	if(!addedNameIds.empty())
+	{
+		_techniqueNameIds.insert(_techniqueNameIds.end(), addedNameIds.begin(), addedNameIds.end());
+		_techniqueHandles.insert(_techniqueHandles.end(), addedHandles.begin(), addedHandles.end());
+		enabledFlags.insert(enabledFlags.end(), addedEnabledFlags.begin(), addedEnabledFlags.end());
+		IGCS::Utils::sortParallelArrays(_techniqueNameIds, _techniqueHandles, enabledFlags);
 	}
+	setTechniqueEnabledBits(enabledFlags);
 
 	// effects
-	for(const auto& [effectName, effectState] : snapShotWithNewlyEnabledEffectsToCopy._effectStatePerEffectName)
+	const size_t numberOfEffects = _effectStates.size();
+	for(const auto& effectState : source._effectStates)
 	{
-		if(!_effectStatePerEffectName.contains(effectName))
+		// only the effects we had are searched, they're the ones which are sorted.
+		const auto end = _effectStates.begin() + numberOfEffects;
+		const auto it = std::lower_bound(_effectStates.begin(), end, effectState->nameId(), hasLowerNameId);
+		if(it == end || (*it)->nameId() != effectState->nameId())
 		{
-			// not found, so it's new in this snapshot, so we have to copy it over.
-			_effectStatePerEffectName[effectName] = effectState;
+			// not found, so it's new in this snapshot, so we have to add it. The state itself is shared, not copied.
+			_effectStates.push_back(effectState);
 		}
 	}
+	if(_effectStates.size() > numberOfEffects)
+	{
+		std::sort(_effectStates.begin(), _effectStates.end(), [](const auto& a, const auto& b) { return a->nameId() < b->nameId(); });
+	}
+}
+
+
+size_t ReshadeStateSnapshot::calculateMemoryUsage() const
+{
+	std::unordered_set<const EffectState*> countedEffectStates;
+	return calculateMemoryUsage(countedEffectStates);
+}
+
+
+size_t ReshadeStateSnapshot::calculateMemoryUsage(std::unordered_set<const EffectState*>& countedEffectStates) const
+{
+	size_t toReturn = sizeof(ReshadeStateSnapshot) + (_effectStates.capacity() * sizeof(std::shared_ptr<const EffectState>)) +
+					  (_techniqueNameIds.capacity() * sizeof(uint32_t)) + (_techniqueHandles.capacity() * sizeof(uint64_t)) + (_techniqueEnabledBits.capacity() * sizeof(uint64_t));
+	for(const auto& effectState : _effectStates)
+	{
+		if(countedEffectStates.insert(effectState.get()).second)
+		{
+			toReturn += effectState->calculateMemoryUsage();
+		}
+	}
+	return toReturn;
 }
@@ -33,44 +33,95 @@
 
 #pragma once
 
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
 #include <reshade.hpp>
-#include <string>
-#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "EffectRegistry.h"
 #include "EffectState.h"
 
+class HandleMigration;
+
 /// <summary>
 /// Defines a reshade state snapshot, which contains all enabled techniques and all uniform variables and their values. 
+/// Effects and techniques are stored in arrays sorted on the id of their name in the NameTable, with the enabled state of the techniques as a bitset, so
+/// a snapshot is a handful of flat arrays and two snapshots are matched by walking their arrays side by side.
+/// The effect states are immutable blocks from the EffectStatePool, shared with all other snapshots containing the same state, so copying a snapshot
+/// only copies references. Changing an effect state replaces the reference with the one of the changed copy.
 /// </summary>
 ///	<remarks>It's not possible to add a mutex to this class as it's contained in the CameraPathData objects for camera paths.</remarks>
 class ReshadeStateSnapshot
 {
 public:
-	void applyState(reshade::api::effect_runtime* runtime);
+	void applyState(reshade::api::effect_runtime* runtime) const;
 
 	/// <summary>
 	/// Will migrate the state contained in this snapshot to the new id's used for variables. Doesn't mgirate variables to new values, only
 	///	id's so we can set the state again using the current id's. Will also remove effects that are no longer enabled, and add new ones that are now enabled. 
+	/// migration is shared by all snapshots migrated after a reload, so effect states shared by snapshots are migrated once.
+	/// </summary>
+	void migrateState(HandleMigration& migration);
+	/// <summary>
+	/// Obtains the state of the techniques and the uniform values of the enabled effects in registry, which has to be built for runtime.
+	/// </summary>
+	void obtainReshadeState(reshade::api::effect_runtime* runtime, const EffectRegistry& registry);
+	/// <summary>
+	/// Appends the handles and keys of the float uniforms of the effects present in both this snapshot and snapShotDestination, with their values in both.
+	/// </summary>
+	void collectValuePairs(const ReshadeStateSnapshot& snapShotDestination, std::vector<uint64_t>& handles, std::vector<uint64_t>& keys,
+						   std::vector<DirectX::XMFLOAT4A>& fromValues, std::vector<DirectX::XMFLOAT4A>& toValues) const;
+	/// <summary>
+	/// Appends to values the value in this snapshot of each float uniform in keys, which have to be ascending (as collected by collectValuePairs). If a
+	/// uniform isn't present in this snapshot, its value in fallbackValues, which runs parallel with keys, is used instead.
+	/// </summary>
+	void collectValues(const std::vector<uint64_t>& keys, const std::vector<DirectX::XMFLOAT4A>& fallbackValues, std::vector<DirectX::XMFLOAT4A>& values) const;
+	/// <summary>
+	/// Appends the handles of our techniques to techniquesToEnable if they're enabled in both this snapshot and snapShotDestination, otherwise to techniquesToDisable.
 	/// </summary>
-	void migrateState(const ReshadeStateSnapshot& currentState);
-	void obtainReshadeState(reshade::api::effect_runtime* runtime);
-	void applyStateFromTo(const ReshadeStateSnapshot& snapShotDestination, float interpolationFactor, reshade::api::effect_runtime* runtime);
+	void collectTechniqueStates(const ReshadeStateSnapshot& snapShotDestination, std::vector<uint64_t>& techniquesToEnable, std::vector<uint64_t>& techniquesToDisable) const;
 	ReshadeStateSnapshot getNewlyEnabledEffects(const ReshadeStateSnapshot& originalSnapshot) const;
 	void addNewlyEnabledEffects(const ReshadeStateSnapshot& snapShotWithNewlyEnabledEffectsToCopy);
+	/// <summary>
+	/// Adds the effect state specified, interning it in the EffectStatePool. Call sortOnNameIds after all effects and techniques have been added.
+	/// </summary>
+	void addEffectState(EffectState toAdd);
+	/// <summary>
+	/// Adds the pooled effect state specified. Call sortOnNameIds after all effects and techniques have been added.
+	/// </summary>
+	void addEffectState(std::shared_ptr<const EffectState> toAdd);
+	/// <summary>
+	/// Adds the technique specified. Call sortOnNameIds after all effects and techniques have been added.
+	/// </summary>
+	void addTechnique(uint32_t nameId, uint64_t handle, bool isEnabled);
+	void sortOnNameIds();
 
-	bool isEmpty() const { return _effectStatePerEffectName.size() <= 0; }
-	int numberOfContainedEffects() { return _effectStatePerEffectName.size(); }
-	void logContents();
-	void setUniformIntVariable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, int valueToWrite);
-	void setUniformFloatVariable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, float valueToWrite);
-	void setUniformFloat2Variable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, float value1ToWrite, float value2ToWrite);
-	void setUniformBoolVariable(reshade::api::effect_runtime* runtime, const std::string& effectName, const std::string& uniformName, bool valueToWrite);
+	bool isEmpty() const { return _effectStates.size() <= 0; }
+	int numberOfContainedEffects() const { return _effectStates.size(); }
+	const std::vector<std::shared_ptr<const EffectState>>& getEffectStates() const { return _effectStates; }
+	const std::vector<uint32_t>& getTechniqueNameIds() const { return _techniqueNameIds; }
+	bool isTechniqueEnabled(size_t index) const { return (_techniqueEnabledBits[index / 64] >> (index % 64)) & 1; }
+	/// <summary>
+	/// Returns the number of bytes used by this snapshot, including the heap memory of its arrays and effect states.
+	/// </summary>
+	size_t calculateMemoryUsage() const;
+	/// <summary>
+	/// Returns the number of bytes used by this snapshot, including the effect states which aren't in countedEffectStates yet. These are added to it, so
+	/// effect states shared by several snapshots are counted once.
+	/// </summary>
+	size_t calculateMemoryUsage(std::unordered_set<const EffectState*>& countedEffectStates) const;
+	void logContents() const;
 
 private:
-	void addEffectState(EffectState toAdd);
-	void addTechnique(reshade::api::effect_technique id, std::string name, bool isEnabled);
+	/// <summary>
+	/// Rebuilds the enabled bitset from the flags specified, which run parallel with _techniqueNameIds.
+	/// </summary>
+	void setTechniqueEnabledBits(const std::vector<bool>& enabledFlags);
+	std::vector<bool> getTechniqueEnabledFlags() const;
 
-	std::unordered_map<std::string, EffectState> _effectStatePerEffectName;
-	std::unordered_map<std::string, uint64_t> _techniqueIdPerName;
-	std::unordered_map<std::string, bool> _techniqueEnabledPerName;
+	std::vector<std::shared_ptr<const EffectState>> _effectStates;		// sorted on nameId
+	std::vector<uint32_t> _techniqueNameIds;		// sorted
+	std::vector<uint64_t> _techniqueHandles;
+	std::vector<uint64_t> _techniqueEnabledBits;
 };
-
@@ -0,0 +1,423 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "ReshadeStateStressTest.h"
+#include "EffectRegistry.h"
+#include "OverlayControl.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <thread>
+
+using namespace std::chrono;
+
+namespace
+{
+	constexpr int NUMBER_OF_SNAPSHOTS_PER_PATH = 8;
+	constexpr int NUMBER_OF_EDITOR_THREADS = 2;
+	constexpr int TEST_DURATION_SECONDS = 10;
+	constexpr int SETUP_TIMEOUT_SECONDS = 5;
+	// the render thread appends a snapshot to the second path every this many presents, the editors remove them again.
+	constexpr uint64_t APPEND_INTERVAL_IN_FRAMES = 4;
+	constexpr int MILLISECONDS_BETWEEN_SAVES = 10;
+	// the path played back by the render thread and the path it appends to. The editors only add and remove paths after these.
+	constexpr int PLAYBACK_PATH_INDEX = 0;
+	constexpr int APPEND_PATH_INDEX = 1;
+	constexpr int NUMBER_OF_FIXED_PATHS = 2;
+	// the paths store floats and interpolate in float, so the played back values are only equal to the expected ones within this margin.
+	constexpr float VALUE_TOLERANCE = 0.001f;
+
+
+	uint64_t currentTicks()
+	{
+		return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+
+	/// <summary>
+	/// The value the checked uniform has in the snapshot with the index specified. Not on a line, so linear and Catmull-Rom interpolation give different values.
+	/// </summary>
+	float knownValueOfSnapshot(int stateIndex)
+	{
+		return (float)((stateIndex * 5) % NUMBER_OF_SNAPSHOTS_PER_PATH);
+	}
+
+
+	/// <summary>
+	/// The value playback has to set for the checked uniform between the snapshot with the index specified and the next one, using the mode specified.
+	/// At the ends of the path the node value itself is the neighbour, like InterpolationPlan does.
+	/// </summary>
+	float expectedValue(int fromStateIndex, float interpolationFactor, StateInterpolationMode mode)
+	{
+		const float p1 = knownValueOfSnapshot(fromStateIndex);
+		const float p2 = knownValueOfSnapshot(fromStateIndex + 1);
+		if(mode == StateInterpolationMode::Linear)
+		{
+			return p1 + (interpolationFactor * (p2 - p1));
+		}
+		const float p0 = fromStateIndex > 0 ? knownValueOfSnapshot(fromStateIndex - 1) : p1;
+		const float p3 = fromStateIndex + 2 < NUMBER_OF_SNAPSHOTS_PER_PATH ? knownValueOfSnapshot(fromStateIndex + 2) : p2;
+		const float t = interpolationFactor;
+		return p1 + (0.5f * (p2 - p0) * t) + ((p0 - (2.5f * p1) + (2.0f * p2) - (0.5f * p3)) * t * t) + (((0.5f * (p3 - p0)) + (1.5f * (p1 - p2))) * t * t * t);
+	}
+}
+
+
+void ReshadeStateStressTest::start(const std::string& outputFolder)
+{
+	bool expected = false;
+	if(!_isRunning.compare_exchange_strong(expected, true))
+	{
+		return;
+	}
+	std::thread t(&ReshadeStateStressTest::run, this, outputFolder);
+	t.detach();
+}
+
+
+void ReshadeStateStressTest::presentCalled(reshade::api::effect_runtime* runtime)
+{
+	switch(_phase)
+	{
+		case ReshadeStateStressTestPhase::Setup:
+			recordPaths(runtime);
+			_phase = ReshadeStateStressTestPhase::Running;
+			break;
+		case ReshadeStateStressTestPhase::Running:
+			playBackFrame(runtime);
+			break;
+		case ReshadeStateStressTestPhase::Done:
+			restoreCheckedUniform(runtime);
+			_phase = ReshadeStateStressTestPhase::Idle;
+			break;
+		default:
+			break;
+	}
+}
+
+
+void ReshadeStateStressTest::run(std::string outputFolder)
+{
+	_numberOfFramesPlayed = 0;
+	_frameTimes.clear();
+	_numberOfEdits = 0;
+	_numberOfSaves = 0;
+	_numberOfLoads = 0;
+	_numberOfReads = 0;
+	_numberOfInconsistencies = 0;
+	// the editors switch between these two modes, so the played back values are checked against both. They start from linear.
+	_controller.setStateInterpolationMode(StateInterpolationMode::Linear);
+
+	// the paths are recorded on the render thread, as snapshots have to be obtained there.
+	_phase = ReshadeStateStressTestPhase::Setup;
+	const uint64_t setupEndTimeTicks = currentTicks() + SETUP_TIMEOUT_SECONDS * 1000;
+	while(_phase == ReshadeStateStressTestPhase::Setup && currentTicks() < setupEndTimeTicks)
+	{
+		std::this_thread::sleep_for(milliseconds(10));
+	}
+	if(_phase != ReshadeStateStressTestPhase::Running)
+	{
+		_phase = ReshadeStateStressTestPhase::Idle;
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Reshade state stress test: no present was called within %d seconds, test aborted.", SETUP_TIMEOUT_SECONDS);
+		OverlayControl::addNotification("Reshade state stress test aborted: no frames were presented.");
+		_isRunning = false;
+		return;
+	}
+
+	const std::string pathsFilename = (std::filesystem::path(outputFolder) / "ReshadeStateStressTest.bin").string();
+	const uint64_t endTimeTicks = currentTicks() + TEST_DURATION_SECONDS * 1000;
+	std::vector<std::thread> threads;
+	for(int i = 0; i < NUMBER_OF_EDITOR_THREADS; i++)
+	{
+		threads.emplace_back(&ReshadeStateStressTest::editPaths, this, endTimeTicks, i);
+	}
+	threads.emplace_back(&ReshadeStateStressTest::saveAndLoadPaths, this, endTimeTicks, pathsFilename);
+	threads.emplace_back(&ReshadeStateStressTest::readPaths, this, endTimeTicks);
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+	_phase = ReshadeStateStressTestPhase::Done;
+
+	std::vector<double> frameTimes;
+	uint64_t numberOfFramesPlayed = 0;
+	{
+		std::scoped_lock lock(_frameTimesMutex);
+		frameTimes = _frameTimes;
+		numberOfFramesPlayed = _numberOfFramesPlayed;
+	}
+	double averageFrameTime = 0.0;
+	double p99FrameTime = 0.0;
+	double maxFrameTime = 0.0;
+	if(!frameTimes.empty())
+	{
+		for(const double frameTime : frameTimes)
+		{
+			averageFrameTime += frameTime;
+		}
+		averageFrameTime /= (double)frameTimes.size();
+		std::sort(frameTimes.begin(), frameTimes.end());
+		p99FrameTime = frameTimes[(size_t)((double)(frameTimes.size() - 1) * 0.99)];
+		maxFrameTime = frameTimes.back();
+	}
+
+	IGCS::Utils::logLineToReshade(reshade::log_level::info, "Reshade state stress test: %llu frames played back, playback time %.3f ms average, %.3f ms 99th percentile, %.3f ms max. "
+								  "%llu edits, %llu saves, %llu loads, %llu reads, %llu inconsistencies.", numberOfFramesPlayed, averageFrameTime, p99FrameTime, maxFrameTime,
+								  _numberOfEdits.load(), _numberOfSaves.load(), _numberOfLoads.load(), _numberOfReads.load(), _numberOfInconsistencies.load());
+
+	const std::string filename = (std::filesystem::path(outputFolder) / "ReshadeStateStressTest.json").string();
+	FILE* resultsFile = nullptr;
+	if(fopen_s(&resultsFile, filename.c_str(), "w") != 0 || nullptr == resultsFile)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Reshade state stress test: couldn't write results to %s", filename.c_str());
+	}
+	else
+	{
+		fprintf(resultsFile, "{\n\t\"durationSeconds\": %d,\n\t\"numberOfEditorThreads\": %d,\n\t\"numberOfSnapshotsPerPath\": %d,\n\t\"numberOfFramesPlayed\": %llu,\n"
+				"\t\"averagePlaybackMilliseconds\": %.3f,\n\t\"p99PlaybackMilliseconds\": %.3f,\n\t\"maxPlaybackMilliseconds\": %.3f,\n\t\"numberOfEdits\": %llu,\n"
+				"\t\"numberOfSaves\": %llu,\n\t\"numberOfLoads\": %llu,\n\t\"numberOfReads\": %llu,\n\t\"numberOfInconsistencies\": %llu\n}\n",
+				TEST_DURATION_SECONDS, NUMBER_OF_EDITOR_THREADS, NUMBER_OF_SNAPSHOTS_PER_PATH, numberOfFramesPlayed, averageFrameTime, p99FrameTime, maxFrameTime,
+				_numberOfEdits.load(), _numberOfSaves.load(), _numberOfLoads.load(), _numberOfReads.load(), _numberOfInconsistencies.load());
+		fclose(resultsFile);
+	}
+	OverlayControl::addNotification(0 == _numberOfInconsistencies ? "Reshade state stress test completed. Results written to " + filename
+																  : "Reshade state stress test found inconsistencies. Please check the ReShade log.");
+	_controller.clearPaths();
+	// the render thread restores the checked uniform at its next present and then goes idle.
+	const uint64_t restoreEndTimeTicks = currentTicks() + SETUP_TIMEOUT_SECONDS * 1000;
+	while(_phase == ReshadeStateStressTestPhase::Done && currentTicks() < restoreEndTimeTicks)
+	{
+		std::this_thread::sleep_for(milliseconds(10));
+	}
+	_phase = ReshadeStateStressTestPhase::Idle;
+	_isRunning = false;
+}
+
+
+void ReshadeStateStressTest::recordPaths(reshade::api::effect_runtime* runtime)
+{
+	// the first float uniform of an effect with an enabled technique is in every snapshot, so it gets a known value per snapshot. Only the x component
+	// is set and checked, as every float type has it.
+	EffectRegistry registry;
+	registry.build(runtime);
+	_checkedUniformHandle = 0;
+	for(const auto& technique : registry.getTechniques())
+	{
+		const auto& floatUniforms = registry.getEffects()[technique.effectIndex].floatUniforms;
+		if(!floatUniforms.empty() && runtime->get_technique_state(reshade::api::effect_technique(technique.handle)))
+		{
+			_checkedUniformHandle = floatUniforms.front().handle;
+			break;
+		}
+	}
+	if(0 == _checkedUniformHandle)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::warning, "Reshade state stress test: no enabled effect has a float uniform, the played back values aren't checked.");
+	}
+	else
+	{
+		runtime->get_uniform_value_float(reshade::api::effect_uniform_variable(_checkedUniformHandle), _checkedUniformOriginalValues, 4);
+	}
+
+	_controller.clearPaths();
+	for(int i = 0; i < NUMBER_OF_FIXED_PATHS; i++)
+	{
+		_controller.addCameraPath();
+		for(int j = 0; j < NUMBER_OF_SNAPSHOTS_PER_PATH; j++)
+		{
+			if(0 != _checkedUniformHandle)
+			{
+				runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(_checkedUniformHandle), knownValueOfSnapshot(j), _checkedUniformOriginalValues[1],
+												 _checkedUniformOriginalValues[2], _checkedUniformOriginalValues[3]);
+			}
+			_controller.appendStateSnapshotToPath(i, runtime);
+		}
+	}
+	restoreCheckedUniform(runtime);
+}
+
+
+void ReshadeStateStressTest::playBackFrame(reshade::api::effect_runtime* runtime)
+{
+	// what the camera tools do every present when playing back a path, for all segments at once, plus a timeline if one is playing.
+	// every segment sets the checked uniform, so it's checked after each one, outside the time measured.
+	const float interpolationFactor = (float)(_numberOfFramesPlayed % 100) / 100.0f;
+	double frameTime = 0.0;
+	for(int i = 0; i < NUMBER_OF_SNAPSHOTS_PER_PATH - 1; i++)
+	{
+		const auto segmentStartTime = steady_clock::now();
+		_controller.setReshadeState(PLAYBACK_PATH_INDEX, i, i + 1, interpolationFactor, runtime);
+		frameTime += duration<double, std::milli>(steady_clock::now() - segmentStartTime).count();
+		checkPlayedBackValue(runtime, i, interpolationFactor);
+	}
+	const auto startTime = steady_clock::now();
+	_controller.setReshadeState(PLAYBACK_PATH_INDEX, (int)(_numberOfFramesPlayed % NUMBER_OF_SNAPSHOTS_PER_PATH), runtime);
+	_controller.applyTimeline(runtime);
+	frameTime += duration<double, std::milli>(steady_clock::now() - startTime).count();
+
+	if(0 == (_numberOfFramesPlayed % APPEND_INTERVAL_IN_FRAMES))
+	{
+		_controller.appendStateSnapshotToPath(APPEND_PATH_INDEX, runtime);
+	}
+	std::scoped_lock lock(_frameTimesMutex);
+	_frameTimes.push_back(frameTime);
+	_numberOfFramesPlayed++;
+}
+
+
+void ReshadeStateStressTest::checkPlayedBackValue(reshade::api::effect_runtime* runtime, int fromStateIndex, float interpolationFactor)
+{
+	if(0 == _checkedUniformHandle)
+	{
+		return;
+	}
+	float values[4] = {};
+	runtime->get_uniform_value_float(reshade::api::effect_uniform_variable(_checkedUniformHandle), values, 4);
+	// the mode can be switched by an editor while we play back, so either mode's value is fine, but it has to be one of a path with the known values.
+	const float linearValue = expectedValue(fromStateIndex, interpolationFactor, StateInterpolationMode::Linear);
+	const float catmullRomValue = expectedValue(fromStateIndex, interpolationFactor, StateInterpolationMode::CatmullRom);
+	if(std::abs(values[0] - linearValue) > VALUE_TOLERANCE && std::abs(values[0] - catmullRomValue) > VALUE_TOLERANCE)
+	{
+		reportInconsistency("a played back value isn't the interpolation of the recorded values");
+	}
+}
+
+
+void ReshadeStateStressTest::restoreCheckedUniform(reshade::api::effect_runtime* runtime)
+{
+	if(0 == _checkedUniformHandle)
+	{
+		return;
+	}
+	runtime->set_uniform_value_float(reshade::api::effect_uniform_variable(_checkedUniformHandle), _checkedUniformOriginalValues[0], _checkedUniformOriginalValues[1],
+									 _checkedUniformOriginalValues[2], _checkedUniformOriginalValues[3]);
+}
+
+
+void ReshadeStateStressTest::editPaths(uint64_t endTimeTicks, int threadIndex)
+{
+	const std::vector<float> segmentDurations(NUMBER_OF_SNAPSHOTS_PER_PATH - 1, 0.5f);
+	const StateInterpolationMode modes[] = { StateInterpolationMode::Linear, StateInterpolationMode::CatmullRom };
+	int round = threadIndex;
+	while(currentTicks() < endTimeTicks)
+	{
+		_controller.addCameraPath();
+		const int numberOfPaths = _controller.numberOfPaths();
+		if(numberOfPaths > NUMBER_OF_FIXED_PATHS)
+		{
+			_controller.removeCameraPath(numberOfPaths - 1);
+		}
+		const int numberOfSnapshotsAppended = _controller.numberOfSnapshotsOnPath(APPEND_PATH_INDEX);
+		if(numberOfSnapshotsAppended > 1)
+		{
+			_controller.removeStateSnapshotFromPath(APPEND_PATH_INDEX, numberOfSnapshotsAppended - 1);
+		}
+		if(!_controller.startTimelinePlayback(PLAYBACK_PATH_INDEX, segmentDurations))
+		{
+			reportInconsistency("a timeline couldn't be started for the playback path");
+		}
+		if(0 == (round % 4))
+		{
+			_controller.stopTimelinePlayback();
+		}
+		_controller.setStateInterpolationMode(modes[round % 2]);
+		_numberOfEdits++;
+		round++;
+	}
+	_controller.stopTimelinePlayback();
+}
+
+
+void ReshadeStateStressTest::saveAndLoadPaths(uint64_t endTimeTicks, const std::string& filename)
+{
+	while(currentTicks() < endTimeTicks)
+	{
+		if(!_controller.savePaths(filename))
+		{
+			reportInconsistency("the paths couldn't be saved");
+			return;
+		}
+		_numberOfSaves++;
+		// a load makes the render thread migrate the handles of all paths before its next playback.
+		if(!_controller.loadPaths(filename))
+		{
+			reportInconsistency("the saved paths couldn't be loaded");
+			return;
+		}
+		_numberOfLoads++;
+		std::this_thread::sleep_for(milliseconds(MILLISECONDS_BETWEEN_SAVES));
+	}
+}
+
+
+void ReshadeStateStressTest::readPaths(uint64_t endTimeTicks)
+{
+	while(currentTicks() < endTimeTicks)
+	{
+		// the editors never touch the fixed paths as a whole and never empty the append path, and every version saved has them, so whatever version
+		// we read has to have them.
+		if(_controller.numberOfPaths() < NUMBER_OF_FIXED_PATHS)
+		{
+			reportInconsistency("a fixed path is missing");
+		}
+		if(_controller.numberOfSnapshotsOnPath(PLAYBACK_PATH_INDEX) != NUMBER_OF_SNAPSHOTS_PER_PATH)
+		{
+			reportInconsistency("the playback path doesn't have all its snapshots");
+		}
+		if(_controller.numberOfSnapshotsOnPath(APPEND_PATH_INDEX) < 1)
+		{
+			reportInconsistency("the append path is empty");
+		}
+		_controller.calculateMemoryUsageOfPath(PLAYBACK_PATH_INDEX);
+		double elapsedSeconds = 0.0;
+		double durationSeconds = 0.0;
+		size_t memoryUsage = 0;
+		_controller.getTimelineProgress(elapsedSeconds, durationSeconds, memoryUsage);
+		RuntimeCallStatistics lastFrame;
+		RuntimeCallStatistics total;
+		_controller.getRuntimeCallStatistics(lastFrame, total);
+		_numberOfReads++;
+	}
+}
+
+
+void ReshadeStateStressTest::reportInconsistency(const char* description)
+{
+	// logged once per test, as it would otherwise flood the log.
+	if(0 == _numberOfInconsistencies++)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Reshade state stress test: %s.", description);
+	}
+}
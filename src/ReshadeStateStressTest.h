@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <reshade.hpp>
+#include "ConstantsEnums.h"
+#include "ReshadeStateController.h"
+
+/// <summary>
+/// Stress test of the camera path versions of ReshadeStateController: the render thread plays back a path every present, like the camera tools do,
+/// while background threads edit the paths, start and stop timelines, save and load them (which makes the render thread migrate the handles) and read
+/// them, for a fixed time. The test uses its own controller, with paths recorded from the current state of the runtime, except for one float uniform
+/// of an enabled effect which gets a known value per snapshot and is restored when the test is done. It checks the invariants the edits keep (the
+/// played back path never changes, so it's always there with the same number of snapshots and every value played back is the interpolation of the
+/// known values) and measures the time the render thread spends on playback per present, which shouldn't grow with the writers as readers never
+/// wait for them. Results are written as JSON to the output folder.
+/// </summary>
+class ReshadeStateStressTest
+{
+public:
+	ReshadeStateStressTest() = default;
+	~ReshadeStateStressTest() = default;
+
+	/// <summary>
+	/// Starts the test, which runs on background threads and on the render thread through presentCalled, writing the results to outputFolder. Ignored
+	/// if a test is already running.
+	/// </summary>
+	/// <param name="outputFolder"></param>
+	void start(const std::string& outputFolder);
+	bool isRunning() { return _isRunning; }
+	uint64_t numberOfInconsistencies() { return _numberOfInconsistencies; }
+	/// <summary>
+	/// Has to be called every present. Records the paths at the start of the test, plays them back while it runs and restores the checked uniform when it's done.
+	/// </summary>
+	void presentCalled(reshade::api::effect_runtime* runtime);
+
+private:
+	void run(std::string outputFolder);
+	void recordPaths(reshade::api::effect_runtime* runtime);
+	void playBackFrame(reshade::api::effect_runtime* runtime);
+	void checkPlayedBackValue(reshade::api::effect_runtime* runtime, int fromStateIndex, float interpolationFactor);
+	void restoreCheckedUniform(reshade::api::effect_runtime* runtime);
+	void editPaths(uint64_t endTimeTicks, int threadIndex);
+	void saveAndLoadPaths(uint64_t endTimeTicks, const std::string& filename);
+	void readPaths(uint64_t endTimeTicks);
+	void reportInconsistency(const char* description);
+
+	std::atomic<bool> _isRunning = false;
+	std::atomic<ReshadeStateStressTestPhase> _phase = ReshadeStateStressTestPhase::Idle;
+	ReshadeStateController _controller;
+	// written by the render thread only
+	uint64_t _numberOfFramesPlayed = 0;
+	// the uniform which gets a known value per recorded snapshot, 0 if no effect is enabled. Its value from before the test is restored when it's done.
+	uint64_t _checkedUniformHandle = 0;
+	float _checkedUniformOriginalValues[4] = {};
+	// the playback time per present in milliseconds, read by the test thread when the test is done
+	std::mutex _frameTimesMutex;
+	std::vector<double> _frameTimes;
+	std::atomic<uint64_t> _numberOfEdits = 0;
+	std::atomic<uint64_t> _numberOfSaves = 0;
+	std::atomic<uint64_t> _numberOfLoads = 0;
+	std::atomic<uint64_t> _numberOfReads = 0;
+	std::atomic<uint64_t> _numberOfInconsistencies = 0;
+};
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "RuntimeStateCache.h"
+#include <cstring>
+
+namespace
+{
+	constexpr uint8_t TECHNIQUE_STATE_UNKNOWN = 0;
+	constexpr uint8_t TECHNIQUE_STATE_DISABLED = 1;
+	constexpr uint8_t TECHNIQUE_STATE_ENABLED = 2;
+}
+
+
+uint32_t RuntimeStateCache::getUniformSlot(uint64_t handle)
+{
+	const auto [it, isAdded] = _slotPerUniformHandle.try_emplace(handle, (uint32_t)_uniformValues.size());
+	if(isAdded)
+	{
+		_uniformValues.emplace_back();
+		_isUniformValueKnown.push_back(false);
+	}
+	return it->second;
+}
+
+
+uint32_t RuntimeStateCache::getTechniqueSlot(uint64_t handle)
+{
+	const auto [it, isAdded] = _slotPerTechniqueHandle.try_emplace(handle, (uint32_t)_techniqueStates.size());
+	if(isAdded)
+	{
+		_techniqueStates.push_back(TECHNIQUE_STATE_UNKNOWN);
+	}
+	return it->second;
+}
+
+
+bool RuntimeStateCache::updateUniformValue(uint32_t slot, const DirectX::XMFLOAT4A& value)
+{
+	// bitwise, so a value is only skipped if it's exactly what we've written.
+	if(_isUniformValueKnown[slot] && std::memcmp(&_uniformValues[slot], &value, sizeof(DirectX::XMFLOAT4A)) == 0)
+	{
+		return false;
+	}
+	_uniformValues[slot] = value;
+	_isUniformValueKnown[slot] = true;
+	return true;
+}
+
+
+bool RuntimeStateCache::updateTechniqueState(uint32_t slot, bool isEnabled)
+{
+	const uint8_t state = isEnabled ? TECHNIQUE_STATE_ENABLED : TECHNIQUE_STATE_DISABLED;
+	if(_techniqueStates[slot] == state)
+	{
+		return false;
+	}
+	_techniqueStates[slot] = state;
+	return true;
+}
+
+
+void RuntimeStateCache::invalidateValues()
+{
+	_isUniformValueKnown.assign(_isUniformValueKnown.size(), false);
+	_techniqueStates.assign(_techniqueStates.size(), TECHNIQUE_STATE_UNKNOWN);
+}
+
+
+void RuntimeStateCache::invalidate()
+{
+	_slotPerUniformHandle.clear();
+	_uniformValues.clear();
+	_isUniformValueKnown.clear();
+	_slotPerTechniqueHandle.clear();
+	_techniqueStates.clear();
+	_generation++;
+}
+
+
+void RuntimeStateCache::recordFrame(const RuntimeCallStatistics& frameStatistics)
+{
+	_lastFrameStatistics = frameStatistics;
+	_totalStatistics.uniformWrites += frameStatistics.uniformWrites;
+	_totalStatistics.uniformWritesSkipped += frameStatistics.uniformWritesSkipped;
+	_totalStatistics.techniqueWrites += frameStatistics.techniqueWrites;
+	_totalStatistics.techniqueWritesSkipped += frameStatistics.techniqueWritesSkipped;
+}
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// The statistics of the runtime calls made by applying an interpolation plan: the calls issued and the calls skipped because the value or state
+/// was already set.
+/// </summary>
+struct RuntimeCallStatistics
+{
+	uint64_t uniformWrites = 0;
+	uint64_t uniformWritesSkipped = 0;
+	uint64_t techniqueWrites = 0;
+	uint64_t techniqueWritesSkipped = 0;
+
+	uint64_t callsSaved() const { return uniformWritesSkipped + techniqueWritesSkipped; }
+};
+
+
+/// <summary>
+/// Shadow copy of the uniform values and technique states last written to a runtime by path playback, so values which didn't change since the
+/// previous frame aren't written again. Handles are mapped to slots once, when an interpolation plan is bound to the cache, so checking a value
+/// during playback is an array access. The generation changes when the slots are invalidated (e.g. after a reload, as handles can be reused),
+/// so plans know they have to map their handles again.
+/// </summary>
+class RuntimeStateCache
+{
+public:
+	RuntimeStateCache() = default;
+
+	uint32_t getUniformSlot(uint64_t handle);
+	uint32_t getTechniqueSlot(uint64_t handle);
+	/// <summary>
+	/// Returns true if value differs from the value last written to the uniform in the slot specified, and records it as the last written value.
+	/// </summary>
+	bool updateUniformValue(uint32_t slot, const DirectX::XMFLOAT4A& value);
+	/// <summary>
+	/// Returns true if isEnabled differs from the state last written to the technique in the slot specified, and records it as the last written state.
+	/// </summary>
+	bool updateTechniqueState(uint32_t slot, bool isEnabled);
+	/// <summary>
+	/// Forgets the values and states written, e.g. because they've been written bypassing the cache. Slots stay valid.
+	/// </summary>
+	void invalidateValues();
+	/// <summary>
+	/// Forgets everything, including the slots. Has to be called when handles change, e.g. after a reload of the effects.
+	/// </summary>
+	void invalidate();
+	/// <summary>
+	/// Records the statistics of applying a plan, which is done once per frame during path playback.
+	/// </summary>
+	void recordFrame(const RuntimeCallStatistics& frameStatistics);
+
+	uint32_t getGeneration() const { return _generation; }
+	const RuntimeCallStatistics& getLastFrameStatistics() const { return _lastFrameStatistics; }
+	const RuntimeCallStatistics& getTotalStatistics() const { return _totalStatistics; }
+
+private:
+	uint32_t _generation = 0;
+	std::unordered_map<uint64_t, uint32_t> _slotPerUniformHandle;
+	std::vector<DirectX::XMFLOAT4A> _uniformValues;
+	std::vector<bool> _isUniformValueKnown;
+	std::unordered_map<uint64_t, uint32_t> _slotPerTechniqueHandle;
+	// per technique slot: 0 unknown, 1 disabled, 2 enabled
+	std::vector<uint8_t> _techniqueStates;
+	RuntimeCallStatistics _lastFrameStatistics;
+	RuntimeCallStatistics _totalStatistics;
+};
@@ -38,11 +38,10 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "std_image_write.h"
 #include "Utils.h"
+#include "ImageFileIO.h"
 #include <thread>
 #include <random>
 
-#include "fpng.h"
-
 ScreenshotController::ScreenshotController(CameraToolsConnector& connector) : _cameraToolsConnector(connector)
 {
 }
@@ -504,7 +503,15 @@ void ScreenshotController::saveShotToFile(std::string destinationFolder, const s
 	{
 	case ScreenshotFiletype::Bmp:
 		filename = IGCS::Utils::formatString("%s\\%d.bmp", destinationFolder.c_str(), frameNumber);
-		stbi_write_bmp(filename.c_str(), _framebufferWidth, _framebufferHeight, 3, data.data()) != 0;
+		IGCS::ImageFileIO::writeBmp(filename, data.data(), _framebufferWidth, _framebufferHeight);
+		break;
+	case ScreenshotFiletype::Tga:
+		filename = IGCS::Utils::formatString("%s\\%d.tga", destinationFolder.c_str(), frameNumber);
+		IGCS::ImageFileIO::writeTga(filename, data.data(), _framebufferWidth, _framebufferHeight);
+		break;
+	case ScreenshotFiletype::Ppm:
+		filename = IGCS::Utils::formatString("%s\\%d.ppm", destinationFolder.c_str(), frameNumber);
+		IGCS::ImageFileIO::writePpm(filename, data.data(), _framebufferWidth, _framebufferHeight);
 		break;
 	case ScreenshotFiletype::Jpeg:
 		filename = IGCS::Utils::formatString("%s\\%d.jpg", destinationFolder.c_str(), frameNumber);
@@ -512,19 +519,7 @@ void ScreenshotController::saveShotToFile(std::string destinationFolder, const s
 		break;
 	case ScreenshotFiletype::Png:
 		filename = IGCS::Utils::formatString("%s\\%d.png", destinationFolder.c_str(), frameNumber);
-		// 3 bytes per pixel!
-		//stbi_write_png(filename.c_str(), _framebufferWidth, _framebufferHeight, 3, data.data(), 3 * _framebufferWidth) != 0;
-		std::vector<uint8_t> encoded_data;
-		fpng::fpng_encode_image_to_memory(data.data(), _framebufferWidth, _framebufferHeight, 3, encoded_data);
-		FILE* pngFile;
-		if(fopen_s(&pngFile, filename.c_str(), "wb")==0)
-		{
-			fwrite(encoded_data.data(), encoded_data.size(), 1, pngFile);
-		}
-		if(nullptr != pngFile)
-		{
-			fclose(pngFile);
-		}
+		IGCS::ImageFileIO::writePng(filename, data.data(), _framebufferWidth, _framebufferHeight);
 		break;
 	}
 }
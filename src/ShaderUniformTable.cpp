@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "ShaderUniformTable.h"
+#include <cstring>
+
+ShaderUniformTable::ShaderUniformTable(std::string effectName, std::vector<std::string> uniformNames) : _effectName(effectName), _uniformNames(uniformNames)
+{
+	_entries.resize(_uniformNames.size());
+}
+
+
+void ShaderUniformTable::resolve(reshade::api::effect_runtime* runtime)
+{
+	if(nullptr == runtime)
+	{
+		return;
+	}
+	_numberOfResolvedHandles = 0;
+	for(size_t i = 0; i < _entries.size(); i++)
+	{
+		_entries[i].handle = runtime->find_uniform_variable(_effectName.c_str(), _uniformNames[i].c_str());
+		if(_entries[i].handle.handle != 0)
+		{
+			_numberOfResolvedHandles++;
+		}
+	}
+	invalidateCache();
+}
+
+
+void ShaderUniformTable::invalidateCache()
+{
+	for(auto& entry : _entries)
+	{
+		entry.isCached = false;
+	}
+}
+
+
+void ShaderUniformTable::startBatch()
+{
+	_numberOfWritesInLastBatch = _numberOfWrites;
+	_numberOfWriteRequestsInLastBatch = _numberOfWriteRequests;
+	_numberOfWrites = 0;
+	_numberOfWriteRequests = 0;
+}
+
+
+void ShaderUniformTable::setInt(reshade::api::effect_runtime* runtime, int uniformIndex, int valueToWrite)
+{
+	if(!updateCache(uniformIndex, (uint32_t)valueToWrite, 0))
+	{
+		return;
+	}
+	runtime->set_uniform_value_int(_entries[uniformIndex].handle, &valueToWrite, 1);
+}
+
+
+void ShaderUniformTable::setBool(reshade::api::effect_runtime* runtime, int uniformIndex, bool valueToWrite)
+{
+	if(!updateCache(uniformIndex, valueToWrite ? 1 : 0, 0))
+	{
+		return;
+	}
+	runtime->set_uniform_value_bool(_entries[uniformIndex].handle, &valueToWrite, 1);
+}
+
+
+void ShaderUniformTable::setFloat(reshade::api::effect_runtime* runtime, int uniformIndex, float valueToWrite)
+{
+	uint32_t valueBits;
+	memcpy(&valueBits, &valueToWrite, sizeof(float));
+	if(!updateCache(uniformIndex, valueBits, 0))
+	{
+		return;
+	}
+	runtime->set_uniform_value_float(_entries[uniformIndex].handle, &valueToWrite, 1);
+}
+
+
+void ShaderUniformTable::setFloat2(reshade::api::effect_runtime* runtime, int uniformIndex, float value1ToWrite, float value2ToWrite)
+{
+	const float values[2] = { value1ToWrite, value2ToWrite };
+	uint32_t valueBits[2];
+	memcpy(valueBits, values, sizeof(values));
+	if(!updateCache(uniformIndex, valueBits[0], valueBits[1]))
+	{
+		return;
+	}
+	runtime->set_uniform_value_float(_entries[uniformIndex].handle, values, 2);
+}
+
+
+bool ShaderUniformTable::updateCache(int uniformIndex, uint32_t value1, uint32_t value2)
+{
+	if(uniformIndex < 0 || uniformIndex >= (int)_entries.size())
+	{
+		return false;
+	}
+	_numberOfWriteRequests++;
+	UniformEntry& entry = _entries[uniformIndex];
+	if(entry.handle.handle == 0)
+	{
+		return false;
+	}
+	if(entry.isCached && entry.cachedValue[0] == value1 && entry.cachedValue[1] == value2)
+	{
+		return false;
+	}
+	entry.cachedValue[0] = value1;
+	entry.cachedValue[1] = value2;
+	entry.isCached = true;
+	_numberOfWrites++;
+	return true;
+}
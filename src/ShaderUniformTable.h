@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <reshade.hpp>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Table of uniform handles for a single effect, indexed by the position of the uniform name in the list passed to the constructor (typically an enum value).
+/// Handles are resolved once, after a (re)load of the effects, so writing a value doesn't need any name lookups. Every value written is cached, and only
+/// values which differ from the cached value result in a call into the runtime. The cache is invalidated when the effects are reloaded (by resolve) or the
+/// runtime is resized (by invalidateCache), as the runtime then resets the values.
+/// </summary>
+class ShaderUniformTable
+{
+public:
+	ShaderUniformTable(std::string effectName, std::vector<std::string> uniformNames);
+	~ShaderUniformTable() = default;
+
+	/// <summary>
+	/// Resolves the handles of all uniforms using the runtime specified. Has to be called after the effects have been (re)loaded as the handles then change.
+	/// Invalidates the value cache as the values in the runtime are reset at that point.
+	/// </summary>
+	/// <param name="runtime"></param>
+	void resolve(reshade::api::effect_runtime* runtime);
+	/// <summary>
+	/// Marks all cached values as invalid so the next write of each uniform always results in a call into the runtime.
+	/// </summary>
+	void invalidateCache();
+	/// <summary>
+	/// Starts a new batch of writes, e.g. a frame. The write counters of the current batch are moved to the 'last batch' counters.
+	/// </summary>
+	void startBatch();
+	void setInt(reshade::api::effect_runtime* runtime, int uniformIndex, int valueToWrite);
+	void setBool(reshade::api::effect_runtime* runtime, int uniformIndex, bool valueToWrite);
+	void setFloat(reshade::api::effect_runtime* runtime, int uniformIndex, float valueToWrite);
+	void setFloat2(reshade::api::effect_runtime* runtime, int uniformIndex, float value1ToWrite, float value2ToWrite);
+
+	bool isResolved() { return _numberOfResolvedHandles > 0; }
+	int getNumberOfWritesInLastBatch() { return _numberOfWritesInLastBatch; }
+	int getNumberOfWriteRequestsInLastBatch() { return _numberOfWriteRequestsInLastBatch; }
+
+private:
+	struct UniformEntry
+	{
+		reshade::api::effect_uniform_variable handle = { 0 };
+		uint32_t cachedValue[2] = { 0, 0 };
+		bool isCached = false;
+	};
+
+	/// <summary>
+	/// Returns true if the value specified has to be written to the uniform with the index specified, and if so, caches the value as the uniform's value.
+	/// </summary>
+	bool updateCache(int uniformIndex, uint32_t value1, uint32_t value2);
+
+	std::string _effectName;
+	std::vector<std::string> _uniformNames;
+	std::vector<UniformEntry> _entries;
+	int _numberOfResolvedHandles = 0;
+	int _numberOfWrites = 0;
+	int _numberOfWriteRequests = 0;
+	int _numberOfWritesInLastBatch = 0;
+	int _numberOfWriteRequestsInLastBatch = 0;
+};
@@ -0,0 +1,462 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "DepthOfFieldBenchmark.h"
+#include "ImageFileIO.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+using namespace std::chrono;
+
+namespace
+{
+	struct WeightPreset
+	{
+		const char* name;
+		DepthOfFieldWeightParameters parameters;
+		bool isRadiallySymmetric;		// if true, the weighted centroid of every channel has to be at the center
+	};
+
+	struct PointLight
+	{
+		float x;
+		float y;
+		float colorRGB[3];
+	};
+
+	// Number of times the uncached generation is repeated to get a stable timing.
+	constexpr int GENERATION_ITERATIONS = 5;
+	constexpr float WEIGHT_SUM_TOLERANCE = 0.0001f;
+	constexpr float CENTROID_TOLERANCE = 0.001f;
+	constexpr float POSITION_TOLERANCE = 0.0001f;
+	// Below this PSNR (dB) an accumulated image is considered different from its golden image.
+	constexpr double GOLDEN_MIN_PSNR = 45.0;
+	constexpr int SCENE_WIDTH = 256;
+	constexpr int SCENE_HEIGHT = 256;
+	constexpr float BOKEH_RADIUS_IN_PIXELS = 24.0f;
+
+	const int QUALITIES[] = { 1, 2, 4, 8, 16, 32 };
+	const int POINTS_INNERMOST_RING[] = { 3, 6 };
+	const int APERTURE_VERTICES[] = { 5, 6, 8 };
+	const float ANAMORPHIC_FACTORS[] = { 1.0f, 0.5f };
+	const WeightPreset WEIGHT_PRESETS[] = {
+		{ "flat", { 0.0f, 0.0f, 0.1f, 0.0f, 0.1f, DepthOfFieldCAType::RGB }, true },
+		{ "aberration", { 0.5f, 0.0f, 0.1f, 0.0f, 0.1f, DepthOfFieldCAType::RGB }, true },
+		{ "fringe", { 0.5f, 0.8f, 0.2f, 0.0f, 0.1f, DepthOfFieldCAType::RGB }, true },
+		{ "ca-rgb", { 0.5f, 0.5f, 0.1f, 0.7f, 0.3f, DepthOfFieldCAType::RGB }, false },
+		{ "ca-rb", { 0.5f, 0.5f, 0.1f, 0.7f, 0.3f, DepthOfFieldCAType::RB }, false },
+	};
+	// point lights far brighter than the background, like highlights in a night scene, so the bokeh shape dominates the image.
+	const PointLight POINT_LIGHTS[] = {
+		{ 64.0f, 64.0f, { 40.0f, 40.0f, 40.0f } },
+		{ 190.0f, 70.0f, { 60.0f, 25.0f, 5.0f } },
+		{ 128.0f, 128.0f, { 10.0f, 30.0f, 50.0f } },
+		{ 60.0f, 200.0f, { 30.0f, 50.0f, 10.0f } },
+		{ 200.5f, 190.5f, { 50.0f, 50.0f, 30.0f } },
+	};
+
+
+	std::string createPatternCaseName(const DepthOfFieldGeometryParameters& geometryParameters, const char* weightPresetName)
+	{
+		if(DepthOfFieldBlurType::Circular == geometryParameters.blurType)
+		{
+			return IGCS::Utils::formatString("circle-q%d-p%d-a%.2f-%s", geometryParameters.quality, geometryParameters.numberOfPointsInnermostRing,
+											 geometryParameters.anamorphicFactor, weightPresetName);
+		}
+		return IGCS::Utils::formatString("aperture-q%d-v%d-a%.2f-%s", geometryParameters.quality, geometryParameters.numberOfVertices, geometryParameters.anamorphicFactor,
+										 weightPresetName);
+	}
+
+
+	/// <summary>
+	/// Both shapes have a center sample and rings with a number of samples which grows linearly per ring.
+	/// </summary>
+	int calculateExpectedNumberOfSamples(const DepthOfFieldGeometryParameters& geometryParameters)
+	{
+		const int samplesPerRingStep = DepthOfFieldBlurType::Circular == geometryParameters.blurType ? geometryParameters.numberOfPointsInnermostRing : geometryParameters.numberOfVertices;
+		return 1 + (samplesPerRingStep * geometryParameters.quality * (geometryParameters.quality + 1) / 2);
+	}
+
+
+	void createPointLightScene(std::vector<float>& scene)
+	{
+		scene.resize((size_t)SCENE_WIDTH * SCENE_HEIGHT * 3);
+		for(int y = 0; y < SCENE_HEIGHT; y++)
+		{
+			const float v = (float)y / (float)SCENE_HEIGHT;
+			for(int x = 0; x < SCENE_WIDTH; x++)
+			{
+				float* pixel = scene.data() + ((size_t)y * SCENE_WIDTH + x) * 3;
+				pixel[0] = 0.02f + 0.06f * v;
+				pixel[1] = 0.03f + 0.04f * v;
+				pixel[2] = 0.08f;
+			}
+		}
+		// lights at a half pixel location are spread over 4 pixels, so the bilinear reads are covered as well.
+		for(const PointLight& light : POINT_LIGHTS)
+		{
+			const int x = (int)light.x;
+			const int y = (int)light.y;
+			const float fx = light.x - (float)x;
+			const float fy = light.y - (float)y;
+			const float pixelWeights[4] = { (1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy };
+			for(int i = 0; i < 4; i++)
+			{
+				float* pixel = scene.data() + ((size_t)(y + (i / 2)) * SCENE_WIDTH + x + (i % 2)) * 3;
+				for(int channel = 0; channel < 3; channel++)
+				{
+					pixel[channel] += light.colorRGB[channel] * pixelWeights[i];
+				}
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Reference accumulation: for every sample the scene is read at the sample's offset (bilinear, clamped at the edges) and added with the
+	/// sample's weight per channel. This is what the shader does for a scene at infinity with the focus plane at the camera.
+	/// </summary>
+	void accumulatePattern(const std::vector<float>& scene, const DepthOfFieldSamplePattern& pattern, std::vector<float>& accumulation)
+	{
+		accumulation.assign(scene.size(), 0.0f);
+		const float* weights[3] = { pattern.weightR.data(), pattern.weightG.data(), pattern.weightB.data() };
+		for(size_t sampleIndex = 0; sampleIndex < pattern.size(); sampleIndex++)
+		{
+			const float offsetX = pattern.x[sampleIndex] * BOKEH_RADIUS_IN_PIXELS;
+			const float offsetY = pattern.y[sampleIndex] * BOKEH_RADIUS_IN_PIXELS;
+			const float sampleWeightRGB[3] = { weights[0][sampleIndex], weights[1][sampleIndex], weights[2][sampleIndex] };
+			for(int y = 0; y < SCENE_HEIGHT; y++)
+			{
+				const float readY = std::clamp((float)y - offsetY, 0.0f, (float)(SCENE_HEIGHT - 1));
+				const int y0 = (int)readY;
+				const int y1 = std::min(y0 + 1, SCENE_HEIGHT - 1);
+				const float fy = readY - (float)y0;
+				const float* row0 = scene.data() + (size_t)y0 * SCENE_WIDTH * 3;
+				const float* row1 = scene.data() + (size_t)y1 * SCENE_WIDTH * 3;
+				float* destination = accumulation.data() + (size_t)y * SCENE_WIDTH * 3;
+				for(int x = 0; x < SCENE_WIDTH; x++)
+				{
+					const float readX = std::clamp((float)x - offsetX, 0.0f, (float)(SCENE_WIDTH - 1));
+					const int x0 = (int)readX;
+					const int x1 = std::min(x0 + 1, SCENE_WIDTH - 1);
+					const float fx = readX - (float)x0;
+					for(int channel = 0; channel < 3; channel++)
+					{
+						const float top = IGCS::Utils::lerp(row0[(x0 * 3) + channel], row0[(x1 * 3) + channel], fx);
+						const float bottom = IGCS::Utils::lerp(row1[(x0 * 3) + channel], row1[(x1 * 3) + channel], fx);
+						destination[(x * 3) + channel] += sampleWeightRGB[channel] * IGCS::Utils::lerp(top, bottom, fy);
+					}
+				}
+			}
+		}
+	}
+
+
+	void quantizeAccumulation(const std::vector<float>& accumulation, std::vector<uint8_t>& rgbData)
+	{
+		rgbData.resize(accumulation.size());
+		for(size_t i = 0; i < accumulation.size(); i++)
+		{
+			rgbData[i] = (uint8_t)(std::clamp(accumulation[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+
+
+	/// <summary>
+	/// PSNR in dB over all channels, or infinity if the images are identical.
+	/// </summary>
+	double calculatePsnr(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference)
+	{
+		double sumOfSquaredErrors = 0.0;
+		for(size_t i = 0; i < image.size(); i++)
+		{
+			const double error = (double)image[i] - (double)reference[i];
+			sumOfSquaredErrors += error * error;
+		}
+		if(sumOfSquaredErrors <= 0.0)
+		{
+			return INFINITY;
+		}
+		const double meanSquaredError = sumOfSquaredErrors / (double)image.size();
+		return 10.0 * log10((255.0 * 255.0) / meanSquaredError);
+	}
+}
+
+
+int DepthOfFieldBenchmark::run(const std::string& goldenFolder, const std::string& outputFolder)
+{
+	std::error_code errorCode;
+	std::filesystem::create_directories(outputFolder, errorCode);
+
+	_numberOfFailedChecks = 0;
+	std::vector<PatternResult> patternResults;
+	for(const WeightPreset& weightPreset : WEIGHT_PRESETS)
+	{
+		for(const float anamorphicFactor : ANAMORPHIC_FACTORS)
+		{
+			for(const int quality : QUALITIES)
+			{
+				DepthOfFieldGeometryParameters geometryParameters;
+				geometryParameters.quality = quality;
+				geometryParameters.anamorphicFactor = anamorphicFactor;
+				geometryParameters.blurType = DepthOfFieldBlurType::Circular;
+				for(const int numberOfPoints : POINTS_INNERMOST_RING)
+				{
+					geometryParameters.numberOfPointsInnermostRing = numberOfPoints;
+					patternResults.push_back(checkPattern(createPatternCaseName(geometryParameters, weightPreset.name), geometryParameters, weightPreset.parameters,
+														  weightPreset.isRadiallySymmetric));
+				}
+				geometryParameters.blurType = DepthOfFieldBlurType::ApertureShape;
+				for(const int numberOfVertices : APERTURE_VERTICES)
+				{
+					geometryParameters.numberOfVertices = numberOfVertices;
+					patternResults.push_back(checkPattern(createPatternCaseName(geometryParameters, weightPreset.name), geometryParameters, weightPreset.parameters,
+														  weightPreset.isRadiallySymmetric));
+				}
+			}
+		}
+	}
+
+	std::vector<AccumulationResult> accumulationResults;
+	DepthOfFieldGeometryParameters circle;
+	circle.blurType = DepthOfFieldBlurType::Circular;
+	circle.quality = 8;
+	circle.numberOfPointsInnermostRing = 6;
+	DepthOfFieldGeometryParameters hexagon;
+	hexagon.blurType = DepthOfFieldBlurType::ApertureShape;
+	hexagon.quality = 8;
+	hexagon.numberOfVertices = 6;
+	hexagon.rotationAngle = 0.1f;
+	hexagon.roundFactor = 0.25f;
+	DepthOfFieldGeometryParameters anamorphicPentagon = hexagon;
+	anamorphicPentagon.numberOfVertices = 5;
+	anamorphicPentagon.quality = 12;
+	anamorphicPentagon.anamorphicFactor = 0.6f;
+	accumulationResults.push_back(checkAccumulation("circle-flat", circle, WEIGHT_PRESETS[0].parameters, goldenFolder, outputFolder));
+	accumulationResults.push_back(checkAccumulation("circle-fringe", circle, WEIGHT_PRESETS[2].parameters, goldenFolder, outputFolder));
+	accumulationResults.push_back(checkAccumulation("circle-ca-rgb", circle, WEIGHT_PRESETS[3].parameters, goldenFolder, outputFolder));
+	accumulationResults.push_back(checkAccumulation("hexagon-aberration", hexagon, WEIGHT_PRESETS[1].parameters, goldenFolder, outputFolder));
+	accumulationResults.push_back(checkAccumulation("pentagon-anamorphic-ca-rb", anamorphicPentagon, WEIGHT_PRESETS[4].parameters, goldenFolder, outputFolder));
+
+	for(const PatternResult& result : patternResults)
+	{
+		if(!result.failure.empty())
+		{
+			++_numberOfFailedChecks;
+			IGCS::Utils::logLineToReshade(reshade::log_level::warning, "Depth of field benchmark: pattern %s failed: %s", result.name.c_str(), result.failure.c_str());
+		}
+	}
+	for(const AccumulationResult& result : accumulationResults)
+	{
+		if(!result.failure.empty())
+		{
+			++_numberOfFailedChecks;
+			IGCS::Utils::logLineToReshade(reshade::log_level::warning, "Depth of field benchmark: accumulation %s failed: %s", result.name.c_str(), result.failure.c_str());
+		}
+	}
+	writeResults(outputFolder, patternResults, accumulationResults);
+	return _numberOfFailedChecks;
+}
+
+
+DepthOfFieldBenchmark::PatternResult DepthOfFieldBenchmark::checkPattern(const std::string& name, const DepthOfFieldGeometryParameters& geometryParameters,
+																		   const DepthOfFieldWeightParameters& weightParameters, bool checkCentroid)
+{
+	PatternResult result;
+	result.name = name;
+	result.expectedNumberOfSamples = calculateExpectedNumberOfSamples(geometryParameters);
+
+	// a new generator per iteration, so nothing is cached.
+	const auto uncachedStartTime = high_resolution_clock::now();
+	for(int i = 0; i < GENERATION_ITERATIONS; i++)
+	{
+		DepthOfFieldPatternGenerator generator;
+		generator.getPattern(geometryParameters, weightParameters);
+	}
+	result.msUncached = duration<double, std::milli>(high_resolution_clock::now() - uncachedStartTime).count() / GENERATION_ITERATIONS;
+
+	DepthOfFieldPatternGenerator generator;
+	generator.getPattern(geometryParameters, weightParameters);
+	const auto cachedStartTime = high_resolution_clock::now();
+	const DepthOfFieldSamplePattern& pattern = generator.getPattern(geometryParameters, weightParameters);
+	result.msCached = duration<double, std::milli>(high_resolution_clock::now() - cachedStartTime).count();
+
+	result.numberOfSamples = (int)pattern.size();
+	if(result.numberOfSamples != result.expectedNumberOfSamples)
+	{
+		result.failure = IGCS::Utils::formatString("Expected %d samples, got %d", result.expectedNumberOfSamples, result.numberOfSamples);
+		return result;
+	}
+	if(pattern.weightR.size() != pattern.size() || pattern.weightG.size() != pattern.size() || pattern.weightB.size() != pattern.size() || pattern.y.size() != pattern.size())
+	{
+		result.failure = "The pattern arrays don't have the same length";
+		return result;
+	}
+
+	const float* weights[3] = { pattern.weightR.data(), pattern.weightG.data(), pattern.weightB.data() };
+	for(size_t i = 0; i < pattern.size(); i++)
+	{
+		// positions are relative to the max bokeh radius and the anamorphic squeeze is applied to x only.
+		const float unsqueezedX = pattern.x[i] / geometryParameters.anamorphicFactor;
+		const float radius = sqrtf((unsqueezedX * unsqueezedX) + (pattern.y[i] * pattern.y[i]));
+		if(!std::isfinite(radius) || radius > 1.0f + POSITION_TOLERANCE)
+		{
+			result.failure = IGCS::Utils::formatString("Sample %d is outside the bokeh: radius %f", (int)i, radius);
+			return result;
+		}
+		for(int channel = 0; channel < 3; channel++)
+		{
+			const float weight = weights[channel][i];
+			if(!std::isfinite(weight) || weight < 0.0f)
+			{
+				result.failure = IGCS::Utils::formatString("Sample %d has an invalid weight in channel %d: %f", (int)i, channel, weight);
+				return result;
+			}
+			result.weightSumRGB[channel] += weight;
+			result.centroidRGB[channel][0] += weight * pattern.x[i];
+			result.centroidRGB[channel][1] += weight * pattern.y[i];
+			result.secondMomentRGB[channel] += weight * ((pattern.x[i] * pattern.x[i]) + (pattern.y[i] * pattern.y[i]));
+		}
+	}
+	for(int channel = 0; channel < 3; channel++)
+	{
+		if(fabsf(result.weightSumRGB[channel] - 1.0f) > WEIGHT_SUM_TOLERANCE)
+		{
+			result.failure = IGCS::Utils::formatString("Weights of channel %d sum up to %f", channel, result.weightSumRGB[channel]);
+			return result;
+		}
+		if(checkCentroid && (fabsf(result.centroidRGB[channel][0]) > CENTROID_TOLERANCE || fabsf(result.centroidRGB[channel][1]) > CENTROID_TOLERANCE))
+		{
+			result.failure = IGCS::Utils::formatString("Centroid of channel %d isn't at the center: (%f, %f)", channel, result.centroidRGB[channel][0], result.centroidRGB[channel][1]);
+			return result;
+		}
+	}
+
+	std::vector<bool> isInOrder(pattern.size(), false);
+	for(const int index : pattern.progressiveOrder)
+	{
+		if(index < 0 || index >= (int)pattern.size() || isInOrder[index])
+		{
+			result.failure = IGCS::Utils::formatString("The progressive order isn't a permutation of the samples: index %d", index);
+			return result;
+		}
+		isInOrder[index] = true;
+	}
+	if(pattern.progressiveOrder.size() != pattern.size())
+	{
+		result.failure = IGCS::Utils::formatString("The progressive order has %d samples instead of %d", (int)pattern.progressiveOrder.size(), (int)pattern.size());
+	}
+	return result;
+}
+
+
+DepthOfFieldBenchmark::AccumulationResult DepthOfFieldBenchmark::checkAccumulation(const std::string& name, const DepthOfFieldGeometryParameters& geometryParameters,
+																				   const DepthOfFieldWeightParameters& weightParameters, const std::string& goldenFolder,
+																				   const std::string& outputFolder)
+{
+	AccumulationResult result;
+	result.name = name;
+	DepthOfFieldPatternGenerator generator;
+	const DepthOfFieldSamplePattern& pattern = generator.getPattern(geometryParameters, weightParameters);
+	result.numberOfSamples = (int)pattern.size();
+
+	std::vector<float> scene;
+	createPointLightScene(scene);
+	std::vector<float> accumulation;
+	const auto startTime = high_resolution_clock::now();
+	accumulatePattern(scene, pattern, accumulation);
+	result.msAccumulation = duration<double, std::milli>(high_resolution_clock::now() - startTime).count();
+
+	std::vector<uint8_t> image;
+	quantizeAccumulation(accumulation, image);
+	IGCS::ImageFileIO::writePpm((std::filesystem::path(outputFolder) / (name + ".ppm")).string(), image.data(), SCENE_WIDTH, SCENE_HEIGHT);
+
+	const std::string goldenFilename = (std::filesystem::path(goldenFolder) / (name + ".ppm")).string();
+	std::vector<uint8_t> goldenImage;
+	int goldenWidth = 0;
+	int goldenHeight = 0;
+	if(!IGCS::ImageFileIO::readPpm(goldenFilename, goldenImage, goldenWidth, goldenHeight))
+	{
+		result.failure = "The golden image is missing or can't be read";
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Depth of field benchmark: couldn't read the golden image %s", goldenFilename.c_str());
+		return result;
+	}
+	if(goldenWidth != SCENE_WIDTH || goldenHeight != SCENE_HEIGHT)
+	{
+		result.failure = IGCS::Utils::formatString("The golden image is %dx%d instead of %dx%d", goldenWidth, goldenHeight, SCENE_WIDTH, SCENE_HEIGHT);
+		return result;
+	}
+	result.psnr = calculatePsnr(image, goldenImage);
+	if(result.psnr < GOLDEN_MIN_PSNR)
+	{
+		result.failure = IGCS::Utils::formatString("PSNR against the golden image is %.2f dB, the minimum is %.2f dB", result.psnr, GOLDEN_MIN_PSNR);
+	}
+	return result;
+}
+
+
+void DepthOfFieldBenchmark::writeResults(const std::string& outputFolder, const std::vector<PatternResult>& patternResults, const std::vector<AccumulationResult>& accumulationResults)
+{
+	const std::string filename = (std::filesystem::path(outputFolder) / "results.json").string();
+	FILE* resultsFile = nullptr;
+	if(fopen_s(&resultsFile, filename.c_str(), "w") != 0 || nullptr == resultsFile)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Depth of field benchmark: couldn't write results to %s", filename.c_str());
+		return;
+	}
+	fprintf(resultsFile, "{\n\t\"numberOfFailedChecks\": %d,\n\t\"patterns\": [\n", _numberOfFailedChecks);
+	for(size_t i = 0; i < patternResults.size(); i++)
+	{
+		const PatternResult& result = patternResults[i];
+		fprintf(resultsFile, "\t\t{ \"name\": \"%s\", \"samples\": %d, \"expectedSamples\": %d, \"weightSumRGB\": [%.6f, %.6f, %.6f], "
+				"\"centroidR\": [%.6f, %.6f], \"centroidG\": [%.6f, %.6f], \"centroidB\": [%.6f, %.6f], \"secondMomentRGB\": [%.6f, %.6f, %.6f], "
+				"\"msUncached\": %.4f, \"msCached\": %.4f, \"failure\": \"%s\" }%s\n",
+				result.name.c_str(), result.numberOfSamples, result.expectedNumberOfSamples, result.weightSumRGB[0], result.weightSumRGB[1], result.weightSumRGB[2],
+				result.centroidRGB[0][0], result.centroidRGB[0][1], result.centroidRGB[1][0], result.centroidRGB[1][1], result.centroidRGB[2][0], result.centroidRGB[2][1],
+				result.secondMomentRGB[0], result.secondMomentRGB[1], result.secondMomentRGB[2], result.msUncached, result.msCached, result.failure.c_str(),
+				(i + 1 < patternResults.size()) ? "," : "");
+	}
+	fprintf(resultsFile, "\t],\n\t\"accumulations\": [\n");
+	for(size_t i = 0; i < accumulationResults.size(); i++)
+	{
+		const AccumulationResult& result = accumulationResults[i];
+		// JSON has no infinity, identical images are reported with a PSNR of -1.
+		fprintf(resultsFile, "\t\t{ \"name\": \"%s\", \"samples\": %d, \"msAccumulation\": %.3f, \"psnr\": %.3f, \"failure\": \"%s\" }%s\n",
+				result.name.c_str(), result.numberOfSamples, result.msAccumulation, std::isfinite(result.psnr) ? result.psnr : -1.0, result.failure.c_str(), (i + 1 < accumulationResults.size()) ? "," : "");
+	}
+	fprintf(resultsFile, "\t]\n}\n");
+	fclose(resultsFile);
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DepthOfFieldPatternGenerator.h"
+
+/// <summary>
+/// Regression benchmark for the depth of field sample patterns and the accumulation maths. It has two parts:
+/// 1) it generates the sample patterns for a matrix of settings and checks the sample counts, the weight sums per channel, the positions, the
+///    progressive order and the first moments, and measures how long generation takes, uncached and cached.
+/// 2) it accumulates a synthetic point light scene with a set of patterns on the cpu and compares the result with the golden images in the golden
+///    folder by PSNR. The golden images were rendered with the pattern maths as it was in DepthOfFieldController before the pattern generator was
+///    split off. A missing golden image is a failed check.
+/// Results and timings are written as JSON to the output folder, together with the accumulated images.
+/// </summary>
+class DepthOfFieldBenchmark
+{
+public:
+	DepthOfFieldBenchmark() = default;
+	~DepthOfFieldBenchmark() = default;
+
+	/// <summary>
+	/// Runs all checks on the calling thread.
+	/// </summary>
+	/// <param name="goldenFolder">the folder with the golden images, one ppm file per accumulation case</param>
+	/// <param name="outputFolder">the folder to write results.json and the accumulated images to. Created if it doesn't exist</param>
+	/// <returns>the number of failed checks</returns>
+	int run(const std::string& goldenFolder, const std::string& outputFolder);
+
+private:
+	struct PatternResult
+	{
+		std::string name;
+		int numberOfSamples = 0;
+		int expectedNumberOfSamples = 0;
+		float weightSumRGB[3] = { 0.0f, 0.0f, 0.0f };
+		float centroidRGB[3][2] = {};
+		float secondMomentRGB[3] = { 0.0f, 0.0f, 0.0f };
+		double msUncached = 0.0;
+		double msCached = 0.0;
+		std::string failure;		// empty if all checks passed
+	};
+
+	struct AccumulationResult
+	{
+		std::string name;
+		int numberOfSamples = 0;
+		double msAccumulation = 0.0;
+		double psnr = 0.0;
+		std::string failure;		// empty if the result matches the golden image
+	};
+
+	/// <summary>
+	/// Generates the pattern and checks it. If checkCentroid is true, the weights are radially symmetric so the weighted centroid of every channel has
+	/// to be at the center.
+	/// </summary>
+	PatternResult checkPattern(const std::string& name, const DepthOfFieldGeometryParameters& geometryParameters, const DepthOfFieldWeightParameters& weightParameters,
+							   bool checkCentroid);
+	AccumulationResult checkAccumulation(const std::string& name, const DepthOfFieldGeometryParameters& geometryParameters, const DepthOfFieldWeightParameters& weightParameters,
+										 const std::string& goldenFolder, const std::string& outputFolder);
+	void writeResults(const std::string& outputFolder, const std::vector<PatternResult>& patternResults, const std::vector<AccumulationResult>& accumulationResults);
+
+	int _numberOfFailedChecks = 0;
+};
@@ -0,0 +1,320 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "TestFramework.h"
+#include "DepthOfFieldRenderPipeline.h"
+#include <functional>
+
+namespace
+{
+	constexpr int NUMBER_OF_STEPS = 24;
+	constexpr int MAX_LATENCY_IN_FRAMES = 4;
+	// way more than any render in these tests needs, so a pipeline which stalls fails instead of hanging.
+	constexpr int MAX_NUMBER_OF_FRAMES = 1000;
+
+	/// <summary>
+	/// Camera of a game which shows a move issued at the end of frame F from frame F + latency on, like the camera tools driving a real engine.
+	/// </summary>
+	class SimulatedCamera
+	{
+	public:
+		explicit SimulatedCamera(int latencyInFrames) : _latencyInFrames(latencyInFrames) {}
+
+		void moveTo(int stepIndex, int64_t frameIssued)
+		{
+			_moves.push_back({ stepIndex, frameIssued });
+		}
+
+		/// <summary>
+		/// Returns the step the camera is at in the frame specified, or -1 if no move is visible yet.
+		/// </summary>
+		int getVisibleStep(int64_t frame) const
+		{
+			int visibleStep = -1;
+			for(const auto& move : _moves)
+			{
+				if(move.frameIssued + _latencyInFrames <= frame)
+				{
+					visibleStep = move.stepIndex;
+				}
+			}
+			return visibleStep;
+		}
+
+	private:
+		struct Move
+		{
+			int stepIndex;
+			int64_t frameIssued;
+		};
+
+		int _latencyInFrames;
+		std::vector<Move> _moves;
+	};
+
+
+	struct RenderResult
+	{
+		std::vector<int> blendedSteps;
+		// the frame in which each step in blendedSteps was blended
+		std::vector<int64_t> blendFrames;
+		// the steps blended in a frame in which the camera showed another step
+		int numberOfMisalignedBlends = 0;
+		int64_t numberOfFrames = 0;
+		bool isComplete = false;
+	};
+
+
+	/// <summary>
+	/// Renders with the pipeline like DepthOfFieldController does: per frame beginFrame before the effects, blending the step returned, and endFrame
+	/// after them, moving the camera to the step returned, till the pipeline is complete. frameHook is called before endFrame with the frame number and
+	/// returns whether the render is paused in that frame. It can change the pipeline.
+	/// </summary>
+	RenderResult render(DepthOfFieldRenderPipeline& pipeline, int latencyInFrames, const std::function<bool(int64_t frame, DepthOfFieldRenderPipeline& pipeline)>& frameHook)
+	{
+		RenderResult result;
+		SimulatedCamera camera(latencyInFrames);
+		for(int64_t frame = 1; frame <= MAX_NUMBER_OF_FRAMES; frame++)
+		{
+			result.numberOfFrames = frame;
+			const int stepToBlend = pipeline.beginFrame();
+			if(stepToBlend >= 0)
+			{
+				result.blendedSteps.push_back(stepToBlend);
+				result.blendFrames.push_back(frame);
+				result.numberOfMisalignedBlends += (camera.getVisibleStep(frame) != stepToBlend) ? 1 : 0;
+			}
+			if(pipeline.isComplete())
+			{
+				result.isComplete = true;
+				break;
+			}
+			const bool isPaused = frameHook(frame, pipeline);
+			const int stepToMoveTo = pipeline.endFrame(isPaused);
+			if(stepToMoveTo >= 0)
+			{
+				camera.moveTo(stepToMoveTo, frame);
+			}
+		}
+		return result;
+	}
+
+
+	bool neverPaused(int64_t, DepthOfFieldRenderPipeline&)
+	{
+		return false;
+	}
+
+
+	/// <summary>
+	/// Checks the steps blended are 0...numberOfSteps-1, in order, each blended once.
+	/// </summary>
+	void checkAllStepsBlendedInOrder(const RenderResult& result, int numberOfSteps)
+	{
+		IGCS_CHECK(result.isComplete);
+		IGCS_CHECK_EQUAL((size_t)numberOfSteps, result.blendedSteps.size());
+		for(size_t i = 0; i < result.blendedSteps.size(); i++)
+		{
+			IGCS_CHECK_EQUAL((int)i, result.blendedSteps[i]);
+		}
+	}
+}
+
+
+IGCS_TEST(fastWaitBlendsEveryFrameAfterWarmUp)
+{
+	for(int latency = 1; latency <= MAX_LATENCY_IN_FRAMES; latency++)
+	{
+		DepthOfFieldRenderPipeline pipeline;
+		pipeline.start(NUMBER_OF_STEPS, latency, latency);
+		const RenderResult result = render(pipeline, latency, neverPaused);
+		checkAllStepsBlendedInOrder(result, NUMBER_OF_STEPS);
+		IGCS_CHECK_EQUAL(0, result.numberOfMisalignedBlends);
+		// the first move is issued at the end of frame 1 and shows up at 1 + latency, after which every frame is blended.
+		for(size_t i = 0; i < result.blendFrames.size(); i++)
+		{
+			IGCS_CHECK_EQUAL((int64_t)(1 + latency + i), result.blendFrames[i]);
+		}
+		IGCS_CHECK_EQUAL((int64_t)(latency + NUMBER_OF_STEPS), result.numberOfFrames);
+	}
+}
+
+
+IGCS_TEST(classicWaitWaitsTheFullLatencyForEveryStep)
+{
+	for(int latency = 1; latency <= MAX_LATENCY_IN_FRAMES; latency++)
+	{
+		DepthOfFieldRenderPipeline pipeline;
+		pipeline.start(NUMBER_OF_STEPS, latency, 1);
+		const RenderResult result = render(pipeline, latency, [](int64_t, DepthOfFieldRenderPipeline& pipeline)
+		{
+			IGCS_CHECK(pipeline.getNumberOfStepsInFlight() <= 1);
+			return false;
+		});
+		checkAllStepsBlendedInOrder(result, NUMBER_OF_STEPS);
+		IGCS_CHECK_EQUAL(0, result.numberOfMisalignedBlends);
+		// each move is issued in the frame the previous one is blended in, and shows up latency frames later.
+		for(size_t i = 0; i < result.blendFrames.size(); i++)
+		{
+			IGCS_CHECK_EQUAL((int64_t)(1 + latency * (i + 1)), result.blendFrames[i]);
+		}
+	}
+}
+
+
+IGCS_TEST(pauseDrainsTheMovesInFlightAndResumesAligned)
+{
+	for(int latency = 1; latency <= MAX_LATENCY_IN_FRAMES; latency++)
+	{
+		for(const int maxNumberOfStepsInFlight : { 1, latency })
+		{
+			DepthOfFieldRenderPipeline pipeline;
+			pipeline.start(NUMBER_OF_STEPS, latency, maxNumberOfStepsInFlight);
+			// paused twice: once while the pipeline warms up and once with all moves in flight. Unpausing again before the pipeline has drained.
+			int numberOfStepsBlendedAtPause = -1;
+			const RenderResult result = render(pipeline, latency, [&](int64_t frame, DepthOfFieldRenderPipeline& pipeline)
+			{
+				const bool isPaused = (frame >= 2 && frame < 4) || (frame >= 10 && frame < 10 + 2 * latency) || (frame >= 30 && frame < 31);
+				if(10 == frame)
+				{
+					numberOfStepsBlendedAtPause = pipeline.getNumberOfStepsBlended() + pipeline.getNumberOfStepsInFlight();
+				}
+				if(frame == 10 + 2 * latency - 1)
+				{
+					// with no new moves issued for more than the latency, every move in flight has been blended.
+					IGCS_CHECK_EQUAL(0, pipeline.getNumberOfStepsInFlight());
+					IGCS_CHECK_EQUAL(numberOfStepsBlendedAtPause, pipeline.getNumberOfStepsBlended());
+				}
+				return isPaused;
+			});
+			checkAllStepsBlendedInOrder(result, NUMBER_OF_STEPS);
+			IGCS_CHECK_EQUAL(0, result.numberOfMisalignedBlends);
+		}
+	}
+}
+
+
+IGCS_TEST(stopAtCheckpointDropsTheMovesBeyondIt)
+{
+	for(int latency = 1; latency <= MAX_LATENCY_IN_FRAMES; latency++)
+	{
+		for(const int maxNumberOfStepsInFlight : { 1, latency })
+		{
+			DepthOfFieldRenderPipeline pipeline;
+			pipeline.start(NUMBER_OF_STEPS, latency, maxNumberOfStepsInFlight);
+			// like DepthOfFieldController::stopRenderAtNextCheckpoint: stop at the next multiple of the block size, with moves beyond it in flight.
+			constexpr int BLOCK_SIZE = 4;
+			int checkpoint = -1;
+			const RenderResult result = render(pipeline, latency, [&](int64_t frame, DepthOfFieldRenderPipeline& pipeline)
+			{
+				if(-1 == checkpoint && pipeline.getNumberOfStepsBlended() >= 5)
+				{
+					const int numberOfStepsBlended = pipeline.getNumberOfStepsBlended();
+					checkpoint = ((numberOfStepsBlended + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+					pipeline.setNumberOfStepsToRender(checkpoint);
+					IGCS_CHECK(pipeline.getNumberOfStepsBlended() + pipeline.getNumberOfStepsInFlight() <= checkpoint);
+				}
+				return false;
+			});
+			IGCS_CHECK(checkpoint > 0);
+			checkAllStepsBlendedInOrder(result, checkpoint);
+			IGCS_CHECK_EQUAL(0, result.numberOfMisalignedBlends);
+			IGCS_CHECK_EQUAL(checkpoint, pipeline.getNumberOfStepsToRender());
+		}
+	}
+}
+
+
+IGCS_TEST(stopAtCheckpointWhileAllBlendedStopsImmediately)
+{
+	for(int latency = 1; latency <= MAX_LATENCY_IN_FRAMES; latency++)
+	{
+		DepthOfFieldRenderPipeline pipeline;
+		pipeline.start(NUMBER_OF_STEPS, latency, latency);
+		// a checkpoint at exactly the number of steps blended: the moves in flight are all dropped.
+		const RenderResult result = render(pipeline, latency, [](int64_t, DepthOfFieldRenderPipeline& pipeline)
+		{
+			if(8 == pipeline.getNumberOfStepsBlended() && pipeline.getNumberOfStepsToRender() == NUMBER_OF_STEPS)
+			{
+				pipeline.setNumberOfStepsToRender(8);
+				IGCS_CHECK_EQUAL(0, pipeline.getNumberOfStepsInFlight());
+				IGCS_CHECK(pipeline.isComplete());
+			}
+			return false;
+		});
+		checkAllStepsBlendedInOrder(result, 8);
+		IGCS_CHECK_EQUAL(0, result.numberOfMisalignedBlends);
+	}
+}
+
+
+IGCS_TEST(setNumberOfStepsToRenderMidRenderExtendsAndShortens)
+{
+	for(int latency = 1; latency <= MAX_LATENCY_IN_FRAMES; latency++)
+	{
+		for(const int maxNumberOfStepsInFlight : { 1, latency })
+		{
+			// extending a render which was limited: the render continues after the old end.
+			DepthOfFieldRenderPipeline pipeline;
+			pipeline.start(NUMBER_OF_STEPS, latency, maxNumberOfStepsInFlight);
+			pipeline.setNumberOfStepsToRender(6);
+			const RenderResult extendedResult = render(pipeline, latency, [](int64_t, DepthOfFieldRenderPipeline& pipeline)
+			{
+				if(4 == pipeline.getNumberOfStepsBlended())
+				{
+					pipeline.setNumberOfStepsToRender(NUMBER_OF_STEPS);
+				}
+				return false;
+			});
+			checkAllStepsBlendedInOrder(extendedResult, NUMBER_OF_STEPS);
+			IGCS_CHECK_EQUAL(0, extendedResult.numberOfMisalignedBlends);
+
+			// shortening it several times, while paused too.
+			pipeline.start(NUMBER_OF_STEPS, latency, maxNumberOfStepsInFlight);
+			const RenderResult shortenedResult = render(pipeline, latency, [latency](int64_t frame, DepthOfFieldRenderPipeline& pipeline)
+			{
+				if(6 == frame)
+				{
+					pipeline.setNumberOfStepsToRender(18);
+				}
+				if(12 == frame)
+				{
+					pipeline.setNumberOfStepsToRender(std::max(pipeline.getNumberOfStepsBlended() + 1, 10));
+				}
+				return frame >= 12 && frame < 12 + latency;
+			});
+			checkAllStepsBlendedInOrder(shortenedResult, pipeline.getNumberOfStepsToRender());
+			IGCS_CHECK_EQUAL(0, shortenedResult.numberOfMisalignedBlends);
+		}
+	}
+}
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "FakeEffectRuntime.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// handles are never 0, as 0 means no handle. A uniform handle is (effect index + 1) * UNIFORM_HANDLE_STRIDE + uniform index.
+	constexpr uint64_t FIRST_TECHNIQUE_HANDLE = 1;
+	constexpr uint64_t UNIFORM_HANDLE_STRIDE = 1000;
+	constexpr const char* EFFECT_NAME_PREFIX = "Effect";
+
+
+	/// <summary>
+	/// Copies the name to the buffer like the runtime does: truncated to the buffer size and the length written back, or only the length if there's no buffer.
+	/// </summary>
+	void copyName(const char* formattedName, char* name, size_t* nameSize)
+	{
+		const size_t length = strlen(formattedName);
+		if(nullptr != name && *nameSize > 0)
+		{
+			strncpy_s(name, *nameSize, formattedName, _TRUNCATE);
+		}
+		*nameSize = length + 1;
+	}
+}
+
+
+FakeEffectRuntime::FakeEffectRuntime(int numberOfEffects, int numberOfUniformsPerEffect) : _numberOfEffects(numberOfEffects), _numberOfUniformsPerEffect(numberOfUniformsPerEffect),
+	_techniqueStates(numberOfEffects, false), _uniformValues(numberOfEffects * numberOfUniformsPerEffect, std::array<float, 4>{})
+{}
+
+
+reshade::api::effect_technique FakeEffectRuntime::getTechnique(int effectIndex) const
+{
+	return { FIRST_TECHNIQUE_HANDLE + effectIndex };
+}
+
+
+reshade::api::effect_uniform_variable FakeEffectRuntime::getUniform(int effectIndex, int uniformIndex) const
+{
+	return { ((effectIndex + 1) * UNIFORM_HANDLE_STRIDE) + uniformIndex };
+}
+
+
+float FakeEffectRuntime::getUniformValue(int effectIndex, int uniformIndex) const
+{
+	return _uniformValues[(effectIndex * _numberOfUniformsPerEffect) + uniformIndex][0];
+}
+
+
+void FakeEffectRuntime::enumerate_uniform_variables(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_uniform_variable variable, void* user_data),
+													void* user_data)
+{
+	// Effect<index>.fx
+	if(nullptr == effect_name || strncmp(effect_name, EFFECT_NAME_PREFIX, strlen(EFFECT_NAME_PREFIX)) != 0)
+	{
+		return;
+	}
+	const int effectIndex = atoi(effect_name + strlen(EFFECT_NAME_PREFIX));
+	if(effectIndex < 0 || effectIndex >= _numberOfEffects)
+	{
+		return;
+	}
+	for(int i = 0; i < _numberOfUniformsPerEffect; i++)
+	{
+		callback(this, getUniform(effectIndex, i), user_data);
+	}
+}
+
+
+void FakeEffectRuntime::get_uniform_variable_type(reshade::api::effect_uniform_variable variable, reshade::api::format* out_base_type, uint32_t* out_rows, uint32_t* out_columns,
+												  uint32_t* out_array_length) const
+{
+	// float4
+	*out_base_type = reshade::api::format::r32_float;
+	if(nullptr != out_rows)
+	{
+		*out_rows = 4;
+	}
+	if(nullptr != out_columns)
+	{
+		*out_columns = 1;
+	}
+	if(nullptr != out_array_length)
+	{
+		*out_array_length = 0;
+	}
+}
+
+
+void FakeEffectRuntime::get_uniform_variable_name(reshade::api::effect_uniform_variable variable, char* name, size_t* name_size) const
+{
+	char formattedName[64];
+	snprintf(formattedName, sizeof(formattedName), "Uniform%d", (int)(variable.handle % UNIFORM_HANDLE_STRIDE));
+	copyName(formattedName, name, name_size);
+}
+
+
+void FakeEffectRuntime::get_uniform_value_float(reshade::api::effect_uniform_variable variable, float* values, size_t count, size_t array_index) const
+{
+	const int index = toUniformIndex(variable.handle);
+	for(size_t i = 0; i < count; i++)
+	{
+		values[i] = (index >= 0 && i < 4) ? _uniformValues[index][i] : 0.0f;
+	}
+}
+
+
+void FakeEffectRuntime::set_uniform_value_float(reshade::api::effect_uniform_variable variable, const float* values, size_t count, size_t array_index)
+{
+	const int index = toUniformIndex(variable.handle);
+	if(index < 0)
+	{
+		return;
+	}
+	for(size_t i = 0; i < count && i < 4; i++)
+	{
+		_uniformValues[index][i] = values[i];
+	}
+}
+
+
+void FakeEffectRuntime::enumerate_techniques(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_technique technique, void* user_data),
+											 void* user_data)
+{
+	// only called for all effects by the code under test
+	for(int i = 0; i < _numberOfEffects; i++)
+	{
+		callback(this, getTechnique(i), user_data);
+	}
+}
+
+
+void FakeEffectRuntime::get_technique_name(reshade::api::effect_technique technique, char* name, size_t* name_size) const
+{
+	char formattedName[64];
+	snprintf(formattedName, sizeof(formattedName), "Technique%d", toEffectIndex(technique.handle));
+	copyName(formattedName, name, name_size);
+}
+
+
+bool FakeEffectRuntime::get_technique_state(reshade::api::effect_technique technique) const
+{
+	const int effectIndex = toEffectIndex(technique.handle);
+	return effectIndex >= 0 && _techniqueStates[effectIndex];
+}
+
+
+void FakeEffectRuntime::set_technique_state(reshade::api::effect_technique technique, bool enabled)
+{
+	const int effectIndex = toEffectIndex(technique.handle);
+	if(effectIndex >= 0)
+	{
+		_techniqueStates[effectIndex] = enabled;
+	}
+}
+
+
+void FakeEffectRuntime::get_uniform_variable_effect_name(reshade::api::effect_uniform_variable variable, char* effect_name, size_t* effect_name_size) const
+{
+	char formattedName[64];
+	snprintf(formattedName, sizeof(formattedName), "%s%d.fx", EFFECT_NAME_PREFIX, (int)(variable.handle / UNIFORM_HANDLE_STRIDE) - 1);
+	copyName(formattedName, effect_name, effect_name_size);
+}
+
+
+void FakeEffectRuntime::get_technique_effect_name(reshade::api::effect_technique technique, char* effect_name, size_t* effect_name_size) const
+{
+	char formattedName[64];
+	snprintf(formattedName, sizeof(formattedName), "%s%d.fx", EFFECT_NAME_PREFIX, toEffectIndex(technique.handle));
+	copyName(formattedName, effect_name, effect_name_size);
+}
+
+
+int FakeEffectRuntime::toUniformIndex(uint64_t handle) const
+{
+	const int effectIndex = (int)(handle / UNIFORM_HANDLE_STRIDE) - 1;
+	const int uniformIndex = (int)(handle % UNIFORM_HANDLE_STRIDE);
+	if(effectIndex < 0 || effectIndex >= _numberOfEffects || uniformIndex >= _numberOfUniformsPerEffect)
+	{
+		return -1;
+	}
+	return (effectIndex * _numberOfUniformsPerEffect) + uniformIndex;
+}
+
+
+int FakeEffectRuntime::toEffectIndex(uint64_t techniqueHandle) const
+{
+	const int effectIndex = (int)(techniqueHandle - FIRST_TECHNIQUE_HANDLE);
+	return (techniqueHandle >= FIRST_TECHNIQUE_HANDLE && effectIndex < _numberOfEffects) ? effectIndex : -1;
+}
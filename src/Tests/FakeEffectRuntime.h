@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <reshade.hpp>
+
+/// <summary>
+/// An effect runtime without ReShade, for the tests of the code which reads and sets the state of the effects. It has a number of effects, named
+/// Effect0.fx, Effect1.fx etc., each with one technique and a number of float4 uniforms named Uniform0, Uniform1 etc. Technique states and uniform
+/// values are kept, all other calls do nothing. Like a real runtime it's only called from the render thread, so it's not thread safe.
+/// </summary>
+class FakeEffectRuntime : public reshade::api::effect_runtime
+{
+public:
+	FakeEffectRuntime(int numberOfEffects, int numberOfUniformsPerEffect);
+	~FakeEffectRuntime() = default;
+
+	/// <summary>
+	/// Returns the technique of the effect with the index specified.
+	/// </summary>
+	reshade::api::effect_technique getTechnique(int effectIndex) const;
+	/// <summary>
+	/// Returns the uniform with the index specified of the effect with the index specified.
+	/// </summary>
+	reshade::api::effect_uniform_variable getUniform(int effectIndex, int uniformIndex) const;
+	/// <summary>
+	/// Returns the x component of the value of the uniform specified.
+	/// </summary>
+	float getUniformValue(int effectIndex, int uniformIndex) const;
+
+	// the overrides below hide the overloads of effect_runtime, like set_uniform_value_float(variable, x, y, z, w)
+	using reshade::api::effect_runtime::set_uniform_value_float;
+	// the calls the code under test makes
+	void enumerate_uniform_variables(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_uniform_variable variable, void* user_data), void* user_data) override;
+	void get_uniform_variable_type(reshade::api::effect_uniform_variable variable, reshade::api::format* out_base_type, uint32_t* out_rows = nullptr, uint32_t* out_columns = nullptr, uint32_t* out_array_length = nullptr) const override;
+	void get_uniform_variable_name(reshade::api::effect_uniform_variable variable, char* name, size_t* name_size) const override;
+	void get_uniform_value_float(reshade::api::effect_uniform_variable variable, float* values, size_t count, size_t array_index = 0) const override;
+	void set_uniform_value_float(reshade::api::effect_uniform_variable variable, const float* values, size_t count, size_t array_index = 0) override;
+	void enumerate_techniques(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_technique technique, void* user_data), void* user_data) override;
+	void get_technique_name(reshade::api::effect_technique technique, char* name, size_t* name_size) const override;
+	bool get_technique_state(reshade::api::effect_technique technique) const override;
+	void set_technique_state(reshade::api::effect_technique technique, bool enabled) override;
+	void get_uniform_variable_effect_name(reshade::api::effect_uniform_variable variable, char* effect_name, size_t* effect_name_size) const override;
+	void get_technique_effect_name(reshade::api::effect_technique technique, char* effect_name, size_t* effect_name_size) const override;
+
+	// not used by the code under test
+	uint64_t get_native() const override { return {}; }
+	void get_private_data(const uint8_t guid[16], uint64_t* data) const override {}
+	void set_private_data(const uint8_t guid[16], const uint64_t data) override {}
+	reshade::api::device* get_device() override { return {}; }
+	void* get_hwnd() const override { return {}; }
+	reshade::api::resource get_back_buffer(uint32_t index) override { return {}; }
+	uint32_t get_back_buffer_count() const override { return {}; }
+	uint32_t get_current_back_buffer_index() const override { return {}; }
+	reshade::api::command_queue* get_command_queue() override { return {}; }
+	void render_effects(reshade::api::command_list* cmd_list, reshade::api::resource_view rtv, reshade::api::resource_view rtv_srgb = { 0 }) override {}
+	bool capture_screenshot(uint8_t* pixels) override { return {}; }
+	void get_screenshot_width_and_height(uint32_t* out_width, uint32_t* out_height) const override {}
+	bool is_key_down(uint32_t keycode) const override { return {}; }
+	bool is_key_pressed(uint32_t keycode) const override { return {}; }
+	bool is_key_released(uint32_t keycode) const override { return {}; }
+	bool is_mouse_button_down(uint32_t button) const override { return {}; }
+	bool is_mouse_button_pressed(uint32_t button) const override { return {}; }
+	bool is_mouse_button_released(uint32_t button) const override { return {}; }
+	void get_mouse_cursor_position(uint32_t* out_x, uint32_t* out_y, int16_t* out_wheel_delta = nullptr) const override {}
+	reshade::api::effect_uniform_variable find_uniform_variable(const char* effect_name, const char* variable_name) const override { return {}; }
+	bool get_annotation_bool_from_uniform_variable(reshade::api::effect_uniform_variable variable, const char* name, bool* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_float_from_uniform_variable(reshade::api::effect_uniform_variable variable, const char* name, float* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_int_from_uniform_variable(reshade::api::effect_uniform_variable variable, const char* name, int32_t* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_uint_from_uniform_variable(reshade::api::effect_uniform_variable variable, const char* name, uint32_t* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_string_from_uniform_variable(reshade::api::effect_uniform_variable variable, const char* name, char* value, size_t* value_size) const override { return {}; }
+	void get_uniform_value_bool(reshade::api::effect_uniform_variable variable, bool* values, size_t count, size_t array_index = 0) const override {}
+	void get_uniform_value_int(reshade::api::effect_uniform_variable variable, int32_t* values, size_t count, size_t array_index = 0) const override {}
+	void get_uniform_value_uint(reshade::api::effect_uniform_variable variable, uint32_t* values, size_t count, size_t array_index = 0) const override {}
+	void set_uniform_value_bool(reshade::api::effect_uniform_variable variable, const bool* values, size_t count, size_t array_index = 0) override {}
+	void set_uniform_value_int(reshade::api::effect_uniform_variable variable, const int32_t* values, size_t count, size_t array_index = 0) override {}
+	void set_uniform_value_uint(reshade::api::effect_uniform_variable variable, const uint32_t* values, size_t count, size_t array_index = 0) override {}
+	void enumerate_texture_variables(const char* effect_name, void(*callback)(reshade::api::effect_runtime* runtime, reshade::api::effect_texture_variable variable, void* user_data), void* user_data) override {}
+	reshade::api::effect_texture_variable find_texture_variable(const char* effect_name, const char* variable_name) const override { return {}; }
+	void get_texture_variable_name(reshade::api::effect_texture_variable variable, char* name, size_t* name_size) const override {}
+	bool get_annotation_bool_from_texture_variable(reshade::api::effect_texture_variable variable, const char* name, bool* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_float_from_texture_variable(reshade::api::effect_texture_variable variable, const char* name, float* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_int_from_texture_variable(reshade::api::effect_texture_variable variable, const char* name, int32_t* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_uint_from_texture_variable(reshade::api::effect_texture_variable variable, const char* name, uint32_t* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_string_from_texture_variable(reshade::api::effect_texture_variable variable, const char* name, char* value, size_t* value_size) const override { return {}; }
+	void update_texture(reshade::api::effect_texture_variable variable, const uint32_t width, const uint32_t height, const uint8_t* pixels) override {}
+	void get_texture_binding(reshade::api::effect_texture_variable variable, reshade::api::resource_view* out_srv, reshade::api::resource_view* out_srv_srgb = nullptr) const override {}
+	void update_texture_bindings(const char* semantic, reshade::api::resource_view srv, reshade::api::resource_view srv_srgb = { 0 }) override {}
+	reshade::api::effect_technique find_technique(const char* effect_name, const char* technique_name) override { return {}; }
+	bool get_annotation_bool_from_technique(reshade::api::effect_technique technique, const char* name, bool* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_float_from_technique(reshade::api::effect_technique technique, const char* name, float* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_int_from_technique(reshade::api::effect_technique technique, const char* name, int32_t* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_uint_from_technique(reshade::api::effect_technique technique, const char* name, uint32_t* values, size_t count, size_t array_index = 0) const override { return {}; }
+	bool get_annotation_string_from_technique(reshade::api::effect_technique technique, const char* name, char* value, size_t* value_size) const override { return {}; }
+	bool get_preprocessor_definition(const char* name, char* value, size_t* value_size) const override { return {}; }
+	void set_preprocessor_definition(const char* name, const char* value) override {}
+	void render_technique(reshade::api::effect_technique technique, reshade::api::command_list* cmd_list, reshade::api::resource_view rtv, reshade::api::resource_view rtv_srgb = { 0 }) override {}
+	bool get_effects_state() const override { return {}; }
+	void set_effects_state(bool enabled) override {}
+	void get_current_preset_path(char* path, size_t* path_size) const override {}
+	void set_current_preset_path(const char* path) override {}
+	void reorder_techniques(size_t count, const reshade::api::effect_technique* techniques) override {}
+	void block_input_next_frame() override {}
+	uint32_t last_key_pressed() const override { return {}; }
+	uint32_t last_key_released() const override { return {}; }
+	void get_texture_variable_effect_name(reshade::api::effect_texture_variable variable, char* effect_name, size_t* effect_name_size) const override {}
+	void save_current_preset() const override {}
+	bool get_preprocessor_definition_for_effect(const char* effect_name, const char* name, char* value, size_t* value_size) const override { return {}; }
+	void set_preprocessor_definition_for_effect(const char* effect_name, const char* name, const char* value) override {}
+
+private:
+	// the index in _uniformValues of the uniform with the handle specified, -1 if it's not a handle of ours.
+	int toUniformIndex(uint64_t handle) const;
+	// the index of the effect of the technique with the handle specified, -1 if it's not a handle of ours.
+	int toEffectIndex(uint64_t techniqueHandle) const;
+
+	int _numberOfEffects;
+	int _numberOfUniformsPerEffect;
+	std::vector<bool> _techniqueStates;
+	// the values of the uniforms of all effects, effect by effect
+	std::vector<std::array<float, 4>> _uniformValues;
+};
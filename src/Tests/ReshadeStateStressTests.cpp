@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "TestFramework.h"
+#include "FakeEffectRuntime.h"
+#include "ReshadeStateStressTest.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+	constexpr int NUMBER_OF_EFFECTS = 3;
+	constexpr int NUMBER_OF_UNIFORMS_PER_EFFECT = 4;
+	// about 60 presents per second, like a game
+	constexpr int MILLISECONDS_BETWEEN_PRESENTS = 16;
+
+
+	float initialValue(int effectIndex, int uniformIndex)
+	{
+		return (float)((effectIndex * 10) + uniformIndex) + 0.5f;
+	}
+}
+
+
+// Runs the stress test of concurrent path edits, playback, saves and loads, with this thread as the render thread. Every value played back has to
+// be the interpolation of the recorded values, and the runtime has to have the state from before the test when it's done. The playback times and
+// the operation counts are in TestResults\ReshadeStateStressTest.json and in the console output.
+IGCS_TEST(concurrentPathEditsDontChangeThePlayedBackValues)
+{
+	FakeEffectRuntime runtime(NUMBER_OF_EFFECTS, NUMBER_OF_UNIFORMS_PER_EFFECT);
+	runtime.set_technique_state(runtime.getTechnique(0), true);
+	runtime.set_technique_state(runtime.getTechnique(2), true);
+	for(int i = 0; i < NUMBER_OF_EFFECTS; i++)
+	{
+		for(int j = 0; j < NUMBER_OF_UNIFORMS_PER_EFFECT; j++)
+		{
+			runtime.set_uniform_value_float(runtime.getUniform(i, j), initialValue(i, j));
+		}
+	}
+	const std::string outputFolder = IGCS::Tests::getTestOutputFolder();
+	const std::filesystem::path resultsFile = std::filesystem::path(outputFolder) / "ReshadeStateStressTest.json";
+	std::error_code errorCode;
+	std::filesystem::remove(resultsFile, errorCode);
+
+	ReshadeStateStressTest test;
+	test.start(outputFolder);
+	while(test.isRunning())
+	{
+		test.presentCalled(&runtime);
+		std::this_thread::sleep_for(std::chrono::milliseconds(MILLISECONDS_BETWEEN_PRESENTS));
+	}
+
+	IGCS_CHECK_EQUAL(0ULL, (unsigned long long)test.numberOfInconsistencies());
+	IGCS_CHECK(std::filesystem::exists(resultsFile));
+	for(int i = 0; i < NUMBER_OF_EFFECTS; i++)
+	{
+		for(int j = 0; j < NUMBER_OF_UNIFORMS_PER_EFFECT; j++)
+		{
+			IGCS_CHECK(runtime.getUniformValue(i, j) == initialValue(i, j));
+		}
+	}
+}
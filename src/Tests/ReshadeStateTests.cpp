@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "TestFramework.h"
+#include "CameraPathFile.h"
+#include "FakeEffectRuntime.h"
+#include "NameTable.h"
+#include "ReshadeStateBenchmark.h"
+#include "ReshadeStateController.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace
+{
+	constexpr int NUMBER_OF_EFFECTS = 3;
+	constexpr int NUMBER_OF_UNIFORMS_PER_EFFECT = 4;
+	constexpr float VALUE_TOLERANCE = 0.0001f;
+
+
+	float valueInSnapshot(int snapshotIndex, int effectIndex, int uniformIndex)
+	{
+		return (float)((snapshotIndex * 100) + (effectIndex * 10) + uniformIndex);
+	}
+
+
+	void setUniformValuesOfSnapshot(FakeEffectRuntime& runtime, int snapshotIndex)
+	{
+		for(int i = 0; i < NUMBER_OF_EFFECTS; i++)
+		{
+			for(int j = 0; j < NUMBER_OF_UNIFORMS_PER_EFFECT; j++)
+			{
+				runtime.set_uniform_value_float(runtime.getUniform(i, j), valueInSnapshot(snapshotIndex, i, j));
+			}
+		}
+	}
+}
+
+
+// Two snapshots of the flat layout, interpolated linearly: the uniforms of the enabled effects get the lerped values, the ones of the disabled effect,
+// which the snapshots don't store, are left alone.
+IGCS_TEST(interpolatingBetweenSnapshotsSetsTheLerpedValuesOfTheEnabledEffects)
+{
+	FakeEffectRuntime runtime(NUMBER_OF_EFFECTS, NUMBER_OF_UNIFORMS_PER_EFFECT);
+	runtime.set_technique_state(runtime.getTechnique(0), true);
+	runtime.set_technique_state(runtime.getTechnique(2), true);
+	ReshadeStateController controller;
+	controller.setStateInterpolationMode(StateInterpolationMode::Linear);
+	controller.addCameraPath();
+	setUniformValuesOfSnapshot(runtime, 0);
+	controller.appendStateSnapshotToPath(0, &runtime);
+	setUniformValuesOfSnapshot(runtime, 1);
+	controller.appendStateSnapshotToPath(0, &runtime);
+	IGCS_CHECK_EQUAL(2, controller.numberOfSnapshotsOnPath(0));
+
+	controller.setReshadeState(0, 0, 1, 0.25f, &runtime);
+	for(int i = 0; i < NUMBER_OF_EFFECTS; i++)
+	{
+		for(int j = 0; j < NUMBER_OF_UNIFORMS_PER_EFFECT; j++)
+		{
+			const float from = valueInSnapshot(0, i, j);
+			const float to = valueInSnapshot(1, i, j);
+			const float expected = (1 == i) ? to : from + (0.25f * (to - from));
+			IGCS_CHECK(std::abs(runtime.getUniformValue(i, j) - expected) < VALUE_TOLERANCE);
+		}
+	}
+	IGCS_CHECK(runtime.get_technique_state(runtime.getTechnique(0)));
+	IGCS_CHECK(!runtime.get_technique_state(runtime.getTechnique(1)));
+	IGCS_CHECK(runtime.get_technique_state(runtime.getTechnique(2)));
+}
+
+
+// A camera path file which turns out to be damaged after its names mustn't add these names to the NameTable.
+IGCS_TEST(readingADamagedCameraPathFileDoesntAddItsNames)
+{
+	NameTable& nameTable = NameTable::instance();
+	nameTable.intern("CameraPathFileTestName");
+	const std::string filename = (std::filesystem::path(IGCS::Tests::getTestOutputFolder()) / "DamagedCameraPaths.bin").string();
+	IGCS_CHECK(IGCS::CameraPathFile::write(filename, { std::make_shared<CameraPathData>() }));
+
+	// rename the name in the file to one which isn't in the table, and make the snapshot count of the path point outside the file.
+	std::vector<char> fileData;
+	{
+		std::ifstream file(filename, std::ios::binary);
+		fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	const std::string name = "CameraPathFileTestName";
+	const auto nameLocation = std::search(fileData.begin(), fileData.end(), name.begin(), name.end());
+	IGCS_CHECK(nameLocation != fileData.end());
+	*(nameLocation + name.size() - 1) = 'X';
+	uint64_t pathsOffset = 0;
+	std::memcpy(&pathsOffset, fileData.data() + 48, sizeof(pathsOffset));
+	const uint32_t numberOfSnapshots = 0xFFFFFFFF;
+	std::memcpy(fileData.data() + pathsOffset, &numberOfSnapshots, sizeof(numberOfSnapshots));
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file.write(fileData.data(), (std::streamsize)fileData.size());
+	}
+
+	const uint32_t numberOfNamesBeforeRead = nameTable.getNumberOfNames();
+	CameraPaths paths;
+	IGCS_CHECK(!IGCS::CameraPathFile::read(filename, paths));
+	IGCS_CHECK(paths.empty());
+	IGCS_CHECK_EQUAL(numberOfNamesBeforeRead, nameTable.getNumberOfNames());
+}
+
+
+// Runs the benchmark of the flat snapshot layout against the map layout it replaced, 100 effects x 50 uniforms. The timings and the memory per
+// snapshot are in TestResults\ReshadeStateBenchmark.json and in the console output.
+IGCS_TEST(reshadeStateBenchmarkWritesItsResults)
+{
+	const std::string outputFolder = IGCS::Tests::getTestOutputFolder();
+	const std::filesystem::path resultsFile = std::filesystem::path(outputFolder) / "ReshadeStateBenchmark.json";
+	std::error_code errorCode;
+	std::filesystem::remove(resultsFile, errorCode);
+	ReshadeStateBenchmark benchmark;
+	benchmark.start(outputFolder);
+	while(benchmark.isRunning())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	IGCS_CHECK(std::filesystem::exists(resultsFile));
+}
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	typedef void (*TestFunction)();
+
+	struct TestCase
+	{
+		const char* name;
+		TestFunction testFunction;
+	};
+
+	/// <summary>
+	/// Returns the tests registered with IGCS_TEST, in the order they were registered.
+	/// </summary>
+	std::vector<TestCase>& getTestCases();
+	/// <summary>
+	/// Marks the test running as failed and logs the failed check.
+	/// </summary>
+	void reportFailure(const char* file, int line, const std::string& message);
+	/// <summary>
+	/// Returns the folder with the data files the tests read, like golden images. It's the Data folder next to the test sources.
+	/// </summary>
+	std::string getTestDataFolder();
+	/// <summary>
+	/// Returns the folder tests write their results to, a TestResults folder in the working directory. It's created if it doesn't exist.
+	/// </summary>
+	std::string getTestOutputFolder();
+
+	struct TestRegistration
+	{
+		TestRegistration(const char* name, TestFunction testFunction)
+		{
+			getTestCases().push_back({ name, testFunction });
+		}
+	};
+}
+
+// Defines and registers a test, which is run by the test runner in TestMain.cpp.
+#define IGCS_TEST(testName) \
+	static void testName(); \
+	static IGCS::Tests::TestRegistration testName##Registration(#testName, &testName); \
+	static void testName()
+
+// Checks don't stop the test, so a test reports all its failed checks.
+#define IGCS_CHECK(condition) \
+	do { if(!(condition)) { IGCS::Tests::reportFailure(__FILE__, __LINE__, #condition); } } while(false)
+
+#define IGCS_CHECK_EQUAL(expected, actual) \
+	do \
+	{ \
+		const auto expectedValue = (expected); \
+		const auto actualValue = (actual); \
+		if(!(expectedValue == actualValue)) \
+		{ \
+			IGCS::Tests::reportFailure(__FILE__, __LINE__, std::string(#actual " == " #expected ": expected ") + std::to_string(expectedValue) + ", got " + std::to_string(actualValue)); \
+		} \
+	} while(false)
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "TestFramework.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+	int g_numberOfFailedChecks = 0;
+}
+
+
+namespace IGCS::Tests
+{
+	std::vector<TestCase>& getTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+
+	void reportFailure(const char* file, int line, const std::string& message)
+	{
+		printf("  %s(%d): check failed: %s\n", file, line, message.c_str());
+		g_numberOfFailedChecks++;
+	}
+
+
+	std::string getTestDataFolder()
+	{
+		// relative to this source file, so the tests don't depend on the working directory they're started in.
+		return (std::filesystem::path(__FILE__).parent_path() / "Data").string();
+	}
+
+
+	std::string getTestOutputFolder()
+	{
+		const std::filesystem::path outputFolder = std::filesystem::current_path() / "TestResults";
+		std::error_code errorCode;
+		std::filesystem::create_directories(outputFolder, errorCode);
+		return outputFolder.string();
+	}
+}
+
+
+/// <summary>
+/// Runs the registered tests whose name contains the first argument, or all tests if there's no argument. Returns the number of failed tests.
+/// </summary>
+int main(int argc, char* argv[])
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+	int numberOfTestsRun = 0;
+	int numberOfTestsFailed = 0;
+	for(const auto& testCase : IGCS::Tests::getTestCases())
+	{
+		if(nullptr == strstr(testCase.name, filter))
+		{
+			continue;
+		}
+		printf("[ RUN  ] %s\n", testCase.name);
+		const int numberOfFailedChecksBefore = g_numberOfFailedChecks;
+		testCase.testFunction();
+		const bool hasFailed = g_numberOfFailedChecks != numberOfFailedChecksBefore;
+		printf("[ %s ] %s\n", hasFailed ? "FAIL" : " OK ", testCase.name);
+		numberOfTestsRun++;
+		numberOfTestsFailed += hasFailed ? 1 : 0;
+	}
+	printf("%d tests run, %d failed.\n", numberOfTestsRun, numberOfTestsFailed);
+	return numberOfTestsFailed;
+}
@@ -39,7 +39,7 @@ namespace IGCS
             {
                 return {};
             }
-            T tmp = queue_.front();
+            T tmp = std::move(queue_.front());
             queue_.pop();
             return tmp;
         }
@@ -50,6 +50,12 @@ namespace IGCS
             queue_.push(item);
         }
 
+        void push(T&& item)
+        {
+            std::scoped_lock lock(mutex_);
+            queue_.push(std::move(item));
+        }
+
     private:
         std::queue<T> queue_;
         mutable std::mutex mutex_;
@@ -28,6 +28,7 @@
 #pragma once
 #include <reshade.hpp>
 #include "stdafx.h"
+#include <algorithm>
 #include <vector>
 
 namespace IGCS::Utils
@@ -74,4 +75,34 @@ namespace IGCS::Utils
 	{
 		return (x + (s * (y - x)));
 	}
+
+	/// <summary>
+	/// Sorts the keys ascending and puts the elements of the arrays specified, which run parallel with the keys, in the same order. If a key occurs
+	/// more than once, only its first occurrence and the elements belonging to it are kept.
+	/// </summary>
+	/// <param name="keys"></param>
+	/// <param name="arrays"></param>
+	template <typename TKey, typename... TArrays>
+	void sortParallelArrays(std::vector<TKey>& keys, TArrays&... arrays)
+	{
+		std::vector<size_t> order(keys.size());
+		for(size_t i = 0; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+		order.erase(std::unique(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] == keys[b]; }), order.end());
+		auto applyOrder = [&order](auto& array)
+		{
+			std::remove_reference_t<decltype(array)> sorted;
+			sorted.reserve(order.size());
+			for(const size_t index : order)
+			{
+				sorted.push_back(array[index]);
+			}
+			array = std::move(sorted);
+		};
+		(applyOrder(arrays), ...);
+		applyOrder(keys);
+	}
 }
\ No newline at end of file
@@ -35,20 +35,35 @@
 
 #include <functional>
 #include <reshade.hpp>
+#include "ConstantsEnums.h"
 
+/// <summary>
+/// Work to perform on the render thread at present. Move-only, so passing it through the present work queue never copies the function and its captures.
+/// Work with a coalescing key other than None supersedes the pending work with the same key, see CoalescingWorkQueue, which uses empty work with
+/// a key as the marker of the latest work with that key.
+/// </summary>
 struct WorkItem
 {
 public:
-	WorkItem(std::function<void(reshade::api::effect_runtime* runtime)> workPerformer)
+	WorkItem() = default;
+	WorkItem(std::function<void(reshade::api::effect_runtime* runtime)> workPerformer, WorkItemCoalescingKey coalescingKey = WorkItemCoalescingKey::None) :
+		_workPerformer(std::move(workPerformer)), _coalescingKey(coalescingKey)
 	{
-		_workPerformer = workPerformer;
 	}
+	WorkItem(WorkItem&& other) = default;
+	WorkItem& operator=(WorkItem&& other) = default;
+	WorkItem(const WorkItem&) = delete;
+	WorkItem& operator=(const WorkItem&) = delete;
 
 	void perform(reshade::api::effect_runtime* runtime)
 	{
 		_workPerformer(runtime);
 	}
 
+	bool isEmpty() const { return !_workPerformer; }
+	WorkItemCoalescingKey getCoalescingKey() const { return _coalescingKey; }
+
 private:
 	std::function<void(reshade::api::effect_runtime* runtime)> _workPerformer;
+	WorkItemCoalescingKey _coalescingKey = WorkItemCoalescingKey::None;
 };
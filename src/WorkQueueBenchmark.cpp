@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#include "stdafx.h"
+#include "WorkQueueBenchmark.h"
+#include "MpscRingQueue.h"
+#include "OverlayControl.h"
+#include "ThreadSafeQueue.h"
+#include "Utils.h"
+#include "WorkItem.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+	constexpr int NUMBER_OF_ITEMS_PER_PRODUCER = 100000;
+	constexpr int PRODUCER_COUNTS[] = { 1, 2, 4, 8 };
+	// the capacity of the present work queue
+	constexpr size_t RING_QUEUE_CAPACITY = 1024;
+
+	struct RunResult
+	{
+		const char* queueName;
+		int numberOfProducers;
+		double itemsPerSecond;
+		double averageLatencyMicroseconds;
+		double p99LatencyMicroseconds;
+	};
+
+
+	/// <summary>
+	/// Lets numberOfProducers threads push work items with push, while this thread calls drainQueue, which returns the number of items performed, until
+	/// all items have been performed. Every item records the time from its push to its perform.
+	/// </summary>
+	template<typename TPush, typename TDrain>
+	RunResult runQueue(const char* queueName, int numberOfProducers, TPush push, TDrain drainQueue)
+	{
+		const size_t numberOfItems = (size_t)numberOfProducers * NUMBER_OF_ITEMS_PER_PRODUCER;
+		// only written by the items, which are performed on this thread.
+		std::vector<double> latencies;
+		latencies.reserve(numberOfItems);
+		std::atomic<bool> isStarted = false;
+		std::vector<std::thread> producers;
+		for(int i = 0; i < numberOfProducers; i++)
+		{
+			producers.emplace_back([&]()
+			{
+				while(!isStarted)
+				{
+					std::this_thread::yield();
+				}
+				for(int j = 0; j < NUMBER_OF_ITEMS_PER_PRODUCER; j++)
+				{
+					const auto pushTime = steady_clock::now();
+					push(WorkItem([pushTime, &latencies](reshade::api::effect_runtime*) { latencies.push_back(duration<double, std::micro>(steady_clock::now() - pushTime).count()); }));
+				}
+			});
+		}
+		const auto startTime = steady_clock::now();
+		isStarted = true;
+		while(latencies.size() < numberOfItems)
+		{
+			if(0 == drainQueue())
+			{
+				std::this_thread::yield();
+			}
+		}
+		const double elapsedSeconds = duration<double>(steady_clock::now() - startTime).count();
+		for(auto& producer : producers)
+		{
+			producer.join();
+		}
+
+		double totalLatency = 0.0;
+		for(const double latency : latencies)
+		{
+			totalLatency += latency;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		return { queueName, numberOfProducers, (double)numberOfItems / elapsedSeconds, totalLatency / (double)numberOfItems, latencies[(size_t)((double)(numberOfItems - 1) * 0.99)] };
+	}
+}
+
+
+void WorkQueueBenchmark::start(const std::string& outputFolder)
+{
+	bool expected = false;
+	if(!_isRunning.compare_exchange_strong(expected, true))
+	{
+		return;
+	}
+	std::thread t(&WorkQueueBenchmark::run, this, outputFolder);
+	t.detach();
+}
+
+
+void WorkQueueBenchmark::run(std::string outputFolder)
+{
+	std::vector<RunResult> results;
+	for(const int numberOfProducers : PRODUCER_COUNTS)
+	{
+		IGCS::MpscRingQueue<WorkItem> ringQueue(RING_QUEUE_CAPACITY);
+		results.push_back(runQueue("mpscRing", numberOfProducers, [&ringQueue](WorkItem&& item) { ringQueue.push(std::move(item)); },
+								   [&ringQueue]() { return ringQueue.drain([](WorkItem&& item) { item.perform(nullptr); }); }));
+
+		IGCS::ThreadSafeQueue<WorkItem> mutexQueue;
+		results.push_back(runQueue("mutex", numberOfProducers, [&mutexQueue](WorkItem&& item) { mutexQueue.push(std::move(item)); },
+								   [&mutexQueue]()
+								   {
+									   // what the present handler did with this queue: pop under the lock per item.
+									   size_t numberOfItemsPerformed = 0;
+									   for(auto item = mutexQueue.pop(); item.has_value(); item = mutexQueue.pop())
+									   {
+										   item.value().perform(nullptr);
+										   numberOfItemsPerformed++;
+									   }
+									   return numberOfItemsPerformed;
+								   }));
+	}
+
+	for(const auto& result : results)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::info, "Work queue benchmark: %s queue, %d producers: %.0f items per second, latency %.2f us average, %.2f us 99th percentile.",
+									  result.queueName, result.numberOfProducers, result.itemsPerSecond, result.averageLatencyMicroseconds, result.p99LatencyMicroseconds);
+	}
+
+	const std::string optionalBackslash = (outputFolder.ends_with('\\')) ? "" : "\\";
+	const std::string filename = outputFolder + optionalBackslash + "WorkQueueBenchmark.json";
+	FILE* resultsFile = nullptr;
+	if(fopen_s(&resultsFile, filename.c_str(), "w") != 0 || nullptr == resultsFile)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log_level::error, "Work queue benchmark: couldn't write results to %s", filename.c_str());
+		_isRunning = false;
+		return;
+	}
+	fprintf(resultsFile, "{\n\t\"numberOfItemsPerProducer\": %d,\n\t\"ringQueueCapacity\": %llu,\n\t\"runs\": [\n", NUMBER_OF_ITEMS_PER_PRODUCER, (unsigned long long)RING_QUEUE_CAPACITY);
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+		fprintf(resultsFile, "\t\t{ \"queue\": \"%s\", \"numberOfProducers\": %d, \"itemsPerSecond\": %.0f, \"averageLatencyMicroseconds\": %.3f, \"p99LatencyMicroseconds\": %.3f }%s\n",
+				result.queueName, result.numberOfProducers, result.itemsPerSecond, result.averageLatencyMicroseconds, result.p99LatencyMicroseconds, (i < results.size() - 1) ? "," : "");
+	}
+	fprintf(resultsFile, "\t]\n}\n");
+	fclose(resultsFile);
+	OverlayControl::addNotification("Work queue benchmark completed. Results written to " + filename);
+	_isRunning = false;
+}
@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <string>
+
+/// <summary>
+/// Benchmarks the present work queue: 1, 2, 4 and 8 producer threads push work items as fast as they can while a consumer thread drains them, once with
+/// the lock-free MpscRingQueue and once with the mutex based ThreadSafeQueue it replaced. Per run it measures the throughput and the latency from push to
+/// perform (average and 99th percentile). Results are written as JSON to the output folder.
+/// </summary>
+class WorkQueueBenchmark
+{
+public:
+	WorkQueueBenchmark() = default;
+	~WorkQueueBenchmark() = default;
+
+	/// <summary>
+	/// Starts the benchmark on a background thread, writing the results to outputFolder. Ignored if a benchmark is already running.
+	/// </summary>
+	/// <param name="outputFolder"></param>
+	void start(const std::string& outputFolder);
+	bool isRunning() { return _isRunning; }
+
+private:
+	void run(std::string outputFolder);
+
+	std::atomic<bool> _isRunning = false;
+};